@@ -39,6 +39,7 @@ ostream &operator<<(ostream &out, const Analysis& analysis) {
 
 void Analysis::add(const Reference<LoadSet>& loadSetReference) {
 	this->loadSet_references.push_back(loadSetReference.clone());
+	model.invalidateSetClassification();
 }
 
 const vector<shared_ptr<LoadSet>> Analysis::getLoadSets() const {
@@ -79,12 +80,14 @@ const vector<shared_ptr<BoundaryCondition>> Analysis::getBoundaryConditions() co
 
 void Analysis::add(const Reference<ConstraintSet>& constraintSetReference) {
 	this->constraintSet_references.push_back(constraintSetReference.clone());
+	model.invalidateSetClassification();
 }
 
 void Analysis::remove(const Reference<LoadSet> loadSetReference) {
 	for (auto it = loadSet_references.begin(); it != loadSet_references.end(); ++it) {
 		if (**it == loadSetReference) {
 			loadSet_references.erase(it);
+			model.invalidateSetClassification();
 			return;
 		}
 	}
@@ -94,6 +97,7 @@ void Analysis::remove(const Reference<ConstraintSet> constraintSetReference) {
 	for (auto it = constraintSet_references.begin(); it != constraintSet_references.end(); ++it) {
 		if (**it == constraintSetReference) {
 			constraintSet_references.erase(it);
+			model.invalidateSetClassification();
 			return;
 		}
 	}
@@ -227,22 +231,45 @@ void Analysis::removeSPCNodeDofs(SinglePointConstraint& spc, int nodePosition,	c
 }
 
 void Analysis::addBoundaryDOFS(int nodePosition, const DOFS dofs) {
-	boundaryDOFSByNodePosition[nodePosition] = DOFS(boundaryDOFSByNodePosition[nodePosition]) + dofs;
+	const size_t position = static_cast<size_t>(nodePosition);
+	if (position >= boundaryDOFSByNodePosition.size()) {
+		boundaryDOFSByNodePosition.resize(position + 1, 0);
+	}
+	boundaryDOFSByNodePosition[position] = static_cast<char>(boundaryDOFSByNodePosition[position]
+			| dofs);
 }
 
 const DOFS Analysis::findBoundaryDOFS(int nodePosition) const {
-	const auto& entry = boundaryDOFSByNodePosition.find(nodePosition);
-	if (entry == boundaryDOFSByNodePosition.end()) {
+	const size_t position = static_cast<size_t>(nodePosition);
+	if (position >= boundaryDOFSByNodePosition.size()) {
 		return DOFS::NO_DOFS;
 	} else {
-		return entry->second;
+		return DOFS(boundaryDOFSByNodePosition[position]);
 	}
 }
 
+const list<shared_ptr<Reference<LoadSet>>>& Analysis::getLoadSetReferences() const {
+	return loadSet_references;
+}
+
+const list<shared_ptr<Reference<ConstraintSet>>>& Analysis::getConstraintSetReferences() const {
+	return constraintSet_references;
+}
+
+const list<shared_ptr<Reference<Objective>>>& Analysis::getAssertionReferences() const {
+	return assertion_references;
+}
+
+const vector<char>& Analysis::getBoundaryDOFS() const {
+	return boundaryDOFSByNodePosition;
+}
+
 const set<int> Analysis::boundaryNodePositions() const {
 	set<int> result;
-	for (auto& entry : boundaryDOFSByNodePosition) {
-		result.insert(entry.first);
+	for (size_t position = 0; position < boundaryDOFSByNodePosition.size(); position++) {
+		if (boundaryDOFSByNodePosition[position] != 0) {
+			result.insert(static_cast<int>(position));
+		}
 	}
 	return result;
 }
@@ -256,7 +283,7 @@ LinearMecaStat::LinearMecaStat(Model& model, const int original_id) :
 }
 
 shared_ptr<Analysis> LinearMecaStat::clone() const {
-	return shared_ptr<LinearMecaStat>(new LinearMecaStat(*this));
+	return makeModelObject<LinearMecaStat>(model, *this);
 }
 
 NonLinearMecaStat::NonLinearMecaStat(Model& model, const int strategy_id, const int original_id) :
@@ -266,7 +293,7 @@ NonLinearMecaStat::NonLinearMecaStat(Model& model, const int strategy_id, const
 }
 
 shared_ptr<Analysis> NonLinearMecaStat::clone() const {
-	return shared_ptr<NonLinearMecaStat>(new NonLinearMecaStat(*this));
+	return makeModelObject<NonLinearMecaStat>(model, *this);
 }
 
 bool NonLinearMecaStat::validate() const {
@@ -279,12 +306,21 @@ LinearModal::LinearModal(Model& model, const int frequency_band_original_id, con
 				frequency_band_original_id) {
 }
 
+LinearModal::LinearModal(Model& model, const Reference<Objective>& frequency_band_reference,
+		const int original_id, const Type type) :
+		Analysis(model, type, original_id), frequency_band_reference(frequency_band_reference) {
+}
+
 shared_ptr<FrequencyBand> LinearModal::getFrequencyBand() const {
 	return dynamic_pointer_cast<FrequencyBand>(model.find(frequency_band_reference));
 }
 
+const Reference<Objective>& LinearModal::getFrequencyBandReference() const {
+	return frequency_band_reference;
+}
+
 shared_ptr<Analysis> LinearModal::clone() const {
-	return shared_ptr<LinearModal>(new LinearModal(*this));
+	return makeModelObject<LinearModal>(model, *this);
 }
 
 bool LinearModal::validate() const {
@@ -304,12 +340,31 @@ shared_ptr<ModalDamping> LinearDynaModalFreq::getModalDamping() const {
 	return dynamic_pointer_cast<ModalDamping>(model.find(modal_damping_reference));
 }
 
+LinearDynaModalFreq::LinearDynaModalFreq(Model& model,
+		const Reference<Objective>& frequency_band_reference,
+		const Reference<Objective>& modal_damping_reference,
+		const Reference<Objective>& frequency_values_reference, const bool residual_vector,
+		const int original_id) :
+		LinearModal(model, frequency_band_reference, original_id,
+				Analysis::LINEAR_DYNA_MODAL_FREQ), modal_damping_reference(
+				modal_damping_reference), frequency_values_reference(frequency_values_reference), residual_vector(
+				residual_vector) {
+}
+
 shared_ptr<FrequencyValues> LinearDynaModalFreq::getFrequencyValues() const {
 	return dynamic_pointer_cast<FrequencyValues>(model.find(frequency_values_reference));
 }
 
+const Reference<Objective>& LinearDynaModalFreq::getModalDampingReference() const {
+	return modal_damping_reference;
+}
+
+const Reference<Objective>& LinearDynaModalFreq::getFrequencyValuesReference() const {
+	return frequency_values_reference;
+}
+
 shared_ptr<Analysis> LinearDynaModalFreq::clone() const {
-	return shared_ptr<LinearDynaModalFreq>(new LinearDynaModalFreq(*this));
+	return makeModelObject<LinearDynaModalFreq>(model, *this);
 }
 
 bool LinearDynaModalFreq::validate() const {
@@ -38,7 +38,11 @@ class ModelConfiguration;
 class Analysis: public Identifiable<Analysis> {
 private:
 	friend ostream &operator<<(ostream &out, const Analysis& analysis);    //output
-	std::map<int, char> boundaryDOFSByNodePosition;
+	/**
+	 * DOFS of the boundary conditions of the analysis, indexed by node position and 0 for the
+	 * nodes without boundary conditions. Only as long as the last such node position.
+	 */
+	std::vector<char> boundaryDOFSByNodePosition;
 public:
 	enum Type {
 		LINEAR_MECA_STAT,
@@ -86,10 +90,18 @@ public:
 	const vector<std::shared_ptr<LoadSet>> getLoadSets() const;
 	const vector<std::shared_ptr<BoundaryCondition>> getBoundaryConditions() const;
 	const vector<std::shared_ptr<Assertion>> getAssertions() const;
+	const list<std::shared_ptr<Reference<LoadSet>>>& getLoadSetReferences() const;
+	const list<std::shared_ptr<Reference<ConstraintSet>>>& getConstraintSetReferences() const;
+	const list<std::shared_ptr<Reference<Objective>>>& getAssertionReferences() const;
 
 	void removeSPCNodeDofs(SinglePointConstraint& spc, int nodePosition, const DOFS dofs);
 	void addBoundaryDOFS(int nodePosition, const DOFS dofs);
 	const DOFS findBoundaryDOFS(int nodePosition) const;
+	/**
+	 * DOFS of the boundary conditions as DOFS codes indexed by node position, possibly
+	 * shorter than the node count of the mesh.
+	 */
+	const std::vector<char>& getBoundaryDOFS() const;
 	const set<int> boundaryNodePositions() const;
 
 	virtual std::shared_ptr<Analysis> clone() const =0;
@@ -124,7 +136,10 @@ public:
 			NO_ORIGINAL_ID, const Type type = LINEAR_MODAL);
 	LinearModal(Model& model, const int frequency_band_original_id, const int original_id =
 			NO_ORIGINAL_ID, const Type type = LINEAR_MODAL);
+	LinearModal(Model& model, const Reference<Objective>& frequency_band_reference,
+			const int original_id = NO_ORIGINAL_ID, const Type type = LINEAR_MODAL);
 	std::shared_ptr<FrequencyBand> getFrequencyBand() const;
+	const Reference<Objective>& getFrequencyBandReference() const;
 	std::shared_ptr<Analysis> clone() const;
 	bool validate() const override;
 };
@@ -140,9 +155,15 @@ public:
 	LinearDynaModalFreq(Model& model, const int frequency_band_original_id,
 			const int modal_damping_original_id, const int frequency_value_original_id,
 			const bool residual_vector = false, const int original_id = NO_ORIGINAL_ID);
+	LinearDynaModalFreq(Model& model, const Reference<Objective>& frequency_band_reference,
+			const Reference<Objective>& modal_damping_reference,
+			const Reference<Objective>& frequency_values_reference,
+			const bool residual_vector = false, const int original_id = NO_ORIGINAL_ID);
 	const bool residual_vector;
 	std::shared_ptr<ModalDamping> getModalDamping() const;
 	std::shared_ptr<FrequencyValues> getFrequencyValues() const;
+	const Reference<Objective>& getModalDampingReference() const;
+	const Reference<Objective>& getFrequencyValuesReference() const;
 	std::shared_ptr<Analysis> clone() const;
 	bool validate() const override;
 };
@@ -22,22 +22,33 @@ namespace vega {
 ConfigurationParameters::ConfigurationParameters(string inputFile, Solver outputSolver,
         string solverVersion, string outputFile, string outputPath, LogLevel logLevel,
         TranslationMode translationMode, fs::path resultFile, double tolerance, bool runSolver,
-        string solverServer, string solverCommand) :
+        string solverServer, string solverCommand, unsigned int parserThreads,
+        fs::path modelCacheDirectory, unsigned int finishThreads, unsigned int writerThreads,
+        unsigned int maxNameListSize, bool concurrentMedWrite) :
         inputFile(inputFile), outputSolver(outputSolver), solverVersion(solverVersion), outputFile(
                 outputFile), outputPath(outputPath), logLevel(logLevel), translationMode(
                 translationMode), resultFile(resultFile), testTolerance(tolerance), runSolver(
-                runSolver), solverServer(solverServer), solverCommand(solverCommand) {
+                runSolver), solverServer(solverServer), solverCommand(solverCommand), parserThreads(
+                parserThreads), modelCacheDirectory(modelCacheDirectory), finishThreads(
+                finishThreads), writerThreads(writerThreads), maxNameListSize(maxNameListSize), concurrentMedWrite(
+                concurrentMedWrite) {
 
 }
 
 const ModelConfiguration ConfigurationParameters::getModelConfiguration() const {
     if (this->outputSolver.getSolverName() == CODE_ASTER) {
-        return ModelConfiguration(true, this->logLevel, true);
+        ModelConfiguration configuration(true, this->logLevel, true);
+        configuration.finishThreads = finishThreads;
+        return configuration;
     } else if (this->outputSolver.getSolverName() == SYSTUS) {
-        return ModelConfiguration(false, this->logLevel, true, false);
+        ModelConfiguration configuration(false, this->logLevel, true, false);
+        configuration.finishThreads = finishThreads;
+        return configuration;
     } else if (this->outputSolver.getSolverName() == NASTRAN) {
-        return ModelConfiguration(false, this->logLevel, false, false, false, false, false, false,
-                false, false, false);
+        ModelConfiguration configuration(false, this->logLevel, false, false, false, false, false,
+                false, false, false, false);
+        configuration.finishThreads = finishThreads;
+        return configuration;
     } else {
         throw logic_error(" solver not implemented");
     }
@@ -87,7 +98,7 @@ ModelConfiguration::ModelConfiguration(bool virtualDiscrets, LogLevel logLevel,
                 displayHomogeneousConstraint), emulateAdditionalMass(emulateAdditionalMass), replaceCombinedLoadSets(
                 replaceCombinedLoadSets), removeIneffectives(removeIneffectives), partitionModel(
                 partitionModel), replaceDirectMatrices(replaceDirectMatrices), removeRedundantSpcs(
-                removeRedundantSpcs) {
+                removeRedundantSpcs), finishThreads(1) {
 }
 
 }
@@ -82,6 +82,11 @@ public:
     const bool partitionModel;
     const bool replaceDirectMatrices;
     const bool removeRedundantSpcs;
+    /**
+     * Threads running the independent passes of Model::finish, 1 to run them in sequence
+     * (deterministic mode).
+     */
+    unsigned int finishThreads;
 };
 
 class ConfigurationParameters {
@@ -96,7 +101,10 @@ public:
             "", std::string outputFile = "vega", std::string outputPath = ".", LogLevel logLevel =
             LogLevel::INFO, TranslationMode translationMode = BEST_EFFORT, fs::path resultFile = "",
             double testTolerance = 0.02, bool runSolver = false, std::string solverServer = "",
-            std::string solverCommand = "");
+            std::string solverCommand = "", unsigned int parserThreads = 1,
+            fs::path modelCacheDirectory = "", unsigned int finishThreads = 1,
+            unsigned int writerThreads = 1, unsigned int maxNameListSize = 1000,
+            bool concurrentMedWrite = false);
     const ModelConfiguration getModelConfiguration() const;
     virtual ~ConfigurationParameters();
 
@@ -112,6 +120,33 @@ public:
     const bool runSolver;
     const std::string solverServer;
     const std::string solverCommand;
+    /**
+     * Threads used to read the input model, 1 to read it sequentially.
+     */
+    const unsigned int parserThreads;
+    /**
+     * Directory of the .vega model caches, empty to parse the input model without cache.
+     */
+    const fs::path modelCacheDirectory;
+    /**
+     * Threads used to finish the model, 1 to finish it sequentially.
+     */
+    const unsigned int finishThreads;
+    /**
+     * Threads used to render the large sections of the output files, 1 to render them
+     * sequentially.
+     */
+    const unsigned int writerThreads;
+    /**
+     * Largest number of node or cell names listed in a command file: larger sets are written
+     * as groups of the mesh, and referenced by the name of the group.
+     */
+    const unsigned int maxNameListSize;
+    /**
+     * Whether the Aster writer writes the MED file on its own thread while it renders the
+     * command file.
+     */
+    const bool concurrentMedWrite;
 };
 
 }
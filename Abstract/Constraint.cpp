@@ -12,6 +12,9 @@
 #include "Constraint.h"
 #include "Model.h"
 #include <ciso646>
+#include <algorithm>
+#include <numeric>
+#include <tuple>
 
 namespace vega {
 
@@ -45,6 +48,10 @@ void ConstraintSet::add(const Reference<ConstraintSet>& constraintSetReference)
 	constraintSetReferences.push_back(constraintSetReference);
 }
 
+const vector<Reference<ConstraintSet>>& ConstraintSet::getConstraintSetReferences() const {
+	return constraintSetReferences;
+}
+
 const set<shared_ptr<Constraint> > ConstraintSet::getConstraints() const {
 	set<shared_ptr<Constraint>> result = model.getConstraintsByConstraintSet(this->getReference());
 	for (auto constraintSetReference : constraintSetReferences) {
@@ -81,7 +88,7 @@ ostream &operator<<(ostream &out, const ConstraintSet& constraintSet) {
 }
 
 shared_ptr<ConstraintSet> ConstraintSet::clone() const {
-	return shared_ptr<ConstraintSet>(new ConstraintSet(*this));
+	return makeModelObject<ConstraintSet>(model, *this);
 }
 
 ConstraintSet::~ConstraintSet() {
@@ -162,7 +169,7 @@ QuasiRigidConstraint::QuasiRigidConstraint(Model& model, const DOFS& dofs, int m
 
 }
 shared_ptr<Constraint> QuasiRigidConstraint::clone() const {
-	return shared_ptr<Constraint>(new QuasiRigidConstraint(*this));
+	return makeModelObject<QuasiRigidConstraint>(model, *this);
 }
 
 RigidConstraint::RigidConstraint(Model& model, int masterId, int constraintGroup,
@@ -171,7 +178,7 @@ RigidConstraint::RigidConstraint(Model& model, int masterId, int constraintGroup
 }
 
 shared_ptr<Constraint> RigidConstraint::clone() const {
-	return shared_ptr<Constraint>(new RigidConstraint(*this));
+	return makeModelObject<RigidConstraint>(model, *this);
 }
 
 RBE3::RBE3(Model& model, int masterId, const DOFS dofs, int original_id) :
@@ -211,7 +218,7 @@ const DOFS RBE3::getDOFSForNode(int nodePosition) const {
 }
 
 shared_ptr<Constraint> RBE3::clone() const {
-	return shared_ptr<Constraint>(new RBE3(*this));
+	return makeModelObject<RBE3>(model, *this);
 }
 
 const ValueOrReference& SinglePointConstraint::NO_SPC = ValueOrReference::EMPTY_VALUE;
@@ -267,7 +274,13 @@ void SinglePointConstraint::addNodeId(int nodeId) {
 
 shared_ptr<Constraint> SinglePointConstraint::clone()
 const {
-	return shared_ptr<Constraint>(new SinglePointConstraint(*this));
+	return makeModelObject<SinglePointConstraint>(model, *this);
+}
+
+void SinglePointConstraint::addNodePositions(const vector<int>& nodePositions) {
+	for (int nodePosition : nodePositions) {
+		_nodePositions.insert(_nodePositions.end(), nodePosition);
+	}
 }
 
 set<int> SinglePointConstraint::nodePositions() const {
@@ -276,7 +289,7 @@ set<int> SinglePointConstraint::nodePositions() const {
 	if (group != nullptr) {
 		if (this->group->type == Group::NODEGROUP) {
 			NodeGroup* const ngroup = static_cast<NodeGroup* const >(group);
-			set<int> nodePositions = ngroup->nodePositions();
+			const PositionSet& nodePositions = ngroup->nodePositionSet();
 			result.insert(nodePositions.begin(), nodePositions.end());
 		} else {
 			throw logic_error("SPC:: getAllNodes on unknown group type");
@@ -359,7 +372,7 @@ LinearMultiplePointConstraint::LinearMultiplePointConstraint(Model& model, doubl
 }
 
 shared_ptr<Constraint> LinearMultiplePointConstraint::clone() const {
-	return shared_ptr<Constraint>(new LinearMultiplePointConstraint(*this));
+	return makeModelObject<LinearMultiplePointConstraint>(model, *this);
 }
 
 void LinearMultiplePointConstraint::addParticipation(int nodeId, double dx, double dy, double dz,
@@ -430,7 +443,7 @@ GapTwoNodes::GapTwoNodes(Model& model, int original_id) :
 }
 
 shared_ptr<Constraint> GapTwoNodes::clone() const {
-	return shared_ptr<Constraint>(new GapTwoNodes(*this));
+	return makeModelObject<GapTwoNodes>(model, *this);
 }
 
 void GapTwoNodes::addGapNodes(int constrainedNodeId, int directionNodeId) {
@@ -493,7 +506,7 @@ GapNodeDirection::GapNodeDirection(Model& model, int original_id) :
 }
 
 shared_ptr<Constraint> GapNodeDirection::clone() const {
-	return shared_ptr<Constraint>(new GapNodeDirection(*this));
+	return makeModelObject<GapNodeDirection>(model, *this);
 }
 
 void GapNodeDirection::addGapNodeDirection(int constrainedNodeId, double directionX,
@@ -546,4 +559,145 @@ const DOFS GapNodeDirection::getDOFSForNode(int nodePosition) const {
 	return dofs;
 }
 
+void SinglePointConstraintTable::add(int constraintSetId, int nodePosition, const DOFS& dofs,
+		double value) {
+	constraintSetIds.push_back(constraintSetId);
+	nodePositions.push_back(nodePosition);
+	dofsCodes.push_back(dofs);
+	values.push_back(value);
+}
+
+void SinglePointConstraintTable::add(int constraintSetId,
+		const SinglePointConstraint& groupConstraint) {
+	groupConstraints.push_back(groupConstraint);
+	groupConstraintSetIds.push_back(constraintSetId);
+}
+
+size_t SinglePointConstraintTable::size() const {
+	return nodePositions.size() + groupConstraints.size();
+}
+
+bool SinglePointConstraintTable::empty() const {
+	return nodePositions.empty() && groupConstraints.empty();
+}
+
+void SinglePointConstraintTable::clear() {
+	constraintSetIds.clear();
+	nodePositions.clear();
+	dofsCodes.clear();
+	values.clear();
+	groupConstraints.clear();
+	groupConstraintSetIds.clear();
+}
+
+vector<string> SinglePointConstraintTable::conflicts(const Model& model) const {
+	// a row for each DOF, with the nodes of the groups, sorted by constraint set and node
+	typedef tuple<int, int, int, double> DofRow;
+	vector<DofRow> dofRows;
+	dofRows.reserve(nodePositions.size());
+	for (size_t row = 0; row < nodePositions.size(); row++) {
+		for (const DOF dof : DOFS(dofsCodes[row])) {
+			dofRows.push_back(DofRow(constraintSetIds[row], nodePositions[row], dof.position,
+					values[row]));
+		}
+	}
+	for (size_t i = 0; i < groupConstraints.size(); i++) {
+		const SinglePointConstraint& spc = groupConstraints[i];
+		for (int nodePosition : spc.nodePositions()) {
+			for (const DOF dof : spc.getDOFSForNode(nodePosition)) {
+				dofRows.push_back(DofRow(groupConstraintSetIds[i], nodePosition, dof.position,
+						spc.getDoubleForDOF(dof)));
+			}
+		}
+	}
+	sort(dofRows.begin(), dofRows.end());
+	vector<string> result;
+	for (size_t begin = 0; begin < dofRows.size();) {
+		const int constraintSetId = get<0>(dofRows[begin]);
+		const int nodePosition = get<1>(dofRows[begin]);
+		DOFS conflictingDofs;
+		size_t end = begin + 1;
+		for (; end < dofRows.size() && get<0>(dofRows[end]) == constraintSetId
+				&& get<1>(dofRows[end]) == nodePosition; end++) {
+			const DofRow& previous = dofRows[end - 1];
+			if (get<2>(dofRows[end]) == get<2>(previous)
+					&& !is_equal(get<3>(dofRows[end]), get<3>(previous))) {
+				conflictingDofs = conflictingDofs + DOF::findByPosition(get<2>(previous));
+			}
+		}
+		if (conflictingDofs.size() > 0) {
+			ostringstream message;
+			message << "SPC set " << constraintSetId << " gives different values to DOFS "
+					<< conflictingDofs << " of node id "
+					<< model.mesh->findNode(nodePosition).id;
+			result.push_back(message.str());
+		}
+		begin = end;
+	}
+	return result;
+}
+
+size_t SinglePointConstraintTable::flush(Model& model) {
+	// rows sorted by constraint set, node and value, then in input order
+	vector<size_t> rows(nodePositions.size());
+	iota(rows.begin(), rows.end(), 0);
+	sort(rows.begin(), rows.end(), [this](size_t row1, size_t row2) {
+		return make_tuple(constraintSetIds[row1], nodePositions[row1], values[row1], row1)
+				< make_tuple(constraintSetIds[row2], nodePositions[row2], values[row2], row2);
+	});
+	// the merged rows with the same constraint set, DOFS and value make a constraint
+	typedef tuple<int, char, double> Key;
+	map<Key, size_t> constraintIndexByKey;
+	vector<Key> keys;
+	vector<size_t> firstRows;
+	vector<vector<int>> nodePositionsByConstraint;
+	for (size_t begin = 0; begin < rows.size();) {
+		const size_t first = rows[begin];
+		char dofsCode = 0;
+		size_t end = begin;
+		for (; end < rows.size(); end++) {
+			const size_t row = rows[end];
+			if (constraintSetIds[row] != constraintSetIds[first]
+					|| nodePositions[row] != nodePositions[first] || values[first] < values[row]) {
+				break;
+			}
+			dofsCode = static_cast<char>(dofsCode | dofsCodes[row]);
+		}
+		const Key key(constraintSetIds[first], dofsCode, values[first]);
+		auto inserted = constraintIndexByKey.insert(make_pair(key, keys.size()));
+		if (inserted.second) {
+			keys.push_back(key);
+			firstRows.push_back(first);
+			nodePositionsByConstraint.push_back(vector<int>());
+		} else {
+			firstRows[inserted.first->second] = min(firstRows[inserted.first->second], first);
+		}
+		// nodes come sorted inside a constraint set
+		nodePositionsByConstraint[inserted.first->second].push_back(nodePositions[first]);
+		begin = end;
+	}
+	vector<size_t> constraintIndexes(keys.size());
+	iota(constraintIndexes.begin(), constraintIndexes.end(), 0);
+	sort(constraintIndexes.begin(), constraintIndexes.end(), [&firstRows](size_t i1, size_t i2) {
+		return firstRows[i1] < firstRows[i2];
+	});
+	// created before the constraints of the rows, the constraints on a group come first
+	for (size_t i = 0; i < groupConstraints.size(); i++) {
+		model.add(groupConstraints[i]);
+		model.addConstraintIntoConstraintSet(groupConstraints[i],
+				Reference<ConstraintSet>(ConstraintSet::SPC, groupConstraintSetIds[i]));
+	}
+	for (size_t constraintIndex : constraintIndexes) {
+		const Key& key = keys[constraintIndex];
+		SinglePointConstraint spc(model, DOFS(get<1>(key)), get<2>(key));
+		spc.addNodePositions(nodePositionsByConstraint[constraintIndex]);
+		model.add(spc);
+		model.addConstraintIntoConstraintSet(spc,
+				Reference<ConstraintSet>(ConstraintSet::SPC, get<0>(key)));
+	}
+	const size_t constraintCount = keys.size() + groupConstraints.size();
+	clear();
+	return constraintCount;
+}
+
 } // namespace vega
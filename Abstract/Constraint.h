@@ -67,6 +67,7 @@ public:
 	static const std::string name;
 	static const std::map<Type, std::string> stringByType;
 	void add(const Reference<ConstraintSet>&);
+	const std::vector<Reference<ConstraintSet>>& getConstraintSetReferences() const;
 	const std::set<std::shared_ptr<Constraint> > getConstraints() const;
 	const std::set<std::shared_ptr<Constraint> > getConstraintsByType(Constraint::Type) const;
 	int size() const;
@@ -75,6 +76,7 @@ public:
 };
 
 class HomogeneousConstraint: public Constraint {
+	friend ModelSnapshot;
 protected:
 	DOFS dofs;
 	int masterPosition;
@@ -122,6 +124,7 @@ public:
 };
 
 class RBE3: public HomogeneousConstraint {
+	friend ModelSnapshot;
 	std::map<int, DOFS> slaveDofsByPosition;
 	std::map<int, double> slaveCoefByPosition;
 public:
@@ -136,6 +139,7 @@ public:
 };
 
 class SinglePointConstraint: public Constraint {
+	friend ModelSnapshot;
 	std::set<int> _nodePositions;
 	std::array<ValueOrReference, 6> spcs;
 public:
@@ -158,6 +162,10 @@ public:
 	Group* group;
 
 	void addNodeId(int nodeId);
+	/**
+	 * Adds nodes by their position in the mesh, faster when they are sorted.
+	 */
+	void addNodePositions(const std::vector<int>& nodePositions);
 	void setDOF(const DOF& dof, const ValueOrReference& value);
 	void setDOFS(const DOFS& dofs, const ValueOrReference& value);
 	double getDoubleForDOF(const DOF& dof) const;
@@ -230,6 +238,7 @@ public:
 
 class GapTwoNodes: public Gap {
 private:
+	friend ModelSnapshot;
 	std::map<int, int> directionNodePositionByconstrainedNodePosition;
 public:
 	GapTwoNodes(Model& model, int original_id = NO_ORIGINAL_ID);
@@ -244,6 +253,7 @@ public:
 
 class GapNodeDirection: public Gap {
 private:
+	friend ModelSnapshot;
 	std::map<int, VectorialValue> directionBynodePosition;
 public:
 	GapNodeDirection(Model& model, int original_id = NO_ORIGINAL_ID);
@@ -256,6 +266,72 @@ public:
 	void removeNode(int nodePosition) override;
 	bool ineffective() const override;
 };
+/**
+ * Single point constraints read node by node, as the SPC cards of Nastran, with a column by
+ * field until flush() adds them to the model at once. The rows of a constraint set giving the
+ * same value to a node are merged, then the nodes sharing the same DOFS and value get a single
+ * SinglePointConstraint, instead of one for each row.
+ *
+ * Constraints on a node group, as the SPC1 cards, are kept as they are but checked with the
+ * rows of their constraint set.
+ */
+class SinglePointConstraintTable final {
+private:
+	std::vector<int> constraintSetIds;
+	std::vector<int> nodePositions;
+	std::vector<char> dofsCodes;
+	std::vector<double> values;
+	/**
+	 * The constraints on a node group, with their constraint set.
+	 */
+	std::vector<SinglePointConstraint> groupConstraints;
+	std::vector<int> groupConstraintSetIds;
+public:
+	void add(int constraintSetId, int nodePosition, const DOFS& dofs, double value);
+	void add(int constraintSetId, const SinglePointConstraint& groupConstraint);
+	/**
+	 * The number of rows and of constraints on a node group.
+	 */
+	size_t size() const;
+	bool empty() const;
+	/**
+	 * Removes the rows without adding them to the model.
+	 */
+	void clear();
+	/**
+	 * Describes each node of a constraint set having a DOF given different values, by the
+	 * rows or by the constraints on a node group.
+	 */
+	std::vector<std::string> conflicts(const Model& model) const;
+	/**
+	 * Adds the constraints to the model, each one into the constraint set of type
+	 * ConstraintSet::SPC with the original id of its rows, and empties the table.
+	 *
+	 * The constraints on a node group are added first, then the others in the order of their
+	 * first row. Different values given to the same DOF of a node stay in different
+	 * constraints, see conflicts().
+	 *
+	 * @return the number of constraints added.
+	 */
+	size_t flush(Model& model);
+};
+
 } /* namespace vega */
 
+namespace std {
+
+/**
+ * Sets of constraints and of constraint sets are iterated in creation order, so that the
+ * writers do not depend on the addresses of the objects.
+ */
+template<>
+struct less<std::shared_ptr<vega::Constraint>> : vega::IdentifiableLess<vega::Constraint> {
+};
+
+template<>
+struct less<std::shared_ptr<vega::ConstraintSet>> : vega::IdentifiableLess<vega::ConstraintSet> {
+};
+
+} /* namespace std */
+
 #endif /* CONSTRAINT_H_ */
@@ -11,9 +11,43 @@
 
 #include "CoordinateSystem.h"
 #include "Model.h"
+#include <cmath>
 
 namespace vega {
 
+namespace {
+
+/**
+ * global = local[0] * u + local[1] * v + local[2] * w, local being read before global is
+ * written.
+ */
+inline void combine(const double* u, const double* v, const double* w, const double* local,
+		double* global) {
+	const double l0 = local[0];
+	const double l1 = local[1];
+	const double l2 = local[2];
+	global[0] = l0 * u[0] + l1 * v[0] + l2 * w[0];
+	global[1] = l0 * u[1] + l1 * v[1] + l2 * w[1];
+	global[2] = l0 * u[2] + l1 * v[2] + l2 * w[2];
+}
+
+inline void cross(const double* u, const double* v, double* result) {
+	result[0] = u[1] * v[2] - u[2] * v[1];
+	result[1] = u[2] * v[0] - u[0] * v[2];
+	result[2] = u[0] * v[1] - u[1] * v[0];
+}
+
+inline void normalize(double* u) {
+	const double norm = sqrt(u[0] * u[0] + u[1] * u[1] + u[2] * u[2]);
+	u[0] /= norm;
+	u[1] /= norm;
+	u[2] /= norm;
+}
+
+const double DEGREES_TO_RADIANS = M_PI / 180;
+
+}
+
 CoordinateSystem::CoordinateSystem(const Model& model, Type type, const VectorialValue origin,
 		const VectorialValue ex, const VectorialValue ey, int original_id) :
 		Identifiable(original_id), model(model), type(type), origin(origin), ex(ex.normalized()), ey(
@@ -34,6 +68,14 @@ ostream &operator<<(ostream &out, const CoordinateSystem& coordinateSystem) {
 	return out;
 }
 
+const VectorialValue CoordinateSystem::vectorToGlobalAt(const VectorialValue& point,
+		const VectorialValue& local) const {
+	const double pointCoordinates[3] = { point.x(), point.y(), point.z() };
+	double vector[3] = { local.x(), local.y(), local.z() };
+	vectorsToGlobal(pointCoordinates, vector, vector, 1);
+	return VectorialValue(vector[0], vector[1], vector[2]);
+}
+
 const VectorialValue CoordinateSystem::getEulerAnglesIntrinsicZYX() const {
 	double ax, ay, az = 0;
 	double cy = sqrt(ez.z() * ez.z() + ey.z() * ey.z());
@@ -61,8 +103,29 @@ const VectorialValue CartesianCoordinateSystem::vectorToGlobal(const VectorialVa
 	return VectorialValue(x, y, z);
 }
 
+void CartesianCoordinateSystem::vectorsToGlobal(const double*, const double* localVectors,
+		double* globalVectors, size_t count) const {
+	const double u[3] = { ex.x(), ex.y(), ex.z() };
+	const double v[3] = { ey.x(), ey.y(), ey.z() };
+	const double w[3] = { ez.x(), ez.y(), ez.z() };
+	for (size_t i = 0; i < 3 * count; i += 3) {
+		combine(u, v, w, localVectors + i, globalVectors + i);
+	}
+}
+
+void CartesianCoordinateSystem::pointsToGlobal(const double* localCoordinates,
+		double* globalCoordinates, size_t count) const {
+	const double o[3] = { origin.x(), origin.y(), origin.z() };
+	vectorsToGlobal(nullptr, localCoordinates, globalCoordinates, count);
+	for (size_t i = 0; i < 3 * count; i += 3) {
+		globalCoordinates[i] += o[0];
+		globalCoordinates[i + 1] += o[1];
+		globalCoordinates[i + 2] += o[2];
+	}
+}
+
 shared_ptr<CoordinateSystem> CartesianCoordinateSystem::clone() const {
-	return shared_ptr<CoordinateSystem>(new CartesianCoordinateSystem(*this));
+	return makeModelObject<CartesianCoordinateSystem>(model, *this);
 }
 
 CylindricalCoordinateSystem::CylindricalCoordinateSystem(const Model& model,
@@ -72,9 +135,21 @@ CylindricalCoordinateSystem::CylindricalCoordinateSystem(const Model& model,
 				this->ey) {
 }
 
+void CylindricalCoordinateSystem::localBaseAt(const double* point, double* ur,
+		double* utheta) const {
+	const double w[3] = { ez.x(), ez.y(), ez.z() };
+	const double d[3] = { point[0] - origin.x(), point[1] - origin.y(), point[2] - origin.z() };
+	cross(w, d, utheta);
+	normalize(utheta);
+	cross(utheta, w, ur);
+}
+
 void CylindricalCoordinateSystem::updateLocalBase(const VectorialValue& point) {
-	utheta = ez.cross(point - origin).normalized();
-	ur = utheta.cross(ez);
+	const double p[3] = { point.x(), point.y(), point.z() };
+	double u[3], v[3];
+	localBaseAt(p, u, v);
+	ur = VectorialValue(u[0], u[1], u[2]);
+	utheta = VectorialValue(v[0], v[1], v[2]);
 }
 
 const VectorialValue CylindricalCoordinateSystem::vectorToGlobal(
@@ -86,7 +161,98 @@ const VectorialValue CylindricalCoordinateSystem::vectorToGlobal(
 }
 
 shared_ptr<CoordinateSystem> CylindricalCoordinateSystem::clone() const {
-	return shared_ptr<CoordinateSystem>(new CylindricalCoordinateSystem(*this));
+	return makeModelObject<CylindricalCoordinateSystem>(model, *this);
+}
+
+void CylindricalCoordinateSystem::vectorsToGlobal(const double* points,
+		const double* localVectors, double* globalVectors, size_t count) const {
+	const double w[3] = { ez.x(), ez.y(), ez.z() };
+	double u[3], v[3];
+	for (size_t i = 0; i < 3 * count; i += 3) {
+		localBaseAt(points + i, u, v);
+		combine(u, v, w, localVectors + i, globalVectors + i);
+	}
+}
+
+void CylindricalCoordinateSystem::pointsToGlobal(const double* localCoordinates,
+		double* globalCoordinates, size_t count) const {
+	const double o[3] = { origin.x(), origin.y(), origin.z() };
+	const double u[3] = { ex.x(), ex.y(), ex.z() };
+	const double v[3] = { ey.x(), ey.y(), ey.z() };
+	const double w[3] = { ez.x(), ez.y(), ez.z() };
+	for (size_t i = 0; i < 3 * count; i += 3) {
+		const double r = localCoordinates[i];
+		const double theta = localCoordinates[i + 1] * DEGREES_TO_RADIANS;
+		const double cartesian[3] = { r * cos(theta), r * sin(theta), localCoordinates[i + 2] };
+		combine(u, v, w, cartesian, globalCoordinates + i);
+		globalCoordinates[i] += o[0];
+		globalCoordinates[i + 1] += o[1];
+		globalCoordinates[i + 2] += o[2];
+	}
+}
+
+SphericalCoordinateSystem::SphericalCoordinateSystem(const Model& model,
+		const VectorialValue origin, const VectorialValue ex, const VectorialValue ey,
+		int original_id) :
+		CoordinateSystem(model, SPHERICAL, origin, ex, ey, original_id), ur(this->ex), utheta(
+				-1 * this->ez), uphi(this->ey) {
+}
+
+void SphericalCoordinateSystem::localBaseAt(const double* point, double* ur, double* utheta,
+		double* uphi) const {
+	const double w[3] = { ez.x(), ez.y(), ez.z() };
+	ur[0] = point[0] - origin.x();
+	ur[1] = point[1] - origin.y();
+	ur[2] = point[2] - origin.z();
+	normalize(ur);
+	cross(w, ur, uphi);
+	normalize(uphi);
+	cross(uphi, ur, utheta);
+}
+
+void SphericalCoordinateSystem::updateLocalBase(const VectorialValue& point) {
+	const double p[3] = { point.x(), point.y(), point.z() };
+	double u[3], v[3], w[3];
+	localBaseAt(p, u, v, w);
+	ur = VectorialValue(u[0], u[1], u[2]);
+	utheta = VectorialValue(v[0], v[1], v[2]);
+	uphi = VectorialValue(w[0], w[1], w[2]);
+}
+
+const VectorialValue SphericalCoordinateSystem::vectorToGlobal(const VectorialValue& local) const {
+	return local.x() * ur + local.y() * utheta + local.z() * uphi;
+}
+
+void SphericalCoordinateSystem::vectorsToGlobal(const double* points,
+		const double* localVectors, double* globalVectors, size_t count) const {
+	double u[3], v[3], w[3];
+	for (size_t i = 0; i < 3 * count; i += 3) {
+		localBaseAt(points + i, u, v, w);
+		combine(u, v, w, localVectors + i, globalVectors + i);
+	}
+}
+
+void SphericalCoordinateSystem::pointsToGlobal(const double* localCoordinates,
+		double* globalCoordinates, size_t count) const {
+	const double o[3] = { origin.x(), origin.y(), origin.z() };
+	const double u[3] = { ex.x(), ex.y(), ex.z() };
+	const double v[3] = { ey.x(), ey.y(), ey.z() };
+	const double w[3] = { ez.x(), ez.y(), ez.z() };
+	for (size_t i = 0; i < 3 * count; i += 3) {
+		const double r = localCoordinates[i];
+		const double theta = localCoordinates[i + 1] * DEGREES_TO_RADIANS;
+		const double phi = localCoordinates[i + 2] * DEGREES_TO_RADIANS;
+		const double cartesian[3] = { r * sin(theta) * cos(phi), r * sin(theta) * sin(phi), r
+				* cos(theta) };
+		combine(u, v, w, cartesian, globalCoordinates + i);
+		globalCoordinates[i] += o[0];
+		globalCoordinates[i + 1] += o[1];
+		globalCoordinates[i + 2] += o[2];
+	}
+}
+
+shared_ptr<CoordinateSystem> SphericalCoordinateSystem::clone() const {
+	return makeModelObject<SphericalCoordinateSystem>(model, *this);
 }
 
 bool Orientation::operator ==(const Orientation& orientation) const {
@@ -121,6 +287,8 @@ VectY TwoNodesOrientation::toVectY() const {
 }
 
 shared_ptr<Orientation> TwoNodesOrientation::clone() const {
+	// held by the mesh for a cell, not by the model: kept out of the arena, which never
+	// gives memory back
 	return shared_ptr<Orientation>(new TwoNodesOrientation(*this));
 }
 
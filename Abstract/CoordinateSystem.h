@@ -51,6 +51,28 @@ class CoordinateSystem: public Identifiable<CoordinateSystem> {
 	virtual void updateLocalBase(const VectorialValue&) {
 	}
 	virtual const VectorialValue vectorToGlobal(const VectorialValue&) const = 0;
+	/**
+	 * Transforms count vectors given in the local base at the matching points to the global
+	 * base. points, localVectors and globalVectors hold (x, y, z) triples, the points in
+	 * global coordinates. globalVectors may be localVectors, and points may be nullptr if the
+	 * base does not depend on the point.
+	 *
+	 * The object is not changed: unlike updateLocalBase() followed by vectorToGlobal(), it
+	 * can be used by several threads at the same time.
+	 */
+	virtual void vectorsToGlobal(const double* points, const double* localVectors,
+			double* globalVectors, size_t count) const = 0;
+	/**
+	 * Transforms count points given by their coordinates in this system to global
+	 * coordinates, as (x, y, z) triples. globalCoordinates may be localCoordinates.
+	 */
+	virtual void pointsToGlobal(const double* localCoordinates, double* globalCoordinates,
+			size_t count) const = 0;
+	/**
+	 * A vector given in the local base at a point, in the global base.
+	 */
+	const VectorialValue vectorToGlobalAt(const VectorialValue& point,
+			const VectorialValue& local) const;
 	virtual const VectorialValue getEulerAnglesIntrinsicZYX() const;
 	virtual std::shared_ptr<CoordinateSystem> clone() const = 0;
 };
@@ -61,31 +83,60 @@ public:
 			const VectorialValue& ey, int original_id = NO_ORIGINAL_ID);
 
 	const VectorialValue vectorToGlobal(const VectorialValue&) const override;
+	void vectorsToGlobal(const double* points, const double* localVectors,
+			double* globalVectors, size_t count) const override;
+	void pointsToGlobal(const double* localCoordinates, double* globalCoordinates,
+			size_t count) const override;
 	std::shared_ptr<CoordinateSystem> clone() const override;
 };
 
+/**
+ * Local coordinates are (r, theta, z), theta in degrees. The local base at a point is
+ * (ur, utheta, ez).
+ */
 class CylindricalCoordinateSystem: public CoordinateSystem {
 	VectorialValue ur;
 	VectorialValue utheta;
+	/**
+	 * Computes ur and utheta, as (x, y, z), at a point given in global coordinates.
+	 */
+	void localBaseAt(const double* point, double* ur, double* utheta) const;
 	public:
 	CylindricalCoordinateSystem(const Model&, const VectorialValue origin, const VectorialValue ex,
 			const VectorialValue ey, int original_id = NO_ORIGINAL_ID);
 
 	void updateLocalBase(const VectorialValue&);
 	const VectorialValue vectorToGlobal(const VectorialValue&) const override;
+	void vectorsToGlobal(const double* points, const double* localVectors,
+			double* globalVectors, size_t count) const override;
+	void pointsToGlobal(const double* localCoordinates, double* globalCoordinates,
+			size_t count) const override;
 	std::shared_ptr<CoordinateSystem> clone() const override;
 };
 
+/**
+ * Local coordinates are (r, theta, phi), theta being the angle from ez and phi the angle
+ * from ex in the (ex, ey) plane, both in degrees. The local base at a point is
+ * (ur, utheta, uphi).
+ */
 class SphericalCoordinateSystem: public CoordinateSystem {
 	VectorialValue ur;
 	VectorialValue utheta;
 	VectorialValue uphi;
+	/**
+	 * Computes ur, utheta and uphi, as (x, y, z), at a point given in global coordinates.
+	 */
+	void localBaseAt(const double* point, double* ur, double* utheta, double* uphi) const;
 	public:
 	SphericalCoordinateSystem(const Model&, const VectorialValue origin, const VectorialValue ex,
 			const VectorialValue ey, int original_id = NO_ORIGINAL_ID);
 
 	void updateLocalBase(const VectorialValue&);
 	const VectorialValue vectorToGlobal(const VectorialValue&) const override;
+	void vectorsToGlobal(const double* points, const double* localVectors,
+			double* globalVectors, size_t count) const override;
+	void pointsToGlobal(const double* localCoordinates, double* globalCoordinates,
+			size_t count) const override;
 	std::shared_ptr<CoordinateSystem> clone() const override;
 };
 
@@ -67,6 +67,17 @@ const ModelType ElementSet::getModelType() const {
 	return this->model.modelType;
 }
 
+void ElementSet::addNodeDOFS(vector<char>& dofsByNodePosition) const {
+	for (int nodePosition : nodePositions()) {
+		const size_t position = static_cast<size_t>(nodePosition);
+		if (position >= dofsByNodePosition.size()) {
+			dofsByNodePosition.resize(position + 1, 0);
+		}
+		dofsByNodePosition[position] = static_cast<char>(dofsByNodePosition[position]
+				| getDOFSForNode(nodePosition));
+	}
+}
+
 bool ElementSet::validate() const {
 	bool validElement = true;
 
@@ -106,7 +117,7 @@ CircularSectionBeam::CircularSectionBeam(Model& model, double _radius, BeamModel
 }
 
 shared_ptr<ElementSet> CircularSectionBeam::clone() const {
-	return shared_ptr<ElementSet>(new CircularSectionBeam(*this));
+	return makeModelObject<CircularSectionBeam>(model, *this);
 }
 
 double CircularSectionBeam::getAreaCrossSection() const {
@@ -171,7 +182,7 @@ double RectangularSectionBeam::getShearAreaFactorZ() const {
 }
 
 shared_ptr<ElementSet> RectangularSectionBeam::clone() const {
-	return shared_ptr<ElementSet>(new RectangularSectionBeam(*this));
+	return makeModelObject<RectangularSectionBeam>(model, *this);
 }
 
 GenericSectionBeam::GenericSectionBeam(Model& model, double area_cross_section,
@@ -186,7 +197,7 @@ GenericSectionBeam::GenericSectionBeam(Model& model, double area_cross_section,
 }
 
 shared_ptr<ElementSet> GenericSectionBeam::clone() const {
-	return shared_ptr<ElementSet>(new GenericSectionBeam(*this));
+	return makeModelObject<GenericSectionBeam>(model, *this);
 }
 double GenericSectionBeam::getAreaCrossSection() const {
 	return area_cross_section;
@@ -273,7 +284,7 @@ DiscretePoint::DiscretePoint(Model& model, double x, double y, double z, double
 }
 
 shared_ptr<ElementSet> DiscretePoint::clone() const {
-	return shared_ptr<ElementSet>(new DiscretePoint(*this));
+	return makeModelObject<DiscretePoint>(model, *this);
 }
 
 void DiscretePoint::addComponent(DOF code, double value) {
@@ -343,7 +354,7 @@ DiscreteSegment::DiscreteSegment(Model& model, bool symmetric, int original_id)
 }
 
 shared_ptr<ElementSet> DiscreteSegment::clone() const {
-	return shared_ptr<ElementSet>(new DiscreteSegment(*this));
+	return makeModelObject<DiscreteSegment>(model, *this);
 }
 
 bool DiscreteSegment::hasTranslations() const {
@@ -578,7 +589,7 @@ const set<int> MatrixElement::nodePositions() const {
 const DOFS MatrixElement::getDOFSForNode(int nodePosition) const {
 	DOFS dofs;
 	for (auto& kv : submatrixByNodes) {
-		if (kv.first.first == nodePosition or kv.first.second) {
+		if (kv.first.first == nodePosition or kv.first.second == nodePosition) {
 			if (kv.second->hasRotations()) {
 				dofs += DOFS::ROTATIONS;
 			}
@@ -590,6 +601,26 @@ const DOFS MatrixElement::getDOFSForNode(int nodePosition) const {
 	return dofs;
 }
 
+void MatrixElement::addNodeDOFS(vector<char>& dofsByNodePosition) const {
+	// a single pass over the submatrices instead of one per node
+	for (auto& kv : submatrixByNodes) {
+		DOFS dofs;
+		if (kv.second->hasRotations()) {
+			dofs += DOFS::ROTATIONS;
+		}
+		if (kv.second->hasTranslations()) {
+			dofs += DOFS::TRANSLATIONS;
+		}
+		for (int nodePosition : { kv.first.first, kv.first.second }) {
+			const size_t position = static_cast<size_t>(nodePosition);
+			if (position >= dofsByNodePosition.size()) {
+				dofsByNodePosition.resize(position + 1, 0);
+			}
+			dofsByNodePosition[position] = static_cast<char>(dofsByNodePosition[position] | dofs);
+		}
+	}
+}
+
 const set<pair<int, int>> MatrixElement::nodePairs() const {
 	set<pair<int, int>> result;
 	for (auto& kv : submatrixByNodes) {
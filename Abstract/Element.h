@@ -14,6 +14,7 @@
 #include "Material.h"
 #include "Mesh.h"
 #include "Dof.h"
+#include "ModelArena.h"
 
 #include <fstream>
 #include <boost/lexical_cast.hpp>
@@ -86,6 +87,11 @@ public:
 		return cellGroup->nodePositions();
 	}
 	virtual const DOFS getDOFSForNode(int nodePosition) const = 0;
+	/**
+	 * Adds the DOFS of the nodes of the element set to dofsByNodePosition, DOFS codes indexed
+	 * by node position.
+	 */
+	virtual void addNodeDOFS(std::vector<char>& dofsByNodePosition) const;
 	virtual double getAdditionalRho() const {
 		return 0;
 	}
@@ -116,6 +122,9 @@ public:
 	Beam(Model&, Type type, ModelType* modelType = nullptr, BeamModel beamModel = EULER,
 			double additionalMass = 0.0, int original_id = NO_ORIGINAL_ID);
 	public:
+	double getAdditionalMass() const {
+		return additional_mass;
+	}
 	double getAdditionalRho() const {
 		return additional_mass / std::max(getAreaCrossSection(), DBL_MIN);
 	}
@@ -151,6 +160,7 @@ public:
 
 class GenericSectionBeam: public Beam {
 private:
+	friend ModelSnapshot;
 	const double area_cross_section;
 	const double moment_of_inertia_Y;
 	const double moment_of_inertia_Z;
@@ -214,7 +224,7 @@ public:
 			int original_id = NO_ORIGINAL_ID);
 
 	std::shared_ptr<ElementSet> clone() const override {
-		return std::shared_ptr<ElementSet>(new ISectionBeam(*this));
+		return makeModelObject<ISectionBeam>(model, *this);
 	}
 
 	double getAreaCrossSection() const override;
@@ -236,7 +246,10 @@ public:
 	public:
 	Shell(Model&, double thickness, double additional_mass = 0, int original_id = NO_ORIGINAL_ID);
 	std::shared_ptr<ElementSet> clone() const override {
-		return std::shared_ptr<ElementSet>(new Shell(*this));
+		return makeModelObject<Shell>(model, *this);
+	}
+	double getAdditionalMass() const {
+		return additional_mass;
 	}
 	double getAdditionalRho() const {
 		return additional_mass / std::max(thickness, DBL_MIN);
@@ -254,7 +267,7 @@ class Continuum: public ElementSet {
 public:
 	Continuum(Model&, const ModelType* modelType, int original_id = NO_ORIGINAL_ID);
 	std::shared_ptr<ElementSet> clone() const override {
-		return std::shared_ptr<ElementSet>(new Continuum(*this));
+		return makeModelObject<Continuum>(model, *this);
 	}
 	const DOFS getDOFSForNode(int nodePosition) const override final;
 	virtual ~Continuum() {
@@ -278,6 +291,7 @@ public:
 
 class DiscretePoint final: public Discrete {
 private:
+	friend ModelSnapshot;
 	DOFMatrix stiffness;
 	DOFMatrix mass;
 	DOFMatrix damping;
@@ -297,6 +311,7 @@ public:
 
 class DiscreteSegment final : public Discrete {
 private:
+	friend ModelSnapshot;
 	DOFMatrix stiffness[2][2];
 	DOFMatrix mass[2][2];
 	DOFMatrix damping[2][2];
@@ -312,6 +327,7 @@ public:
 };
 
 class NodalMass: public ElementSet {
+	friend ModelSnapshot;
 	const double m;
 	public:
 	const double ixx;
@@ -342,13 +358,14 @@ class NodalMass: public ElementSet {
 	~NodalMass();
 
 	inline std::shared_ptr<ElementSet> clone() const {
-		return std::shared_ptr<ElementSet>(new NodalMass(*this));
+		return makeModelObject<NodalMass>(model, *this);
 	}
 };
 
 /* Matrix for a group nodes.*/
 class MatrixElement : public ElementSet {
 private:
+	friend ModelSnapshot;
 	std::map<std::pair<int, int>, shared_ptr<DOFMatrix>> submatrixByNodes;
 	bool symmetric = false;
 public:
@@ -359,6 +376,7 @@ public:
 	const std::set<std::pair<int, int>> nodePairs() const;
 	const std::set<std::pair<int, int>> findInPairs(int nodePosition) const;
 	const DOFS getDOFSForNode(int nodePosition) const override final;
+	void addNodeDOFS(std::vector<char>& dofsByNodePosition) const override final;
 	bool isMatrixElement() const override final {
 		return true;
 	}
@@ -374,7 +392,7 @@ public:
 	StiffnessMatrix(Model&, int original_id = NO_ORIGINAL_ID);
 	void addStiffness(const int nodeid1, const DOF dof1, const int nodeid2, const DOF dof2, const double stiffness);
 	std::shared_ptr<ElementSet> clone() const override {
-		return std::shared_ptr<ElementSet>(new StiffnessMatrix(*this));
+		return makeModelObject<StiffnessMatrix>(model, *this);
 	}
 };
 
@@ -382,7 +400,7 @@ class MassMatrix : public MatrixElement {
 public:
 	MassMatrix(Model&, int original_id = NO_ORIGINAL_ID);
 	std::shared_ptr<ElementSet> clone() const override {
-		return std::shared_ptr<ElementSet>(new MassMatrix(*this));
+		return makeModelObject<MassMatrix>(model, *this);
 	}
 };
 
@@ -391,7 +409,7 @@ public:
 	DampingMatrix(Model&, int original_id = NO_ORIGINAL_ID);
 	void addDamping(const int nodeid1, const DOF dof1, const int nodeid2, const DOF dof2, const double damping);
 	std::shared_ptr<ElementSet> clone() const override {
-		return std::shared_ptr<ElementSet>(new DampingMatrix(*this));
+		return makeModelObject<DampingMatrix>(model, *this);
 	}
 };
 
@@ -10,6 +10,7 @@
 
 #include "Loading.h"
 #include "Model.h"
+#include <algorithm>
 #include <boost/lexical_cast.hpp>
 //if with "or" and "and" under windows
 #include <ciso646>
@@ -103,7 +104,7 @@ bool LoadSet::validate() const {
 }
 
 shared_ptr<LoadSet> LoadSet::clone() const {
-	return shared_ptr<LoadSet>(new LoadSet(*this));
+	return makeModelObject<LoadSet>(model, *this);
 }
 
 Gravity::Gravity(const Model& model, double acceleration, const VectorialValue& direction,
@@ -143,7 +144,7 @@ double Gravity::getAccelerationScale() const {
 }
 
 shared_ptr<Loading> Gravity::clone() const {
-	return shared_ptr<Loading>(new Gravity(*this));
+	return makeModelObject<Gravity>(model, *this);
 }
 
 void Gravity::scale(double factor) {
@@ -190,7 +191,7 @@ const VectorialValue RotationCenter::getCenter() const {
 }
 
 shared_ptr<Loading> RotationCenter::clone() const {
-	return shared_ptr<Loading>(new RotationCenter(*this));
+	return makeModelObject<RotationCenter>(model, *this);
 }
 
 void RotationCenter::scale(double factor) {
@@ -216,8 +217,12 @@ const VectorialValue RotationNode::getCenter() const {
 	return VectorialValue(node.x, node.y, node.z);
 }
 
+int RotationNode::getNodePosition() const {
+	return node_position;
+}
+
 shared_ptr<Loading> RotationNode::clone() const {
-	return shared_ptr<Loading>(new RotationNode(*this));
+	return makeModelObject<RotationNode>(model, *this);
 }
 
 void RotationNode::scale(double factor) {
@@ -255,8 +260,7 @@ const VectorialValue NodalForce::localToGlobal(const VectorialValue& vectorialVa
 		throw logic_error(oss.str());
 	}
 	Node node = getNode();
-	coordSystem->updateLocalBase(VectorialValue(node.x, node.y, node.z));
-	return coordSystem->vectorToGlobal(vectorialValue);
+	return coordSystem->vectorToGlobalAt(VectorialValue(node.x, node.y, node.z), vectorialValue);
 }
 
 Node NodalForce::getNode() const {
@@ -271,6 +275,14 @@ const VectorialValue NodalForce::getMoment() const {
 	return localToGlobal(moment);
 }
 
+const VectorialValue NodalForce::getLocalForce() const {
+	return force;
+}
+
+const VectorialValue NodalForce::getLocalMoment() const {
+	return moment;
+}
+
 const DOFS NodalForce::getDOFSForNode(int nodePosition) const {
 	DOFS dofs(DOFS::NO_DOFS);
 	if (nodePosition == node_position) {
@@ -295,7 +307,7 @@ set<int> NodalForce::nodePositions() const {
 }
 
 shared_ptr<Loading> NodalForce::clone() const {
-	return shared_ptr<Loading>(new NodalForce(*this));
+	return makeModelObject<NodalForce>(model, *this);
 }
 
 void NodalForce::scale(double factor) {
@@ -322,8 +334,20 @@ const VectorialValue NodalForceTwoNodes::getForce() const {
 	return magnitude * direction;
 }
 
+Node NodalForceTwoNodes::getNode1() const {
+	return model.mesh->findNode(node_position1);
+}
+
+Node NodalForceTwoNodes::getNode2() const {
+	return model.mesh->findNode(node_position2);
+}
+
+double NodalForceTwoNodes::getMagnitude() const {
+	return magnitude;
+}
+
 shared_ptr<Loading> NodalForceTwoNodes::clone() const {
-	return shared_ptr<Loading>(new NodalForceTwoNodes(*this));
+	return makeModelObject<NodalForceTwoNodes>(model, *this);
 }
 
 void NodalForceTwoNodes::scale(double factor) {
@@ -340,7 +364,8 @@ ElementLoading::ElementLoading(const Model& model, Loading::Type type, int origi
 }
 
 set<int> ElementLoading::nodePositions() const {
-	return CellContainer::nodePositions();
+	const vector<int>& nodePositions = CellContainer::nodePositions();
+	return set<int>(nodePositions.begin(), nodePositions.end());
 }
 
 bool ElementLoading::cellDimensionGreatherThan(SpaceDimension dimension) {
@@ -408,8 +433,8 @@ const VectorialValue ForceSurface::getMoment() const {
 
 const DOFS ForceSurface::getDOFSForNode(int nodePosition) const {
 	DOFS dofs(DOFS::NO_DOFS);
-	set<int> nodes = nodePositions();
-	if (nodes.find(nodePosition) != nodes.end()) {
+	const vector<int>& nodes = CellContainer::nodePositions();
+	if (binary_search(nodes.begin(), nodes.end(), nodePosition)) {
 		if (!is_zero(force.x()))
 			dofs = dofs + DOF::DX;
 		if (!is_zero(force.y()))
@@ -427,7 +452,7 @@ const DOFS ForceSurface::getDOFSForNode(int nodePosition) const {
 }
 
 shared_ptr<Loading> ForceSurface::clone() const {
-	return shared_ptr<Loading>(new ForceSurface(*this));
+	return makeModelObject<ForceSurface>(model, *this);
 }
 
 void ForceSurface::scale(double factor) {
@@ -469,8 +494,8 @@ ForceLine::ForceLine(const Model& model, const VectorialValue& force, const Vect
 
 const DOFS ForceLine::getDOFSForNode(int nodePosition) const {
 	DOFS dofs(DOFS::NO_DOFS);
-	set<int> nodes = nodePositions();
-	if (nodes.find(nodePosition) != nodes.end()) {
+	const vector<int>& nodes = CellContainer::nodePositions();
+	if (binary_search(nodes.begin(), nodes.end(), nodePosition)) {
 		if (!is_zero(force.x()))
 			dofs = dofs + DOF::DX;
 		if (!is_zero(force.y()))
@@ -488,7 +513,7 @@ const DOFS ForceLine::getDOFSForNode(int nodePosition) const {
 }
 
 shared_ptr<Loading> ForceLine::clone() const {
-	return shared_ptr<Loading>(new ForceLine(*this));
+	return makeModelObject<ForceLine>(model, *this);
 }
 
 void ForceLine::scale(double factor) {
@@ -505,7 +530,7 @@ bool ForceLine::validate() const {
 }
 
 shared_ptr<Loading> PressionFaceTwoNodes::clone() const {
-	return shared_ptr<Loading>(new PressionFaceTwoNodes(*this));
+	return makeModelObject<PressionFaceTwoNodes>(model, *this);
 }
 
 NormalPressionFace::NormalPressionFace(const Model& model, double intensity, const int original_id) :
@@ -515,15 +540,15 @@ NormalPressionFace::NormalPressionFace(const Model& model, double intensity, con
 
 const DOFS NormalPressionFace::getDOFSForNode(int nodePosition) const {
 	DOFS dofs(DOFS::NO_DOFS);
-	set<int> nodes = nodePositions();
-	if (nodes.find(nodePosition) != nodes.end()) {
+	const vector<int>& nodes = CellContainer::nodePositions();
+	if (binary_search(nodes.begin(), nodes.end(), nodePosition)) {
 		dofs += DOFS::ALL_DOFS;
 	}
 	return dofs;
 }
 
 shared_ptr<Loading> NormalPressionFace::clone() const {
-	return shared_ptr<Loading>(new NormalPressionFace(*this));
+	return makeModelObject<NormalPressionFace>(model, *this);
 }
 
 void NormalPressionFace::scale(double factor) {
@@ -550,6 +575,18 @@ shared_ptr<DynaPhase> DynamicExcitation::getDynaPhase() const {
 	return dynamic_pointer_cast<DynaPhase>(model.find(dynaPhase));
 }
 
+const Reference<Value>& DynamicExcitation::getDynaPhaseReference() const {
+	return dynaPhase;
+}
+
+const Reference<Value>& DynamicExcitation::getFunctionTableBReference() const {
+	return functionTableB;
+}
+
+const Reference<LoadSet>& DynamicExcitation::getLoadSetReference() const {
+	return loadSet;
+}
+
 shared_ptr<FunctionTable> DynamicExcitation::getFunctionTableB() const {
 	return dynamic_pointer_cast<FunctionTable>(model.find(functionTableB));
 }
@@ -572,7 +609,7 @@ const DOFS DynamicExcitation::getDOFSForNode(int nodePosition) const {
 }
 
 shared_ptr<Loading> DynamicExcitation::clone() const {
-	return shared_ptr<Loading>(new DynamicExcitation(*this));
+	return makeModelObject<DynamicExcitation>(model, *this);
 }
 
 bool DynamicExcitation::validate() const {
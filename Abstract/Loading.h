@@ -173,6 +173,7 @@ class RotationNode: public Rotation {
 	double getSpeed() const;
 	const VectorialValue getAxis() const;
 	const VectorialValue getCenter() const;
+	int getNodePosition() const;
 	std::shared_ptr<Loading> clone() const override;
 	void scale(double factor) override;
 };
@@ -199,6 +200,11 @@ public:
 	Node getNode() const;
 	virtual const VectorialValue getForce() const;
 	virtual const VectorialValue getMoment() const;
+	/**
+	 * Force and moment as given, in the coordinate system of the loading.
+	 */
+	const VectorialValue getLocalForce() const;
+	const VectorialValue getLocalMoment() const;
 	const DOFS getDOFSForNode(int nodePosition) const override;
 	std::set<int> nodePositions() const override;
 	std::shared_ptr<Loading> clone() const override;
@@ -214,6 +220,9 @@ class NodalForceTwoNodes: public NodalForce {
 	NodalForceTwoNodes(const Model&, const int node_id, const int node1_id, const int node2_id,
 			double magnitude, const int original_id = NO_ORIGINAL_ID);
 	const VectorialValue getForce() const;
+	Node getNode1() const;
+	Node getNode2() const;
+	double getMagnitude() const;
 	std::shared_ptr<Loading> clone() const;
 	void scale(double factor) override;
 	bool ineffective() const override;
@@ -334,6 +343,9 @@ private:
 	std::shared_ptr<DynaPhase> getDynaPhase() const;
 	std::shared_ptr<FunctionTable> getFunctionTableB() const;
 	std::shared_ptr<LoadSet> getLoadSet() const;
+	const Reference<Value>& getDynaPhaseReference() const;
+	const Reference<Value>& getFunctionTableBReference() const;
+	const Reference<LoadSet>& getLoadSetReference() const;
 	const ValuePlaceHolder getFunctionTableBPlaceHolder() const;
 	std::set<int> nodePositions() const override;
 	const DOFS getDOFSForNode(int nodePosition) const override;
@@ -344,4 +356,19 @@ private:
 
 } /* namespace vega */
 
+namespace std {
+
+/**
+ * Sets of loadings and of load sets are iterated in creation order, see Constraint.h.
+ */
+template<>
+struct less<std::shared_ptr<vega::Loading>> : vega::IdentifiableLess<vega::Loading> {
+};
+
+template<>
+struct less<std::shared_ptr<vega::LoadSet>> : vega::IdentifiableLess<vega::LoadSet> {
+};
+
+} /* namespace std */
+
 #endif /* LOADING_H_ */
@@ -37,7 +37,7 @@ Material::Material(Model* model, int original_id) :
 }
 
 shared_ptr<Material> Material::clone() const {
-	return shared_ptr<Material>(new Material(*this));
+	return makeModelObject<Material>(*model, *this);
 }
 
 bool Material::validate() const {
@@ -64,6 +64,10 @@ void Material::addNature(const Nature &nature) {
 	nature_by_type[nature.type] = nature.clone();
 }
 
+const map<Nature::NatureType, shared_ptr<Nature>>& Material::getNatures() const {
+	return nature_by_type;
+}
+
 const shared_ptr<Nature> Material::findNature(const Nature::NatureType natureType) const {
 	shared_ptr<Nature> nature;
 	auto it = nature_by_type.find(natureType);
@@ -84,7 +88,7 @@ Nature::~Nature() {
 }
 
 shared_ptr<Nature> ElasticNature::clone() const {
-	return shared_ptr<Nature>(new ElasticNature(*this));
+	return makeModelObject<ElasticNature>(model, *this);
 }
 
 ElasticNature::~ElasticNature() {
@@ -147,7 +151,7 @@ double ElasticNature::getTref() const {
 }
 
 shared_ptr<Nature> BilinearElasticNature::clone() const {
-	return shared_ptr<Nature>(new BilinearElasticNature(*this));
+	return makeModelObject<BilinearElasticNature>(model, *this);
 }
 
 BilinearElasticNature::~BilinearElasticNature() {
@@ -165,7 +169,7 @@ BilinearElasticNature::BilinearElasticNature(const Model& model) :
 }
 
 shared_ptr<Nature> NonLinearElasticNature::clone() const {
-	return shared_ptr<Nature>(new NonLinearElasticNature(*this));
+	return makeModelObject<NonLinearElasticNature>(model, *this);
 }
 
 NonLinearElasticNature::~NonLinearElasticNature() {
@@ -183,10 +187,20 @@ NonLinearElasticNature::NonLinearElasticNature(const Model& model,
 		Nature(model, NATURE_NONLINEAR_ELASTIC), stress_strain_function_ref(stress_strain_function) {
 }
 
+NonLinearElasticNature::NonLinearElasticNature(const Model& model,
+		const Reference<Value>& stress_strain_function_ref) :
+		Nature(model, NATURE_NONLINEAR_ELASTIC), stress_strain_function_ref(
+				stress_strain_function_ref) {
+}
+
 shared_ptr<FunctionTable> NonLinearElasticNature::getStressStrainFunction() const {
 	return dynamic_pointer_cast<FunctionTable>(model.find(stress_strain_function_ref));
 }
 
+const Reference<Value>& NonLinearElasticNature::getStressStrainFunctionReference() const {
+	return stress_strain_function_ref;
+}
+
 CellContainer Material::getAssignment() const {
 	return this->model->getMaterialAssignment(this->getId());
 }
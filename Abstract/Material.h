@@ -45,6 +45,7 @@ public:
 };
 
 class ElasticNature: public Nature {
+	friend ModelSnapshot;
 	double e;
 	double nu;
 	double g;
@@ -98,7 +99,9 @@ class NonLinearElasticNature: public Nature {
 public:
 	NonLinearElasticNature(const Model&, const FunctionTable& stress_strain_function);
 	NonLinearElasticNature(const Model&, const int stress_strain_function_id);
+	NonLinearElasticNature(const Model&, const Reference<Value>& stress_strain_function_ref);
 	std::shared_ptr<FunctionTable> getStressStrainFunction() const;
+	const Reference<Value>& getStressStrainFunctionReference() const;
 	virtual std::shared_ptr<Nature> clone() const;
 	virtual ~NonLinearElasticNature();
 
@@ -121,6 +124,7 @@ public:
 	Material(Model* model, int material_id = NO_ORIGINAL_ID);
 	void addNature(const Nature &nature);
 	const std::shared_ptr<Nature> findNature(Nature::NatureType) const;
+	const std::map<Nature::NatureType, std::shared_ptr<Nature>>& getNatures() const;
 	virtual bool validate() const override;
 	virtual std::shared_ptr<Material> clone() const;
 	/**
@@ -9,6 +9,8 @@
  */
 
 #include "Mesh.h"
+#include "PassScheduler.h"
+#include "Profiler.h"
 
 #ifdef __GNUC__
 #include <valgrind/memcheck.h>
@@ -30,6 +32,7 @@
 #include <set>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -41,12 +44,215 @@ namespace fs = boost::filesystem;
 
 const double NodeStorage::RESERVED_POSITION = -DBL_MAX;
 
+/**
+ * Id to position index
+ */
+const int PositionById::EMPTY;
+const int PositionById::NOT_FOUND;
+const int PositionById::MAX_SPARSITY;
+const int PositionById::DENSE_SLACK;
+
+PositionById::PositionById() :
+		denseBase(0), denseCount(0), hashCount(0), hashShift(32), nextRebalance(DENSE_SLACK) {
+}
+
+bool PositionById::fitsDense(long long first, long long last, size_t count) const {
+	return last - first + 1
+			<= static_cast<long long>(MAX_SPARSITY * count + DENSE_SLACK);
+}
+
+size_t PositionById::hashSlot(int id) const {
+	// Fibonacci hashing: consecutive ids are spread over the whole table
+	return (static_cast<unsigned int>(id) * 2654435769u) >> hashShift;
+}
+
+int PositionById::find(int id) const {
+	const long long offset = static_cast<long long>(id) - denseBase;
+	if (offset >= 0 && offset < static_cast<long long>(densePositions.size())) {
+		const int position = densePositions[static_cast<size_t>(offset)];
+		if (position != EMPTY) {
+			return position;
+		}
+	}
+	if (hashCount == 0) {
+		return NOT_FOUND;
+	}
+	const size_t mask = hashIds.size() - 1;
+	for (size_t slot = hashSlot(id);; slot = (slot + 1) & mask) {
+		if (hashIds[slot] == id) {
+			return hashPositions[slot];
+		}
+		if (hashIds[slot] == EMPTY) {
+			return NOT_FOUND;
+		}
+	}
+}
+
+void PositionById::insertInHash(int id, int position) {
+	if (2 * (hashCount + 1) > hashIds.size()) {
+		vector<int> oldIds;
+		vector<int> oldPositions;
+		oldIds.swap(hashIds);
+		oldPositions.swap(hashPositions);
+		const size_t capacity = max(static_cast<size_t>(64), 2 * oldIds.size());
+		hashIds.assign(capacity, EMPTY);
+		hashPositions.assign(capacity, EMPTY);
+		hashShift = 32;
+		for (size_t c = capacity; c > 1; c >>= 1) {
+			hashShift--;
+		}
+		hashCount = 0;
+		for (size_t i = 0; i < oldIds.size(); i++) {
+			if (oldIds[i] != EMPTY) {
+				insertInHash(oldIds[i], oldPositions[i]);
+			}
+		}
+	}
+	const size_t mask = hashIds.size() - 1;
+	size_t slot = hashSlot(id);
+	while (hashIds[slot] != EMPTY && hashIds[slot] != id) {
+		slot = (slot + 1) & mask;
+	}
+	if (hashIds[slot] == EMPTY) {
+		hashIds[slot] = id;
+		hashCount++;
+	}
+	hashPositions[slot] = position;
+}
+
+void PositionById::insertInDense(int id, int position) {
+	if (densePositions.empty()) {
+		denseBase = id;
+		densePositions.push_back(EMPTY);
+	} else if (id < denseBase) {
+		// leave some room below, so that decreasing ids don't shift the table every time
+		const long long last = static_cast<long long>(denseBase) + densePositions.size() - 1;
+		const long long room = static_cast<long long>(densePositions.size() / 2);
+		long long first = max(static_cast<long long>(id) - room, static_cast<long long>(INT_MIN) + 1);
+		if (!fitsDense(first, last, denseCount + 1)) {
+			first = id;
+		}
+		densePositions.insert(densePositions.begin(), static_cast<size_t>(denseBase - first),
+				EMPTY);
+		denseBase = static_cast<int>(first);
+	}
+	const size_t offset = static_cast<size_t>(static_cast<long long>(id) - denseBase);
+	if (offset >= densePositions.size()) {
+		densePositions.resize(offset + 1, EMPTY);
+	}
+	int& slot = densePositions[offset];
+	if (slot == EMPTY) {
+		denseCount++;
+	}
+	slot = position;
+}
+
+void PositionById::set(int id, int position) {
+	if (id == EMPTY) {
+		throw invalid_argument("Id " + to_string(id) + " is reserved.");
+	}
+	if (hashCount > 0) {
+		const size_t mask = hashIds.size() - 1;
+		for (size_t slot = hashSlot(id); hashIds[slot] != EMPTY; slot = (slot + 1) & mask) {
+			if (hashIds[slot] == id) {
+				hashPositions[slot] = position;
+				return;
+			}
+		}
+	}
+	long long first = id;
+	long long last = id;
+	if (!densePositions.empty()) {
+		first = min(first, static_cast<long long>(denseBase));
+		last = max(last, static_cast<long long>(denseBase) + static_cast<long long>(densePositions.size()) - 1);
+	}
+	if (fitsDense(first, last, denseCount + 1)) {
+		insertInDense(id, position);
+	} else {
+		insertInHash(id, position);
+		if (hashCount >= nextRebalance) {
+			rebalance();
+		}
+	}
+}
+
+size_t PositionById::size() const {
+	return denseCount + hashCount;
+}
+
+bool PositionById::isDense() const {
+	return hashCount == 0;
+}
+
+void PositionById::rebalance() {
+	if (hashCount == 0) {
+		return;
+	}
+	vector<pair<int, int>> positionsById;
+	positionsById.reserve(size());
+	for (size_t i = 0; i < densePositions.size(); i++) {
+		if (densePositions[i] != EMPTY) {
+			const int id = static_cast<int>(denseBase + static_cast<long long>(i));
+			positionsById.push_back(make_pair(id, densePositions[i]));
+		}
+	}
+	for (size_t i = 0; i < hashIds.size(); i++) {
+		if (hashIds[i] != EMPTY) {
+			positionsById.push_back(make_pair(hashIds[i], hashPositions[i]));
+		}
+	}
+	sort(positionsById.begin(), positionsById.end());
+	// sliding window over the sorted ids: find the largest run that fits a dense table
+	size_t bestFirst = 0;
+	size_t bestCount = 0;
+	for (size_t first = 0, last = 0; last < positionsById.size(); last++) {
+		while (!fitsDense(positionsById[first].first, positionsById[last].first,
+				last - first + 1)) {
+			first++;
+		}
+		if (last - first + 1 > bestCount) {
+			bestFirst = first;
+			bestCount = last - first + 1;
+		}
+	}
+	densePositions.clear();
+	denseCount = 0;
+	hashIds.clear();
+	hashPositions.clear();
+	hashCount = 0;
+	hashShift = 32;
+	for (size_t i = 0; i < positionsById.size(); i++) {
+		if (i >= bestFirst && i < bestFirst + bestCount) {
+			insertInDense(positionsById[i].first, positionsById[i].second);
+		} else {
+			insertInHash(positionsById[i].first, positionsById[i].second);
+		}
+	}
+	nextRebalance = max(static_cast<size_t>(DENSE_SLACK), 2 * size());
+}
+
 /**
  * Node Container class
  */
 NodeStorage::NodeStorage(Mesh* mesh, LogLevel logLevel) :
 		logLevel(logLevel), mesh(mesh) {
-	nodeDatas.reserve(4096);
+	ids.reserve(4096);
+	dofs.reserve(4096);
+	coordinates.reserve(3 * 4096);
+	displacementCSs.reserve(4096);
+	positionCSs.reserve(4096);
+}
+
+const vector<double>& NodeStorage::getCoordinates() const {
+	return coordinates;
+}
+
+const vector<int>& NodeStorage::getIds() const {
+	return ids;
+}
+
+const vector<char>& NodeStorage::getDOFS() const {
+	return dofs;
 }
 
 NodeIterator NodeStorage::begin() const {
@@ -54,13 +260,13 @@ NodeIterator NodeStorage::begin() const {
 }
 
 NodeIterator NodeStorage::end() const {
-	return NodeIterator(this, static_cast<int>(nodeDatas.size()));
+	return NodeIterator(this, static_cast<int>(ids.size()));
 }
 
 int NodeStorage::reserveNodePosition(int nodeId) {
 	int nodePosition = mesh->addNode(nodeId, RESERVED_POSITION, RESERVED_POSITION,
 			RESERVED_POSITION);
-	nodepositionById[nodeId] = nodePosition;
+	nodepositionById.set(nodeId, nodePosition);
 	if (this->logLevel >= LogLevel::TRACE) {
 		cout << "Reserve node id:" << nodeId << " position:" << nodePosition << endl;
 	}
@@ -72,37 +278,61 @@ CellData::CellData(int id, CellType type, bool isvirtual, int elementId, int cel
 				elementId), cellTypePosition(cellTypePosition) {
 }
 
-int Mesh::addNode(int id, double x, double y, double z, int cd_id) {
+int Mesh::addNode(int id, double x, double y, double z, int cd_id, int cp_id) {
 	int nodePosition;
 	if (id == Node::AUTO_ID)
 		id = Node::auto_node_id--;
-	auto positionIterator = nodes.nodepositionById.find(id);
-	if (positionIterator == nodes.nodepositionById.end()) {
-		nodePosition = static_cast<int>(nodes.nodeDatas.size());
-		NodeData nodeData;
-
-		nodeData.id = id;
-		nodeData.x = x;
-		nodeData.y = y;
-		nodeData.z = z;
-		nodeData.dofs = DOFS::NO_DOFS;
-		nodeData.displacementCS = cd_id;
-		nodes.nodeDatas.push_back(nodeData);
-		nodes.nodepositionById[id] = nodePosition;
+	nodePosition = nodes.nodepositionById.find(id);
+	if (nodePosition == PositionById::NOT_FOUND) {
+		nodePosition = static_cast<int>(nodes.ids.size());
+		nodes.ids.push_back(id);
+		nodes.dofs.push_back(DOFS::NO_DOFS);
+		nodes.coordinates.push_back(x);
+		nodes.coordinates.push_back(y);
+		nodes.coordinates.push_back(z);
+		nodes.displacementCSs.push_back(cd_id);
+		nodes.positionCSs.push_back(cp_id);
+		nodes.nodepositionById.set(id, nodePosition);
 	} else {
-		nodePosition = positionIterator->second;
-		NodeData& nodeData = nodes.nodeDatas[nodePosition];
-		nodeData.x = x;
-		nodeData.y = y;
-		nodeData.z = z;
-		nodeData.displacementCS = cd_id;
+		double* xyz = &nodes.coordinates[3 * static_cast<size_t>(nodePosition)];
+		xyz[0] = x;
+		xyz[1] = y;
+		xyz[2] = z;
+		nodes.displacementCSs[nodePosition] = cd_id;
+		nodes.positionCSs[nodePosition] = cp_id;
 	}
 
 	return nodePosition;
 }
 
+map<int, vector<int>> Mesh::getNodePositionsByPositionCS() const {
+	map<int, vector<int>> result;
+	for (size_t nodePosition = 0; nodePosition < nodes.positionCSs.size(); nodePosition++) {
+		const int positionCS = nodes.positionCSs[nodePosition];
+		if (positionCS != CoordinateSystem::GLOBAL_COORDINATE_SYSTEM_ID) {
+			result[positionCS].push_back(static_cast<int>(nodePosition));
+		}
+	}
+	return result;
+}
+
+void Mesh::transformNodePositionsToGlobal(const CoordinateSystem& coordinateSystem,
+		const vector<int>& nodePositions) {
+	vector<double> coordinates(3 * nodePositions.size());
+	for (size_t i = 0; i < nodePositions.size(); i++) {
+		copy_n(&nodes.coordinates[3 * static_cast<size_t>(nodePositions[i])], 3,
+				&coordinates[3 * i]);
+	}
+	coordinateSystem.pointsToGlobal(coordinates.data(), coordinates.data(), nodePositions.size());
+	for (size_t i = 0; i < nodePositions.size(); i++) {
+		copy_n(&coordinates[3 * i], 3,
+				&nodes.coordinates[3 * static_cast<size_t>(nodePositions[i])]);
+		nodes.positionCSs[nodePositions[i]] = CoordinateSystem::GLOBAL_COORDINATE_SYSTEM_ID;
+	}
+}
+
 int Mesh::countNodes() const {
-	return static_cast<int>(nodes.nodeDatas.size());
+	return static_cast<int>(nodes.ids.size());
 }
 
 const Node Mesh::findNode(int nodePosition) const {
@@ -110,9 +340,9 @@ const Node Mesh::findNode(int nodePosition) const {
 		throw invalid_argument(
 				string("Node position ") + lexical_cast<string>(nodePosition) + " not found.");
 	}
-	const NodeData &nodeData = nodes.nodeDatas[nodePosition];
-	Node node1 = Node(nodeData.id, nodeData.x, nodeData.y, nodeData.z, nodePosition, nodeData.dofs,
-			nodeData.displacementCS);
+	const double* xyz = &nodes.coordinates[3 * static_cast<size_t>(nodePosition)];
+	Node node1 = Node(nodes.ids[nodePosition], xyz[0], xyz[1], xyz[2], nodePosition,
+			nodes.dofs[nodePosition], nodes.displacementCSs[nodePosition]);
 	/*
 	 * #ifdef __GNUC__
 	 *	cerr << "node:" << node1 << endl;
@@ -140,23 +370,30 @@ set<int> Mesh::findOrReserveNodes(const set<int>& nodeIds) {
 }
 
 int Mesh::findNodePosition(const int nodeId) const {
-	auto positionIterator = this->nodes.nodepositionById.find(nodeId);
-	if (positionIterator == this->nodes.nodepositionById.end()) {
+	const int nodePosition = this->nodes.nodepositionById.find(nodeId);
+	if (nodePosition == PositionById::NOT_FOUND) {
 		return UNAVAILABLE_NODE;
 	}
-	return positionIterator->second;
+	return nodePosition;
 }
 
 void Mesh::allowDOFS(int nodePosition, const DOFS allowed) {
-	nodes.nodeDatas[nodePosition].dofs = static_cast<char>(nodes.nodeDatas[nodePosition].dofs
-			| allowed);
+	nodes.dofs[nodePosition] = static_cast<char>(nodes.dofs[nodePosition] | allowed);
+}
+
+void Mesh::allowDOFS(const vector<char>& allowedByNodePosition) {
+	const size_t count = min(allowedByNodePosition.size(), nodes.dofs.size());
+	const char* allowed = allowedByNodePosition.data();
+	char* dofs = nodes.dofs.data();
+	for (size_t i = 0; i < count; i++) {
+		dofs[i] = static_cast<char>(dofs[i] | allowed[i]);
+	}
 }
 
 bool NodeStorage::validate() const {
 	bool validNodes = true;
-	for (size_t i = 0; i < nodeDatas.size(); ++i) {
-		const NodeData &nodeData = nodeDatas[i];
-		if (nodeData.id == Mesh::UNAVAILABLE_NODE) {
+	for (size_t i = 0; i < ids.size(); ++i) {
+		if (ids[i] == Mesh::UNAVAILABLE_NODE) {
 			validNodes = false;
 			cerr << "Node in position " << i << " has been reserved, but never defined" << endl;
 		}
@@ -183,13 +420,15 @@ Mesh::Mesh(LogLevel logLevel, const string& modelName) :
 }
 
 Mesh::~Mesh() {
-	for (auto it : groupByName) {
-		delete (it.second);
+	for (Group* group : groups) {
+		delete group;
 	}
 }
 
 int Mesh::addCell(int id, const CellType &cellType, const std::vector<int> &nodeIds,
 		bool virtualCell, const Orientation* orientation, int elementId) {
+	incidentCellOffsets.clear();
+	incidentCellPositions.clear();
 	int cellId;
 	const int cellPosition = static_cast<int>(cells.cellDatas.size());
 	if (id == Cell::AUTO_ID) {
@@ -212,7 +451,7 @@ int Mesh::addCell(int id, const CellType &cellType, const std::vector<int> &node
 					string("Duplicate node in connectivity cellId:")
 							+ lexical_cast<string>(cellId));
 		}
-		if (cells.cellpositionById.find(cellId) != cells.cellpositionById.end()) {
+		if (cells.cellpositionById.find(cellId) != PositionById::NOT_FOUND) {
 			throw logic_error(
 					string("CellId: ") + lexical_cast<string>(cellId) + " Already used.");
 		}
@@ -223,51 +462,84 @@ int Mesh::addCell(int id, const CellType &cellType, const std::vector<int> &node
 		throw logic_error("Invalid cell");
 	}
 
-	cells.cellpositionById[cellId] = cellPosition;
+	cells.cellpositionById.set(cellId, cellPosition);
 	const int cellTypePosition = static_cast<int>(cellPositionsByType.find(cellType)->second.size());
 	cellPositionsByType.find(cellType)->second.push_back(cellPosition);
 	CellData cellData(cellId, cellType, virtualCell, elementId, cellTypePosition);
 
-	if (cells.nodepositionsByCelltype.find(cellType) == cells.nodepositionsByCelltype.end()) {
-		cells.nodepositionsByCelltype[cellType] = make_shared<deque<int>>(deque<int>());
-	}
-	shared_ptr<deque<int>> nodePositionsPtr = cells.nodepositionsByCelltype[cellType];
 	for (unsigned int i = 0; i < cellType.numNodes; i++) {
-		int nodePosition = findOrReserveNode(nodeIds[i]);
-		nodePositionsPtr->push_back(nodePosition);
+		cells.nodepositions.push_back(findOrReserveNode(nodeIds[i]));
 	}
+	cells.nodepositionOffsets.push_back(cells.nodepositions.size());
 	cells.cellDatas.push_back(cellData);
 	if (orientation != nullptr) {
 		CellGroup* coordinateSystemCellGroup = this->getOrCreateCellGroupForOrientation(
 				orientation->clone());
-		coordinateSystemCellGroup->addCell(cellId);
+		coordinateSystemCellGroup->addCellByPosition(cellPosition);
 		cellData.orientationId = orientation->getId();
 	}
 	return cellPosition;
 }
 
+void Mesh::buildIncidence() const {
+	const size_t nodeCount = static_cast<size_t>(countNodes());
+	// counting sort of the connectivity by node: cells come out in increasing positions
+	incidentCellOffsets.assign(nodeCount + 1, 0);
+	for (int nodePosition : cells.nodepositions) {
+		incidentCellOffsets[static_cast<size_t>(nodePosition) + 1]++;
+	}
+	for (size_t i = 0; i < nodeCount; i++) {
+		incidentCellOffsets[i + 1] += incidentCellOffsets[i];
+	}
+	incidentCellPositions.resize(cells.nodepositions.size());
+	vector<size_t> next(incidentCellOffsets.begin(), incidentCellOffsets.end() - 1);
+	const size_t cellCount = cells.cellDatas.size();
+	for (size_t cellPosition = 0; cellPosition < cellCount; cellPosition++) {
+		for (size_t i = cells.nodepositionOffsets[cellPosition];
+				i < cells.nodepositionOffsets[cellPosition + 1]; i++) {
+			incidentCellPositions[next[static_cast<size_t>(cells.nodepositions[i])]++] =
+					static_cast<int>(cellPosition);
+		}
+	}
+}
+
+CellPositionRange Mesh::cellPositionsOfNode(int nodePosition) const {
+	if (incidentCellOffsets.empty()) {
+		buildIncidence();
+	}
+	// nodes added after the index was built have no cell
+	if (nodePosition < 0 || static_cast<size_t>(nodePosition) + 1 >= incidentCellOffsets.size()) {
+		return CellPositionRange(nullptr, nullptr);
+	}
+	const int* first = incidentCellPositions.data() + incidentCellOffsets[nodePosition];
+	const int* last = incidentCellPositions.data() + incidentCellOffsets[nodePosition + 1];
+	return CellPositionRange(first, last);
+}
+
 const Cell Mesh::findCell(int cellPosition) const {
 	if (cellPosition == Mesh::UNAVAILABLE_CELL) {
 		throw logic_error("Unavailable cell requested.");
 	}
 	const CellData& cellData = cells.cellDatas[cellPosition];
 	const CellType* type = CellType::findByCode(cellData.typeCode);
-	const unsigned int numNodes = type->numNodes;
+	const NodePositionRange range = cells.nodePositions(cellPosition);
+	vector<int> nodePositions(range.begin(), range.end());
 	vector<int> nodeIds;
-	nodeIds.resize(numNodes);
-	auto it = cells.nodepositionsByCelltype.find(*type);
-	deque<int>& globalNodePositions = *(it->second);
-	const int start = cellData.cellTypePosition * numNodes;
-	vector<int> nodePositions(globalNodePositions.begin() + start,
-			globalNodePositions.begin() + start + numNodes);
-	for (unsigned int i = 0; i < numNodes; i++) {
-		const NodeData &nodeData = nodes.nodeDatas[nodePositions[i]];
-		nodeIds[i] = nodeData.id;
+	nodeIds.reserve(nodePositions.size());
+	for (int nodePosition : nodePositions) {
+		nodeIds.push_back(nodes.ids[nodePosition]);
 	}
 	Cell cell(cellData.id, *type, nodeIds, nodePositions, false, nullptr, cellData.elementId, cellData.cellTypePosition);
 	return cell;
 }
 
+const CellView Mesh::findCellView(int cellPosition) const {
+	if (cellPosition == Mesh::UNAVAILABLE_CELL) {
+		throw logic_error("Unavailable cell requested.");
+	}
+	return cells.view(cellPosition);
+}
+
 void Mesh::add_orientation(int cellId, const Orientation& orientation) {
 	shared_ptr<Orientation> orientation_ptr = orientation.clone();
 	CellGroup* coordinateSystemCellGroup = this->getOrCreateCellGroupForOrientation(
@@ -292,7 +564,9 @@ void Mesh::createFamilies(med_idt fid, const char meshname[MED_NAME_SIZE + 1],
 	}
 }
 
-void Mesh::writeMED(const char* medFileName) {
+void Mesh::writeMED(const char* medFileName, const vector<NodeGroup*>& detachedNodeGroups,
+		const vector<CellGroup*>& detachedCellGroups, ostream& messages, unsigned int threads) {
+	Profiler::Scope scope("writeMED");
 	if (!finished) {
 		this->finish();
 	}
@@ -305,11 +579,10 @@ void Mesh::writeMED(const char* medFileName) {
 	if (this->logLevel >= LogLevel::DEBUG) {
 		med_int v[3];
 		MEDlibraryNumVersion(&v[0], &v[1], &v[2]);
-		cout << "Med Version : " << v[0] << "." << v[1] << "." << v[2] << endl;
-		cout << "Num nodes : " << nnodes << endl;
-		cout << "Num cells : " << this->countCells() << endl;
+		messages << "Med Version : " << v[0] << "." << v[1] << "." << v[2] << endl;
+		messages << "Num nodes : " << nnodes << endl;
+		messages << "Num cells : " << this->countCells() << endl;
 	}
-
 	/* open MED file */
 	med_idt fid = MEDfileOpen(medFileName, MED_ACC_CREAT);
 	if (fid < 0) {
@@ -321,16 +594,14 @@ void Mesh::writeMED(const char* medFileName) {
 			MED_SORT_DTIT, MED_CARTESIAN, axisname, unitname) < 0) {
 		throw logic_error("ERROR : Mesh creation ...");
 	}
-	vector<med_float> coordinates;
-	coordinates.reserve(nnodes);
-	for (NodeData& nodeData : nodes.nodeDatas) {
-		coordinates.push_back(nodeData.x);
-		coordinates.push_back(nodeData.y);
-		coordinates.push_back(nodeData.z);
-	}
-	if (MEDmeshNodeCoordinateWr(fid, meshname, MED_NO_DT, MED_NO_IT, 0.0, MED_FULL_INTERLACE,
-			nnodes, coordinates.data()) < 0) {
-		throw logic_error("ERROR : writing nodes ...");
+	{
+		Profiler::Scope nodesScope("writeMEDNodes");
+		// node coordinates are already stored in the MED full interlace layout
+		static_assert(std::is_same<med_float, double>::value, "med_float must be a double");
+		if (MEDmeshNodeCoordinateWr(fid, meshname, MED_NO_DT, MED_NO_IT, 0.0, MED_FULL_INTERLACE,
+				nnodes, nodes.coordinates.data()) < 0) {
+			throw logic_error("ERROR : writing nodes ...");
+		}
 	}
 
 	/*char* nodeNames = new char[nodes.countNodes()*MED_SNAME_SIZE+1]();
@@ -343,85 +614,109 @@ void Mesh::writeMED(const char* medFileName) {
 	 nodes.countNodes(), nodeNames);
 	 delete[](nodeNames);*/
 
-	for (auto kv : cellPositionsByType) {
-		CellType type = kv.first;
-		vector<int> cellPositions = kv.second;
-		size_t numCells = cellPositions.size();
-		if (type.numNodes == 0 || numCells == 0) {
-			continue;
-		}
-		vector<med_int> connectivity;
-		connectivity.reserve(numCells * type.numNodes);
-		for (int cellPosition : cellPositions) {
-			const Cell cell = findCell(cellPosition);
-			for (int nodePosition : cell.nodePositions) {
-				// med nodes starts at node number 1.
-				connectivity.push_back(static_cast<med_int>(nodePosition + 1));
+	vector<const CellType*> cellTypes;
+	vector<const vector<int>*> cellPositionsOfTypes;
+	vector<vector<med_int>> connectivities;
+	{
+		Profiler::Scope connectivityScope("buildMEDConnectivity");
+		// the connectivities of the cell types are built concurrently, the MED library is only
+		// called from this thread
+		for (const auto& kv : cellPositionsByType) {
+			if (kv.first.numNodes != 0 && !kv.second.empty()) {
+				cellTypes.push_back(&kv.first);
+				cellPositionsOfTypes.push_back(&kv.second);
 			}
 		}
-		int result = MEDmeshElementConnectivityWr(fid, meshname, MED_NO_DT,
-		MED_NO_IT, 0.0, MED_CELL, type.code, MED_NODAL, MED_FULL_INTERLACE,
-				static_cast<med_int>(numCells),
-				connectivity.data());
-		if (result < 0) {
-			throw logic_error("ERROR : writing cells ...");
+		connectivities.resize(cellTypes.size());
+		PassScheduler::forEach(cellTypes.size(), threads,
+				[this, &cellTypes, &cellPositionsOfTypes, &connectivities](size_t i) {
+					vector<med_int>& connectivity = connectivities[i];
+					connectivity.reserve(cellPositionsOfTypes[i]->size() * cellTypes[i]->numNodes);
+					for (int cellPosition : *cellPositionsOfTypes[i]) {
+						for (int nodePosition : cells.nodePositions(cellPosition)) {
+							// med nodes starts at node number 1.
+							connectivity.push_back(static_cast<med_int>(nodePosition + 1));
+						}
+					}
+				});
+	}
+
+	{
+		Profiler::Scope cellsScope("writeMEDCells");
+		for (size_t i = 0; i < cellTypes.size(); i++) {
+			const CellType& type = *cellTypes[i];
+			const size_t numCells = cellPositionsOfTypes[i]->size();
+			vector<med_int>& connectivity = connectivities[i];
+			int result = MEDmeshElementConnectivityWr(fid, meshname, MED_NO_DT,
+			MED_NO_IT, 0.0, MED_CELL, type.code, MED_NODAL, MED_FULL_INTERLACE,
+					static_cast<med_int>(numCells),
+					connectivity.data());
+			if (result < 0) {
+				throw logic_error("ERROR : writing cells ...");
+			}
+			vector<med_int>().swap(connectivity);
+
+			/*		 char* cellNames = new char[numCells*MED_SNAME_SIZE+1]();
+			 //med_int* cellNum=new med_int[numCells];
+			 CellPositionInfo cpInfo(0,code);
+			 for(int i=0; i<numCells;i++){
+			 cpInfo.cellPosition = i;
+			 //FIXME:Utterly slow
+			 const vega::Cell cell = this->findCell(&cpInfo);
+			 strncpy(cellNames+(i*MED_SNAME_SIZE),cell.getMedName().c_str(),MED_SNAME_SIZE);
+			 }
+			 result = MEDmeshEntityNameWr(fid, meshname, MED_NO_DT, MED_NO_IT, MED_CELL, code,
+			 numCells, cellNames);
+			 result = MEDmeshEntityNumberWr(fid, meshname, MED_NO_DT, MED_NO_IT, MED_CELL, code,
+			 numCells, cellNum);
+
+			 delete[](cellNames);
+
+			 if (result < 0) {
+			 throw logic_error("ERROR : writing cell names ...");
+			 }*/
 		}
 
-		/*		 char* cellNames = new char[numCells*MED_SNAME_SIZE+1]();
-		 //med_int* cellNum=new med_int[numCells];
-		 CellPositionInfo cpInfo(0,code);
-		 for(int i=0; i<numCells;i++){
-		 cpInfo.cellPosition = i;
-		 //FIXME:Utterly slow
-		 const vega::Cell cell = this->findCell(&cpInfo);
-		 strncpy(cellNames+(i*MED_SNAME_SIZE),cell.getMedName().c_str(),MED_SNAME_SIZE);
-		 }
-		 result = MEDmeshEntityNameWr(fid, meshname, MED_NO_DT, MED_NO_IT, MED_CELL, code,
-		 numCells, cellNames);
-		 result = MEDmeshEntityNumberWr(fid, meshname, MED_NO_DT, MED_NO_IT, MED_CELL, code,
-		 numCells, cellNum);
-
-		 delete[](cellNames);
-
-		 if (result < 0) {
-		 throw logic_error("ERROR : writing cell names ...");
-		 }*/
-	}
-
-	if (MEDfamilyCr(fid, meshname, MED_NO_NAME, 0, 0, MED_NO_GROUP) < 0) {
-		throw logic_error("ERROR : writing family 0 ...");
-	}
-
-	vector<vega::NodeGroup *> nodeGroups = getNodeGroups();
-	if (nodeGroups.size() > 0) {
-		NodeGroup2Families ng2fam(countNodes(), nodeGroups);
-		//WARN: if writing to file is delayed to MEDfileClose may be necessary
-		//to move the allocation outside the if
-		vector<Family>& families = ng2fam.getFamilies();
-		createFamilies(fid, meshname, families);
-		//write family number for nodes
-		if (MEDmeshEntityFamilyNumberWr(fid, meshname, MED_NO_DT, MED_NO_IT, MED_NODE, MED_NONE,
-				nnodes, ng2fam.getFamilyOnNodes().data()) < 0) {
-			throw logic_error("ERROR : writing family on nodes ...");
+		if (MEDfamilyCr(fid, meshname, MED_NO_NAME, 0, 0, MED_NO_GROUP) < 0) {
+			throw logic_error("ERROR : writing family 0 ...");
 		}
 	}
-	vector<CellGroup *> cellGroups = this->getCellGroups();
-	if (cellGroups.size() > 0) {
-		unordered_map<CellType::Code, int, hash<int>> cellCountByType;
-		for (auto typeAndCodePair : CellType::typeByCode) {
-			int cellNum = this->countCells(*typeAndCodePair.second);
-			if (cellNum > 0) {
-				cellCountByType[typeAndCodePair.first] = cellNum;
+
+	{
+		Profiler::Scope familiesScope("writeMEDFamilies");
+		vector<vega::NodeGroup *> nodeGroups = getNodeGroups();
+		nodeGroups.insert(nodeGroups.end(), detachedNodeGroups.begin(), detachedNodeGroups.end());
+		if (nodeGroups.size() > 0) {
+			NodeGroup2Families ng2fam(countNodes(), nodeGroups);
+			//WARN: if writing to file is delayed to MEDfileClose may be necessary
+			//to move the allocation outside the if
+			vector<Family>& families = ng2fam.getFamilies();
+			createFamilies(fid, meshname, families);
+			//write family number for nodes
+			if (MEDmeshEntityFamilyNumberWr(fid, meshname, MED_NO_DT, MED_NO_IT, MED_NODE, MED_NONE,
+					nnodes, ng2fam.getFamilyOnNodes().data()) < 0) {
+				throw logic_error("ERROR : writing family on nodes ...");
 			}
 		}
-		CellGroup2Families cellGroup2Family = CellGroup2Families(this, cellCountByType, cellGroups);
-		createFamilies(fid, meshname, cellGroup2Family.getFamilies());
-		for (auto cellCodeFamilyVectorPair : cellGroup2Family.getFamilyOnCells()) {
-			int ncells = (int) cellCodeFamilyVectorPair.second->size();
-			if (MEDmeshEntityFamilyNumberWr(fid, meshname, MED_NO_DT, MED_NO_IT, MED_CELL,
-					cellCodeFamilyVectorPair.first, ncells, cellCodeFamilyVectorPair.second->data())
-					< 0) {
-				throw logic_error("ERROR : writing family on cells ...");
+		vector<CellGroup *> cellGroups = this->getCellGroups();
+		cellGroups.insert(cellGroups.end(), detachedCellGroups.begin(), detachedCellGroups.end());
+		if (cellGroups.size() > 0) {
+			unordered_map<CellType::Code, int, hash<int>> cellCountByType;
+			for (auto typeAndCodePair : CellType::typeByCode) {
+				int cellNum = this->countCells(*typeAndCodePair.second);
+				if (cellNum > 0) {
+					cellCountByType[typeAndCodePair.first] = cellNum;
+				}
+			}
+			CellGroup2Families cellGroup2Family = CellGroup2Families(this, cellCountByType, cellGroups);
+			createFamilies(fid, meshname, cellGroup2Family.getFamilies());
+			for (auto cellCodeFamilyVectorPair : cellGroup2Family.getFamilyOnCells()) {
+				int ncells = (int) cellCodeFamilyVectorPair.second->size();
+				if (MEDmeshEntityFamilyNumberWr(fid, meshname, MED_NO_DT, MED_NO_IT, MED_CELL,
+						cellCodeFamilyVectorPair.first, ncells, cellCodeFamilyVectorPair.second->data())
+						< 0) {
+					throw logic_error("ERROR : writing family on cells ...");
+				}
 			}
 		}
 	}
@@ -437,7 +732,7 @@ void Mesh::writeMED(const char* medFileName) {
 		throw logic_error("ERROR : closing med file ...");
 	}
 	if (this->logLevel >= LogLevel::DEBUG) {
-		cout << "File created : " << fs::absolute(medFileName) << endl;
+		messages << "File created : " << fs::absolute(medFileName) << endl;
 	}
 }
 
@@ -464,6 +759,19 @@ CellGroup* Mesh::getOrCreateCellGroupForOrientation(const shared_ptr<Orientation
 
 CellStorage::CellStorage(Mesh* mesh, LogLevel logLevel) :
 		logLevel(logLevel), mesh(mesh) {
+	nodepositionOffsets.push_back(0);
+}
+
+NodePositionRange CellStorage::nodePositions(int cellPosition) const {
+	const int* first = nodepositions.data() + nodepositionOffsets[cellPosition];
+	const int* last = nodepositions.data() + nodepositionOffsets[cellPosition + 1];
+	return NodePositionRange(first, last);
+}
+
+CellView CellStorage::view(int cellPosition) const {
+	const CellData& cellData = cellDatas[cellPosition];
+	return CellView(cellPosition, cellData.id, cellData.typeCode, cellData.elementId,
+			cellData.cellTypePosition, nodePositions(cellPosition));
 }
 
 CellIterator CellStorage::cells_begin(const CellType &type) const {
@@ -488,8 +796,13 @@ int Mesh::countCells() const {
 }
 
 void Mesh::finish() {
+	Profiler::Scope scope("Mesh::finish");
 	finished = true;
-
+	nodes.nodepositionById.rebalance();
+	cells.cellpositionById.rebalance();
+	for (Group* group : groups) {
+		group->compact();
+	}
 }
 
 NodeGroup* Mesh::createNodeGroup(const string& name, int group_id) {
@@ -505,6 +818,7 @@ NodeGroup* Mesh::createNodeGroup(const string& name, int group_id) {
 		throw invalid_argument(errorMessage);
 	}
 	NodeGroup* group = new NodeGroup(this, name, group_id);
+	this->groups.push_back(group);
 	this->groupByName[name] = group;
 	if (group_id != Group::NO_ORIGINAL_ID) {
 		this->groupById[group_id] = group;
@@ -525,6 +839,7 @@ CellGroup* Mesh::createCellGroup(const string& name, int group_id) {
 		throw invalid_argument(errorMessage);
 	}
 	CellGroup* group = new CellGroup(this, name);
+	this->groups.push_back(group);
 	this->groupByName[name] = group;
 	if (group_id != Group::NO_ORIGINAL_ID) {
 		this->groupById[group_id] = group;
@@ -535,33 +850,44 @@ CellGroup* Mesh::createCellGroup(const string& name, int group_id) {
 	return group;
 }
 
+unique_ptr<NodeGroup> Mesh::createDetachedNodeGroup(const string& name) {
+	if (name.empty()) {
+		throw invalid_argument("Can't create a nodeGroup with empty name ");
+	}
+	return unique_ptr<NodeGroup>(new NodeGroup(this, name, Group::NO_ORIGINAL_ID));
+}
+
+unique_ptr<CellGroup> Mesh::createDetachedCellGroup(const string& name) {
+	if (name.empty()) {
+		throw invalid_argument("Can't create a cellGroup with empty name ");
+	}
+	return unique_ptr<CellGroup>(new CellGroup(this, name));
+}
+
 vector<NodeGroup*> Mesh::getNodeGroups() const {
-	vector<NodeGroup*> groups;
-	for (auto it : groupByName) {
-		Group* group = it.second;
+	vector<NodeGroup*> nodeGroups;
+	for (Group* group : groups) {
 		if (group->type != Group::NODEGROUP) {
 			continue;
 		}
-		groups.push_back(static_cast<NodeGroup*>(group));
+		nodeGroups.push_back(static_cast<NodeGroup*>(group));
 	}
-	return groups;
+	return nodeGroups;
 }
 
 vector<CellGroup*> Mesh::getCellGroups() {
-	vector<CellGroup*> groups;
-	for (auto it : groupByName) {
-		Group* group = it.second;
+	vector<CellGroup*> cellGroups;
+	for (Group* group : groups) {
 		if (group->type != Group::CELLGROUP) {
 			continue;
 		}
-		groups.push_back(static_cast<CellGroup*>(group));
+		cellGroups.push_back(static_cast<CellGroup*>(group));
 	}
-	return groups;
+	return cellGroups;
 }
 
 void Mesh::assignElementId(const CellContainer& cellContainer, int elementId) {
-	for (int cellId : cellContainer.getCellIds(true)) {
-		int cellPosition = findCellPosition(cellId);
+	for (int cellPosition : cellContainer.getCellPositions(true)) {
 		CellData& cellData = cells.cellDatas[cellPosition];
 		cellData.elementId = elementId;
 	}
@@ -592,17 +918,15 @@ int Mesh::countCells(const CellType& type) const {
 }
 
 bool Mesh::hasCell(int cellId) const {
-	auto positionIterator =
-			cells.cellpositionById.find(cellId);
-	return positionIterator != cells.cellpositionById.end();
+	return cells.cellpositionById.find(cellId) != PositionById::NOT_FOUND;
 }
 
 int Mesh::findCellPosition(int cellId) const {
-	auto it = this->cells.cellpositionById.find(cellId);
-	if (it == this->cells.cellpositionById.end()) {
+	const int cellPosition = this->cells.cellpositionById.find(cellId);
+	if (cellPosition == PositionById::NOT_FOUND) {
 		return UNAVAILABLE_CELL;
 	}
-	return it->second;
+	return cellPosition;
 }
 
 bool Mesh::validate() const {
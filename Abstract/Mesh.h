@@ -12,6 +12,8 @@
 #define MESH_H_
 
 #include <array>
+#include <iostream>
+#include <memory>
 #include <string>
 #include <stdexcept>
 #include <boost/range.hpp>
@@ -30,24 +32,78 @@ namespace vega {
 
 class Mesh;
 
-class NodeData final {
+/**
+ * Maps the ids given by the input solver to internal positions.
+ *
+ * Ids are usually compact (1..n with a few holes), so they are kept in a direct-address
+ * table indexed by id - denseBase. Ids that would make that table too sparse (for instance
+ * the automatic ids) go to an open addressing hash table. The dense window is chosen again
+ * when the hash table grows too much, and when the mesh is finished.
+ */
+class PositionById final {
+private:
+	static const int EMPTY = INT_MIN;
+	/**
+	 * The dense table may hold up to MAX_SPARSITY slots per id, plus DENSE_SLACK slots.
+	 */
+	static const int MAX_SPARSITY = 2;
+	static const int DENSE_SLACK = 1024;
+	int denseBase;
+	size_t denseCount;
+	std::vector<int> densePositions;
+	size_t hashCount;
+	unsigned int hashShift;
+	std::vector<int> hashIds;
+	std::vector<int> hashPositions;
+	size_t nextRebalance;
+	bool fitsDense(long long first, long long last, size_t count) const;
+	size_t hashSlot(int id) const;
+	void insertInHash(int id, int position);
+	void insertInDense(int id, int position);
 public:
-	int id;
-	char dofs;
-	double x;
-	double y;
-	double z;
-	int displacementCS;
+	static const int NOT_FOUND = INT_MIN;
+	PositionById();
+	/**
+	 * @return the position associated to the id or NOT_FOUND
+	 */
+	int find(int id) const;
+	/**
+	 * Associate a position to an id, replacing the previous one if any. INT_MIN marks the
+	 * empty slots and can't be used as an id.
+	 */
+	void set(int id, int position);
+	size_t size() const;
+	/**
+	 * True if every id is stored in the direct-address table.
+	 */
+	bool isDense() const;
+	/**
+	 * Choose the largest window of ids that fits in a direct-address table, and move the
+	 * others in the hash table.
+	 */
+	void rebalance();
 };
 
 class NodeStorage final {
 private:
 	friend Mesh;
 	friend NodeGroup;
+	friend ModelSnapshot;
 
 	const LogLevel logLevel;
-	std::vector<NodeData> nodeDatas;
-	std::map<int, int> nodepositionById;
+	/**
+	 * Node data, one array per field and indexed by node position. Coordinates are packed
+	 * by node (x0, y0, z0, x1, y1, z1...), which is also the MED full interlace layout.
+	 */
+	std::vector<int> ids;
+	std::vector<char> dofs;
+	std::vector<double> coordinates;
+	std::vector<int> displacementCSs;
+	/**
+	 * Coordinate system of the coordinates, until Mesh::transformNodePositionsToGlobal.
+	 */
+	std::vector<int> positionCSs;
+	PositionById nodepositionById;
 	/*
 	 * Reserve a node position given an id
 	 */
@@ -57,6 +113,19 @@ public:
 	Mesh* mesh;
 
 	NodeStorage(Mesh* mesh, LogLevel logLevel);
+	/**
+	 * Coordinates of all the nodes, packed by node position: x, y, z of the node in
+	 * position p are at index 3*p, 3*p+1 and 3*p+2.
+	 */
+	const std::vector<double>& getCoordinates() const;
+	/**
+	 * Ids of all the nodes, indexed by node position.
+	 */
+	const std::vector<int>& getIds() const;
+	/**
+	 * DOFS codes of all the nodes, indexed by node position.
+	 */
+	const std::vector<char>& getDOFS() const;
 	NodeIterator begin() const;
 	NodeIterator end() const;
 
@@ -79,11 +148,18 @@ private:
 	friend Mesh;
 	friend NodeGroup;
 	friend CellGroup;
+	friend ModelSnapshot;
 
 	const LogLevel logLevel;
 	std::vector<CellData> cellDatas;
-	std::map<int, int> cellpositionById;
-	std::map<CellType, std::shared_ptr<std::deque<int>>> nodepositionsByCelltype;
+	PositionById cellpositionById;
+	/**
+	 * Connectivity of all the cells in compressed row format: the node positions of the
+	 * cell in position p are nodepositions[nodepositionOffsets[p]] up to
+	 * nodepositions[nodepositionOffsets[p + 1]] (excluded).
+	 */
+	std::vector<int> nodepositions;
+	std::vector<size_t> nodepositionOffsets;
 	/*
 	 * Reserve a cell position given an id
 	 */
@@ -91,6 +167,14 @@ private:
 public:
 	Mesh* mesh;
 	CellStorage(Mesh* mesh, LogLevel logLevel);
+	/**
+	 * Node positions of a cell, without copying them.
+	 */
+	NodePositionRange nodePositions(int cellPosition) const;
+	/**
+	 * Allocation free view of the cell stored in a given position.
+	 */
+	CellView view(int cellPosition) const;
 	CellIterator cells_begin(const CellType &type) const;
 	CellIterator cells_end(const CellType &type) const;
 
@@ -104,6 +188,7 @@ private:
 	friend CellIterator;
 	//access flag debug on model
 	friend CellGroup;
+	friend ModelSnapshot;
 	const LogLevel logLevel;
 	const string name;
 	bool finished;
@@ -111,12 +196,25 @@ private:
 	//mapping position->external id
 	std::unordered_map<CellType, vector<int>, std::hash<CellType>> cellPositionsByType;
 
+	/**
+	 * The groups in creation order, the order in which they are iterated.
+	 */
+	vector<Group*> groups;
 	std::unordered_map<string, Group*> groupByName;
 	/**
 	 * Groups ordered by the id provided by the input solver. Since inputSolver may not provide
 	 * this id this map may not contain all the groups.
 	 */
 	map<int, Group*> groupById;
+	/**
+	 * Cells connected to each node, in compressed row format like the connectivity: the
+	 * cells of the node in position p are incidentCellPositions[incidentCellOffsets[p]] up
+	 * to incidentCellPositions[incidentCellOffsets[p + 1]] (excluded). Built on demand by
+	 * cellPositionsOfNode and cleared by addCell.
+	 */
+	mutable std::vector<int> incidentCellPositions;
+	mutable std::vector<size_t> incidentCellOffsets;
+	void buildIncidence() const;
 
 	CellGroup * getOrCreateCellGroupForOrientation(const std::shared_ptr<Orientation> orientation);
 	void createFamilies(med_idt fid, const char meshname[MED_NAME_SIZE + 1],
@@ -136,6 +234,12 @@ public:
 	NodeGroup* createNodeGroup(const string& name, int groupId = Group::NO_ORIGINAL_ID);
 	std::vector<NodeGroup*> getNodeGroups() const;
 	CellGroup* createCellGroup(const string& name, int groupId = Group::NO_ORIGINAL_ID);
+	/**
+	 * Groups on the nodes or cells of the mesh that are not added to it: they are only known
+	 * by their owner, e.g. a writer that passes them to writeMED without modifying the model.
+	 */
+	std::unique_ptr<NodeGroup> createDetachedNodeGroup(const string& name);
+	std::unique_ptr<CellGroup> createDetachedCellGroup(const string& name);
 	std::vector<CellGroup*> getCellGroups();
 	Group* findGroup(string) const;
 	/**
@@ -144,10 +248,30 @@ public:
 	 */
 	Group* findGroup(int originalId) const;
 
+	/**
+	 * Adds a node, or redefines it if its position was reserved. cd_id is the coordinate
+	 * system of its displacements, cp_id the one of its coordinates.
+	 */
 	int addNode(int id, double x, double y, double z = 0, int cd_id =
+				CoordinateSystem::GLOBAL_COORDINATE_SYSTEM_ID, int cp_id =
 				CoordinateSystem::GLOBAL_COORDINATE_SYSTEM_ID);
+	/**
+	 * Positions of the nodes whose coordinates are given in a local coordinate system, by id
+	 * of that system.
+	 */
+	std::map<int, std::vector<int>> getNodePositionsByPositionCS() const;
+	/**
+	 * Replaces the coordinates of the given nodes, all given in coordinateSystem, by their
+	 * global coordinates, transforming them at once.
+	 */
+	void transformNodePositionsToGlobal(const CoordinateSystem& coordinateSystem,
+			const std::vector<int>& nodePositions);
 	int countNodes() const;
 	void allowDOFS(int nodePosition, const DOFS allowed);
+	/**
+	 * Allows DOFS on all the nodes at once, given as DOFS codes indexed by node position.
+	 */
+	void allowDOFS(const std::vector<char>& allowedByNodePosition);
 	/**
 	 * throws invalid_argument if node not found
 	 */
@@ -169,7 +293,18 @@ public:
 			bool virtualCell = false, const Orientation* = nullptr, int elementId = UNAVAILABLE_ELEM);
 	int findCellPosition(int cellId) const;
 	const Cell findCell(int cellPosition) const;
+	/**
+	 * Same as findCell, but returns a view on the mesh storage instead of copying the cell.
+	 * Prefer it when only the id, type or connectivity positions are needed.
+	 */
+	const CellView findCellView(int cellPosition) const;
 	bool hasCell(int cellId) const;
+	/**
+	 * Positions of the cells connected to a node, in increasing order. The first call after
+	 * a cell insertion builds the node to cells index of the whole mesh in linear time, the
+	 * next ones cost the number of cells returned. Not thread safe.
+	 */
+	CellPositionRange cellPositionsOfNode(int nodePosition) const;
 
 	/**
 	 * Assign an elementId (an integer) to a group of cells.
@@ -177,7 +312,14 @@ public:
 	 */
 	void assignElementId(const CellContainer&, int elementId);
 
-	void writeMED(const char* medFileName);
+	/**
+	 * Writes the mesh and its groups, followed by the detached groups given. The debug
+	 * messages are written to messages. The connectivities of the cell types are built on
+	 * up to threads threads, the MED library being only called from the calling thread.
+	 */
+	void writeMED(const char* medFileName, const std::vector<NodeGroup*>& detachedNodeGroups = {},
+			const std::vector<CellGroup*>& detachedCellGroups = {},
+			std::ostream& messages = std::cout, unsigned int threads = 1);
 	void finish();
 	bool validate() const;
 };
@@ -11,8 +11,10 @@
 #include "MeshComponents.h"
 #include "Mesh.h"
 #include "Model.h"
+#include <algorithm>
 #include <string>
 #include <initializer_list>
+#include <cstdlib>
 #include <boost/lexical_cast.hpp>
 #include <boost/assign.hpp>
 #ifdef __GNUC__
@@ -125,9 +127,553 @@ const string Group::getName() const {
 
 }
 
+unsigned long Group::nextGeneration() {
+	static atomic<unsigned long> lastGeneration(0);
+	return ++lastGeneration;
+}
+
 Group::~Group() {
 
 }
+
+/*******************
+ * NodeClosureCache
+ */
+NodeClosureCache::NodeClosureCache() :
+		generation(0) {
+}
+
+NodeClosureCache::NodeClosureCache(const NodeClosureCache&) :
+		generation(0) {
+}
+
+NodeClosureCache& NodeClosureCache::operator=(const NodeClosureCache&) {
+	lock_guard<std::mutex> lock(mutex);
+	generation = 0;
+	nodePositions.clear();
+	return *this;
+}
+
+const vector<int>& NodeClosureCache::get(unsigned long generation,
+		const function<vector<int>()>& compute) const {
+	lock_guard<std::mutex> lock(mutex);
+	if (this->generation != generation) {
+		nodePositions = compute();
+		this->generation = generation;
+	}
+	return nodePositions;
+}
+/*******************
+ * PositionSet
+ */
+PositionSet::Chunk::Chunk(int key) :
+		key(key), count(0) {
+}
+
+bool PositionSet::Chunk::isBitmap() const {
+	return !bits.empty();
+}
+
+bool PositionSet::Chunk::contains(uint16_t low) const {
+	if (isBitmap()) {
+		return (bits[low >> 6] >> (low & 63)) & 1;
+	}
+	return binary_search(values.begin(), values.end(), low);
+}
+
+bool PositionSet::Chunk::insert(uint16_t low) {
+	if (!isBitmap()) {
+		auto it = lower_bound(values.begin(), values.end(), low);
+		if (it != values.end() && *it == low) {
+			return false;
+		}
+		if (values.size() < MAX_ARRAY_SIZE) {
+			values.insert(it, low);
+			count++;
+			return true;
+		}
+		bits = toBitmap();
+		values.clear();
+		values.shrink_to_fit();
+	}
+	uint64_t& word = bits[low >> 6];
+	const uint64_t mask = uint64_t(1) << (low & 63);
+	if (word & mask) {
+		return false;
+	}
+	word |= mask;
+	count++;
+	return true;
+}
+
+bool PositionSet::Chunk::erase(uint16_t low) {
+	if (!isBitmap()) {
+		auto it = lower_bound(values.begin(), values.end(), low);
+		if (it == values.end() || *it != low) {
+			return false;
+		}
+		values.erase(it);
+		count--;
+		return true;
+	}
+	uint64_t& word = bits[low >> 6];
+	const uint64_t mask = uint64_t(1) << (low & 63);
+	if (!(word & mask)) {
+		return false;
+	}
+	word &= ~mask;
+	count--;
+	// half the threshold, so that a chunk does not switch back and forth around it
+	if (count <= MAX_ARRAY_SIZE / 2) {
+		*this = fromBitmap(key, move(bits));
+	}
+	return true;
+}
+
+int PositionSet::Chunk::nextBit(int low) const {
+	size_t word = static_cast<size_t>(low) >> 6;
+	if (word >= BITMAP_WORDS) {
+		return 1 << CHUNK_BITS;
+	}
+	uint64_t remaining = bits[word] & (~uint64_t(0) << (low & 63));
+	while (remaining == 0) {
+		if (++word == BITMAP_WORDS) {
+			return 1 << CHUNK_BITS;
+		}
+		remaining = bits[word];
+	}
+	return static_cast<int>(word * 64) + __builtin_ctzll(remaining);
+}
+
+vector<uint64_t> PositionSet::Chunk::toBitmap() const {
+	if (isBitmap()) {
+		return bits;
+	}
+	vector<uint64_t> result(BITMAP_WORDS, 0);
+	for (uint16_t low : values) {
+		result[low >> 6] |= uint64_t(1) << (low & 63);
+	}
+	return result;
+}
+
+PositionSet::Chunk PositionSet::Chunk::fromBitmap(int key, vector<uint64_t>&& bits) {
+	Chunk chunk(key);
+	for (uint64_t word : bits) {
+		chunk.count += static_cast<size_t>(__builtin_popcountll(word));
+	}
+	if (chunk.count > MAX_ARRAY_SIZE) {
+		chunk.bits = move(bits);
+		return chunk;
+	}
+	chunk.values.reserve(chunk.count);
+	for (size_t word = 0; word < bits.size(); word++) {
+		for (uint64_t remaining = bits[word]; remaining != 0; remaining &= remaining - 1) {
+			chunk.values.push_back(static_cast<uint16_t>(word * 64 + __builtin_ctzll(remaining)));
+		}
+	}
+	return chunk;
+}
+
+PositionSet::Chunk PositionSet::Chunk::fromArray(int key, vector<uint16_t>&& values) {
+	if (values.size() > MAX_ARRAY_SIZE) {
+		Chunk array(key);
+		array.values = move(values);
+		return fromBitmap(key, array.toBitmap());
+	}
+	Chunk chunk(key);
+	chunk.count = values.size();
+	chunk.values = move(values);
+	return chunk;
+}
+
+PositionSet::const_iterator::const_iterator(const PositionSet* set, size_t index) :
+		set(set), index(index), inner(0), current(0) {
+	if (set->compacted && index < set->chunks.size() && set->chunks[index].isBitmap()) {
+		inner = set->chunks[index].nextBit(0);
+	}
+	seek();
+}
+
+void PositionSet::const_iterator::seek() {
+	if (!set->compacted) {
+		current = index < set->sorted.size() ? set->sorted[index] : 0;
+		return;
+	}
+	if (index >= set->chunks.size()) {
+		current = 0;
+		return;
+	}
+	const Chunk& chunk = set->chunks[index];
+	const int low = chunk.isBitmap() ? inner : chunk.values[static_cast<size_t>(inner)];
+	current = (chunk.key << CHUNK_BITS) | low;
+}
+
+int PositionSet::const_iterator::operator*() const {
+	return current;
+}
+
+PositionSet::const_iterator& PositionSet::const_iterator::operator++() {
+	if (!set->compacted) {
+		index++;
+	} else {
+		const Chunk& chunk = set->chunks[index];
+		bool chunkDone;
+		if (chunk.isBitmap()) {
+			inner = chunk.nextBit(inner + 1);
+			chunkDone = inner == 1 << CHUNK_BITS;
+		} else {
+			inner++;
+			chunkDone = static_cast<size_t>(inner) == chunk.values.size();
+		}
+		if (chunkDone) {
+			*this = const_iterator(set, index + 1);
+			return *this;
+		}
+	}
+	seek();
+	return *this;
+}
+
+PositionSet::const_iterator PositionSet::const_iterator::operator++(int) {
+	const_iterator result = *this;
+	++(*this);
+	return result;
+}
+
+bool PositionSet::const_iterator::operator==(const const_iterator& rhs) const {
+	return set == rhs.set && index == rhs.index && inner == rhs.inner;
+}
+
+bool PositionSet::const_iterator::operator!=(const const_iterator& rhs) const {
+	return !(*this == rhs);
+}
+
+PositionSet::PositionSet() :
+		compacted(false), mergedSize(0), count(0), pending(false) {
+}
+
+PositionSet::PositionSet(const PositionSet& other) :
+		PositionSet() {
+	*this = other;
+}
+
+PositionSet::PositionSet(PositionSet&& other) :
+		PositionSet() {
+	*this = move(other);
+}
+
+PositionSet& PositionSet::operator=(const PositionSet& other) {
+	if (this != &other) {
+		other.merge();
+		compacted = other.compacted;
+		sorted = other.sorted;
+		mergedSize = other.mergedSize;
+		chunks = other.chunks;
+		count = other.count;
+		pending = false;
+	}
+	return *this;
+}
+
+PositionSet& PositionSet::operator=(PositionSet&& other) {
+	if (this != &other) {
+		other.merge();
+		compacted = other.compacted;
+		sorted = move(other.sorted);
+		mergedSize = other.mergedSize;
+		chunks = move(other.chunks);
+		count = other.count;
+		pending = false;
+		other.clear();
+	}
+	return *this;
+}
+
+void PositionSet::checkValue(int value) {
+	if (value < 0) {
+		throw invalid_argument("Negative value in a position set: " + to_string(value));
+	}
+}
+
+vector<PositionSet::Chunk>::const_iterator PositionSet::findChunk(int key) const {
+	return lower_bound(chunks.begin(), chunks.end(), key,
+			[](const Chunk& chunk, int key) {return chunk.key < key;});
+}
+
+void PositionSet::insert(int value) {
+	checkValue(value);
+	if (!compacted) {
+		if (!pending && (sorted.empty() || sorted.back() < value)) {
+			sorted.push_back(value);
+			mergedSize++;
+			count++;
+		} else {
+			sorted.push_back(value);
+			pending = true;
+		}
+		return;
+	}
+	const int key = value >> CHUNK_BITS;
+	auto it = chunks.begin() + (findChunk(key) - chunks.cbegin());
+	if (it == chunks.end() || it->key != key) {
+		it = chunks.insert(it, Chunk(key));
+	}
+	if (it->insert(static_cast<uint16_t>(value))) {
+		count++;
+	}
+}
+
+void PositionSet::merge() const {
+	if (!pending.load(memory_order_acquire)) {
+		return;
+	}
+	lock_guard<mutex> lock(mergeMutex);
+	if (!pending.load(memory_order_relaxed)) {
+		return;
+	}
+	mergeFrom(mergedSize);
+	mergedSize = sorted.size();
+	pending.store(false, memory_order_release);
+}
+
+void PositionSet::mergeFrom(size_t oldSize) const {
+	const auto middle = sorted.begin() + static_cast<ptrdiff_t>(oldSize);
+	if (!is_sorted(middle, sorted.end())) {
+		sort(middle, sorted.end());
+	}
+	if (oldSize > 0 && middle != sorted.end() && *middle <= sorted[oldSize - 1]) {
+		inplace_merge(sorted.begin(), middle, sorted.end());
+	}
+	sorted.erase(unique(sorted.begin(), sorted.end()), sorted.end());
+	count = sorted.size();
+}
+
+bool PositionSet::erase(int value) {
+	if (value < 0) {
+		return false;
+	}
+	if (!compacted) {
+		merge();
+		auto it = lower_bound(sorted.begin(), sorted.end(), value);
+		if (it == sorted.end() || *it != value) {
+			return false;
+		}
+		sorted.erase(it);
+		mergedSize--;
+		count--;
+		return true;
+	}
+	const int key = value >> CHUNK_BITS;
+	auto it = chunks.begin() + (findChunk(key) - chunks.cbegin());
+	if (it == chunks.end() || it->key != key || !it->erase(static_cast<uint16_t>(value))) {
+		return false;
+	}
+	if (it->count == 0) {
+		chunks.erase(it);
+	}
+	count--;
+	return true;
+}
+
+bool PositionSet::contains(int value) const {
+	if (value < 0) {
+		return false;
+	}
+	if (!compacted) {
+		merge();
+		return binary_search(sorted.begin(), sorted.end(), value);
+	}
+	const int key = value >> CHUNK_BITS;
+	auto it = findChunk(key);
+	return it != chunks.end() && it->key == key && it->contains(static_cast<uint16_t>(value));
+}
+
+size_t PositionSet::size() const {
+	merge();
+	return count;
+}
+
+bool PositionSet::empty() const {
+	merge();
+	return count == 0;
+}
+
+void PositionSet::clear() {
+	compacted = false;
+	sorted.clear();
+	mergedSize = 0;
+	chunks.clear();
+	count = 0;
+	pending = false;
+}
+
+void PositionSet::compact() {
+	if (compacted) {
+		return;
+	}
+	merge();
+	size_t begin = 0;
+	while (begin < sorted.size()) {
+		const int key = sorted[begin] >> CHUNK_BITS;
+		vector<uint16_t> values;
+		size_t end = begin;
+		for (; end < sorted.size() && (sorted[end] >> CHUNK_BITS) == key; end++) {
+			values.push_back(static_cast<uint16_t>(sorted[end]));
+		}
+		chunks.push_back(Chunk::fromArray(key, move(values)));
+		begin = end;
+	}
+	vector<int>().swap(sorted);
+	mergedSize = 0;
+	compacted = true;
+}
+
+bool PositionSet::isCompact() const {
+	return compacted;
+}
+
+PositionSet::const_iterator PositionSet::begin() const {
+	merge();
+	return const_iterator(this, 0);
+}
+
+PositionSet::const_iterator PositionSet::end() const {
+	merge();
+	return const_iterator(this, compacted ? chunks.size() : sorted.size());
+}
+
+vector<int> PositionSet::toVector() const {
+	merge();
+	if (!compacted) {
+		return sorted;
+	}
+	vector<int> result;
+	result.reserve(count);
+	result.insert(result.end(), begin(), end());
+	return result;
+}
+
+set<int> PositionSet::toSet() const {
+	// the members are sorted, so each insertion at the end is constant time
+	return set<int>(begin(), end());
+}
+
+bool PositionSet::operator==(const PositionSet& other) const {
+	return size() == other.size() && equal(begin(), end(), other.begin());
+}
+
+bool PositionSet::operator!=(const PositionSet& other) const {
+	return !(*this == other);
+}
+
+PositionSet& PositionSet::operator|=(const PositionSet& other) {
+	*this = unionOf(*this, other);
+	return *this;
+}
+
+PositionSet& PositionSet::operator&=(const PositionSet& other) {
+	*this = intersectionOf(*this, other);
+	return *this;
+}
+
+namespace {
+
+/**
+ * Combines two sets of chunks by key: the chunks of a single operand are kept if keepAlone,
+ * the chunks of both operands are combined by arrays (on their sorted arrays) or by bitmaps
+ * (on their bitmap words).
+ */
+template<typename Chunk, typename ArrayOperation, typename WordOperation>
+vector<Chunk> combineChunks(const vector<Chunk>& a, const vector<Chunk>& b, bool keepAlone,
+		ArrayOperation arrays, WordOperation words) {
+	vector<Chunk> result;
+	auto itA = a.begin();
+	auto itB = b.begin();
+	while (itA != a.end() || itB != b.end()) {
+		if (itB == b.end() || (itA != a.end() && itA->key < itB->key)) {
+			if (keepAlone) {
+				result.push_back(*itA);
+			}
+			++itA;
+		} else if (itA == a.end() || itB->key < itA->key) {
+			if (keepAlone) {
+				result.push_back(*itB);
+			}
+			++itB;
+		} else {
+			Chunk chunk(itA->key);
+			if (!itA->isBitmap() && !itB->isBitmap()) {
+				vector<uint16_t> values;
+				arrays(itA->values.begin(), itA->values.end(), itB->values.begin(),
+						itB->values.end(), back_inserter(values));
+				chunk = Chunk::fromArray(itA->key, move(values));
+			} else {
+				vector<uint64_t> bits = itA->toBitmap();
+				const vector<uint64_t> otherBits = itB->toBitmap();
+				for (size_t i = 0; i < bits.size(); i++) {
+					bits[i] = words(bits[i], otherBits[i]);
+				}
+				chunk = Chunk::fromBitmap(itA->key, move(bits));
+			}
+			if (chunk.count > 0) {
+				result.push_back(move(chunk));
+			}
+			++itA;
+			++itB;
+		}
+	}
+	return result;
+}
+
+}
+
+PositionSet PositionSet::unionOf(const PositionSet& a, const PositionSet& b) {
+	PositionSet result;
+	if (a.compacted && b.compacted) {
+		typedef vector<uint16_t>::const_iterator It;
+		result.chunks = combineChunks(a.chunks, b.chunks, true,
+				[](It first1, It last1, It first2, It last2, back_insert_iterator<vector<uint16_t>> out) {
+					set_union(first1, last1, first2, last2, out);
+				},
+				[](uint64_t x, uint64_t y) {return x | y;});
+		result.compacted = true;
+		for (const Chunk& chunk : result.chunks) {
+			result.count += chunk.count;
+		}
+		return result;
+	}
+	result.sorted.reserve(a.size() + b.size());
+	set_union(a.begin(), a.end(), b.begin(), b.end(), back_inserter(result.sorted));
+	result.mergedSize = result.count = result.sorted.size();
+	if (a.compacted || b.compacted) {
+		result.compact();
+	}
+	return result;
+}
+
+PositionSet PositionSet::intersectionOf(const PositionSet& a, const PositionSet& b) {
+	PositionSet result;
+	if (a.compacted && b.compacted) {
+		typedef vector<uint16_t>::const_iterator It;
+		result.chunks = combineChunks(a.chunks, b.chunks, false,
+				[](It first1, It last1, It first2, It last2, back_insert_iterator<vector<uint16_t>> out) {
+					set_intersection(first1, last1, first2, last2, out);
+				},
+				[](uint64_t x, uint64_t y) {return x & y;});
+		result.compacted = true;
+		for (const Chunk& chunk : result.chunks) {
+			result.count += chunk.count;
+		}
+		return result;
+	}
+	set_intersection(a.begin(), a.end(), b.begin(), b.end(), back_inserter(result.sorted));
+	result.mergedSize = result.count = result.sorted.size();
+	if (a.compacted || b.compacted) {
+		result.compact();
+	}
+	return result;
+}
+
 /*******************
  * NodeGroup
  */
@@ -145,33 +691,33 @@ void NodeGroup::addNodeByPosition(int nodePosition) {
 }
 
 void NodeGroup::removeNodeByPosition(int nodePosition) {
-	if (_nodePositions.find(nodePosition) == _nodePositions.end()) {
+	if (!_nodePositions.erase(nodePosition)) {
 		throw logic_error("Node position not present : " + to_string(nodePosition));
 	}
-	for (auto it = _nodePositions.begin(); it != _nodePositions.end();) {
-		if (*it == nodePosition) {
-			_nodePositions.erase(it);
-			return;
-		} else {
-			it++;
-		}
-	}
 }
 
 const std::set<int> NodeGroup::nodePositions() const {
+	return _nodePositions.toSet();
+}
+
+const PositionSet& NodeGroup::nodePositionSet() const {
 	return _nodePositions;
 }
 
+void NodeGroup::compact() {
+	_nodePositions.compact();
+}
+
 const set<int> NodeGroup::getNodeIds() const {
 	set<int> nodeIds;
 	for (int position : _nodePositions) {
-		nodeIds.insert(mesh->nodes.nodeDatas[position].id);
+		nodeIds.insert(mesh->nodes.ids[position]);
 	}
 	return nodeIds;
 }
 
 CellGroup::CellGroup(Mesh* mesh, string name) :
-		Group(mesh, name, CELLGROUP) {
+		Group(mesh, name, CELLGROUP), generation(nextGeneration()) {
 
 }
 /*
@@ -180,39 +726,95 @@ CellGroup::CellGroup(Mesh* mesh, string name) :
  }*/
 
 void CellGroup::addCell(int cellId) {
-	this->cellIds.insert(cellId);
+	const int cellPosition = mesh->findCellPosition(cellId);
+	if (cellPosition == Mesh::UNAVAILABLE_CELL) {
+		throw invalid_argument("Cell id not found in group " + name + " : " + to_string(cellId));
+	}
+	addCellByPosition(cellPosition);
 	if (this->mesh->logLevel >= LogLevel::TRACE) {
 		cout << "Group MA :" << this->getName() << ", Added: " << cellId << endl;
 	}
 }
 
-vector<Cell> CellGroup::getCells() {
+void CellGroup::addCellByPosition(int cellPosition) {
+	_cellPositions.insert(cellPosition);
+	generation = nextGeneration();
+}
+
+const PositionSet& CellGroup::cellPositionSet() const {
+	return _cellPositions;
+}
+
+vector<Cell> CellGroup::getCells() const {
 	vector<Cell> result;
-	for (int cellId : cellIds) {
-		int cellPosition = mesh->findCellPosition(cellId);
+	result.reserve(_cellPositions.size());
+	for (int cellPosition : _cellPositions) {
 		result.push_back(mesh->findCell(cellPosition));
 	}
 	return result;
 }
 
-vector<int> CellGroup::cellPositions() {
+void CellGroup::forEachCell(const function<void(const CellView&)>& visitor) const {
+	for (int cellPosition : _cellPositions) {
+		visitor(mesh->findCellView(cellPosition));
+	}
+}
+
+vector<int> CellGroup::cellPositions() const {
+	return _cellPositions.toVector();
+}
+
+vector<int> CellGroup::getCellIds() const {
 	vector<int> result;
-	for (int cellId : cellIds) {
-		result.push_back(mesh->findCellPosition(cellId));
+	result.reserve(_cellPositions.size());
+	for (int cellPosition : _cellPositions) {
+		result.push_back(mesh->cells.cellDatas[cellPosition].id);
 	}
 	return result;
 }
 
-const set<int> CellGroup::nodePositions() const {
-	set<int> result;
-	for (int cellId : cellIds) {
-		int position = mesh->findCellPosition(cellId);
-		Cell cell = mesh->findCell(position);
-		result.insert(cell.nodePositions.begin(), cell.nodePositions.end());
+bool CellGroup::empty() const {
+	return _cellPositions.empty();
+}
+
+namespace {
+
+/**
+ * Sorted and deduplicated node positions of some cells.
+ */
+template<typename iterator>
+vector<int> nodeClosureOf(const Mesh& mesh, iterator begin, iterator end) {
+	vector<int> result;
+	for (; begin != end; ++begin) {
+		const NodePositionRange nodePositions = mesh.cells.nodePositions(*begin);
+		result.insert(result.end(), nodePositions.begin(), nodePositions.end());
 	}
+	sort(result.begin(), result.end());
+	result.erase(unique(result.begin(), result.end()), result.end());
 	return result;
 }
 
+}
+
+const set<int> CellGroup::nodePositions() const {
+	const vector<int>& closure = nodePositionClosure();
+	return set<int>(closure.begin(), closure.end());
+}
+
+const vector<int>& CellGroup::nodePositionClosure() const {
+	return nodeClosure.get(generation, [this]() {
+		return nodeClosureOf(*mesh, _cellPositions.begin(), _cellPositions.end());
+	});
+}
+
+unsigned long CellGroup::getGeneration() const {
+	return generation;
+}
+
+void CellGroup::compact() {
+	_cellPositions.compact();
+}
+
 CellGroup::~CellGroup() {
 }
 
@@ -399,6 +1001,36 @@ ostream &operator<<(ostream &out, const Cell& cell) {
 	return out;
 }
 
+CellView::CellView(int position, int id, CellType::Code typeCode, int elementId,
+		int cellTypePosition, NodePositionRange nodePositions) :
+		position(position), id(id), typeCode(typeCode), elementId(elementId), cellTypePosition(
+				cellTypePosition), nodePositions(nodePositions) {
+}
+
+const CellType& CellView::type() const {
+	return *CellType::findByCode(typeCode);
+}
+
+string CellView::getMedName() const {
+	return string("M") + lexical_cast<string>(id);
+}
+
+ostream &operator<<(ostream &out, const CellView& cellView) {
+	out << "CellView[id:" << cellView.id;
+	out << ",type:" << cellView.typeCode;
+	out << ",nodePositions:[";
+	bool first = true;
+	for (int nodePosition : cellView.nodePositions) {
+		if (!first) {
+			out << ",";
+		}
+		out << nodePosition;
+		first = false;
+	}
+	out << "]]";
+	return out;
+}
+
 CellIterator::CellIterator(const CellStorage* cellStorage, const CellType &cellType, bool begin) :
 		cellStorage(cellStorage), endPosition(cellStorage->mesh->countCells(cellType)), cellType(cellType), position(
 				begin ? 0 : endPosition) {
@@ -407,8 +1039,8 @@ CellIterator::CellIterator(const CellStorage* cellStorage, const CellType &cellT
 CellIterator::~CellIterator() {
 }
 
-const Cell CellIterator::next() {
-	Cell result = dereference();
+const CellView CellIterator::next() {
+	const CellView result = dereference();
 	increment(1);
 	return result;
 }
@@ -443,11 +1075,11 @@ bool CellIterator::operator !=(const CellIterator& rhs) const {
 	return !(*this == rhs);
 }
 
-const Cell CellIterator::dereference() const {
-	return cellStorage->mesh->findCell(cellStorage->mesh->cellPositionsByType.find(cellType)->second[position]);
+const CellView CellIterator::dereference() const {
+	return cellStorage->view(cellStorage->mesh->cellPositionsByType.find(cellType)->second[position]);
 }
 
-const Cell CellIterator::operator *() const {
+const CellView CellIterator::operator *() const {
 	return dereference();
 }
 
@@ -466,11 +1098,22 @@ bool CellIterator::equal(CellIterator const &other) const {
  */
 
 CellContainer::CellContainer(shared_ptr<Mesh> mesh) :
-		mesh(mesh) {
+		mesh(mesh), generation(Group::nextGeneration()) {
 }
 
 void CellContainer::addCell(int cellId) {
-	cellIds.insert(cellId);
+	const int cellPosition = mesh->findCellPosition(cellId);
+	if (cellPosition == Mesh::UNAVAILABLE_CELL) {
+		pendingCellIds.insert(cellId);
+		generation = Group::nextGeneration();
+	} else {
+		addCellByPosition(cellPosition);
+	}
+}
+
+void CellContainer::addCellByPosition(int cellPosition) {
+	cellPositions.insert(cellPosition);
+	generation = Group::nextGeneration();
 }
 
 void CellContainer::addCellGroup(const string& groupName) {
@@ -479,6 +1122,7 @@ void CellContainer::addCellGroup(const string& groupName) {
 		throw logic_error(string("Group name: ") + groupName + "not found.");
 	}
 	this->groupNames.insert(groupName);
+	generation = Group::nextGeneration();
 }
 
 void CellContainer::add(const Cell& cell) {
@@ -487,23 +1131,40 @@ void CellContainer::add(const Cell& cell) {
 
 void CellContainer::add(const CellGroup& cellGroup) {
 	this->groupNames.insert(cellGroup.getName());
+	generation = Group::nextGeneration();
 }
 
 void CellContainer::add(const CellContainer& cellContainer) {
-	if (cellContainer.cellIds.size() > 0) {
-		this->cellIds.insert(cellContainer.cellIds.begin(), cellContainer.cellIds.end());
+	for (int cellPosition : cellContainer.cellPositions) {
+		this->cellPositions.insert(cellPosition);
+	}
+	for (int cellId : cellContainer.pendingCellIds) {
+		this->pendingCellIds.insert(cellId);
 	}
 
 	if (cellContainer.groupNames.size() > 0) {
 		this->groupNames.insert(cellContainer.groupNames.begin(), cellContainer.groupNames.end());
 	}
+	generation = Group::nextGeneration();
+}
+
+vector<int> CellContainer::ownCellPositions() const {
+	vector<int> result(cellPositions.begin(), cellPositions.end());
+	if (!pendingCellIds.empty()) {
+		for (int cellId : pendingCellIds) {
+			result.push_back(mesh->findCellPosition(cellId));
+		}
+		sort(result.begin(), result.end());
+		result.erase(unique(result.begin(), result.end()), result.end());
+	}
+	return result;
 }
 
 vector<Cell> CellContainer::getCells(bool all) const {
+	const vector<int> cellPositions = ownCellPositions();
 	vector<Cell> cells;
-	cells.reserve(cellIds.size());
-	for (int cellId : cellIds) {
-		int cellPosition = mesh->findCellPosition(cellId);
+	cells.reserve(cellPositions.size());
+	for (int cellPosition : cellPositions) {
 		cells.push_back(mesh->findCell(cellPosition));
 	}
 	if (all) {
@@ -519,49 +1180,90 @@ vector<Cell> CellContainer::getCells(bool all) const {
 }
 
 vector<int> CellContainer::getCellIds(bool all) const {
-	vector<int> cells(cellIds.begin(), cellIds.end());
+	const vector<int> cellPositions = ownCellPositions();
+	vector<int> cells;
+	cells.reserve(cellPositions.size());
+	for (int cellPosition : cellPositions) {
+		cells.push_back(mesh->findCellView(cellPosition).id);
+	}
 	if (all) {
 		for (string groupName : groupNames) {
 			CellGroup* group = static_cast<CellGroup *>(mesh->findGroup(groupName));
 			if (group != nullptr) {
-				cells.insert(cells.end(), group->cellIds.begin(), group->cellIds.end());
+				const vector<int> groupCellIds = group->getCellIds();
+				cells.insert(cells.end(), groupCellIds.begin(), groupCellIds.end());
 			}
 		}
 	}
 	return cells;
 }
 
-set<int> CellContainer::nodePositions() const {
-	set<int> result;
-	for (Cell cell : getCells(true)) {
-		result.insert(cell.nodePositions.begin(), cell.nodePositions.end());
+vector<int> CellContainer::getCellPositions(bool all) const {
+	vector<int> cellPositions = ownCellPositions();
+	if (all) {
+		for (const string& groupName : groupNames) {
+			CellGroup* group = static_cast<CellGroup *>(mesh->findGroup(groupName));
+			if (group != nullptr) {
+				const PositionSet& groupCellPositions = group->cellPositionSet();
+				cellPositions.insert(cellPositions.end(), groupCellPositions.begin(),
+						groupCellPositions.end());
+			}
+		}
 	}
-	return result;
+	return cellPositions;
+}
+
+void CellContainer::forEachCell(const function<void(const CellView&)>& visitor, bool all) const {
+	for (int cellPosition : ownCellPositions()) {
+		visitor(mesh->findCellView(cellPosition));
+	}
+	if (all) {
+		for (const string& groupName : groupNames) {
+			CellGroup* group = static_cast<CellGroup *>(mesh->findGroup(groupName));
+			if (group != nullptr) {
+				group->forEachCell(visitor);
+			}
+		}
+	}
+}
+
+const vector<int>& CellContainer::nodePositions() const {
+	// the closure is also invalid when a group has changed since it was computed
+	unsigned long closureGeneration = generation;
+	for (const string& groupName : groupNames) {
+		CellGroup* group = static_cast<CellGroup *>(mesh->findGroup(groupName));
+		if (group != nullptr) {
+			closureGeneration = max(closureGeneration, group->getGeneration());
+		}
+	}
+	return nodeClosure.get(closureGeneration, [this]() {
+		const vector<int> cellPositions = getCellPositions(true);
+		return nodeClosureOf(*mesh, cellPositions.begin(), cellPositions.end());
+	});
 }
 
 bool CellContainer::containsCells(CellType cellType, bool all) {
-	vector<Cell> cells = getCells(all);
-	bool result = false;
-	for (Cell cell : cells) {
-		if (cell.type.code == cellType.code) {
-			result = true;
-			break;
+	for (int cellPosition : getCellPositions(all)) {
+		if (mesh->findCellView(cellPosition).typeCode == cellType.code) {
+			return true;
 		}
 	}
-	return result;
+	return false;
 }
 
 bool CellContainer::empty() const {
-	return groupNames.empty() && cellIds.empty();
+	return groupNames.empty() && cellPositions.empty() && pendingCellIds.empty();
 }
 
 void CellContainer::clear() {
 	groupNames.clear();
-	cellIds.clear();
+	cellPositions.clear();
+	pendingCellIds.clear();
+	generation = Group::nextGeneration();
 }
 
 bool CellContainer::hasCells() const {
-	return !cellIds.empty();
+	return !cellPositions.empty() || !pendingCellIds.empty();
 }
 
 vector<CellGroup *> CellContainer::getCellGroups() const {
@@ -578,51 +1280,107 @@ bool CellContainer::hasCellGroups() const {
 	return groupNames.size() > 0;
 }
 
+namespace {
+
+/**
+ * Splits the entities of a mesh in families: every group splits the families of its entities
+ * in two, the entities in the group getting a new family. Families are numbered in the order
+ * they are created, ids being positive for nodes and negative for cells.
+ *
+ * Families are indexed by the absolute value of their id in flat arrays: the family of an
+ * entity is a compact encoding of its group membership, so no hash map is needed to remap them.
+ */
+class FamilyBuilder final {
+private:
+	const int sign;
+	const string longNamePrefix;
+	/**
+	 * Created families, the first one being the family 0 (no group).
+	 */
+	vector<Family> families;
+	/**
+	 * New family given to the entities of an old family by the current group. It is valid
+	 * only if the group stamp of the old family is the one of the current group.
+	 */
+	vector<int> newFamilyByOldFamily;
+	vector<int> groupStampByOldFamily;
+	int groupStamp;
+	Group* group;
+public:
+	FamilyBuilder(int sign, const string& longNamePrefix) :
+			sign(sign), longNamePrefix(longNamePrefix), families(1), newFamilyByOldFamily(1), groupStampByOldFamily(
+					1, 0), groupStamp(0), group(nullptr) {
+	}
+
+	void beginGroup(Group* group) {
+		this->group = group;
+		groupStamp++;
+	}
+
+	/**
+	 * @return the family of an entity of oldFamily that belongs to the current group.
+	 */
+	int split(int oldFamily) {
+		const size_t oldIndex = static_cast<size_t>(abs(oldFamily));
+		if (groupStampByOldFamily[oldIndex] == groupStamp) {
+			return newFamilyByOldFamily[oldIndex];
+		}
+		const int index = static_cast<int>(families.size());
+		Family fam;
+		if (oldIndex != 0) {
+			const Family& old = families[oldIndex];
+			fam.groups = old.groups;
+			fam.name = old.name + "_" + group->getName();
+			if (fam.name.length() >= MED_LNAME_SIZE) {
+				fam.name = longNamePrefix + lexical_cast<string>(index);
+			}
+		} else {
+			fam.name = group->getName();
+		}
+		fam.groups.push_back(group);
+		fam.num = sign * index;
+		families.push_back(fam);
+		newFamilyByOldFamily.push_back(0);
+		groupStampByOldFamily.push_back(0);
+		groupStampByOldFamily[oldIndex] = groupStamp;
+		newFamilyByOldFamily[oldIndex] = fam.num;
+		return fam.num;
+	}
+
+	/**
+	 * Families given to at least one entity, sorted by id.
+	 */
+	vector<Family> familiesInUse(const vector<int>& entityFamilies) const {
+		vector<bool> inUse(families.size(), false);
+		for (int family : entityFamilies) {
+			inUse[static_cast<size_t>(abs(family))] = true;
+		}
+		vector<Family> result;
+		for (size_t i = 1; i < families.size(); i++) {
+			// negative ids are sorted by decreasing index
+			const size_t index = sign > 0 ? i : families.size() - i;
+			if (inUse[index]) {
+				result.push_back(families[index]);
+			}
+		}
+		return result;
+	}
+};
+
+}
+
 NodeGroup2Families::NodeGroup2Families(int nnodes, const vector<NodeGroup*> nodeGroups) {
-	int currentFamilyId = 0;
-	unordered_map<int, int> newFamilyByOldfamily;
-	unordered_map<int, Family> familyByFamilyId;
+	FamilyBuilder familyBuilder(1, "Family");
 	if (nnodes > 0 && nodeGroups.size() > 0) {
 		this->nodes.resize(nnodes, 0);
 		for (NodeGroup * nodeGroup : nodeGroups) {
-			newFamilyByOldfamily.clear();
-			for (int nodePosition : nodeGroup->nodePositions()) {
-				int oldFamily = nodes[nodePosition];
-				auto newFamilyPair = newFamilyByOldfamily.find(oldFamily);
-				int newFamilyId;
-				if (newFamilyPair == newFamilyByOldfamily.end()) {
-					//family not found, create one
-					currentFamilyId++;
-					Family fam;
-					auto oldFamilyPair = familyByFamilyId.find(oldFamily);
-					if (oldFamilyPair != familyByFamilyId.end()) {
-						Family& oldFamily = oldFamilyPair->second;
-						fam.groups.insert(fam.groups.begin(), oldFamily.groups.begin(),
-								oldFamily.groups.end());
-						fam.name = oldFamily.name + "_" + nodeGroup->getName();
-						if (fam.name.length() >= MED_LNAME_SIZE) {
-							fam.name = string("Family") + lexical_cast<string>(currentFamilyId);
-						}
-					} else {
-						fam.name = nodeGroup->getName();
-					}
-					newFamilyId = fam.num = currentFamilyId;
-					fam.groups.push_back(nodeGroup);
-					newFamilyByOldfamily.insert(make_pair(oldFamily, currentFamilyId));
-					familyByFamilyId.insert(make_pair(currentFamilyId, fam));
-				} else {
-					newFamilyId = newFamilyPair->second;
-				}
-				nodes[nodePosition] = newFamilyId;
+			familyBuilder.beginGroup(nodeGroup);
+			for (int nodePosition : nodeGroup->nodePositionSet()) {
+				nodes[nodePosition] = familyBuilder.split(nodes[nodePosition]);
 			}
 		}
 	}
-	set<int> familiesInUse(nodes.begin(), nodes.end());
-	for (int fam_id : familiesInUse) {
-		if (fam_id != 0) {
-			families.push_back(familyByFamilyId[fam_id]);
-		}
-	}
+	families = familyBuilder.familiesInUse(nodes);
 }
 
 vector<Family>& NodeGroup2Families::getFamilies() {
@@ -636,9 +1394,7 @@ vector<int>& NodeGroup2Families::getFamilyOnNodes() {
 CellGroup2Families::CellGroup2Families(
 		const Mesh* mesh, unordered_map<CellType::Code, int, hash<int>> cellCountByType,
 		const vector<CellGroup *>& cellGroups) : mesh(mesh) {
-	int currentFamilyId = 0;
-	unordered_map<int, int> newFamilyByOldfamily;
-	unordered_map<int, Family> familyByFamilyId;
+	FamilyBuilder familyBuilder(-1, "CELLFamily");
 	for (auto cellCountByTypePair : cellCountByType) {
 		shared_ptr<vector<int>> cells(new vector<int>());
 		cells->resize(cellCountByTypePair.second, 0);
@@ -646,50 +1402,26 @@ CellGroup2Families::CellGroup2Families(
 	}
 
 	for (CellGroup * cellGroup : cellGroups) {
-		newFamilyByOldfamily.clear();
-		for (auto cellPosition : cellGroup->cellPositions()) {
-			const Cell& cell = mesh->findCell(cellPosition);
-			shared_ptr<vector<int>> currentCellFamilies = cellFamiliesByType[cell.type.code];
-			int oldFamily = currentCellFamilies->at(cell.cellTypePosition);
-			auto newFamilyPair = newFamilyByOldfamily.find(oldFamily);
-			int newFamilyId;
-			if (newFamilyPair == newFamilyByOldfamily.end()) {
-				//family not found, create one
-				currentFamilyId--;
-				Family fam;
-				auto oldFamilyPair = familyByFamilyId.find(oldFamily);
-				if (oldFamilyPair != familyByFamilyId.end()) {
-					Family& oldFamily = oldFamilyPair->second;
-					fam.groups.insert(fam.groups.begin(), oldFamily.groups.begin(),
-							oldFamily.groups.end());
-					fam.name = oldFamily.name + "_" + cellGroup->getName();
-					if (fam.name.length() >= MED_LNAME_SIZE) {
-						fam.name = string("CELLFamily") + lexical_cast<string>(-currentFamilyId);
-					}
-				} else {
-					fam.name = cellGroup->getName();
-				}
-				newFamilyId = fam.num = currentFamilyId;
-				fam.groups.push_back(cellGroup);
-				newFamilyByOldfamily[oldFamily] = currentFamilyId;
-				familyByFamilyId[currentFamilyId] = fam;
-			} else {
-				newFamilyId = newFamilyPair->second;
+		familyBuilder.beginGroup(cellGroup);
+		CellType::Code currentTypeCode = CellType::POINT1_CODE;
+		vector<int>* currentCellFamilies = nullptr;
+		for (int cellPosition : cellGroup->cellPositionSet()) {
+			const CellView cell = mesh->findCellView(cellPosition);
+			if (currentCellFamilies == nullptr || cell.typeCode != currentTypeCode) {
+				currentTypeCode = cell.typeCode;
+				currentCellFamilies = cellFamiliesByType[cell.typeCode].get();
 			}
-			currentCellFamilies->at(cell.cellTypePosition) = newFamilyId;
+			int& family = (*currentCellFamilies)[cell.cellTypePosition];
+			family = familyBuilder.split(family);
 		}
 	}
 
-	set<int> familiesInUse;
+	vector<int> cellFamilies;
 	for (auto cellFamilyAndTypePair : cellFamiliesByType) {
-		familiesInUse.insert(cellFamilyAndTypePair.second->begin(),
+		cellFamilies.insert(cellFamilies.end(), cellFamilyAndTypePair.second->begin(),
 				cellFamilyAndTypePair.second->end());
 	}
-	for (int fam_id : familiesInUse) {
-		if (fam_id != 0) {
-			families.push_back(familyByFamilyId[fam_id]);
-		}
-	}
+	families = familyBuilder.familiesInUse(cellFamilies);
 }
 
 vector<Family>& CellGroup2Families::getFamilies() {
@@ -14,12 +14,18 @@
 
 #include "CoordinateSystem.h"
 #include "Dof.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <set>
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
 #include <string>
 #include <stdexcept>
 #include <iterator>
+#include <boost/range/iterator_range.hpp>
 #ifdef __GNUC__
 // Avoid tons of warnings with root code
 #pragma GCC system_header
@@ -144,6 +150,176 @@ public:
 	static const CellType* findByCode(Code code);
 };
 
+/**
+ * Set of non negative integers, positions or ids, used for the membership of groups.
+ *
+ * While the mesh is built it is a sorted vector: members are appended in any order, and
+ * sorted and deduplicated at once by the first read. compact() switches it to a compressed
+ * bitset in the way of roaring bitmaps: members are split in chunks of 2^16 values by their
+ * high bits, and a chunk is a sorted array of the low bits of its members while it has few of
+ * them, a bitmap otherwise. Both forms iterate in increasing order and can still be modified.
+ * A set can be read concurrently, the pending members being merged under a lock.
+ */
+class PositionSet final {
+private:
+	static const int CHUNK_BITS = 16;
+	/**
+	 * Beyond this count a chunk bitmap (8 KB) is smaller than its array.
+	 */
+	static const size_t MAX_ARRAY_SIZE = 4096;
+	static const size_t BITMAP_WORDS = (1 << CHUNK_BITS) / 64;
+	class Chunk final {
+	public:
+		int key;
+		size_t count;
+		/**
+		 * Low bits of the members, if the chunk is an array.
+		 */
+		std::vector<uint16_t> values;
+		/**
+		 * Empty if the chunk is an array.
+		 */
+		std::vector<uint64_t> bits;
+		explicit Chunk(int key);
+		bool isBitmap() const;
+		bool contains(uint16_t low) const;
+		bool insert(uint16_t low);
+		bool erase(uint16_t low);
+		/**
+		 * Smallest member not lower than low, or 1 << CHUNK_BITS. Only for bitmaps.
+		 */
+		int nextBit(int low) const;
+		std::vector<uint64_t> toBitmap() const;
+		/**
+		 * Chooses the representation of a chunk given as a bitmap.
+		 */
+		static Chunk fromBitmap(int key, std::vector<uint64_t>&& bits);
+		static Chunk fromArray(int key, std::vector<uint16_t>&& values);
+	};
+	bool compacted;
+	/**
+	 * Members of a set that is not compacted: sorted and unique up to mergedSize, followed
+	 * by the values appended since.
+	 */
+	mutable std::vector<int> sorted;
+	mutable size_t mergedSize;
+	std::vector<Chunk> chunks;
+	mutable size_t count;
+	mutable std::atomic<bool> pending;
+	mutable std::mutex mergeMutex;
+	std::vector<Chunk>::const_iterator findChunk(int key) const;
+	/**
+	 * Sorts and merges the appended values, if any.
+	 */
+	void merge() const;
+	static void checkValue(int value);
+public:
+	/**
+	 * Forward iterator over the members, in increasing order. Like the iterators of the
+	 * standard containers it is invalidated by a modification of the set.
+	 */
+	class const_iterator final: public std::iterator<std::forward_iterator_tag, const int> {
+	private:
+		friend PositionSet;
+		const PositionSet* set;
+		/**
+		 * Index in sorted, or index of the chunk if the set is compacted.
+		 */
+		size_t index;
+		/**
+		 * Index in the chunk array, or low bits of the member in a chunk bitmap.
+		 */
+		int inner;
+		int current;
+		const_iterator(const PositionSet* set, size_t index);
+		void seek();
+	public:
+		int operator*() const;
+		const_iterator& operator++();
+		const_iterator operator++(int);
+		bool operator==(const const_iterator& rhs) const;
+		bool operator!=(const const_iterator& rhs) const;
+	};
+	typedef const_iterator iterator;
+	PositionSet();
+	template<typename iterator>
+	PositionSet(iterator begin, iterator end) : PositionSet() {
+		insert(begin, end);
+	}
+	PositionSet(const PositionSet& other);
+	PositionSet(PositionSet&& other);
+	PositionSet& operator=(const PositionSet& other);
+	PositionSet& operator=(PositionSet&& other);
+	/**
+	 * Adds a value. On a set that is not compacted, a value lower than the last one is
+	 * appended and merged by the next read, so that members added in any order cost a
+	 * single sort.
+	 */
+	void insert(int value);
+	template<typename iterator>
+	void insert(iterator begin, iterator end) {
+		for (; begin != end; ++begin) {
+			insert(*begin);
+		}
+	}
+	/**
+	 * @return true if value was a member.
+	 */
+	bool erase(int value);
+	bool contains(int value) const;
+	size_t size() const;
+	bool empty() const;
+	void clear();
+	/**
+	 * Switches to the compressed representation, once the set is not expected to grow much.
+	 */
+	void compact();
+	bool isCompact() const;
+	const_iterator begin() const;
+	const_iterator end() const;
+	std::vector<int> toVector() const;
+	std::set<int> toSet() const;
+	bool operator==(const PositionSet& other) const;
+	bool operator!=(const PositionSet& other) const;
+	PositionSet& operator|=(const PositionSet& other);
+	PositionSet& operator&=(const PositionSet& other);
+	/**
+	 * The result is compacted if one of the operands is.
+	 */
+	static PositionSet unionOf(const PositionSet& a, const PositionSet& b);
+	static PositionSet intersectionOf(const PositionSet& a, const PositionSet& b);
+private:
+	/**
+	 * Sorts sorted[oldSize:], merges it with the rest and removes the duplicates.
+	 */
+	void mergeFrom(size_t oldSize) const;
+};
+
+/**
+ * Sorted node positions of a set of cells, computed on demand and kept while the set does
+ * not change. The owner stamps each of its modifications with Group::nextGeneration(), and
+ * the cache is valid for the generation it was computed for. It can be read concurrently.
+ */
+class NodeClosureCache final {
+private:
+	mutable std::mutex mutex;
+	mutable unsigned long generation;
+	mutable std::vector<int> nodePositions;
+public:
+	NodeClosureCache();
+	/**
+	 * The copy of a cache is empty.
+	 */
+	NodeClosureCache(const NodeClosureCache&);
+	NodeClosureCache& operator=(const NodeClosureCache&);
+	/**
+	 * The node positions, computed by compute if the cache is not valid for generation. The
+	 * reference is valid until the next modification of the owner.
+	 */
+	const std::vector<int>& get(unsigned long generation,
+			const std::function<std::vector<int>()>& compute) const;
+};
+
 class Mesh;
 class NodeStorage;
 class CellStorage;
@@ -165,17 +341,27 @@ public:
 	const Type type;
 	const std::string getName() const;
 	virtual const std::set<int> nodePositions() const = 0;
+	/**
+	 * Switches the members to their compressed representation, see PositionSet::compact().
+	 */
+	virtual void compact() = 0;
+	/**
+	 * A new stamp for a modification of a group or of a cell container, greater than all the
+	 * previous ones.
+	 */
+	static unsigned long nextGeneration();
 	virtual ~Group();
 };
 
 class NodeGroup final : public Group {
 private:
 	friend Mesh;
+	friend ModelSnapshot;
 	NodeGroup(Mesh* mesh, const std::string& name, int groupId);
 	/**
 	 * Positions of the nodes participating to the group
 	 */
-	std::set<int> _nodePositions;
+	PositionSet _nodePositions;
 public:
 	/**
 	 * Add a node using its numerical id. If the node hasn't been yet defined it reserve a
@@ -195,13 +381,19 @@ public:
 	void addNodeByPosition(int nodePosition);
 	void removeNodeByPosition(int nodePosition);
 	const std::set<int> nodePositions() const override;
+	/**
+	 * Positions of the nodes, without copy.
+	 */
+	const PositionSet& nodePositionSet() const;
 	const std::set<int> getNodeIds() const;
+	void compact() override;
 };
 
 class Node final {
 private:
 	friend ostream &operator<<(ostream &out, const Node& node);    //output
 	friend Mesh;
+	friend ModelSnapshot;
 	static int auto_node_id;
 	Node(int id, double x, double y, double z, int position, DOFS dofs,
 			int displacementCS = CoordinateSystem::GLOBAL_COORDINATE_SYSTEM_ID);
@@ -226,6 +418,7 @@ class Cell final {
 private:
 	friend ostream &operator<<(ostream &out, const Cell & cell);    //output
 	friend Mesh;
+	friend ModelSnapshot;
 	int findNodeIdPosition(int node_id2) const;
 	/**
 	 * Every face is identified by the nodes that belongs to that face
@@ -283,16 +476,82 @@ public:
 	virtual ~Cell();
 };
 
+/**
+ * Read-only view over a contiguous run of node positions, as stored in the mesh.
+ * It does not own the memory and is invalidated by the next cell insertion.
+ */
+typedef boost::iterator_range<const int*> NodePositionRange;
+/**
+ * Read-only view over a contiguous run of cell positions, with the same lifetime as
+ * NodePositionRange.
+ */
+typedef boost::iterator_range<const int*> CellPositionRange;
+
+/**
+ * Non-owning view of a cell stored in the mesh. Unlike Cell it does not copy the
+ * connectivity, so building one never allocates. Like NodePositionRange it is invalidated
+ * by the next cell insertion.
+ */
+class CellView final {
+private:
+	friend ostream &operator<<(ostream &out, const CellView & cellView);    //output
+public:
+	CellView(int position, int id, CellType::Code typeCode, int elementId, int cellTypePosition,
+			NodePositionRange nodePositions);
+	int position;
+	int id;
+	CellType::Code typeCode;
+	int elementId;
+	int cellTypePosition;
+	NodePositionRange nodePositions;
+	const CellType& type() const;
+	/**
+	 * Returns the name used in med file for this cell
+	 */
+	std::string getMedName() const;
+};
+
 class CellGroup final: public Group {
 private:
 	friend Mesh;
+	friend ModelSnapshot;
 	CellGroup(Mesh* mesh, std::string name);
+	/**
+	 * Positions of the cells participating to the group
+	 */
+	PositionSet _cellPositions;
+	unsigned long generation;
+	NodeClosureCache nodeClosure;
 public:
-	std::unordered_set<int> cellIds;
+	/**
+	 * Add a cell of the mesh using its numerical id.
+	 */
 	void addCell(int cellId);
-	std::vector<Cell> getCells();
-	std::vector<int> cellPositions();
+	void addCellByPosition(int cellPosition);
+	/**
+	 * Positions of the cells, without copy.
+	 */
+	const PositionSet& cellPositionSet() const;
+	std::vector<int> cellPositions() const;
+	std::vector<int> getCellIds() const;
+	std::vector<Cell> getCells() const;
+	/**
+	 * Calls visitor with a view of each cell of the group, in increasing position, without
+	 * copying the cells: prefer it to getCells() for large groups. The mesh must not get
+	 * new cells during the visit.
+	 */
+	void forEachCell(const std::function<void(const CellView&)>& visitor) const;
+	bool empty() const;
 	const std::set<int> nodePositions() const override;
+	/**
+	 * Sorted positions of the nodes of the cells, computed once per modification of the group.
+	 */
+	const std::vector<int>& nodePositionClosure() const;
+	/**
+	 * Stamp of the last modification, see Group::nextGeneration().
+	 */
+	unsigned long getGeneration() const;
+	void compact() override;
 	virtual ~CellGroup();
 };
 
@@ -317,7 +576,11 @@ public:
 	const Node operator*();
 };
 
-class CellIterator final: public std::iterator<std::input_iterator_tag, const Cell> {
+/**
+ * Iterates over the cells of a given type, yielding views on the mesh storage.
+ * Use Mesh::findCell on the view position to obtain a full Cell.
+ */
+class CellIterator final: public std::iterator<std::input_iterator_tag, const CellView> {
 private:
 	friend CellStorage;
 	const CellStorage* cellStorage;
@@ -326,7 +589,7 @@ private:
 	unsigned int position;
 	bool equal(CellIterator const& other) const;
 	void increment(int i);
-	const Cell dereference() const;
+	const CellView dereference() const;
 	friend Mesh;
 	CellIterator(const CellStorage* cellStorage, const CellType &cellType, bool begin);
 public:
@@ -335,12 +598,12 @@ public:
 
 	virtual ~CellIterator();
 	bool hasNext() const;
-	const Cell next();
+	const CellView next();
 	CellIterator& operator++();
 	CellIterator operator++(int);
 	bool operator==(const CellIterator& rhs) const;
 	bool operator!=(const CellIterator& rhs) const;
-	const Cell operator*() const;
+	const CellView operator*() const;
 };
 
 class NodeContainerMixin final {
@@ -373,16 +636,28 @@ public:
  *
  */
 class CellContainer {
+	friend ModelSnapshot;
 protected:
 	std::shared_ptr<Mesh> mesh;
-	std::unordered_set<int> cellIds;
-	std::unordered_set<std::string> groupNames;
+	PositionSet cellPositions;
+	/**
+	 * Ids of the cells added before the mesh had them, e.g. by a load card read before the
+	 * element cards: their positions are looked up at each read.
+	 */
+	PositionSet pendingCellIds;
+	std::set<std::string> groupNames;
+	/**
+	 * Stamp of the last modification, see Group::nextGeneration().
+	 */
+	unsigned long generation;
+	NodeClosureCache nodeClosure;
 public:
 	CellContainer(std::shared_ptr<Mesh> mesh);
 	/**
 	 * Adds a cellId to the current set
 	 */
 	void addCell(int cellId);
+	void addCellByPosition(int cellPosition);
 	void addCellGroup(const std::string& groupName);
 	void add(const Cell& cell);
 	void add(const CellGroup& cellGroup);
@@ -396,8 +671,22 @@ public:
 	 * @param all: if true include also the cells inside all the cellGroups
 	 */
 	std::vector<int> getCellIds(bool all = false) const;
-
-	std::set<int> nodePositions() const;
+	/**
+	 * Returns the positions of the cells contained into the Container
+	 * @param all: if true include also the cells inside all the cellGroups
+	 */
+	std::vector<int> getCellPositions(bool all = false) const;
+	/**
+	 * Calls visitor with a view of each cell, in the order of getCells(), without copying
+	 * the cells.
+	 * @param all: if true include also the cells inside all the cellGroups
+	 */
+	void forEachCell(const std::function<void(const CellView&)>& visitor, bool all = false) const;
+	/**
+	 * Sorted positions of the nodes of the cells and of the cells of the groups, computed
+	 * again only when the container or one of its groups has changed.
+	 */
+	const std::vector<int>& nodePositions() const;
 
 	bool containsCells(CellType cellType, bool all = false);
 	/**
@@ -412,6 +701,12 @@ public:
 	 */
 	bool hasCells() const;
 	std::vector<CellGroup *> getCellGroups() const;
+private:
+	/**
+	 * Sorted positions of the cells added to the container, without those of the groups.
+	 */
+	std::vector<int> ownCellPositions() const;
+public:
 	virtual ~CellContainer() {
 	}
 };
@@ -9,10 +9,14 @@
  */
 
 #include "Model.h"
+#include "PassScheduler.h"
+#include "Profiler.h"
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <fstream>
+#include <unordered_map>
 #include <boost/lexical_cast.hpp>
 #include <boost/assign.hpp>
 #include <boost/unordered_map.hpp>
@@ -24,7 +28,7 @@ namespace vega {
 
 Model::Model(string name, string inputSolverVersion, SolverName inputSolver,
         const ModelConfiguration configuration) :
-        name(name), inputSolverVersion(inputSolverVersion), //
+        arena(make_shared<ModelArena>()), name(name), inputSolverVersion(inputSolverVersion), //
         inputSolver(inputSolver), //
         modelType(ModelType::TRIDIMENSIONAL_SI), //
         configuration(configuration), commonLoadSet(*this, LoadSet::ALL, LoadSet::COMMON_SET_ID), commonConstraintSet(
@@ -38,6 +42,14 @@ Model::Model(string name, string inputSolverVersion, SolverName inputSolver,
 Model::~Model() {
 }
 
+const shared_ptr<ModelArena>& Model::getArena() const {
+    return arena;
+}
+
+const shared_ptr<ModelArena>& arenaOf(const Model& model) {
+    return model.getArena();
+}
+
 template<class T>
 void Model::Container<T>::add(const T& t) {
     shared_ptr<T> ptr = t.clone();
@@ -147,6 +159,7 @@ void Model::add(const Analysis& analysis) {
         cout << "Adding " << analysis << endl;
     }
     analyses.add(analysis);
+    invalidateSetClassification();
 }
 
 void Model::add(const Loading& loading) {
@@ -161,6 +174,7 @@ void Model::add(const LoadSet& loadSet) {
         cout << "Adding " << loadSet << endl;
     }
     loadSets.add(loadSet);
+    invalidateSetClassification();
 }
 
 void Model::add(const Constraint& constraint) {
@@ -175,6 +189,7 @@ void Model::add(const ConstraintSet& constraintSet) {
         cout << "Adding " << constraintSet << endl;
     }
     constraintSets.add(constraintSet);
+    invalidateSetClassification();
 }
 
 void Model::add(const Objective& objective) {
@@ -205,42 +220,66 @@ void Model::add(const ElementSet& elementSet) {
     elementSets.add(elementSet);
 }
 
-template<>
-void Model::remove(const Reference<Constraint> constraintReference) {
-    for (auto it : constraintReferences_by_constraintSet_ids) {
-        for (auto it2 : it.second) {
-            if (*it2 == constraintReference)
-                constraintReferences_by_constraintSet_ids[it.first].erase(it2);
+namespace {
+
+/**
+ * Removes the references equal to a given one from a set of references.
+ */
+template<class T>
+void eraseReferences(set<Reference<T>>& references, const Reference<T>& reference) {
+    for (auto it = references.begin(); it != references.end();) {
+        if (*it == reference) {
+            it = references.erase(it);
+        } else {
+            ++it;
         }
     }
-    for (auto it : constraintReferences_by_constraintSet_original_ids_by_constraintSet_type) {
-        for (auto it2 : it.second) {
-            for (auto it3 : it2.second) {
-                if (*it3 == constraintReference)
-                    constraintReferences_by_constraintSet_original_ids_by_constraintSet_type[it.first][it2.first].erase(
-                            it3);
+}
+
+}
+
+template<class S>
+void Model::addSetKeys(const Reference<S>& setReference, set<Reference<S>>& setKeys) {
+    if (setReference.has_id())
+        setKeys.insert(Reference<S>(setReference.type, Reference<S>::NO_ID, setReference.id));
+    if (setReference.has_original_id())
+        setKeys.insert(Reference<S>(setReference.type, setReference.original_id));
+}
+
+template<>
+void Model::remove(const Reference<Constraint> constraintReference) {
+    auto itk = constraintSetKeys_by_constraint.find(constraintReference);
+    if (itk != constraintSetKeys_by_constraint.end()) {
+        // only the sets the constraint was added to are visited
+        for (const auto& setKey : itk->second) {
+            if (setKey.has_original_id()) {
+                eraseReferences(
+                        constraintReferences_by_constraintSet_original_ids_by_constraintSet_type[setKey.type][setKey.original_id],
+                        constraintReference);
+            } else {
+                eraseReferences(constraintReferences_by_constraintSet_ids[setKey.id],
+                        constraintReference);
             }
         }
+        constraintSetKeys_by_constraint.erase(itk);
     }
     constraints.erase(constraintReference);
 }
 
 template<>
 void Model::remove(const Reference<Loading> loadingReference) {
-    for (auto it : loadingReferences_by_loadSet_ids) {
-        for (auto it2 : it.second) {
-            if (*it2 == loadingReference)
-                loadingReferences_by_loadSet_ids[it.first].erase(it2);
-        }
-    }
-    for (auto it : loadingReferences_by_loadSet_original_ids_by_loadSet_type) {
-        for (auto it2 : it.second) {
-            for (auto it3 : it2.second) {
-                if (*it3 == loadingReference)
-                    loadingReferences_by_loadSet_original_ids_by_loadSet_type[it.first][it2.first].erase(
-                            it3);
+    auto itk = loadSetKeys_by_loading.find(loadingReference);
+    if (itk != loadSetKeys_by_loading.end()) {
+        for (const auto& setKey : itk->second) {
+            if (setKey.has_original_id()) {
+                eraseReferences(
+                        loadingReferences_by_loadSet_original_ids_by_loadSet_type[setKey.type][setKey.original_id],
+                        loadingReference);
+            } else {
+                eraseReferences(loadingReferences_by_loadSet_ids[setKey.id], loadingReference);
             }
         }
+        loadSetKeys_by_loading.erase(itk);
     }
     loadings.erase(loadingReference);
 }
@@ -256,6 +295,7 @@ void Model::remove(const Reference<LoadSet> loadSetReference) {
         }
     }
     loadSets.erase(loadSetReference);
+    invalidateSetClassification();
 }
 
 template<>
@@ -269,6 +309,7 @@ void Model::remove(const Reference<ConstraintSet> constraintSetReference) {
         }
     }
     constraintSets.erase(constraintSetReference);
+    invalidateSetClassification();
 }
 
 template<>
@@ -354,12 +395,12 @@ const shared_ptr<ElementSet> Model::find(const Reference<ElementSet> reference)
 
 void Model::addLoadingIntoLoadSet(const Reference<Loading>& loadingReference,
         const Reference<LoadSet>& loadSetReference) {
-    shared_ptr<Reference<Loading>> loadingReference_ptr = loadingReference.clone();
     if (loadSetReference.has_id())
-        loadingReferences_by_loadSet_ids[loadSetReference.id].insert(loadingReference_ptr);
+        loadingReferences_by_loadSet_ids[loadSetReference.id].insert(loadingReference);
     if (loadSetReference.has_original_id())
         loadingReferences_by_loadSet_original_ids_by_loadSet_type[loadSetReference.type][loadSetReference.original_id].insert(
-                loadingReference_ptr);
+                loadingReference);
+    addSetKeys(loadSetReference, loadSetKeys_by_loading[loadingReference]);
     if (loadSetReference == commonLoadSet.getReference() && !find(commonLoadSet.getReference()))
         add(commonLoadSet); // commonLoadSet is added to the model if needed
     if (!this->find(loadSetReference)) {
@@ -374,7 +415,7 @@ const set<shared_ptr<Loading>> Model::getLoadingsByLoadSet(
     auto itm = loadingReferences_by_loadSet_ids.find(loadSetReference.id);
     if (itm != loadingReferences_by_loadSet_ids.end()) {
         for (auto itm2 : itm->second) {
-            result.insert(find(*itm2));
+            result.insert(find(itm2));
         }
     }
     auto itm2 = loadingReferences_by_loadSet_original_ids_by_loadSet_type.find(
@@ -383,22 +424,43 @@ const set<shared_ptr<Loading>> Model::getLoadingsByLoadSet(
         auto itm3 = itm2->second.find(loadSetReference.original_id);
         if (itm3 != itm2->second.end()) {
             for (auto itm4 : itm3->second) {
-                result.insert(find(*itm4));
+                result.insert(find(itm4));
             }
         }
     }
     return result;
 }
 
+const set<shared_ptr<LoadSet>> Model::getLoadSetsByLoading(
+        const Reference<Loading>& loadingReference) const {
+    set<shared_ptr<LoadSet>> result;
+    for (const auto& setKey : getLoadSetKeysByLoading(loadingReference)) {
+        shared_ptr<LoadSet> loadSet = loadSets.find(setKey);
+        if (loadSet) {
+            result.insert(loadSet);
+        }
+    }
+    return result;
+}
+
+boost::iterator_range<set<Reference<LoadSet>>::const_iterator> Model::getLoadSetKeysByLoading(
+        const Reference<Loading>& loadingReference) const {
+    static const set<Reference<LoadSet>> NO_KEYS;
+    auto itk = loadSetKeys_by_loading.find(loadingReference);
+    const set<Reference<LoadSet>>& setKeys =
+            itk == loadSetKeys_by_loading.end() ? NO_KEYS : itk->second;
+    return boost::make_iterator_range(setKeys.begin(), setKeys.end());
+}
+
 void Model::addConstraintIntoConstraintSet(const Reference<Constraint>& constraintReference,
         const Reference<ConstraintSet>& constraintSetReference) {
-    shared_ptr<Reference<Constraint>> constraintReference_ptr = constraintReference.clone();
     if (constraintSetReference.has_id())
         constraintReferences_by_constraintSet_ids[constraintSetReference.id].insert(
-                constraintReference_ptr);
+                constraintReference);
     if (constraintSetReference.has_original_id())
         constraintReferences_by_constraintSet_original_ids_by_constraintSet_type[constraintSetReference.type][constraintSetReference.original_id].insert(
-                constraintReference_ptr);
+                constraintReference);
+    addSetKeys(constraintSetReference, constraintSetKeys_by_constraint[constraintReference]);
     if (constraintSetReference == commonConstraintSet.getReference()
             && !find(commonConstraintSet.getReference()))
         add(commonConstraintSet); // commonConstraintSet is added to the model if needed
@@ -410,7 +472,7 @@ const set<shared_ptr<Constraint>> Model::getConstraintsByConstraintSet(
     auto itm = constraintReferences_by_constraintSet_ids.find(constraintSetReference.id);
     if (itm != constraintReferences_by_constraintSet_ids.end()) {
         for (auto itm2 : itm->second) {
-            result.insert(find(*itm2));
+            result.insert(find(itm2));
         }
     }
     auto itm2 = constraintReferences_by_constraintSet_original_ids_by_constraintSet_type.find(
@@ -419,7 +481,7 @@ const set<shared_ptr<Constraint>> Model::getConstraintsByConstraintSet(
         auto itm3 = itm2->second.find(constraintSetReference.original_id);
         if (itm3 != itm2->second.end()) {
             for (auto itm4 : itm3->second) {
-                result.insert(find(*itm4));
+                result.insert(find(itm4));
             }
         }
     }
@@ -429,176 +491,212 @@ const set<shared_ptr<Constraint>> Model::getConstraintsByConstraintSet(
 const set<shared_ptr<ConstraintSet>> Model::getConstraintSetsByConstraint(
         const Reference<Constraint>& constraintReference) const {
     set<shared_ptr<ConstraintSet>> result;
-    for (const auto& it : constraintSets) {
-        set<shared_ptr<Constraint>> constraints = getConstraintsByConstraintSet(it->getReference());
-        bool found = false;
-        for (auto& constraint : constraints) {
-            if (constraint == nullptr) {
-                throw logic_error("Missing constraint declared in constraintSet : " + to_str(*it));
-            }
-            if (constraint->getReference() == constraintReference) {
-                found = true;
-                break;
-            }
-        }
-        if (found) {
-            result.insert(it);
+    for (const auto& setKey : getConstraintSetKeysByConstraint(constraintReference)) {
+        shared_ptr<ConstraintSet> constraintSet = constraintSets.find(setKey);
+        if (constraintSet) {
+            result.insert(constraintSet);
         }
     }
     return result;
 }
 
-const vector<shared_ptr<ConstraintSet>> Model::getActiveConstraintSets() const {
-    vector<shared_ptr<ConstraintSet>> result;
-    set<shared_ptr<ConstraintSet>> set;
-    for (auto analyse : analyses) {
-        for (auto constraintSet : analyse->getConstraintSets()) {
-            if (set.find(constraintSet) == set.end()) {
-                set.insert(constraintSet);
-                result.push_back(constraintSet);
-            }
-        }
-    }
-    return result;
+boost::iterator_range<set<Reference<ConstraintSet>>::const_iterator> Model::getConstraintSetKeysByConstraint(
+        const Reference<Constraint>& constraintReference) const {
+    static const set<Reference<ConstraintSet>> NO_KEYS;
+    auto itk = constraintSetKeys_by_constraint.find(constraintReference);
+    const set<Reference<ConstraintSet>>& setKeys =
+            itk == constraintSetKeys_by_constraint.end() ? NO_KEYS : itk->second;
+    return boost::make_iterator_range(setKeys.begin(), setKeys.end());
 }
 
-const vector<shared_ptr<LoadSet>> Model::getActiveLoadSets() const {
-    vector<shared_ptr<LoadSet>> result;
-    set<shared_ptr<LoadSet>> set;
-    for (auto analyse : analyses) {
-        for (auto loadSet : analyse->getLoadSets()) {
-            if (set.find(loadSet) == set.end()) {
-                set.insert(loadSet);
-                result.push_back(loadSet);
+namespace {
+
+/**
+ * Fills the usage of the sets used by the analyses, and the active sets in the order of
+ * their first use.
+ */
+template<class S, class A, class F>
+void classifyByAnalyses(const A& analyses, F setsOf, vector<shared_ptr<S>>& active,
+        map<shared_ptr<S>, boost::dynamic_bitset<>>& usage_by_set) {
+    const size_t analysisCount = static_cast<size_t>(analyses.size());
+    size_t analysisIndex = 0;
+    for (const auto& analysis : analyses) {
+        for (const auto& set : setsOf(*analysis)) {
+            auto it = usage_by_set.find(set);
+            if (it == usage_by_set.end()) {
+                it = usage_by_set.insert(make_pair(set, boost::dynamic_bitset<>(analysisCount))).first;
+                active.push_back(set);
             }
+            it->second.set(analysisIndex);
         }
+        analysisIndex++;
     }
-    return result;
 }
 
-const vector<shared_ptr<ConstraintSet>> Model::getCommonConstraintSets() const {
-    vector<shared_ptr<ConstraintSet>> result;
-    map<shared_ptr<ConstraintSet>, int> map;
-    for (auto analyse : analyses) {
-        for (auto constraintSet : analyse->getConstraintSets()) {
-            map[constraintSet] += 1;
-        }
-    }
-    for (auto constraintSet : constraintSets) {
-        auto it = map.find(constraintSet);
-        if (it != map.end() && it->second == analyses.size())
-            result.push_back(constraintSet);
-    }
-    return result;
 }
 
-const vector<shared_ptr<LoadSet>> Model::getCommonLoadSets() const {
-    vector<shared_ptr<LoadSet>> result;
-    map<shared_ptr<LoadSet>, int> map;
-    for (auto analyse : analyses) {
-        for (auto loadSet : analyse->getLoadSets()) {
-            map[loadSet] += 1;
-        }
+void Model::classifySets() const {
+    if (setsClassified.load(std::memory_order_acquire)) {
+        return;
     }
-    for (auto loadSet : loadSets) {
-        auto it = map.find(loadSet);
+    lock_guard<mutex> lock(classificationMutex);
+    if (setsClassified.load(std::memory_order_relaxed)) {
+        return;
+    }
+    loadSetClassification = SetClassification<LoadSet>();
+    constraintSetClassification = SetClassification<ConstraintSet>();
+    classifyByAnalyses(analyses, [](const Analysis& analysis) {return analysis.getLoadSets();},
+            loadSetClassification.active, loadSetClassification.usage_by_set);
+    classifyByAnalyses(analyses,
+            [](const Analysis& analysis) {return analysis.getConstraintSets();},
+            constraintSetClassification.active, constraintSetClassification.usage_by_set);
+    for (const auto& loadSet : loadSets) {
+        auto it = loadSetClassification.usage_by_set.find(loadSet);
         // DLOAD is never common
-        if (it != map.end() && it->second == analyses.size() && loadSet->type != LoadSet::DLOAD)
-            result.push_back(loadSet);
+        if (it == loadSetClassification.usage_by_set.end() || loadSet->type == LoadSet::DLOAD)
+            continue;
+        if (it->second.all())
+            loadSetClassification.common.push_back(loadSet);
+        else
+            loadSetClassification.uncommon.insert(loadSet);
+    }
+    for (const auto& constraintSet : constraintSets) {
+        auto it = constraintSetClassification.usage_by_set.find(constraintSet);
+        if (it == constraintSetClassification.usage_by_set.end())
+            continue;
+        if (it->second.all())
+            constraintSetClassification.common.push_back(constraintSet);
+        else
+            constraintSetClassification.uncommon.insert(constraintSet);
     }
-    return result;
+    setsClassified.store(true, std::memory_order_release);
+}
+
+void Model::invalidateSetClassification() {
+    lock_guard<mutex> lock(classificationMutex);
+    setsClassified.store(false, std::memory_order_release);
+}
+
+const vector<shared_ptr<ConstraintSet>> Model::getActiveConstraintSets() const {
+    classifySets();
+    lock_guard<mutex> lock(classificationMutex);
+    return constraintSetClassification.active;
+}
+
+const vector<shared_ptr<LoadSet>> Model::getActiveLoadSets() const {
+    classifySets();
+    lock_guard<mutex> lock(classificationMutex);
+    return loadSetClassification.active;
+}
+
+const vector<shared_ptr<ConstraintSet>> Model::getCommonConstraintSets() const {
+    classifySets();
+    lock_guard<mutex> lock(classificationMutex);
+    return constraintSetClassification.common;
+}
+
+const vector<shared_ptr<LoadSet>> Model::getCommonLoadSets() const {
+    classifySets();
+    lock_guard<mutex> lock(classificationMutex);
+    return loadSetClassification.common;
 }
 
 const set<shared_ptr<ConstraintSet>> Model::getUncommonConstraintSets() const {
-    set<shared_ptr<ConstraintSet>> result;
-    map<shared_ptr<ConstraintSet>, int> map;
-    for (auto analyse : analyses) {
-        for (auto constraintSet : analyse->getConstraintSets()) {
-            map[constraintSet] += 1;
-        }
-    }
-    for (auto constraintSet : constraintSets) {
-        auto it = map.find(constraintSet);
-        if (it != map.end() && it->second < analyses.size())
-            result.insert(constraintSet);
-    }
-    return result;
+    classifySets();
+    lock_guard<mutex> lock(classificationMutex);
+    return constraintSetClassification.uncommon;
 }
 
 const set<shared_ptr<LoadSet>> Model::getUncommonLoadSets() const {
-    set<shared_ptr<LoadSet>> result;
-    map<shared_ptr<LoadSet>, int> map;
-    for (auto analyse : analyses) {
-        for (auto loadSet : analyse->getLoadSets()) {
-            map[loadSet] += 1;
-        }
-    }
-    for (auto loadSet : loadSets) {
-        auto it = map.find(loadSet);
-        if ((it != map.end() && it->second < analyses.size()) && loadSet->type != LoadSet::DLOAD)
-            result.insert(loadSet);
+    classifySets();
+    lock_guard<mutex> lock(classificationMutex);
+    return loadSetClassification.uncommon;
+}
+
+namespace {
+
+/**
+ * Adds to missingDOFS the DOFS of requiredDOFS that are not in availableDOFS, all of them
+ * being DOFS codes indexed by node position. A plain loop over the codes, vectorized by the
+ * compiler.
+ */
+void addMissingDOFS(const vector<char>& requiredDOFS, const vector<char>& availableDOFS,
+        vector<char>& missingDOFS) {
+    const size_t count = min(requiredDOFS.size(), min(availableDOFS.size(), missingDOFS.size()));
+    const char* required = requiredDOFS.data();
+    const char* available = availableDOFS.data();
+    char* missing = missingDOFS.data();
+    for (size_t i = 0; i < count; i++) {
+        missing[i] = static_cast<char>(missing[i] | (required[i] & ~available[i]));
     }
-    return result;
+}
+
 }
 
 void Model::generateDiscrets() {
+    Profiler::Scope scope("generateDiscrets");
 
     //rigid constraints
     CellGroup* virtualDiscretTRGroup = nullptr;
 
     CellGroup* virtualDiscretTGroup = nullptr;
 
-    for (Node node : this->mesh->nodes) {
-        DOFS missingDOFS;
-
-        for (auto& analysis : analyses) {
+    // DOFS required by the boundary conditions of at least one analysis but not by the elements,
+    // for all the nodes
+    const vector<char>& nodeDOFS = mesh->nodes.getDOFS();
+    vector<char> missingDOFSByNodePosition(nodeDOFS.size(), 0);
+    for (const auto& analysis : analyses) {
+        addMissingDOFS(analysis->getBoundaryDOFS(), nodeDOFS, missingDOFSByNodePosition);
+    }
 
-            DOFS requiredDOFS = analysis->findBoundaryDOFS(node.position);
-            if (!node.dofs.containsAll(requiredDOFS)) {
-                missingDOFS = missingDOFS + requiredDOFS - node.dofs;
-            }
+    for (size_t position = 0; position < missingDOFSByNodePosition.size(); position++) {
+        DOFS missingDOFS = missingDOFSByNodePosition[position];
+        if (missingDOFS == DOFS::NO_DOFS) {
+            continue;
         }
+        const int nodePosition = static_cast<int>(position);
+        const int nodeId = mesh->nodes.getIds()[position];
+        // the DOFS of the node before the discrete is added
+        const DOFS dofs = nodeDOFS[position];
 
         DOFS addedDOFS;
-        if (missingDOFS.size() != 0) {
-            if (missingDOFS.containsAnyOf(DOFS::ROTATIONS)) {
-                //extra dofs added by the DISCRET. They need to be blocked.
-                addedDOFS = DOFS::ALL_DOFS - node.dofs - missingDOFS;
-                if (virtualDiscretTRGroup == nullptr) {
-                    DiscretePoint virtualDiscretTR(*this, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
-                    virtualDiscretTRGroup = mesh->createCellGroup("VDiscrTR");
-                    virtualDiscretTR.assignCellGroup(virtualDiscretTRGroup);
-                    virtualDiscretTR.assignMaterial(getVirtualMaterial());
-                    this->add(virtualDiscretTR);
-                }
-                vector<int> cellNodes;
-                cellNodes.push_back(node.id);
-                mesh->allowDOFS(node.position, DOFS::ALL_DOFS);
-                int cellPosition = mesh->addCell(Cell::AUTO_ID, CellType::POINT1, cellNodes,
-                        true);
-                virtualDiscretTRGroup->addCell(mesh->findCell(cellPosition).id);
-            } else {
-                addedDOFS = DOFS::TRANSLATIONS - node.dofs - missingDOFS;
-                if (virtualDiscretTGroup == nullptr) {
-                    DiscretePoint virtualDiscretT(*this, 0.0, 0.0, 0.0);
-                    virtualDiscretTGroup = mesh->createCellGroup("VDiscrT");
-                    virtualDiscretT.assignCellGroup(virtualDiscretTGroup);
-                    virtualDiscretT.assignMaterial(getVirtualMaterial());
-                    this->add(virtualDiscretT);
-                }
-                int cellPosition = mesh->addCell(Cell::AUTO_ID, CellType::POINT1, { node.id },
-                        true);
-                virtualDiscretTGroup->addCell(mesh->findCell(cellPosition).id);
-                mesh->allowDOFS(node.position, DOFS::TRANSLATIONS);
+        if (missingDOFS.containsAnyOf(DOFS::ROTATIONS)) {
+            //extra dofs added by the DISCRET. They need to be blocked.
+            addedDOFS = DOFS::ALL_DOFS - dofs - missingDOFS;
+            if (virtualDiscretTRGroup == nullptr) {
+                DiscretePoint virtualDiscretTR(*this, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+                virtualDiscretTRGroup = mesh->createCellGroup("VDiscrTR");
+                virtualDiscretTR.assignCellGroup(virtualDiscretTRGroup);
+                virtualDiscretTR.assignMaterial(getVirtualMaterial());
+                this->add(virtualDiscretTR);
+            }
+            vector<int> cellNodes;
+            cellNodes.push_back(nodeId);
+            mesh->allowDOFS(nodePosition, DOFS::ALL_DOFS);
+            int cellPosition = mesh->addCell(Cell::AUTO_ID, CellType::POINT1, cellNodes,
+                    true);
+            virtualDiscretTRGroup->addCellByPosition(cellPosition);
+        } else {
+            addedDOFS = DOFS::TRANSLATIONS - dofs - missingDOFS;
+            if (virtualDiscretTGroup == nullptr) {
+                DiscretePoint virtualDiscretT(*this, 0.0, 0.0, 0.0);
+                virtualDiscretTGroup = mesh->createCellGroup("VDiscrT");
+                virtualDiscretT.assignCellGroup(virtualDiscretTGroup);
+                virtualDiscretT.assignMaterial(getVirtualMaterial());
+                this->add(virtualDiscretT);
             }
+            int cellPosition = mesh->addCell(Cell::AUTO_ID, CellType::POINT1, { nodeId },
+                    true);
+            virtualDiscretTGroup->addCellByPosition(cellPosition);
+            mesh->allowDOFS(nodePosition, DOFS::TRANSLATIONS);
         }
 
         for (auto& analysis : analyses) {
             ConstraintSet* spcSet = nullptr;
 
-            DOFS requiredDOFS = analysis->findBoundaryDOFS(node.position);
-            if (!node.dofs.containsAll(requiredDOFS)) {
-                DOFS extraDOFS = addedDOFS - requiredDOFS - node.dofs;
+            DOFS requiredDOFS = analysis->findBoundaryDOFS(nodePosition);
+            if (!dofs.containsAll(requiredDOFS)) {
+                DOFS extraDOFS = addedDOFS - requiredDOFS - dofs;
 
                 if (extraDOFS != DOFS::NO_DOFS) {
                     if (spcSet == nullptr) {
@@ -606,12 +704,12 @@ void Model::generateDiscrets() {
                         add(*spcSet);
                     }
                     SinglePointConstraint spc = SinglePointConstraint(*this, extraDOFS);
-                    spc.addNodeId(node.id);
+                    spc.addNodeId(nodeId);
                     add(spc);
                     addConstraintIntoConstraintSet(spc, *spcSet);
                     analysis->add(*spcSet);
                     if (configuration.logLevel >= LogLevel::DEBUG) {
-                        cout << "Adding virtual spc on node: id: " << node.id << "for " << extraDOFS
+                        cout << "Adding virtual spc on node: id: " << nodeId << "for " << extraDOFS
                                 << endl;
                     }
                 }
@@ -678,6 +776,7 @@ const vector<shared_ptr<Beam>> Model::getBeams() const {
 
 
 void Model::generateSkin() {
+    Profiler::Scope scope("generateSkin");
     for (Container<Loading>::iterator it = loadings.begin(); it != loadings.end(); it++) {
         shared_ptr<Loading> loadingPtr = *it;
         if (loadingPtr->applicationType == Loading::ELEMENT) {
@@ -734,7 +833,22 @@ Cell Model::generateSkinCell(const vector<int>& faceIds, const SpaceDimension& d
     return mesh->findCell(cellPosition);
 }
 
+void Model::transformLocalNodePositions() {
+    Profiler::Scope scope("transformLocalNodePositions");
+    for (const auto& it : mesh->getNodePositionsByPositionCS()) {
+        shared_ptr<CoordinateSystem> coordSystem = find(
+                Reference<CoordinateSystem>(CoordinateSystem::UNKNOWN, it.first));
+        if (!coordSystem) {
+            throw logic_error(
+                    "Coordinate system id: " + to_string(it.first)
+                            + " for node positions not found.");
+        }
+        mesh->transformNodePositionsToGlobal(*coordSystem, it.second);
+    }
+}
+
 void Model::emulateLocalDisplacementConstraint() {
+    Profiler::Scope scope("emulateLocalDisplacementConstraint");
     boost::unordered_map<shared_ptr<Constraint>, set<LinearMultiplePointConstraint*>> linearMultiplePointConstraintsByConstraint;
     // first pass : create LinearMultiplePoint constraints for each constraint that need it
     for (auto it = constraints.begin(); it != constraints.end(); it++) {
@@ -748,13 +862,13 @@ void Model::emulateLocalDisplacementConstraint() {
                     shared_ptr<CoordinateSystem> coordSystem = find(
                             Reference<CoordinateSystem>(CoordinateSystem::UNKNOWN,
                                     node.displacementCS));
-                    coordSystem->updateLocalBase(VectorialValue(node.x, node.y, node.z));
+                    const VectorialValue point(node.x, node.y, node.z);
                     DOFS dofs = constraint->getDOFSForNode(nodePosition);
                     for (int i = 0; i < 6; i++) {
                         vega::DOF currentDOF = *DOF::dofByPosition[i];
                         if (dofs.contains(currentDOF)) {
-                            VectorialValue participation = coordSystem->vectorToGlobal(
-                                    VectorialValue::XYZ[i % 3]);
+                            VectorialValue participation = coordSystem->vectorToGlobalAt(
+                                    point, VectorialValue::XYZ[i % 3]);
                             LinearMultiplePointConstraint* lmpc =
                                     new LinearMultiplePointConstraint(*this,
                                             spc->getDoubleForDOF(currentDOF));
@@ -776,13 +890,14 @@ void Model::emulateLocalDisplacementConstraint() {
     // second pass : insert the new LinearMultiplePointConstraints into the model and the constraintSets
     for (auto it : linearMultiplePointConstraintsByConstraint) {
         shared_ptr<Constraint> constraint = it.first;
-        const set<shared_ptr<ConstraintSet>> constraintSets = getConstraintSetsByConstraint(
+        // read in place, the keys of the constraint are not modified by adding others
+        const auto constraintSetKeys = getConstraintSetKeysByConstraint(
                 constraint->getReference());
         for (auto linearMultiplePointConstraint : it.second) {
             add(*linearMultiplePointConstraint);
-            for (auto constraintSet : constraintSets) {
+            for (const auto& constraintSetKey : constraintSetKeys) {
                 addConstraintIntoConstraintSet(linearMultiplePointConstraint->getReference(),
-                        constraintSet->getReference());
+                        constraintSetKey);
             }
             delete linearMultiplePointConstraint;
         }
@@ -792,6 +907,7 @@ void Model::emulateLocalDisplacementConstraint() {
 }
 
 void Model::emulateAdditionalMass() {
+    Profiler::Scope scope("emulateAdditionalMass");
     vector<shared_ptr<ElementSet>> newElementSets;
     for (auto elementSet : elementSets) {
         double rho = elementSet->getAdditionalRho();
@@ -813,7 +929,7 @@ void Model::emulateAdditionalMass() {
             for (auto cell : cells) {
                 int cellPosition = mesh->addCell(Cell::AUTO_ID, cell.type, cell.nodeIds, cell.isvirtual,
                         &*cell.orientation, cell.elementId);
-                newCellGroup->addCell(mesh->findCell(cellPosition).id);
+                newCellGroup->addCellByPosition(cellPosition);
             }
         }
     }
@@ -822,6 +938,7 @@ void Model::emulateAdditionalMass() {
 }
 
 void Model::generateBeamsToDisplayHomogeneousConstraint() {
+    Profiler::Scope scope("generateBeamsToDisplayHomogeneousConstraint");
 
     CellGroup* virtualGroupRigid = nullptr;
     CellGroup* virtualGroupRBE3 = nullptr;
@@ -847,7 +964,7 @@ void Model::generateBeamsToDisplayHomogeneousConstraint() {
                 for (int slaveNode : rigid->getSlaves()) {
                     nodes[1] = mesh->findNode(slaveNode).id;
                     int cellPosition = mesh->addCell(Cell::AUTO_ID, CellType::SEG2, nodes, true);
-                    virtualGroupRigid->addCell(mesh->findCell(cellPosition).id);
+                    virtualGroupRigid->addCellByPosition(cellPosition);
                     mesh->allowDOFS(slaveNode, DOFS::ALL_DOFS);
                 }
                 break;
@@ -868,7 +985,7 @@ void Model::generateBeamsToDisplayHomogeneousConstraint() {
                     nodes[1] = mesh->findNode(slaveNode).id;
                     int cellPosition = mesh->addCell(Cell::AUTO_ID, CellType::SEG2, nodes, true);
                     mesh->allowDOFS(slaveNode, DOFS::ALL_DOFS);
-                    virtualGroupRBE3->addCell(mesh->findCell(cellPosition).id);
+                    virtualGroupRBE3->addCellByPosition(cellPosition);
                 }
                 break;
             }
@@ -880,6 +997,7 @@ void Model::generateBeamsToDisplayHomogeneousConstraint() {
 }
 
 void Model::generateMaterialAssignments() {
+    Profiler::Scope scope("generateMaterialAssignments");
     if (configuration.partitionModel) {
         if (this->material_assignment_by_material_id.size() > 0) {
             cerr << "generateMaterialAssignments with PartitionModel is not "
@@ -908,6 +1026,7 @@ void Model::generateMaterialAssignments() {
 }
 
 void Model::removeIneffectives() {
+    Profiler::Scope scope("removeIneffectives");
     // remove ineffective loadings from the model
     vector<shared_ptr<Loading>> loadingsToRemove;
     for (auto loading : loadings) {
@@ -961,7 +1080,7 @@ void Model::removeIneffectives() {
     // remove empty elementSets from the model
     vector<shared_ptr<ElementSet>> elementSetsToRemove;
     for (auto elementSet : elementSets) {
-        if (elementSet->cellGroup && elementSet->cellGroup->cellIds.size() == 0)
+        if (elementSet->cellGroup && elementSet->cellGroup->empty())
             elementSetsToRemove.push_back(elementSet);
     }
     for (auto elementSet : elementSetsToRemove) {
@@ -972,6 +1091,7 @@ void Model::removeIneffectives() {
 }
 
 void Model::replaceCombinedLoadSets() {
+    Profiler::Scope scope("replaceCombinedLoadSets");
     for (auto loadSet : this->loadSets) {
         for (auto& kv : loadSet->embedded_loadsets) {
             shared_ptr<LoadSet> otherloadSet = this->find(kv.first);
@@ -997,6 +1117,7 @@ void Model::replaceCombinedLoadSets() {
 
 void Model::removeAssertionsMissingDOFS()
 {
+    Profiler::Scope scope("removeAssertionsMissingDOFS");
     vector<shared_ptr<Objective> > objectivesToRemove;
     for (auto& analysis : analyses) {
         for(auto& assertion : analysis->getAssertions()) {
@@ -1022,6 +1143,7 @@ void Model::removeAssertionsMissingDOFS()
 
 void Model::addDefaultAnalysis()
 {
+    Profiler::Scope scope("addDefaultAnalysis");
     if (this->analyses.size() == 0 && (loadings.size() > 0 || constraints.size() > 0)) {
         //add an automatic linear analysis
         LinearMecaStat analysis(*this, 1);
@@ -1034,11 +1156,57 @@ void Model::addDefaultAnalysis()
 
 void Model::replaceDirectMatrices()
 {
+    Profiler::Scope scope("replaceDirectMatrices");
     vector<shared_ptr<ElementSet> > elementSetsToRemove;
     int matrix_count = 0;
     map<int, DOFS> addedDofsByNode;
     map<int, DOFS> requiredDofsByNode;
     map<int, DOFS> ownedDofsByNode;
+    // dofs given to the nodes of the matrices by the elements of their cells. The cells of
+    // the nodes are found through the node to cells index of the mesh, read before the first
+    // cell is added so that it is built once: the discretes added for the matrices then add
+    // their dofs to the nodes of their cells.
+    unordered_map<int, DOFS> ownedDofsByCell;
+    for (const auto& elementSet : elementSets) {
+        if (elementSet->cellGroup == nullptr) {
+            continue;
+        }
+        const DOFS owned = (elementSet->isBeam() or elementSet->isShell()) ?
+                DOFS::ALL_DOFS : DOFS::TRANSLATIONS;
+        for (int cellPosition : elementSet->cellGroup->cellPositions()) {
+            auto it = ownedDofsByCell.insert(make_pair(cellPosition, DOFS::NO_DOFS)).first;
+            it->second += owned;
+        }
+    }
+    unordered_map<int, DOFS> ownedDofsByMatrixNode;
+    for (const auto& elementSet : elementSets) {
+        if (!elementSet->isMatrixElement()) {
+            continue;
+        }
+        for (int nodePosition : static_pointer_cast<MatrixElement>(elementSet)->nodePositions()) {
+            if (ownedDofsByMatrixNode.find(nodePosition) != ownedDofsByMatrixNode.end()) {
+                continue;
+            }
+            DOFS owned;
+            for (int cellPosition : mesh->cellPositionsOfNode(nodePosition)) {
+                auto it = ownedDofsByCell.find(cellPosition);
+                if (it != ownedDofsByCell.end()) {
+                    owned += it->second;
+                }
+            }
+            ownedDofsByMatrixNode[nodePosition] = owned;
+        }
+    }
+    auto addOwnedDofs = [this, &ownedDofsByMatrixNode](const ElementSet& discrete) {
+        for (int cellPosition : discrete.cellGroup->cellPositions()) {
+            for (int nodePosition : mesh->cells.nodePositions(cellPosition)) {
+                auto it = ownedDofsByMatrixNode.find(nodePosition);
+                if (it != ownedDofsByMatrixNode.end()) {
+                    it->second += DOFS::TRANSLATIONS;
+                }
+            }
+        }
+    };
     for (auto elementSet : elementSets) {
         if (!elementSet->isMatrixElement()) {
             continue;
@@ -1046,30 +1214,20 @@ void Model::replaceDirectMatrices()
         shared_ptr<MatrixElement> matrix = static_pointer_cast<MatrixElement>(elementSet);
         for (int nodePosition : matrix->nodePositions()) {
             requiredDofsByNode[nodePosition] = DOFS();
-            Node node = mesh->findNode(nodePosition);
-            DOFS owned;
-            for (const auto elementSet : elementSets) {
-                if (elementSet->cellGroup == nullptr) {
-                    continue;
-                }
-                for (Cell cell : elementSet->cellGroup->getCells()) {
-                    for (int nodeId : cell.nodeIds) {
-                        if (nodeId == node.id) {
-                            if (elementSet->isBeam() or elementSet->isShell()) {
-                                owned += DOFS::ALL_DOFS;
-                            } else {
-                                owned += DOFS::TRANSLATIONS;
-                            }
-                            break;
-                        }
-                    }
-                }
+            ownedDofsByNode[nodePosition] = ownedDofsByMatrixNode[nodePosition];
+        }
+        const set<pair<int, int>> nodePairs = matrix->nodePairs();
+        // same as matrix->findInPairs(nodePosition).size(), without scanning all the pairs
+        unordered_map<int, int> coupledNodeCountByNode;
+        for (const auto& pair : nodePairs) {
+            if (pair.first != pair.second) {
+                coupledNodeCountByNode[pair.first]++;
+                coupledNodeCountByNode[pair.second]++;
             }
-            ownedDofsByNode[nodePosition] = owned;
         }
-        for (auto pair : matrix->nodePairs()) {
+        for (auto pair : nodePairs) {
             if (pair.first == pair.second) {
-                if (matrix->findInPairs(pair.first).size() != 0) {
+                if (coupledNodeCountByNode.find(pair.first) != coupledNodeCountByNode.end()) {
                     continue; // will be handled by a segment cell with another node
                 }
                 // single node
@@ -1100,7 +1258,7 @@ void Model::replaceDirectMatrices()
                         "MTN" + to_string(matrix_count));
                 discrete.assignCellGroup(matrixGroup);
                 int cellPosition = mesh->addCell(Cell::AUTO_ID, CellType::SEG2, { node.id }, true);
-                matrixGroup->addCell(mesh->findCell(cellPosition).id);
+                matrixGroup->addCellByPosition(cellPosition);
                 if (discrete.hasRotations()) {
                     addedDofsByNode[nodePosition] = DOFS::ALL_DOFS;
                     mesh->allowDOFS(node.position, DOFS::ALL_DOFS);
@@ -1113,6 +1271,7 @@ void Model::replaceDirectMatrices()
                             << to_string(node.id) << endl;
                 }
                 this->add(discrete);
+                addOwnedDofs(discrete);
             } else {
                 // node couple
                 Node rowNode = mesh->findNode(pair.first);
@@ -1126,7 +1285,7 @@ void Model::replaceDirectMatrices()
                 matrix_count++;
                 int cellPosition = mesh->addCell(Cell::AUTO_ID, CellType::SEG2, { rowNode.id,
                         colNode.id }, true);
-                matrixGroup->addCell(mesh->findCell(cellPosition).id);
+                matrixGroup->addCellByPosition(cellPosition);
                 discrete.assignMaterial(getVirtualMaterial());
                 discrete.assignCellGroup(matrixGroup);
                 if (discrete.hasRotations()) {
@@ -1158,7 +1317,7 @@ void Model::replaceDirectMatrices()
                                 colNodePosition);
                         for (auto& kv : submatrix->componentByDofs) {
                             // We are disassembling the matrix, so we must divide the value by the segments
-                            double value = kv.second / static_cast<int>(matrix->findInPairs(pair.first).size());
+                            double value = kv.second / coupledNodeCountByNode[pair.first];
                             const DOF rowDof = kv.first.first;
                             const DOF colDof = kv.first.second;
                             if (!is_equal(value, 0)) {
@@ -1181,6 +1340,7 @@ void Model::replaceDirectMatrices()
                             << to_string(rowNode.id) << " and : " << to_string(colNode.id) << endl;
                 }
                 this->add(discrete);
+                addOwnedDofs(discrete);
             }
         }
         elementSetsToRemove.push_back(elementSet);
@@ -1239,8 +1399,12 @@ void Model::replaceDirectMatrices()
 
 void Model::removeRedundantSpcs()
 {
+    Profiler::Scope scope("removeRedundantSpcs");
     for (auto analysis : this->analyses) {
-        std::unordered_map<std::pair<int, DOF>, double, boost::hash<std::pair<int, int> > > spcvalueByNodeAndDof;
+        // the DOFS already blocked and their values, in a slot for each node having an SPC
+        unordered_map<int, size_t> slotByNodePosition;
+        vector<char> blockedDofsBySlot;
+        vector<double> spcValueBySlotAndDof;
         for (const auto& constraintSet : analysis->getConstraintSets()) {
             const set<shared_ptr<Constraint> > spcs = constraintSet->getConstraintsByType(
                     Constraint::SPC);
@@ -1253,19 +1417,28 @@ void Model::removeRedundantSpcs()
                 for (int nodePosition : spc->nodePositions()) {
                     DOFS dofsToRemove;
                     DOFS blockedDofs = spc->getDOFSForNode(nodePosition);
+                    const auto inserted = slotByNodePosition.insert(
+                            make_pair(nodePosition, blockedDofsBySlot.size()));
+                    if (inserted.second) {
+                        blockedDofsBySlot.push_back(0);
+                        spcValueBySlotAndDof.resize(spcValueBySlotAndDof.size() + 6);
+                    }
+                    const size_t slot = inserted.first->second;
+                    char& blockedByPreviousSpcs = blockedDofsBySlot[slot];
                     for (const DOF dof : blockedDofs) {
-                        pair<int, DOF> key = make_pair(nodePosition, dof);
+                        const char dofCode = static_cast<char>(1 << dof.position);
+                        double& previousValue = spcValueBySlotAndDof[slot * 6 + dof.position];
                         double spcValue = spc->getDoubleForDOF(dof);
-                        auto entry = spcvalueByNodeAndDof.find(key);
-                        if (entry == spcvalueByNodeAndDof.end()) {
-                            spcvalueByNodeAndDof[key] = spcValue;
-                        } else if (!is_equal(spcValue, entry->second)) {
+                        if (!(blockedByPreviousSpcs & dofCode)) {
+                            blockedByPreviousSpcs = static_cast<char>(blockedByPreviousSpcs | dofCode);
+                            previousValue = spcValue;
+                        } else if (!is_equal(spcValue, previousValue)) {
                             Node node = this->mesh->findNode(nodePosition);
                             throw logic_error(
                                     "In analysis : " + to_str(*analysis) + ", spc : " + to_str(*spc)
                                             + " value : " + to_string(spcValue)
                                             + " different by other spc value : "
-                                            + to_string(entry->second) + " on same node id : "
+                                            + to_string(previousValue) + " on same node id : "
                                             + to_string(node.id) + " and dof : " + dof.label);
                         } else {
                             dofsToRemove = dofsToRemove + dof;
@@ -1288,67 +1461,112 @@ void Model::finish() {
     if (finished) {
         return;
     }
+    Profiler::Scope scope("finish");
 
-    for (shared_ptr<ElementSet> elementSet : elementSets) {
-        for (int nodePosition : elementSet->nodePositions()) {
-            mesh->allowDOFS(nodePosition,elementSet->getDOFSForNode(nodePosition));
+    // all the passes use global coordinates, for the models not given by a parser
+    transformLocalNodePositions();
+
+    {
+        Profiler::Scope dofsScope("allowDOFS");
+        // the DOFS of the elements are gathered for all the nodes, then allowed at once
+        vector<char> elementDOFS(static_cast<size_t>(mesh->countNodes()), 0);
+        for (shared_ptr<ElementSet> elementSet : elementSets) {
+            elementSet->addNodeDOFS(elementDOFS);
         }
-    }
-    for (shared_ptr<Analysis> analysis : analyses) {
-        for (const auto& boundaryCondition : analysis->getBoundaryConditions()) {
-            for(int nodePosition: boundaryCondition->nodePositions()) {
-                analysis->addBoundaryDOFS(nodePosition,
-                        boundaryCondition->getDOFSForNode(nodePosition));
-            }
+        mesh->allowDOFS(elementDOFS);
+        // each analysis only accumulates its own boundary DOFS
+        vector<shared_ptr<Analysis>> analysisList;
+        for (shared_ptr<Analysis> analysis : analyses) {
+            analysisList.push_back(analysis);
         }
+        PassScheduler::forEach(analysisList.size(), configuration.finishThreads,
+                [&analysisList](size_t i) {
+                    Analysis& analysis = *analysisList[i];
+                    for (const auto& boundaryCondition : analysis.getBoundaryConditions()) {
+                        for(int nodePosition: boundaryCondition->nodePositions()) {
+                            analysis.addBoundaryDOFS(nodePosition,
+                                    boundaryCondition->getDOFSForNode(nodePosition));
+                        }
+                    }
+                });
     }
 
-    removeAssertionsMissingDOFS();
+    // passes in the order of a sequential run, with the parts of the model they use
+    typedef PassScheduler S;
+    PassScheduler scheduler(configuration.finishThreads);
+    scheduler.add("removeAssertionsMissingDOFS", S::MESH | S::ANALYSES | S::OBJECTIVES,
+            S::ANALYSES | S::OBJECTIVES, [this]() {removeAssertionsMissingDOFS();});
 
     if (this->configuration.emulateLocalDisplacement) {
-        emulateLocalDisplacementConstraint();
+        scheduler.add("emulateLocalDisplacementConstraint",
+                S::MESH | S::CONSTRAINTS | S::COORDINATE_SYSTEMS,
+                S::CONSTRAINTS | S::COORDINATE_SYSTEMS,
+                [this]() {emulateLocalDisplacementConstraint();});
     }
 
     if (this->configuration.displayHomogeneousConstraint) {
-        generateBeamsToDisplayHomogeneousConstraint();
+        // the active constraint sets come from classifySets, which reads the load sets too
+        scheduler.add("generateBeamsToDisplayHomogeneousConstraint",
+                S::MESH | S::ELEMENTS | S::CONSTRAINTS | S::LOADINGS | S::ANALYSES,
+                S::MESH | S::ELEMENTS,
+                [this]() {generateBeamsToDisplayHomogeneousConstraint();});
     }
 
     if (this->configuration.createSkin) {
-        generateSkin();
+        scheduler.add("generateSkin", S::MESH | S::LOADINGS,
+                S::MESH | S::ELEMENTS | S::LOADINGS,
+                [this]() {generateSkin();});
     }
     if (this->configuration.emulateAdditionalMass) {
-        emulateAdditionalMass();
+        scheduler.add("emulateAdditionalMass", S::MESH | S::ELEMENTS,
+                S::MESH | S::ELEMENTS, [this]() {emulateAdditionalMass();});
     }
 
     if (this->configuration.replaceCombinedLoadSets) {
-        replaceCombinedLoadSets();
+        // the common load set may be added, which changes the sets of the analyses
+        scheduler.add("replaceCombinedLoadSets", S::LOADINGS,
+                S::LOADINGS | S::ANALYSES, [this]() {replaceCombinedLoadSets();});
     }
 
     if (this->configuration.replaceDirectMatrices) {
-        replaceDirectMatrices();
+        scheduler.add("replaceDirectMatrices", S::ALL_PARTS, S::ALL_PARTS,
+                [this]() {replaceDirectMatrices();});
     }
 
     if (this->configuration.removeRedundantSpcs) {
-        removeRedundantSpcs();
+        scheduler.add("removeRedundantSpcs", S::MESH | S::CONSTRAINTS | S::ANALYSES,
+                S::CONSTRAINTS | S::ANALYSES, [this]() {removeRedundantSpcs();});
     }
 
     if (this->configuration.removeIneffectives) {
-        removeIneffectives();
+        scheduler.add("removeIneffectives",
+                S::MESH | S::ELEMENTS | S::CONSTRAINTS | S::LOADINGS | S::ANALYSES,
+                S::ELEMENTS | S::CONSTRAINTS | S::LOADINGS | S::ANALYSES,
+                [this]() {removeIneffectives();});
     }
 
     if (this->configuration.virtualDiscrets) {
-        generateDiscrets();
-    }
-
-    assignElementsToCells();
-    generateMaterialAssignments();
-    addDefaultAnalysis();
-
-    this->mesh->finish();
+        scheduler.add("generateDiscrets", S::MESH | S::ELEMENTS | S::ANALYSES,
+                S::MESH | S::ELEMENTS | S::CONSTRAINTS | S::ANALYSES,
+                [this]() {generateDiscrets();});
+    }
+
+    scheduler.add("assignElementsToCells", S::MESH | S::ELEMENTS, S::MESH,
+            [this]() {assignElementsToCells();});
+    // only keeps the names of the cell groups of the element sets
+    scheduler.add("generateMaterialAssignments", S::ELEMENTS, S::MATERIAL_ASSIGNMENTS,
+            [this]() {generateMaterialAssignments();});
+    scheduler.add("addDefaultAnalysis", S::CONSTRAINTS | S::LOADINGS | S::ANALYSES,
+            S::ANALYSES, [this]() {addDefaultAnalysis();});
+
+    scheduler.add("Mesh::finish", S::MESH, S::MESH, [this]() {this->mesh->finish();});
+    scheduler.run();
+    classifySets();
     finished = true;
 }
 
 bool Model::validate() {
+    Profiler::Scope scope("validate");
     bool meshValid = mesh->validate();
 
     bool validMaterials = materials.validate();
@@ -1382,6 +1600,7 @@ bool Model::validate() {
 }
 
 void Model::assignElementsToCells() {
+    Profiler::Scope scope("assignElementsToCells");
     for (shared_ptr<ElementSet> element : elementSets) {
         if (element->cellGroup != nullptr) {
             CellContainer container(mesh);
@@ -22,7 +22,12 @@
 #include "Value.h"
 #include "Objective.h"
 #include "Reference.h"
+#include "ModelArena.h"
+#include <atomic>
+#include <mutex>
 #include <string>
+#include <boost/dynamic_bitset.hpp>
+#include <boost/range/iterator_range.hpp>
 
 namespace vega {
 
@@ -36,6 +41,11 @@ class Mesh;
 
 class Model final {
 private:
+    friend ModelSnapshot;
+    /**
+     * Memory of the objects of the model, see ModelArena.
+     */
+    const std::shared_ptr<ModelArena> arena;
     const string type;
     std::shared_ptr<Material> virtualMaterial;
     void generateDiscrets();
@@ -85,21 +95,34 @@ public:
     const ConstraintSet commonConstraintSet;
 
 private:
-    std::unordered_map<LoadSet::Type, map<int, set<std::shared_ptr<Reference<Loading>>> > ,hash<int>>
+    /**
+     * Members of the sets, held by value: a membership costs a tree node and no other
+     * allocation.
+     */
+    std::unordered_map<LoadSet::Type, map<int, set<Reference<Loading>> > ,hash<int>>
     loadingReferences_by_loadSet_original_ids_by_loadSet_type;
-    std::unordered_map<int, set<std::shared_ptr<Reference<Loading>>> >
+    std::unordered_map<int, set<Reference<Loading>> >
     loadingReferences_by_loadSet_ids;
 
     std::unordered_map< ConstraintSet::Type,
-    map<int, set<std::shared_ptr<Reference<Constraint>>>>,hash<int>>
+    map<int, set<Reference<Constraint>>>,hash<int>>
     constraintReferences_by_constraintSet_original_ids_by_constraintSet_type;
-    std::map< int, set<std::shared_ptr<Reference<Constraint>>>>
+    std::map< int, set<Reference<Constraint>>>
     constraintReferences_by_constraintSet_ids;
+    /**
+     * Reverse of the maps above: for each Loading or Constraint, the keys under which it was
+     * added to a set, that is the id and the original id of the set. Members and sets are
+     * resolved when queried, as they may be added to the model after their membership.
+     */
+    std::map<Reference<Loading>, set<Reference<LoadSet>>> loadSetKeys_by_loading;
+    std::map<Reference<Constraint>, set<Reference<ConstraintSet>>> constraintSetKeys_by_constraint;
+    template<class S>
+    static void addSetKeys(const Reference<S>& setReference, set<Reference<S>>& setKeys);
 
     template<class T> class Container final {
+        friend ModelSnapshot;
         std::map<int, std::shared_ptr<T>> by_id;
-        std::unordered_map< typename T::Type, std::map<int, std::shared_ptr<T>>,
-        std::hash<int>> by_original_ids_by_type;
+        std::map<typename T::Type, std::map<int, std::shared_ptr<T>>> by_original_ids_by_type;
     public:
         class iterator;
         friend class iterator;
@@ -138,6 +161,28 @@ private:
                     bool validate() const;
                 };
         std::unordered_map<int,CellContainer> material_assignment_by_material_id;
+        /**
+         * The load or constraint sets of the model classified by the analyses using them.
+         * Bit i of the usage of an active set is set if the i-th analysis uses it.
+         */
+        template<class S> class SetClassification final {
+        public:
+            vector<std::shared_ptr<S>> active;
+            vector<std::shared_ptr<S>> common;
+            set<std::shared_ptr<S>> uncommon;
+            std::map<std::shared_ptr<S>, boost::dynamic_bitset<>> usage_by_set;
+        };
+        /**
+         * Guards the classification below: const getters may be called from several threads.
+         */
+        mutable std::mutex classificationMutex;
+        mutable std::atomic<bool> setsClassified{false};
+        mutable SetClassification<LoadSet> loadSetClassification;
+        mutable SetClassification<ConstraintSet> constraintSetClassification;
+        /**
+         * Classifies the sets once, until invalidateSetClassification() is called.
+         */
+        void classifySets() const;
     public:
         Container<Analysis> analyses;
         Container<Objective> objectives;
@@ -152,6 +197,10 @@ private:
         std::map<Parameter, double> parameters;
 
         bool onlyMesh;
+        /**
+         * Files read to build the model: the input file, then its includes. See ModelSnapshot.
+         */
+        std::vector<fs::path> inputFiles;
 
         Model(string name, string inputSolverVersion = string("UNKNOWN"),
                 SolverName inputSolver = NASTRAN,
@@ -199,6 +248,19 @@ private:
          */
         const set<std::shared_ptr<Loading>> getLoadingsByLoadSet(const Reference<LoadSet>&) const;
 
+        /**
+         * Retrieve all the LoadSet containing a corresponding Loading.
+         */
+        const set<std::shared_ptr<LoadSet>> getLoadSetsByLoading(const Reference<Loading>& loadingReference) const;
+
+        /**
+         * The keys under which a Loading was added to LoadSets, without copying them: the id
+         * and the original id of each set, which may not be in the model yet. The range is
+         * invalidated when the Loading is removed.
+         */
+        boost::iterator_range<set<Reference<LoadSet>>::const_iterator> getLoadSetKeysByLoading(
+                const Reference<Loading>& loadingReference) const;
+
         /**
          * Create a material
          */
@@ -230,10 +292,18 @@ private:
         const set<std::shared_ptr<Constraint>> getConstraintsByConstraintSet(const Reference<ConstraintSet>&) const;
 
         /**
-         * Retrieve all the ConstraintSet containing a corresponding Constraint.
+         * Retrieve all the ConstraintSet containing a corresponding Constraint, without
+         * scanning the ConstraintSets of the model.
          */
         const set<std::shared_ptr<ConstraintSet>> getConstraintSetsByConstraint(const Reference<Constraint>& constraintReference) const;
 
+        /**
+         * The keys under which a Constraint was added to ConstraintSets, see
+         * getLoadSetKeysByLoading.
+         */
+        boost::iterator_range<set<Reference<ConstraintSet>>::const_iterator> getConstraintSetKeysByConstraint(
+                const Reference<Constraint>& constraintReference) const;
+
         /**
          * Retrieve all the ConstraintSet of the model that are at least referenced by one analysis
          */
@@ -260,16 +330,34 @@ private:
          * Retrieve all the ConstraintSet of the model that are active but not common to all analysis
          */
         const set<std::shared_ptr<LoadSet>> getUncommonLoadSets() const;
+        /**
+         * Must be called whenever an analysis, a LoadSet or a ConstraintSet is added to or
+         * removed from the model, or when the sets of an analysis change: the active, common
+         * and uncommon sets are otherwise only computed once. The getters above return
+         * copies, which stay valid after the next classification.
+         */
+        void invalidateSetClassification();
 
         /**
          * Get a non rigid material (virtual)
          */
         std::shared_ptr<Material> getVirtualMaterial();
+        /**
+         * The arena where the objects added to the model are allocated.
+         */
+        const std::shared_ptr<ModelArena>& getArena() const;
 
         const vector<std::shared_ptr<ElementSet>> filterElements(ElementSet::Type type) const;
 
         const vector<std::shared_ptr<Beam>> getBeams() const;
 
+        /**
+         * Replaces the coordinates of the nodes given in a local coordinate system by their
+         * global coordinates, the nodes of each coordinate system at once. Called by the
+         * parsers once the coordinate systems are read, and again by finish for the models
+         * built otherwise: the nodes already in global coordinates are left unchanged.
+         */
+        void transformLocalNodePositions();
         /**
          * Method that is called when parsing is complete.
          */
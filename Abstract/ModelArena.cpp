@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) Alneos, s. a r. l. (contact@alneos.fr)
+ * Released under the GNU General Public License
+ *
+ * ModelArena.cpp
+ *
+ *  Memory of the objects of a Model.
+ */
+
+#include "ModelArena.h"
+#include <algorithm>
+#include <cstdint>
+
+namespace vega {
+
+using namespace std;
+
+ModelArena::ModelArena() :
+		next(nullptr), remaining(0), allocationCount(0), allocatedBytes(0) {
+}
+
+void* ModelArena::allocate(size_t bytes, size_t alignment) {
+	lock_guard<std::mutex> lock(mutex);
+	size_t padding = (alignment - reinterpret_cast<uintptr_t>(next) % alignment) % alignment;
+	if (next == nullptr || padding + bytes > remaining) {
+		// objects larger than a block get their own block, the current one is kept
+		const size_t blockSize = max(static_cast<size_t>(BLOCK_SIZE), bytes + alignment);
+		blocks.push_back(unique_ptr<char[]>(new char[blockSize]));
+		char* block = blocks.back().get();
+		padding = (alignment - reinterpret_cast<uintptr_t>(block) % alignment) % alignment;
+		if (blockSize > BLOCK_SIZE) {
+			allocationCount++;
+			allocatedBytes += bytes;
+			return block + padding;
+		}
+		next = block;
+		remaining = blockSize;
+	}
+	char* result = next + padding;
+	next = result + bytes;
+	remaining -= padding + bytes;
+	allocationCount++;
+	allocatedBytes += bytes;
+	return result;
+}
+
+size_t ModelArena::getAllocationCount() const {
+	lock_guard<std::mutex> lock(mutex);
+	return allocationCount;
+}
+
+size_t ModelArena::getAllocatedBytes() const {
+	lock_guard<std::mutex> lock(mutex);
+	return allocatedBytes;
+}
+
+size_t ModelArena::getBlockCount() const {
+	lock_guard<std::mutex> lock(mutex);
+	return blocks.size();
+}
+
+} /* namespace vega */
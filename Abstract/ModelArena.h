@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) Alneos, s. a r. l. (contact@alneos.fr)
+ * Released under the GNU General Public License
+ *
+ * ModelArena.h
+ *
+ *  Memory of the objects of a Model.
+ */
+
+#ifndef MODELARENA_H_
+#define MODELARENA_H_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace vega {
+
+class Model;
+
+/**
+ * Monotonic buffer holding the objects of a model (analyses, loadings, constraints, values,
+ * element sets, materials...) together with their shared_ptr control blocks. Memory is taken
+ * from large blocks and is never given back one object at a time: the blocks are freed all
+ * at once when the arena is destroyed, that is when the model and the last object allocated
+ * in it are gone.
+ *
+ * Allocations are serialized, so objects can be created by concurrent passes.
+ */
+class ModelArena final {
+public:
+	static const size_t BLOCK_SIZE = 64 * 1024;
+	ModelArena();
+	ModelArena(const ModelArena&) = delete;
+	ModelArena& operator=(const ModelArena&) = delete;
+	void* allocate(size_t bytes, size_t alignment);
+	/**
+	 * Number of allocations served since the creation of the arena.
+	 */
+	size_t getAllocationCount() const;
+	/**
+	 * Bytes requested since the creation of the arena, padding excluded.
+	 */
+	size_t getAllocatedBytes() const;
+	size_t getBlockCount() const;
+private:
+	mutable std::mutex mutex;
+	std::vector<std::unique_ptr<char[]>> blocks;
+	char* next;
+	size_t remaining;
+	size_t allocationCount;
+	size_t allocatedBytes;
+};
+
+/**
+ * Standard allocator taking its memory from an arena, which it keeps alive.
+ */
+template<class T>
+class ArenaAllocator final {
+public:
+	typedef T value_type;
+	std::shared_ptr<ModelArena> arena;
+	explicit ArenaAllocator(const std::shared_ptr<ModelArena>& arena) :
+			arena(arena) {
+	}
+	template<class U>
+	ArenaAllocator(const ArenaAllocator<U>& other) :
+			arena(other.arena) {
+	}
+	T* allocate(size_t n) {
+		return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+	}
+	void deallocate(T*, size_t) {
+		// freed with the arena
+	}
+};
+
+template<class T, class U>
+bool operator==(const ArenaAllocator<T>& left, const ArenaAllocator<U>& right) {
+	return left.arena == right.arena;
+}
+
+template<class T, class U>
+bool operator!=(const ArenaAllocator<T>& left, const ArenaAllocator<U>& right) {
+	return left.arena != right.arena;
+}
+
+/**
+ * The arena of a model, see Model::getArena(). Declared here so that objects can be
+ * allocated in the arena of their model where Model is not complete yet.
+ */
+const std::shared_ptr<ModelArena>& arenaOf(const Model& model);
+
+/**
+ * Like std::make_shared, the object and its control block being allocated in the arena of
+ * a model. Used by the clone() methods of the objects stored by the model.
+ */
+template<class T, class ... Args>
+std::shared_ptr<T> makeModelObject(const Model& model, Args&&... args) {
+	return std::allocate_shared<T>(ArenaAllocator<T>(arenaOf(model)),
+			std::forward<Args>(args)...);
+}
+
+} /* namespace vega */
+
+#endif /* MODELARENA_H_ */
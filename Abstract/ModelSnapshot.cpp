@@ -0,0 +1,2389 @@
+/*
+ * Copyright (C) Alneos, s. a r. l. (contact@alneos.fr)
+ * Released under the GNU General Public License
+ *
+ * ModelSnapshot.cpp
+ *
+ *  Binary snapshot (.vega file) of a finished Model.
+ */
+
+#include "ModelSnapshot.h"
+#include "Model.h"
+#include "build_properties.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <typeinfo>
+
+namespace vega {
+
+using namespace std;
+
+const char ModelSnapshot::MAGIC[8] = { 'V', 'E', 'G', 'A', 'S', 'N', 'A', 'P' };
+
+/**
+ * Base class of an object of the model, which tells how to read it.
+ */
+enum class ModelSnapshot::Family : uint8_t {
+	ANALYSIS,
+	OBJECTIVE,
+	VALUE,
+	LOADING,
+	LOAD_SET,
+	CONSTRAINT,
+	CONSTRAINT_SET,
+	COORDINATE_SYSTEM,
+	ELEMENT_SET,
+	MATERIAL,
+	ORIENTATION
+};
+
+namespace {
+
+/**
+ * Written after the magic: a snapshot written on a machine with another byte order is
+ * ignored.
+ */
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+/**
+ * Index of a null pointer to an object.
+ */
+const uint32_t NO_OBJECT = UINT32_MAX;
+const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+
+/**
+ * Class of an object, within its family.
+ */
+enum class Kind : uint8_t {
+	LINEAR_MECA_STAT,
+	NONLINEAR_MECA_STAT,
+	LINEAR_MODAL,
+	LINEAR_DYNA_MODAL_FREQ,
+	NODAL_DISPLACEMENT_ASSERTION,
+	NODAL_COMPLEX_DISPLACEMENT_ASSERTION,
+	FREQUENCY_ASSERTION,
+	ANALYSIS_PARAMETER,
+	FREQUENCY_VALUES,
+	FREQUENCY_BAND,
+	MODAL_DAMPING,
+	NONLINEAR_STRATEGY,
+	VALUE_PLACE_HOLDER,
+	STEP_RANGE,
+	FUNCTION_TABLE,
+	DYNA_PHASE,
+	GRAVITY,
+	ROTATION_CENTER,
+	ROTATION_NODE,
+	NODAL_FORCE,
+	NODAL_FORCE_TWO_NODES,
+	FORCE_SURFACE,
+	PRESSION_FACE_TWO_NODES,
+	FORCE_LINE,
+	NORMAL_PRESSION_FACE,
+	DYNAMIC_EXCITATION,
+	QUASI_RIGID_CONSTRAINT,
+	RIGID_CONSTRAINT,
+	RBE3_CONSTRAINT,
+	SINGLE_POINT_CONSTRAINT,
+	LINEAR_MULTIPLE_POINT_CONSTRAINT,
+	GAP_TWO_NODES,
+	GAP_NODE_DIRECTION,
+	CARTESIAN_COORDINATE_SYSTEM,
+	CYLINDRICAL_COORDINATE_SYSTEM,
+	SPHERICAL_COORDINATE_SYSTEM,
+	CIRCULAR_SECTION_BEAM,
+	GENERIC_SECTION_BEAM,
+	RECTANGULAR_SECTION_BEAM,
+	I_SECTION_BEAM,
+	SHELL,
+	CONTINUUM,
+	DISCRETE_POINT,
+	DISCRETE_SEGMENT,
+	NODAL_MASS,
+	STIFFNESS_MATRIX,
+	MASS_MATRIX,
+	DAMPING_MATRIX,
+	ELASTIC_NATURE,
+	BILINEAR_ELASTIC_NATURE,
+	NONLINEAR_ELASTIC_NATURE,
+	VECT_Y,
+	TWO_NODES_ORIENTATION
+};
+
+/**
+ * The model types an element set or the model can point to, by index.
+ */
+const ModelType* const MODEL_TYPES[] = { &ModelType::PLANE_STRESS, &ModelType::PLANE_STRAIN,
+		&ModelType::AXISYMMETRIC, &ModelType::TRIDIMENSIONAL, &ModelType::TRIDIMENSIONAL_SI };
+const int MODEL_TYPE_COUNT = sizeof(MODEL_TYPES) / sizeof(MODEL_TYPES[0]);
+
+int8_t modelTypeIndex(const ModelType* modelType) {
+	if (modelType == nullptr) {
+		return -1;
+	}
+	ModelType copy = *modelType;
+	for (int i = 0; i < MODEL_TYPE_COUNT; i++) {
+		if (copy == *MODEL_TYPES[i]) {
+			return static_cast<int8_t>(i);
+		}
+	}
+	throw runtime_error("unknown model type");
+}
+
+const ModelType* modelTypeAt(int8_t index) {
+	if (index == -1) {
+		return nullptr;
+	}
+	if (index < 0 || index >= MODEL_TYPE_COUNT) {
+		throw runtime_error("corrupted model snapshot");
+	}
+	return MODEL_TYPES[index];
+}
+
+uint64_t hashBytes(const unsigned char* data, size_t size, uint64_t hash) {
+	for (size_t i = 0; i < size; i++) {
+		hash ^= data[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+template<class T, class B>
+bool is(const B& object) {
+	return typeid(object) == typeid(T);
+}
+
+runtime_error unsupported(const string& family, const type_info& type) {
+	return runtime_error(family + " of class " + type.name() + " not supported");
+}
+
+bool sameVector(const VectorialValue& left, const VectorialValue& right) {
+	// bitwise, as the snapshot must give back the same values
+	const double leftComponents[] = { left.x(), left.y(), left.z() };
+	const double rightComponents[] = { right.x(), right.y(), right.z() };
+	return memcmp(leftComponents, rightComponents, sizeof(leftComponents)) == 0;
+}
+
+int nodeId(const Model& model, int nodePosition) {
+	return model.mesh->nodes.getIds().at(static_cast<size_t>(nodePosition));
+}
+
+class Identity final {
+public:
+	int originalId;
+	int id;
+};
+
+}
+
+/**
+ * Encodes the model in a buffer.
+ */
+class ModelSnapshot::Output final {
+public:
+	vector<char> buffer;
+	template<typename T>
+	void put(const T& value) {
+		const char* bytes = reinterpret_cast<const char*>(&value);
+		buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+	}
+	void putString(const string& value) {
+		put<uint32_t>(static_cast<uint32_t>(value.size()));
+		buffer.insert(buffer.end(), value.begin(), value.end());
+	}
+	template<typename T>
+	void putVector(const vector<T>& values) {
+		put<uint64_t>(values.size());
+		const char* bytes = reinterpret_cast<const char*>(values.data());
+		buffer.insert(buffer.end(), bytes, bytes + values.size() * sizeof(T));
+	}
+	void putVectorial(const VectorialValue& value) {
+		put<double>(value.x());
+		put<double>(value.y());
+		put<double>(value.z());
+	}
+	template<class T>
+	void putIdentity(const Identifiable<T>& object) {
+		put<int32_t>(object.getOriginalId());
+		put<int32_t>(object.getId());
+	}
+	template<class T>
+	void putReference(const Reference<T>& reference) {
+		put<int32_t>(reference.type);
+		put<int32_t>(reference.original_id);
+		put<int32_t>(reference.id);
+	}
+	template<class T>
+	void putReferences(const list<shared_ptr<Reference<T>>>& references) {
+		put<uint64_t>(references.size());
+		for (const auto& reference : references) {
+			putReference(*reference);
+		}
+	}
+	template<class T>
+	void putReferenceSet(const set<Reference<T>>& references) {
+		put<uint64_t>(references.size());
+		for (const auto& reference : references) {
+			putReference(reference);
+		}
+	}
+	void putIntSet(const set<int>& values) {
+		put<uint64_t>(values.size());
+		for (int value : values) {
+			put<int32_t>(value);
+		}
+	}
+	void putPositionSet(const PositionSet& positions) {
+		put<uint8_t>(positions.isCompact());
+		putVector(positions.toVector());
+	}
+	void putValueOrReference(const ValueOrReference& value) {
+		put<uint8_t>(value.isReference());
+		if (value.isReference()) {
+			putReference(value.getReference());
+		} else {
+			put<double>(value.getValue());
+		}
+	}
+	void putDOFMatrix(const DOFMatrix& matrix) {
+		put<uint8_t>(matrix.isSymmetric());
+		put<uint64_t>(matrix.componentByDofs.size());
+		for (const auto& component : matrix.componentByDofs) {
+			put<int32_t>(component.first.first.position);
+			put<int32_t>(component.first.second.position);
+			put<double>(component.second);
+		}
+	}
+};
+
+/**
+ * Decodes the values of a mapped snapshot, checking its bounds.
+ */
+class ModelSnapshot::Input final {
+public:
+	const char* position;
+	const char* const end;
+	Input(const char* begin, const char* end) :
+			position(begin), end(end) {
+	}
+	void require(size_t size) const {
+		if (static_cast<size_t>(end - position) < size) {
+			throw runtime_error("truncated model snapshot");
+		}
+	}
+	template<typename T>
+	T get() {
+		require(sizeof(T));
+		T value;
+		memcpy(&value, position, sizeof(T));
+		position += sizeof(T);
+		return value;
+	}
+	string getString() {
+		const uint32_t size = get<uint32_t>();
+		require(size);
+		string value(position, size);
+		position += size;
+		return value;
+	}
+	template<typename T>
+	vector<T> getVector() {
+		const uint64_t size = get<uint64_t>();
+		if (size > static_cast<uint64_t>(end - position) / sizeof(T)) {
+			throw runtime_error("truncated model snapshot");
+		}
+		vector<T> values(static_cast<size_t>(size));
+		memcpy(values.data(), position, values.size() * sizeof(T));
+		position += values.size() * sizeof(T);
+		return values;
+	}
+	VectorialValue getVectorial() {
+		const double x = get<double>();
+		const double y = get<double>();
+		const double z = get<double>();
+		return VectorialValue(x, y, z);
+	}
+	Identity getIdentity() {
+		Identity identity;
+		identity.originalId = get<int32_t>();
+		identity.id = get<int32_t>();
+		return identity;
+	}
+	template<class T>
+	Reference<T> getReference() {
+		const auto type = static_cast<typename T::Type>(get<int32_t>());
+		const int originalId = get<int32_t>();
+		const int id = get<int32_t>();
+		return Reference<T>(type, originalId, id);
+	}
+	template<class T>
+	list<shared_ptr<Reference<T>>> getReferences() {
+		list<shared_ptr<Reference<T>>> references;
+		for (uint64_t i = get<uint64_t>(); i > 0; i--) {
+			references.push_back(make_shared<Reference<T>>(getReference<T>()));
+		}
+		return references;
+	}
+	template<class T>
+	set<Reference<T>> getReferenceSet() {
+		set<Reference<T>> references;
+		for (uint64_t i = get<uint64_t>(); i > 0; i--) {
+			references.insert(references.end(), getReference<T>());
+		}
+		return references;
+	}
+	set<int> getIntSet() {
+		set<int> values;
+		for (uint64_t i = get<uint64_t>(); i > 0; i--) {
+			values.insert(values.end(), get<int32_t>());
+		}
+		return values;
+	}
+	PositionSet getPositionSet() {
+		const bool compact = get<uint8_t>() != 0;
+		const vector<int> values = getVector<int>();
+		PositionSet positions(values.begin(), values.end());
+		if (compact) {
+			positions.compact();
+		}
+		return positions;
+	}
+	ValueOrReference getValueOrReference() {
+		if (get<uint8_t>() != 0) {
+			return ValueOrReference(boost::variant<double, Reference<Value>>(getReference<Value>()));
+		}
+		return ValueOrReference(get<double>());
+	}
+	DOFMatrix getDOFMatrix() {
+		DOFMatrix matrix(get<uint8_t>() != 0);
+		for (uint64_t i = get<uint64_t>(); i > 0; i--) {
+			const DOF dof1 = DOF::findByPosition(get<int32_t>());
+			const DOF dof2 = DOF::findByPosition(get<int32_t>());
+			matrix.componentByDofs[make_pair(dof1, dof2)] = get<double>();
+		}
+		return matrix;
+	}
+};
+
+/**
+ * The objects of the model. Pointers between objects are written as indices in the table.
+ */
+class ModelSnapshot::ObjectTable final {
+public:
+	class Entry final {
+	public:
+		Family family;
+		/**
+		 * The object, as a pointer to the base class of its family.
+		 */
+		shared_ptr<void> object;
+		const void* address;
+	};
+	vector<Entry> entries;
+	map<const void*, size_t> indexByAddress;
+	/**
+	 * Pointers between objects, set once all the objects are read.
+	 */
+	vector<function<void()>> fixups;
+	template<class T>
+	void add(Family family, const shared_ptr<T>& object) {
+		if (object == nullptr) {
+			return;
+		}
+		const void* address = dynamic_cast<const void*>(object.get());
+		if (indexByAddress.insert(make_pair(address, entries.size())).second) {
+			entries.push_back(Entry { family, static_pointer_cast<void>(object), address });
+		}
+	}
+	template<class T>
+	uint32_t indexOf(const shared_ptr<T>& object) const {
+		if (object == nullptr) {
+			return NO_OBJECT;
+		}
+		const auto it = indexByAddress.find(dynamic_cast<const void*>(object.get()));
+		if (it == indexByAddress.end()) {
+			throw logic_error("object not collected for the model snapshot");
+		}
+		return static_cast<uint32_t>(it->second);
+	}
+	template<class T>
+	void set(size_t index, Family family, const shared_ptr<T>& object) {
+		entries[index] = Entry { family, static_pointer_cast<void>(object),
+				dynamic_cast<const void*>(object.get()) };
+	}
+	template<class T>
+	shared_ptr<T> get(uint32_t index, Family family) const {
+		if (index == NO_OBJECT) {
+			return nullptr;
+		}
+		if (index >= entries.size() || entries[index].object == nullptr
+				|| entries[index].family != family) {
+			throw runtime_error("corrupted model snapshot");
+		}
+		return static_pointer_cast<T>(entries[index].object);
+	}
+};
+
+ModelSnapshot::ModelSnapshot(const ConfigurationParameters& configuration) :
+		configuration(configuration), inputDirectory(
+				fs::absolute(configuration.inputFile).parent_path()), fingerprint(
+				fingerprintOf(configuration)), valid(false), payloadOffset(0) {
+	const fs::path inputFile(configuration.inputFile);
+	const InputFile& mainFile = describe(inputFile);
+	const uint64_t hash = hashBytes(reinterpret_cast<const unsigned char*>(fingerprint.data()),
+			fingerprint.size(), mainFile.hash);
+	ostringstream name;
+	name << inputFile.filename().string() << "-" << hex << setw(16) << setfill('0') << hash
+			<< ".vega";
+	snapshotPath = configuration.modelCacheDirectory / name.str();
+	if (mainFile.size >= 0 && fs::exists(snapshotPath)) {
+		try {
+			open();
+		} catch (exception& e) {
+			cerr << "Model snapshot " << snapshotPath << " ignored: " << e.what() << endl;
+			valid = false;
+		}
+	}
+	if (!valid) {
+		if (mappedSnapshot.is_open()) {
+			mappedSnapshot.close();
+		}
+		inputFiles.clear();
+	}
+	if (configuration.logLevel >= LogLevel::DEBUG) {
+		cout << "Model snapshot " << snapshotPath << (valid ? " used." : " will be written.")
+				<< endl;
+	}
+}
+
+string ModelSnapshot::fingerprintOf(const ConfigurationParameters& configuration) {
+	const ModelConfiguration modelConfiguration = configuration.getModelConfiguration();
+	ostringstream fingerprint;
+	// the layout of the snapshot and the finished model both depend on the build
+	fingerprint << VEGA_VERSION_MAJOR << "." << VEGA_VERSION_MINOR << "." << VEGA_VERSION_PATCH
+			<< " " << VEGA_BUILD_ID << " " << BUILD_TYPE << " " << __DATE__ << " " << __TIME__
+			<< " " << configuration.outputSolver << " " << configuration.solverVersion << " "
+			<< configuration.translationMode << " "
+			<< (configuration.resultFile.empty() ?
+					string() : fs::absolute(configuration.resultFile).string()) << " "
+			<< setprecision(17) << configuration.testTolerance << " "
+			<< modelConfiguration.virtualDiscrets << modelConfiguration.createSkin
+			<< modelConfiguration.emulateLocalDisplacement
+			<< modelConfiguration.displayHomogeneousConstraint
+			<< modelConfiguration.emulateAdditionalMass
+			<< modelConfiguration.replaceCombinedLoadSets
+			<< modelConfiguration.removeIneffectives << modelConfiguration.partitionModel
+			<< modelConfiguration.replaceDirectMatrices << modelConfiguration.removeRedundantSpcs;
+	return fingerprint.str();
+}
+
+string ModelSnapshot::key(const fs::path& file) const {
+	// includes are given relative to the input file, or below its directory
+	const string absolute = fs::absolute(file).string();
+	const string directory = inputDirectory.string() + "/";
+	if (absolute.compare(0, directory.size(), directory) == 0) {
+		return absolute.substr(directory.size());
+	}
+	return absolute;
+}
+
+const ModelSnapshot::InputFile& ModelSnapshot::describe(const fs::path& file) {
+	const string fileKey = key(file);
+	auto it = describedFiles.find(fileKey);
+	if (it != describedFiles.end()) {
+		return it->second;
+	}
+	InputFile& inputFile = describedFiles[fileKey];
+	inputFile.path = fileKey;
+	if (fs::exists(file)) {
+		inputFile.size = static_cast<int64_t>(fs::file_size(file));
+		inputFile.hash = hashFile(file);
+	} else {
+		inputFile.size = -1;
+		inputFile.hash = 0;
+	}
+	return inputFile;
+}
+
+uint64_t ModelSnapshot::hashFile(const fs::path& file) {
+	// empty files can't be mapped
+	if (fs::file_size(file) == 0) {
+		return FNV_OFFSET_BASIS;
+	}
+	boost::iostreams::mapped_file_source mapped(file);
+	return hashBytes(reinterpret_cast<const unsigned char*>(mapped.data()), mapped.size(),
+			FNV_OFFSET_BASIS);
+}
+
+void ModelSnapshot::open() {
+	mappedSnapshot.open(snapshotPath);
+	Input input(mappedSnapshot.data(), mappedSnapshot.data() + mappedSnapshot.size());
+	input.require(sizeof(MAGIC));
+	if (memcmp(input.position, MAGIC, sizeof(MAGIC)) != 0) {
+		throw runtime_error("not a model snapshot");
+	}
+	input.position += sizeof(MAGIC);
+	if (input.get<uint32_t>() != BYTE_ORDER_MARK) {
+		throw runtime_error("written with another byte order");
+	}
+	if (input.getString() != fingerprint) {
+		throw runtime_error("written by another build or for other options");
+	}
+	const uint32_t fileCount = input.get<uint32_t>();
+	for (uint32_t i = 0; i < fileCount; i++) {
+		InputFile inputFile;
+		inputFile.path = input.getString();
+		inputFile.size = input.get<int64_t>();
+		inputFile.hash = input.get<uint64_t>();
+		const fs::path path =
+				fs::path(inputFile.path).is_absolute() ?
+						fs::path(inputFile.path) : inputDirectory / inputFile.path;
+		const InputFile& current = describe(path);
+		if (current.size != inputFile.size || current.hash != inputFile.hash) {
+			if (configuration.logLevel >= LogLevel::DEBUG) {
+				cout << "Model snapshot " << snapshotPath << " outdated: " << path << " changed."
+						<< endl;
+			}
+			return;
+		}
+		inputFiles.push_back(inputFile);
+	}
+	payloadOffset = static_cast<size_t>(input.position - mappedSnapshot.data());
+	valid = true;
+}
+
+bool ModelSnapshot::isValid() const {
+	return valid;
+}
+
+const fs::path& ModelSnapshot::getPath() const {
+	return snapshotPath;
+}
+
+template<class T>
+int& ModelSnapshot::autoId() {
+	return Identifiable<T>::auto_id;
+}
+
+vector<int> ModelSnapshot::autoIds() {
+	return {autoId<Analysis>(), autoId<Objective>(), autoId<Value>(), autoId<Loading>(),
+		autoId<LoadSet>(), autoId<Constraint>(), autoId<ConstraintSet>(),
+		autoId<CoordinateSystem>(), autoId<ElementSet>(), autoId<Material>(), autoId<Group>(),
+		autoId<Orientation>(), Node::auto_node_id, Cell::auto_cell_id};
+}
+
+void ModelSnapshot::restoreAutoIds(const vector<int>& autoIds) {
+	if (autoIds.size() != 14) {
+		throw runtime_error("corrupted model snapshot");
+	}
+	autoId<Analysis>() = autoIds[0];
+	autoId<Objective>() = autoIds[1];
+	autoId<Value>() = autoIds[2];
+	autoId<Loading>() = autoIds[3];
+	autoId<LoadSet>() = autoIds[4];
+	autoId<Constraint>() = autoIds[5];
+	autoId<ConstraintSet>() = autoIds[6];
+	autoId<CoordinateSystem>() = autoIds[7];
+	autoId<ElementSet>() = autoIds[8];
+	autoId<Material>() = autoIds[9];
+	autoId<Group>() = autoIds[10];
+	autoId<Orientation>() = autoIds[11];
+	Node::auto_node_id = autoIds[12];
+	Cell::auto_cell_id = autoIds[13];
+}
+
+template<class T>
+void ModelSnapshot::restoreIdentity(Identifiable<T>& object, int originalId, int id) {
+	object.original_id = originalId;
+	object.id = id;
+}
+
+shared_ptr<Model> ModelSnapshot::load() {
+	if (!valid) {
+		return nullptr;
+	}
+	// a snapshot that can't be read must not change the ids of the model parsed instead
+	const vector<int> previousAutoIds = autoIds();
+	try {
+		Input input(mappedSnapshot.data() + payloadOffset,
+				mappedSnapshot.data() + mappedSnapshot.size());
+		shared_ptr<Model> model = readModel(input);
+		if (input.position != input.end) {
+			throw runtime_error("corrupted model snapshot");
+		}
+		return model;
+	} catch (exception& e) {
+		restoreAutoIds(previousAutoIds);
+		cerr << "Model snapshot " << snapshotPath << " ignored: " << e.what() << endl;
+		return nullptr;
+	}
+}
+
+void ModelSnapshot::write(const Model& model) {
+	vector<InputFile> modelFiles;
+	vector<fs::path> files(model.inputFiles);
+	if (!configuration.resultFile.empty()) {
+		files.push_back(configuration.resultFile);
+	}
+	for (const fs::path& file : files) {
+		const InputFile& inputFile = describe(file);
+		if (none_of(modelFiles.begin(), modelFiles.end(), [&inputFile](const InputFile& other) {
+			return other.path == inputFile.path;
+		})) {
+			modelFiles.push_back(inputFile);
+		}
+	}
+	Output output;
+	output.buffer.assign(MAGIC, MAGIC + sizeof(MAGIC));
+	output.put<uint32_t>(BYTE_ORDER_MARK);
+	output.putString(fingerprint);
+	output.put<uint32_t>(static_cast<uint32_t>(modelFiles.size()));
+	for (const InputFile& inputFile : modelFiles) {
+		output.putString(inputFile.path);
+		output.put<int64_t>(inputFile.size);
+		output.put<uint64_t>(inputFile.hash);
+	}
+	// written aside then renamed, so that a concurrent translation never maps half a snapshot
+	const fs::path temporaryPath = snapshotPath.string() + "." + fs::unique_path().string();
+	try {
+		if (model.inputFiles.empty()) {
+			throw runtime_error("input files of the model unknown");
+		}
+		writeModel(output, model);
+		fs::create_directories(snapshotPath.parent_path());
+		{
+			ofstream out(temporaryPath.string(), ios::binary);
+			out.write(output.buffer.data(), static_cast<streamsize>(output.buffer.size()));
+			if (!out) {
+				throw runtime_error("write error");
+			}
+		}
+		fs::rename(temporaryPath, snapshotPath);
+	} catch (exception& e) {
+		cerr << "Model snapshot " << snapshotPath << " not written: " << e.what() << endl;
+		boost::system::error_code ignored;
+		fs::remove(temporaryPath, ignored);
+		return;
+	}
+	if (configuration.logLevel >= LogLevel::DEBUG) {
+		cout << "Model snapshot " << snapshotPath << " written." << endl;
+	}
+}
+
+template<class T, class C>
+void ModelSnapshot::collectObjects(ObjectTable& table, Family family, const C& container) {
+	for (const auto& idAndObject : container.by_id) {
+		table.add<T>(family, idAndObject.second);
+	}
+	for (const auto& typeAndObjects : container.by_original_ids_by_type) {
+		for (const auto& idAndObject : typeAndObjects.second) {
+			table.add<T>(family, idAndObject.second);
+		}
+	}
+}
+
+template<class C>
+void ModelSnapshot::writeContainer(Output& output, const ObjectTable& table, const C& container) {
+	output.put<uint64_t>(container.by_id.size());
+	for (const auto& idAndObject : container.by_id) {
+		output.put<int32_t>(idAndObject.first);
+		output.put<uint32_t>(table.indexOf(idAndObject.second));
+	}
+	output.put<uint64_t>(container.by_original_ids_by_type.size());
+	for (const auto& typeAndObjects : container.by_original_ids_by_type) {
+		output.put<int32_t>(typeAndObjects.first);
+		output.put<uint64_t>(typeAndObjects.second.size());
+		for (const auto& idAndObject : typeAndObjects.second) {
+			output.put<int32_t>(idAndObject.first);
+			output.put<uint32_t>(table.indexOf(idAndObject.second));
+		}
+	}
+}
+
+template<class T, class C>
+void ModelSnapshot::readContainer(Input& input, const ObjectTable& table, Family family,
+		C& container) {
+	for (uint64_t i = input.get<uint64_t>(); i > 0; i--) {
+		const int id = input.get<int32_t>();
+		container.by_id[id] = table.get<T>(input.get<uint32_t>(), family);
+	}
+	for (uint64_t i = input.get<uint64_t>(); i > 0; i--) {
+		const auto type = static_cast<typename T::Type>(input.get<int32_t>());
+		map<int, shared_ptr<T>>& objects = container.by_original_ids_by_type[type];
+		for (uint64_t j = input.get<uint64_t>(); j > 0; j--) {
+			const int originalId = input.get<int32_t>();
+			objects[originalId] = table.get<T>(input.get<uint32_t>(), family);
+		}
+	}
+}
+
+void ModelSnapshot::writeModel(Output& output, const Model& model) {
+	output.putVector(autoIds());
+	output.putIdentity(model.commonLoadSet);
+	output.putIdentity(model.commonConstraintSet);
+	output.putString(model.name);
+	output.putString(model.inputSolverVersion);
+	output.put<int32_t>(model.inputSolver);
+	output.put<uint8_t>(model.finished);
+	output.put<uint8_t>(model.afterValidation);
+	output.put<uint8_t>(model.onlyMesh);
+	output.put<int8_t>(modelTypeIndex(&model.modelType));
+	output.putString(model.title);
+	output.putString(model.description);
+	output.put<uint64_t>(model.parameters.size());
+	for (const auto& parameterAndValue : model.parameters) {
+		output.put<int32_t>(parameterAndValue.first);
+		output.put<double>(parameterAndValue.second);
+	}
+	output.put<uint32_t>(static_cast<uint32_t>(model.inputFiles.size()));
+	for (const fs::path& inputFile : model.inputFiles) {
+		output.putString(inputFile.string());
+	}
+	writeMesh(output, *model.mesh);
+
+	ObjectTable table;
+	collectObjects<Analysis>(table, Family::ANALYSIS, model.analyses);
+	collectObjects<Objective>(table, Family::OBJECTIVE, model.objectives);
+	collectObjects<Value>(table, Family::VALUE, model.values);
+	collectObjects<Loading>(table, Family::LOADING, model.loadings);
+	collectObjects<LoadSet>(table, Family::LOAD_SET, model.loadSets);
+	collectObjects<Constraint>(table, Family::CONSTRAINT, model.constraints);
+	collectObjects<ConstraintSet>(table, Family::CONSTRAINT_SET, model.constraintSets);
+	collectObjects<CoordinateSystem>(table, Family::COORDINATE_SYSTEM,
+			model.coordinateSystems);
+	collectObjects<ElementSet>(table, Family::ELEMENT_SET, model.elementSets);
+	collectObjects<Material>(table, Family::MATERIAL, model.materials);
+	table.add<Material>(Family::MATERIAL, model.virtualMaterial);
+	for (const auto& idAndAnalysis : model.analyses.by_id) {
+		table.add<Analysis>(Family::ANALYSIS, idAndAnalysis.second->previousAnalysis);
+	}
+	for (const auto& idAndObjective : model.objectives.by_id) {
+		if (is<ModalDamping>(*idAndObjective.second)) {
+			table.add<Value>(Family::VALUE,
+					static_cast<const ModalDamping&>(*idAndObjective.second).function);
+		}
+	}
+	for (const auto& idAndElementSet : model.elementSets.by_id) {
+		table.add<Material>(Family::MATERIAL, idAndElementSet.second->material);
+	}
+	for (const auto& orientationAndName : model.mesh->cellGroupName_by_orientation) {
+		table.add<Orientation>(Family::ORIENTATION, orientationAndName.first);
+	}
+	output.put<uint64_t>(table.entries.size());
+	for (size_t i = 0; i < table.entries.size(); i++) {
+		writeObject(output, table, i);
+	}
+
+	writeContainer(output, table, model.analyses);
+	writeContainer(output, table, model.objectives);
+	writeContainer(output, table, model.values);
+	writeContainer(output, table, model.loadings);
+	writeContainer(output, table, model.loadSets);
+	writeContainer(output, table, model.constraints);
+	writeContainer(output, table, model.constraintSets);
+	writeContainer(output, table, model.coordinateSystems);
+	writeContainer(output, table, model.elementSets);
+	writeContainer(output, table, model.materials);
+	output.put<uint32_t>(table.indexOf(model.virtualMaterial));
+	output.put<uint64_t>(model.mesh->cellGroupName_by_orientation.size());
+	for (const auto& orientationAndName : model.mesh->cellGroupName_by_orientation) {
+		output.put<uint32_t>(table.indexOf(orientationAndName.first));
+		output.putString(orientationAndName.second);
+	}
+
+	const auto& loadingsByTypes = model.loadingReferences_by_loadSet_original_ids_by_loadSet_type;
+	output.put<uint64_t>(loadingsByTypes.size());
+	for (const auto& typeAndSets : loadingsByTypes) {
+		output.put<int32_t>(typeAndSets.first);
+		output.put<uint64_t>(typeAndSets.second.size());
+		for (const auto& setAndLoadings : typeAndSets.second) {
+			output.put<int32_t>(setAndLoadings.first);
+			output.putReferenceSet(setAndLoadings.second);
+		}
+	}
+	const auto& loadingsBySetIds = model.loadingReferences_by_loadSet_ids;
+	output.put<uint64_t>(loadingsBySetIds.size());
+	for (const auto& setAndLoadings : loadingsBySetIds) {
+		output.put<int32_t>(setAndLoadings.first);
+		output.putReferenceSet(setAndLoadings.second);
+	}
+	const auto& constraintsByTypes =
+			model.constraintReferences_by_constraintSet_original_ids_by_constraintSet_type;
+	output.put<uint64_t>(constraintsByTypes.size());
+	for (const auto& typeAndSets : constraintsByTypes) {
+		output.put<int32_t>(typeAndSets.first);
+		output.put<uint64_t>(typeAndSets.second.size());
+		for (const auto& setAndConstraints : typeAndSets.second) {
+			output.put<int32_t>(setAndConstraints.first);
+			output.putReferenceSet(setAndConstraints.second);
+		}
+	}
+	output.put<uint64_t>(model.constraintReferences_by_constraintSet_ids.size());
+	for (const auto& setAndConstraints : model.constraintReferences_by_constraintSet_ids) {
+		output.put<int32_t>(setAndConstraints.first);
+		output.putReferenceSet(setAndConstraints.second);
+	}
+	output.put<uint64_t>(model.loadSetKeys_by_loading.size());
+	for (const auto& loadingAndKeys : model.loadSetKeys_by_loading) {
+		output.putReference(loadingAndKeys.first);
+		output.putReferenceSet(loadingAndKeys.second);
+	}
+	output.put<uint64_t>(model.constraintSetKeys_by_constraint.size());
+	for (const auto& constraintAndKeys : model.constraintSetKeys_by_constraint) {
+		output.putReference(constraintAndKeys.first);
+		output.putReferenceSet(constraintAndKeys.second);
+	}
+	const auto& assignments = model.material_assignment_by_material_id;
+	output.put<uint64_t>(assignments.size());
+	for (const auto& materialAndCells : assignments) {
+		output.put<int32_t>(materialAndCells.first);
+		writeCellContainer(output, materialAndCells.second);
+	}
+}
+
+shared_ptr<Model> ModelSnapshot::readModel(Input& input) const {
+	const vector<int> finalAutoIds = input.getVector<int>();
+	const Identity commonLoadSet = input.getIdentity();
+	const Identity commonConstraintSet = input.getIdentity();
+	const string name = input.getString();
+	const string inputSolverVersion = input.getString();
+	const auto inputSolver = static_cast<SolverName>(input.get<int32_t>());
+	const bool finished = input.get<uint8_t>() != 0;
+	const bool afterValidation = input.get<uint8_t>() != 0;
+	const bool onlyMesh = input.get<uint8_t>() != 0;
+	const ModelType* modelType = modelTypeAt(input.get<int8_t>());
+	if (modelType == nullptr) {
+		throw runtime_error("corrupted model snapshot");
+	}
+	// the common sets get the ids they had, as they are built with the model
+	autoId<LoadSet>() = commonLoadSet.id - 1;
+	autoId<ConstraintSet>() = commonConstraintSet.id - 1;
+	shared_ptr<Model> model = shared_ptr<Model>(new Model(name, inputSolverVersion, inputSolver,
+			configuration.getModelConfiguration()));
+	model->afterValidation = afterValidation;
+	model->onlyMesh = onlyMesh;
+	model->modelType = *modelType;
+	model->title = input.getString();
+	model->description = input.getString();
+	for (uint64_t i = input.get<uint64_t>(); i > 0; i--) {
+		const auto parameter = static_cast<Model::Parameter>(input.get<int32_t>());
+		model->parameters[parameter] = input.get<double>();
+	}
+	for (uint32_t i = input.get<uint32_t>(); i > 0; i--) {
+		model->inputFiles.push_back(input.getString());
+	}
+	readMesh(input, *model->mesh);
+
+	ObjectTable table;
+	table.entries.resize(static_cast<size_t>(input.get<uint64_t>()));
+	for (size_t i = 0; i < table.entries.size(); i++) {
+		readObject(input, *model, table, i);
+	}
+	for (const auto& fixup : table.fixups) {
+		fixup();
+	}
+
+	readContainer<Analysis>(input, table, Family::ANALYSIS, model->analyses);
+	readContainer<Objective>(input, table, Family::OBJECTIVE, model->objectives);
+	readContainer<Value>(input, table, Family::VALUE, model->values);
+	readContainer<Loading>(input, table, Family::LOADING, model->loadings);
+	readContainer<LoadSet>(input, table, Family::LOAD_SET, model->loadSets);
+	readContainer<Constraint>(input, table, Family::CONSTRAINT, model->constraints);
+	readContainer<ConstraintSet>(input, table, Family::CONSTRAINT_SET, model->constraintSets);
+	readContainer<CoordinateSystem>(input, table, Family::COORDINATE_SYSTEM,
+			model->coordinateSystems);
+	readContainer<ElementSet>(input, table, Family::ELEMENT_SET, model->elementSets);
+	readContainer<Material>(input, table, Family::MATERIAL, model->materials);
+	model->virtualMaterial = table.get<Material>(input.get<uint32_t>(), Family::MATERIAL);
+	for (uint64_t i = input.get<uint64_t>(); i > 0; i--) {
+		const shared_ptr<Orientation> orientation = table.get<Orientation>(
+				input.get<uint32_t>(), Family::ORIENTATION);
+		if (orientation == nullptr) {
+			throw runtime_error("corrupted model snapshot");
+		}
+		model->mesh->cellGroupName_by_orientation[orientation] = input.getString();
+	}
+
+	// the unordered maps of the model are only searched, never iterated
+	for (uint64_t i = input.get<uint64_t>(); i > 0; i--) {
+		const auto type = static_cast<LoadSet::Type>(input.get<int32_t>());
+		auto& loadingsBySets = model->loadingReferences_by_loadSet_original_ids_by_loadSet_type[type];
+		for (uint64_t j = input.get<uint64_t>(); j > 0; j--) {
+			const int setId = input.get<int32_t>();
+			loadingsBySets[setId] = input.getReferenceSet<Loading>();
+		}
+	}
+	for (uint64_t i = input.get<uint64_t>(); i > 0; i--) {
+		const int setId = input.get<int32_t>();
+		model->loadingReferences_by_loadSet_ids[setId] = input.getReferenceSet<Loading>();
+	}
+	for (uint64_t i = input.get<uint64_t>(); i > 0; i--) {
+		const auto type = static_cast<ConstraintSet::Type>(input.get<int32_t>());
+		auto& constraintsBySets =
+				model->constraintReferences_by_constraintSet_original_ids_by_constraintSet_type[type];
+		for (uint64_t j = input.get<uint64_t>(); j > 0; j--) {
+			const int setId = input.get<int32_t>();
+			constraintsBySets[setId] = input.getReferenceSet<Constraint>();
+		}
+	}
+	for (uint64_t i = input.get<uint64_t>(); i > 0; i--) {
+		const int setId = input.get<int32_t>();
+		model->constraintReferences_by_constraintSet_ids[setId] =
+				input.getReferenceSet<Constraint>();
+	}
+	for (uint64_t i = input.get<uint64_t>(); i > 0; i--) {
+		const Reference<Loading> loading = input.getReference<Loading>();
+		model->loadSetKeys_by_loading[loading] = input.getReferenceSet<LoadSet>();
+	}
+	for (uint64_t i = input.get<uint64_t>(); i > 0; i--) {
+		const Reference<Constraint> constraint = input.getReference<Constraint>();
+		model->constraintSetKeys_by_constraint[constraint] =
+				input.getReferenceSet<ConstraintSet>();
+	}
+	for (uint64_t i = input.get<uint64_t>(); i > 0; i--) {
+		const int materialId = input.get<int32_t>();
+		CellContainer cells(model->mesh);
+		readCellContainer(input, cells);
+		model->material_assignment_by_material_id.insert(make_pair(materialId, std::move(cells)));
+	}
+
+	model->finished = finished;
+	restoreAutoIds(finalAutoIds);
+	return model;
+}
+
+void ModelSnapshot::writeMesh(Output& output, const Mesh& mesh) {
+	output.put<uint8_t>(mesh.finished);
+	const NodeStorage& nodes = mesh.nodes;
+	output.putVector(nodes.ids);
+	output.putVector(nodes.dofs);
+	output.putVector(nodes.coordinates);
+	output.putVector(nodes.displacementCSs);
+	output.putVector(nodes.positionCSs);
+	const CellStorage& cells = mesh.cells;
+	output.put<uint64_t>(cells.cellDatas.size());
+	for (const CellData& cellData : cells.cellDatas) {
+		output.put<int32_t>(cellData.id);
+		output.put<int32_t>(cellData.typeCode);
+		output.put<uint8_t>(cellData.isvirtual);
+		output.put<int32_t>(cellData.orientationId);
+		output.put<int32_t>(cellData.elementId);
+		output.put<int32_t>(cellData.cellTypePosition);
+	}
+	output.putVector(cells.nodepositions);
+	output.putVector(vector<uint64_t>(cells.nodepositionOffsets.begin(),
+			cells.nodepositionOffsets.end()));
+	output.put<uint64_t>(mesh.cellPositionsByType.size());
+	for (const auto& typeAndPositions : mesh.cellPositionsByType) {
+		output.put<int32_t>(typeAndPositions.first.code);
+		output.putVector(typeAndPositions.second);
+	}
+	output.put<uint64_t>(mesh.groups.size());
+	for (const Group* groupPointer : mesh.groups) {
+		const Group& group = *groupPointer;
+		output.putString(group.getName());
+		output.put<int32_t>(group.type);
+		output.putIdentity(group);
+		if (group.type == Group::NODEGROUP) {
+			output.putPositionSet(static_cast<const NodeGroup&>(group)._nodePositions);
+		} else {
+			output.putPositionSet(static_cast<const CellGroup&>(group)._cellPositions);
+		}
+	}
+	output.put<uint64_t>(mesh.groupById.size());
+	for (const auto& idAndGroup : mesh.groupById) {
+		output.put<int32_t>(idAndGroup.first);
+		output.putString(idAndGroup.second->getName());
+	}
+}
+
+void ModelSnapshot::readMesh(Input& input, Mesh& mesh) {
+	mesh.finished = input.get<uint8_t>() != 0;
+	NodeStorage& nodes = mesh.nodes;
+	nodes.ids = input.getVector<int>();
+	nodes.dofs = input.getVector<char>();
+	nodes.coordinates = input.getVector<double>();
+	nodes.displacementCSs = input.getVector<int>();
+	nodes.positionCSs = input.getVector<int>();
+	const size_t nodeCount = nodes.ids.size();
+	if (nodes.dofs.size() != nodeCount || nodes.coordinates.size() != 3 * nodeCount
+			|| nodes.displacementCSs.size() != nodeCount || nodes.positionCSs.size() != nodeCount) {
+		throw runtime_error("corrupted model snapshot");
+	}
+	for (size_t position = 0; position < nodeCount; position++) {
+		nodes.nodepositionById.set(nodes.ids[position], static_cast<int>(position));
+	}
+	CellStorage& cells = mesh.cells;
+	const uint64_t cellCount = input.get<uint64_t>();
+	cells.cellDatas.reserve(static_cast<size_t>(cellCount));
+	for (uint64_t position = 0; position < cellCount; position++) {
+		const int id = input.get<int32_t>();
+		const CellType* type = CellType::findByCode(static_cast<CellType::Code>(input.get<int32_t>()));
+		if (type == nullptr) {
+			throw runtime_error("corrupted model snapshot");
+		}
+		const bool isvirtual = input.get<uint8_t>() != 0;
+		const int orientationId = input.get<int32_t>();
+		const int elementId = input.get<int32_t>();
+		const int cellTypePosition = input.get<int32_t>();
+		cells.cellDatas.push_back(CellData(id, *type, isvirtual, elementId, cellTypePosition));
+		cells.cellDatas.back().orientationId = orientationId;
+		cells.cellpositionById.set(id, static_cast<int>(position));
+	}
+	cells.nodepositions = input.getVector<int>();
+	const vector<uint64_t> offsets = input.getVector<uint64_t>();
+	if (offsets.size() != cellCount + 1 || offsets.back() != cells.nodepositions.size()) {
+		throw runtime_error("corrupted model snapshot");
+	}
+	cells.nodepositionOffsets.assign(offsets.begin(), offsets.end());
+	for (uint64_t i = input.get<uint64_t>(); i > 0; i--) {
+		const CellType* type = CellType::findByCode(static_cast<CellType::Code>(input.get<int32_t>()));
+		if (type == nullptr) {
+			throw runtime_error("corrupted model snapshot");
+		}
+		mesh.cellPositionsByType.at(*type) = input.getVector<int>();
+	}
+	if (mesh.finished) {
+		nodes.nodepositionById.rebalance();
+		cells.cellpositionById.rebalance();
+	}
+
+	vector<unique_ptr<Group>> groups;
+	for (uint64_t i = input.get<uint64_t>(); i > 0; i--) {
+		const string name = input.getString();
+		const int type = input.get<int32_t>();
+		const Identity identity = input.getIdentity();
+		if (type == Group::NODEGROUP) {
+			NodeGroup* nodeGroup = new NodeGroup(&mesh, name, identity.originalId);
+			groups.push_back(unique_ptr<Group>(nodeGroup));
+			nodeGroup->_nodePositions = input.getPositionSet();
+		} else if (type == Group::CELLGROUP) {
+			CellGroup* cellGroup = new CellGroup(&mesh, name);
+			groups.push_back(unique_ptr<Group>(cellGroup));
+			cellGroup->_cellPositions = input.getPositionSet();
+		} else {
+			throw runtime_error("corrupted model snapshot");
+		}
+		restoreIdentity(*groups.back(), identity.originalId, identity.id);
+	}
+	// the mesh owns the groups, in creation order
+	for (auto& group : groups) {
+		mesh.groups.push_back(group.get());
+		mesh.groupByName[group->getName()] = group.release();
+	}
+	for (uint64_t i = input.get<uint64_t>(); i > 0; i--) {
+		const int id = input.get<int32_t>();
+		Group* group = mesh.findGroup(input.getString());
+		if (group == nullptr) {
+			throw runtime_error("corrupted model snapshot");
+		}
+		mesh.groupById[id] = group;
+	}
+}
+
+void ModelSnapshot::writeCellContainer(Output& output, const CellContainer& cellContainer) {
+	output.putPositionSet(cellContainer.cellPositions);
+	output.putPositionSet(cellContainer.pendingCellIds);
+	output.put<uint64_t>(cellContainer.groupNames.size());
+	for (const string& groupName : cellContainer.groupNames) {
+		output.putString(groupName);
+	}
+}
+
+void ModelSnapshot::readCellContainer(Input& input, CellContainer& cellContainer) {
+	cellContainer.cellPositions = input.getPositionSet();
+	cellContainer.pendingCellIds = input.getPositionSet();
+	for (uint64_t i = input.get<uint64_t>(); i > 0; i--) {
+		cellContainer.groupNames.insert(cellContainer.groupNames.end(), input.getString());
+	}
+	cellContainer.generation = Group::nextGeneration();
+}
+
+void ModelSnapshot::writeObject(Output& output, const ObjectTable& table, size_t index) {
+	const ObjectTable::Entry& entry = table.entries[index];
+	output.put<Family>(entry.family);
+	switch (entry.family) {
+	case Family::ANALYSIS:
+		writeAnalysis(output, table, *table.get<Analysis>(static_cast<uint32_t>(index), entry.family));
+		break;
+	case Family::OBJECTIVE:
+		writeObjective(output, table, *table.get<Objective>(static_cast<uint32_t>(index), entry.family));
+		break;
+	case Family::VALUE:
+		writeValue(output, *table.get<Value>(static_cast<uint32_t>(index), entry.family));
+		break;
+	case Family::LOADING:
+		writeLoading(output, *table.get<Loading>(static_cast<uint32_t>(index), entry.family));
+		break;
+	case Family::LOAD_SET: {
+		const LoadSet& loadSet = *table.get<LoadSet>(static_cast<uint32_t>(index), entry.family);
+		output.putIdentity(loadSet);
+		output.put<int32_t>(loadSet.type);
+		output.put<uint64_t>(loadSet.embedded_loadsets.size());
+		for (const auto& embedded : loadSet.embedded_loadsets) {
+			output.putReference(embedded.first);
+			output.put<double>(embedded.second);
+		}
+		break;
+	}
+	case Family::CONSTRAINT:
+		writeConstraint(output, *table.get<Constraint>(static_cast<uint32_t>(index), entry.family));
+		break;
+	case Family::CONSTRAINT_SET: {
+		const ConstraintSet& constraintSet = *table.get<ConstraintSet>(static_cast<uint32_t>(index),
+				entry.family);
+		output.putIdentity(constraintSet);
+		output.put<int32_t>(constraintSet.type);
+		output.put<uint64_t>(constraintSet.getConstraintSetReferences().size());
+		for (const auto& reference : constraintSet.getConstraintSetReferences()) {
+			output.putReference(reference);
+		}
+		break;
+	}
+	case Family::COORDINATE_SYSTEM:
+		writeCoordinateSystem(output,
+				*table.get<CoordinateSystem>(static_cast<uint32_t>(index), entry.family));
+		break;
+	case Family::ELEMENT_SET:
+		writeElementSet(output, table,
+				*table.get<ElementSet>(static_cast<uint32_t>(index), entry.family));
+		break;
+	case Family::MATERIAL:
+		writeMaterial(output, *table.get<Material>(static_cast<uint32_t>(index), entry.family));
+		break;
+	case Family::ORIENTATION:
+		writeOrientation(output, *table.get<Orientation>(static_cast<uint32_t>(index), entry.family));
+		break;
+	}
+}
+
+void ModelSnapshot::readObject(Input& input, Model& model, ObjectTable& table, size_t index) {
+	const Family family = input.get<Family>();
+	switch (family) {
+	case Family::ANALYSIS:
+		table.set(index, family, readAnalysis(input, model, table));
+		break;
+	case Family::OBJECTIVE:
+		table.set(index, family, readObjective(input, model, table));
+		break;
+	case Family::VALUE:
+		table.set(index, family, readValue(input, model));
+		break;
+	case Family::LOADING:
+		table.set(index, family, readLoading(input, model));
+		break;
+	case Family::LOAD_SET: {
+		const Identity identity = input.getIdentity();
+		const auto type = static_cast<LoadSet::Type>(input.get<int32_t>());
+		const shared_ptr<LoadSet> loadSet = makeModelObject<LoadSet>(model, model, type,
+				identity.originalId);
+		restoreIdentity(*loadSet, identity.originalId, identity.id);
+		for (uint64_t i = input.get<uint64_t>(); i > 0; i--) {
+			const Reference<LoadSet> embedded = input.getReference<LoadSet>();
+			loadSet->embedded_loadsets.push_back(make_pair(embedded, input.get<double>()));
+		}
+		table.set(index, family, loadSet);
+		break;
+	}
+	case Family::CONSTRAINT:
+		table.set(index, family, readConstraint(input, model));
+		break;
+	case Family::CONSTRAINT_SET: {
+		const Identity identity = input.getIdentity();
+		const auto type = static_cast<ConstraintSet::Type>(input.get<int32_t>());
+		const shared_ptr<ConstraintSet> constraintSet = makeModelObject<ConstraintSet>(model,
+				model, type, identity.originalId);
+		restoreIdentity(*constraintSet, identity.originalId, identity.id);
+		for (uint64_t i = input.get<uint64_t>(); i > 0; i--) {
+			constraintSet->add(input.getReference<ConstraintSet>());
+		}
+		table.set(index, family, constraintSet);
+		break;
+	}
+	case Family::COORDINATE_SYSTEM:
+		table.set(index, family, readCoordinateSystem(input, model));
+		break;
+	case Family::ELEMENT_SET:
+		table.set(index, family, readElementSet(input, model, table));
+		break;
+	case Family::MATERIAL:
+		table.set(index, family, readMaterial(input, model));
+		break;
+	case Family::ORIENTATION:
+		table.set(index, family, readOrientation(input, model));
+		break;
+	default:
+		throw runtime_error("corrupted model snapshot");
+	}
+}
+
+void ModelSnapshot::writeAnalysis(Output& output, const ObjectTable& table,
+		const Analysis& analysis) {
+	Kind kind;
+	if (is<LinearMecaStat>(analysis)) {
+		kind = Kind::LINEAR_MECA_STAT;
+	} else if (is<NonLinearMecaStat>(analysis)) {
+		kind = Kind::NONLINEAR_MECA_STAT;
+	} else if (is<LinearModal>(analysis)) {
+		kind = Kind::LINEAR_MODAL;
+	} else if (is<LinearDynaModalFreq>(analysis)) {
+		kind = Kind::LINEAR_DYNA_MODAL_FREQ;
+	} else {
+		throw unsupported("analysis", typeid(analysis));
+	}
+	output.put<Kind>(kind);
+	output.putIdentity(analysis);
+	output.putVector(analysis.getBoundaryDOFS());
+	output.putReferences(analysis.getLoadSetReferences());
+	output.putReferences(analysis.getConstraintSetReferences());
+	output.putReferences(analysis.getAssertionReferences());
+	output.put<uint32_t>(table.indexOf(analysis.previousAnalysis));
+	switch (kind) {
+	case Kind::NONLINEAR_MECA_STAT:
+		output.putReference(static_cast<const NonLinearMecaStat&>(analysis).strategy_reference);
+		break;
+	case Kind::LINEAR_MODAL: {
+		const LinearModal& linearModal = static_cast<const LinearModal&>(analysis);
+		output.put<int32_t>(linearModal.type);
+		output.putReference(linearModal.getFrequencyBandReference());
+		break;
+	}
+	case Kind::LINEAR_DYNA_MODAL_FREQ: {
+		const LinearDynaModalFreq& linearDynaModalFreq =
+				static_cast<const LinearDynaModalFreq&>(analysis);
+		output.put<uint8_t>(linearDynaModalFreq.residual_vector);
+		output.putReference(linearDynaModalFreq.getFrequencyBandReference());
+		output.putReference(linearDynaModalFreq.getModalDampingReference());
+		output.putReference(linearDynaModalFreq.getFrequencyValuesReference());
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+shared_ptr<Analysis> ModelSnapshot::readAnalysis(Input& input, Model& model,
+		ObjectTable& table) {
+	const Kind kind = input.get<Kind>();
+	const Identity identity = input.getIdentity();
+	const vector<char> boundaryDOFS = input.getVector<char>();
+	auto loadSetReferences = input.getReferences<LoadSet>();
+	auto constraintSetReferences = input.getReferences<ConstraintSet>();
+	auto assertionReferences = input.getReferences<Objective>();
+	const uint32_t previousAnalysis = input.get<uint32_t>();
+	shared_ptr<Analysis> analysis;
+	switch (kind) {
+	case Kind::LINEAR_MECA_STAT:
+		analysis = makeModelObject<LinearMecaStat>(model, model, identity.originalId);
+		break;
+	case Kind::NONLINEAR_MECA_STAT: {
+		const auto nonLinearMecaStat = makeModelObject<NonLinearMecaStat>(model, model, 0,
+				identity.originalId);
+		nonLinearMecaStat->strategy_reference = input.getReference<Objective>();
+		analysis = nonLinearMecaStat;
+		break;
+	}
+	case Kind::LINEAR_MODAL: {
+		const auto type = static_cast<Analysis::Type>(input.get<int32_t>());
+		analysis = makeModelObject<LinearModal>(model, model, input.getReference<Objective>(),
+				identity.originalId, type);
+		break;
+	}
+	case Kind::LINEAR_DYNA_MODAL_FREQ: {
+		const bool residualVector = input.get<uint8_t>() != 0;
+		const Reference<Objective> frequencyBand = input.getReference<Objective>();
+		const Reference<Objective> modalDamping = input.getReference<Objective>();
+		const Reference<Objective> frequencyValues = input.getReference<Objective>();
+		analysis = makeModelObject<LinearDynaModalFreq>(model, model, frequencyBand,
+				modalDamping, frequencyValues, residualVector, identity.originalId);
+		break;
+	}
+	default:
+		throw runtime_error("corrupted model snapshot");
+	}
+	restoreIdentity(*analysis, identity.originalId, identity.id);
+	for (size_t position = 0; position < boundaryDOFS.size(); position++) {
+		if (boundaryDOFS[position] != 0) {
+			analysis->addBoundaryDOFS(static_cast<int>(position), DOFS(boundaryDOFS[position]));
+		}
+	}
+	for (const auto& reference : loadSetReferences) {
+		analysis->add(*reference);
+	}
+	for (const auto& reference : constraintSetReferences) {
+		analysis->add(*reference);
+	}
+	for (const auto& reference : assertionReferences) {
+		analysis->add(*reference);
+	}
+	if (previousAnalysis != NO_OBJECT) {
+		Analysis* const target = analysis.get();
+		const ObjectTable* const objects = &table;
+		table.fixups.push_back([target, objects, previousAnalysis]() {
+			target->previousAnalysis = objects->get<Analysis>(previousAnalysis, Family::ANALYSIS);
+		});
+	}
+	return analysis;
+}
+
+void ModelSnapshot::writeObjective(Output& output, const ObjectTable& table,
+		const Objective& objective) {
+	if (is<NodalDisplacementAssertion>(objective)) {
+		const auto& assertion = static_cast<const NodalDisplacementAssertion&>(objective);
+		output.put<Kind>(Kind::NODAL_DISPLACEMENT_ASSERTION);
+		output.putIdentity(objective);
+		output.put<double>(assertion.tolerance);
+		output.put<int32_t>(assertion.nodePosition);
+		output.put<int32_t>(assertion.dof.position);
+		output.put<double>(assertion.value);
+		output.put<double>(assertion.instant);
+	} else if (is<NodalComplexDisplacementAssertion>(objective)) {
+		const auto& assertion = static_cast<const NodalComplexDisplacementAssertion&>(objective);
+		output.put<Kind>(Kind::NODAL_COMPLEX_DISPLACEMENT_ASSERTION);
+		output.putIdentity(objective);
+		output.put<double>(assertion.tolerance);
+		output.put<int32_t>(assertion.nodePosition);
+		output.put<int32_t>(assertion.dof.position);
+		output.put<double>(assertion.value.real());
+		output.put<double>(assertion.value.imag());
+		output.put<double>(assertion.frequency);
+	} else if (is<FrequencyAssertion>(objective)) {
+		const auto& assertion = static_cast<const FrequencyAssertion&>(objective);
+		output.put<Kind>(Kind::FREQUENCY_ASSERTION);
+		output.putIdentity(objective);
+		output.put<int32_t>(assertion.number);
+		output.put<double>(assertion.value);
+		output.put<double>(assertion.tolerance);
+	} else if (is<AnalysisParameter>(objective)) {
+		output.put<Kind>(Kind::ANALYSIS_PARAMETER);
+		output.putIdentity(objective);
+		output.put<int32_t>(objective.type);
+	} else if (is<FrequencyValues>(objective)) {
+		output.put<Kind>(Kind::FREQUENCY_VALUES);
+		output.putIdentity(objective);
+		output.putReference(
+				static_cast<const FrequencyValues&>(objective).getStepRangeReference());
+	} else if (is<FrequencyBand>(objective)) {
+		const auto& frequencyBand = static_cast<const FrequencyBand&>(objective);
+		output.put<Kind>(Kind::FREQUENCY_BAND);
+		output.putIdentity(objective);
+		output.put<double>(frequencyBand.lower);
+		output.put<double>(frequencyBand.upper);
+		output.put<int32_t>(frequencyBand.num_max);
+	} else if (is<ModalDamping>(objective)) {
+		const auto& modalDamping = static_cast<const ModalDamping&>(objective);
+		output.put<Kind>(Kind::MODAL_DAMPING);
+		output.putIdentity(objective);
+		output.putReference(modalDamping.getFunctionTableReference());
+		output.put<uint32_t>(table.indexOf(modalDamping.function));
+	} else if (is<NonLinearStrategy>(objective)) {
+		output.put<Kind>(Kind::NONLINEAR_STRATEGY);
+		output.putIdentity(objective);
+		output.put<int32_t>(static_cast<const NonLinearStrategy&>(objective).number_of_increments);
+	} else {
+		throw unsupported("objective", typeid(objective));
+	}
+}
+
+shared_ptr<Objective> ModelSnapshot::readObjective(Input& input, Model& model,
+		ObjectTable& table) {
+	const Kind kind = input.get<Kind>();
+	const Identity identity = input.getIdentity();
+	shared_ptr<Objective> objective;
+	switch (kind) {
+	case Kind::NODAL_DISPLACEMENT_ASSERTION: {
+		const double tolerance = input.get<double>();
+		const int nodePosition = input.get<int32_t>();
+		const DOF dof = DOF::findByPosition(input.get<int32_t>());
+		const double value = input.get<double>();
+		const double instant = input.get<double>();
+		objective = makeModelObject<NodalDisplacementAssertion>(model, model, tolerance,
+				nodeId(model, nodePosition), dof, value, instant, identity.originalId);
+		break;
+	}
+	case Kind::NODAL_COMPLEX_DISPLACEMENT_ASSERTION: {
+		const double tolerance = input.get<double>();
+		const int nodePosition = input.get<int32_t>();
+		const DOF dof = DOF::findByPosition(input.get<int32_t>());
+		const double real = input.get<double>();
+		const double imag = input.get<double>();
+		const double frequency = input.get<double>();
+		objective = makeModelObject<NodalComplexDisplacementAssertion>(model, model, tolerance,
+				nodeId(model, nodePosition), dof, complex<double>(real, imag), frequency,
+				identity.originalId);
+		break;
+	}
+	case Kind::FREQUENCY_ASSERTION: {
+		const int number = input.get<int32_t>();
+		const double value = input.get<double>();
+		const double tolerance = input.get<double>();
+		objective = makeModelObject<FrequencyAssertion>(model, model, number, value, tolerance,
+				identity.originalId);
+		break;
+	}
+	case Kind::ANALYSIS_PARAMETER: {
+		const auto type = static_cast<Objective::Type>(input.get<int32_t>());
+		objective = makeModelObject<AnalysisParameter>(model, model, type, identity.originalId);
+		break;
+	}
+	case Kind::FREQUENCY_VALUES: {
+		objective = makeModelObject<FrequencyValues>(model, model, input.getReference<Value>(),
+				identity.originalId);
+		break;
+	}
+	case Kind::FREQUENCY_BAND: {
+		const double lower = input.get<double>();
+		const double upper = input.get<double>();
+		const int numMax = input.get<int32_t>();
+		objective = makeModelObject<FrequencyBand>(model, model, lower, upper, numMax,
+				identity.originalId);
+		break;
+	}
+	case Kind::MODAL_DAMPING: {
+		const auto modalDamping = makeModelObject<ModalDamping>(model, model,
+				input.getReference<Value>(), identity.originalId);
+		const uint32_t function = input.get<uint32_t>();
+		if (function != NO_OBJECT) {
+			ModalDamping* const target = modalDamping.get();
+			const ObjectTable* const objects = &table;
+			table.fixups.push_back([target, objects, function]() {
+				target->function = objects->get<Value>(function, Family::VALUE);
+			});
+		}
+		objective = modalDamping;
+		break;
+	}
+	case Kind::NONLINEAR_STRATEGY:
+		objective = makeModelObject<NonLinearStrategy>(model, model, input.get<int32_t>(),
+				identity.originalId);
+		break;
+	default:
+		throw runtime_error("corrupted model snapshot");
+	}
+	restoreIdentity(*objective, identity.originalId, identity.id);
+	return objective;
+}
+
+void ModelSnapshot::writeValue(Output& output, const Value& value) {
+	Kind kind;
+	if (is<ValuePlaceHolder>(value)) {
+		kind = Kind::VALUE_PLACE_HOLDER;
+	} else if (is<StepRange>(value)) {
+		kind = Kind::STEP_RANGE;
+	} else if (is<FunctionTable>(value)) {
+		kind = Kind::FUNCTION_TABLE;
+	} else if (is<DynaPhase>(value)) {
+		kind = Kind::DYNA_PHASE;
+	} else {
+		throw unsupported("value", typeid(value));
+	}
+	output.put<Kind>(kind);
+	output.putIdentity(value);
+	output.put<int32_t>(value.getParaX());
+	output.put<int32_t>(value.getParaY());
+	switch (kind) {
+	case Kind::VALUE_PLACE_HOLDER:
+		output.put<int32_t>(value.type);
+		break;
+	case Kind::STEP_RANGE: {
+		const StepRange& stepRange = static_cast<const StepRange&>(value);
+		output.put<double>(stepRange.start);
+		output.put<double>(stepRange.step);
+		output.put<int32_t>(stepRange.count);
+		output.put<double>(stepRange.end);
+		break;
+	}
+	case Kind::FUNCTION_TABLE: {
+		const FunctionTable& functionTable = static_cast<const FunctionTable&>(value);
+		output.put<int32_t>(functionTable.parameter);
+		output.put<int32_t>(functionTable.value);
+		output.put<int32_t>(functionTable.left);
+		output.put<int32_t>(functionTable.right);
+		output.put<uint64_t>(
+				static_cast<uint64_t>(functionTable.getEndValuesXY()
+						- functionTable.getBeginValuesXY()));
+		for (auto it = functionTable.getBeginValuesXY(); it != functionTable.getEndValuesXY();
+				++it) {
+			output.put<double>(it->first);
+			output.put<double>(it->second);
+		}
+		break;
+	}
+	case Kind::DYNA_PHASE:
+		output.put<double>(static_cast<const DynaPhase&>(value).get());
+		break;
+	default:
+		break;
+	}
+}
+
+shared_ptr<Value> ModelSnapshot::readValue(Input& input, Model& model) {
+	const Kind kind = input.get<Kind>();
+	const Identity identity = input.getIdentity();
+	const auto paraX = static_cast<Value::ParaName>(input.get<int32_t>());
+	const auto paraY = static_cast<Value::ParaName>(input.get<int32_t>());
+	shared_ptr<Value> value;
+	switch (kind) {
+	case Kind::VALUE_PLACE_HOLDER: {
+		const auto type = static_cast<Value::Type>(input.get<int32_t>());
+		value = makeModelObject<ValuePlaceHolder>(model, model, type, identity.originalId, paraX,
+				paraY);
+		break;
+	}
+	case Kind::STEP_RANGE: {
+		const double start = input.get<double>();
+		const double step = input.get<double>();
+		const int count = input.get<int32_t>();
+		const auto stepRange = makeModelObject<StepRange>(model, model, start, step, count,
+				identity.originalId);
+		stepRange->end = input.get<double>();
+		value = stepRange;
+		break;
+	}
+	case Kind::FUNCTION_TABLE: {
+		const auto parameter = static_cast<FunctionTable::Interpolation>(input.get<int32_t>());
+		const auto interpolation = static_cast<FunctionTable::Interpolation>(input.get<int32_t>());
+		const auto left = static_cast<FunctionTable::Interpolation>(input.get<int32_t>());
+		const auto right = static_cast<FunctionTable::Interpolation>(input.get<int32_t>());
+		const auto functionTable = makeModelObject<FunctionTable>(model, model, parameter,
+				interpolation, left, right, identity.originalId);
+		for (uint64_t i = input.get<uint64_t>(); i > 0; i--) {
+			const double x = input.get<double>();
+			functionTable->setXY(x, input.get<double>());
+		}
+		value = functionTable;
+		break;
+	}
+	case Kind::DYNA_PHASE:
+		value = makeModelObject<DynaPhase>(model, model, input.get<double>(), identity.originalId);
+		break;
+	default:
+		throw runtime_error("corrupted model snapshot");
+	}
+	restoreIdentity(*value, identity.originalId, identity.id);
+	value->setParaX(paraX);
+	value->setParaY(paraY);
+	return value;
+}
+
+void ModelSnapshot::writeLoading(Output& output, const Loading& loading) {
+	Kind kind;
+	if (is<Gravity>(loading)) {
+		kind = Kind::GRAVITY;
+	} else if (is<RotationCenter>(loading)) {
+		kind = Kind::ROTATION_CENTER;
+	} else if (is<RotationNode>(loading)) {
+		kind = Kind::ROTATION_NODE;
+	} else if (is<NodalForce>(loading)) {
+		kind = Kind::NODAL_FORCE;
+	} else if (is<NodalForceTwoNodes>(loading)) {
+		kind = Kind::NODAL_FORCE_TWO_NODES;
+	} else if (is<ForceSurface>(loading)) {
+		kind = Kind::FORCE_SURFACE;
+	} else if (is<PressionFaceTwoNodes>(loading)) {
+		kind = Kind::PRESSION_FACE_TWO_NODES;
+	} else if (is<ForceLine>(loading)) {
+		kind = Kind::FORCE_LINE;
+	} else if (is<NormalPressionFace>(loading)) {
+		kind = Kind::NORMAL_PRESSION_FACE;
+	} else if (is<DynamicExcitation>(loading)) {
+		kind = Kind::DYNAMIC_EXCITATION;
+	} else {
+		throw unsupported("loading", typeid(loading));
+	}
+	output.put<Kind>(kind);
+	output.putIdentity(loading);
+	switch (kind) {
+	case Kind::GRAVITY: {
+		const Gravity& gravity = static_cast<const Gravity&>(loading);
+		output.put<double>(gravity.getAcceleration());
+		output.putVectorial(gravity.getDirection());
+		break;
+	}
+	case Kind::ROTATION_CENTER: {
+		const RotationCenter& rotation = static_cast<const RotationCenter&>(loading);
+		output.put<double>(rotation.getSpeed());
+		output.putVectorial(rotation.getCenter());
+		output.putVectorial(rotation.getAxis());
+		break;
+	}
+	case Kind::ROTATION_NODE: {
+		const RotationNode& rotation = static_cast<const RotationNode&>(loading);
+		output.put<double>(rotation.getSpeed());
+		output.put<int32_t>(rotation.getNodePosition());
+		output.putVectorial(rotation.getAxis());
+		break;
+	}
+	case Kind::NODAL_FORCE: {
+		const NodalForce& nodalForce = static_cast<const NodalForce&>(loading);
+		output.put<int32_t>(nodalForce.getNode().position);
+		output.putVectorial(nodalForce.getLocalForce());
+		output.putVectorial(nodalForce.getLocalMoment());
+		output.put<int32_t>(loading.coordinateSystem_reference.original_id);
+		break;
+	}
+	case Kind::NODAL_FORCE_TWO_NODES: {
+		const NodalForceTwoNodes& nodalForce = static_cast<const NodalForceTwoNodes&>(loading);
+		output.put<int32_t>(nodalForce.getNode().position);
+		output.put<int32_t>(nodalForce.getNode1().position);
+		output.put<int32_t>(nodalForce.getNode2().position);
+		output.put<double>(nodalForce.getMagnitude());
+		break;
+	}
+	case Kind::FORCE_SURFACE: {
+		const ForceSurface& forceSurface = static_cast<const ForceSurface&>(loading);
+		output.putVectorial(forceSurface.getForce());
+		output.putVectorial(forceSurface.getMoment());
+		writeCellContainer(output, forceSurface);
+		break;
+	}
+	case Kind::PRESSION_FACE_TWO_NODES: {
+		const PressionFaceTwoNodes& pression = static_cast<const PressionFaceTwoNodes&>(loading);
+		output.put<int32_t>(pression.nodePosition1);
+		output.put<int32_t>(pression.nodePosition2);
+		output.putVectorial(pression.getForce());
+		output.putVectorial(pression.getMoment());
+		writeCellContainer(output, pression);
+		break;
+	}
+	case Kind::FORCE_LINE: {
+		const ForceLine& forceLine = static_cast<const ForceLine&>(loading);
+		output.putVectorial(forceLine.force);
+		output.putVectorial(forceLine.moment);
+		writeCellContainer(output, forceLine);
+		break;
+	}
+	case Kind::NORMAL_PRESSION_FACE: {
+		const NormalPressionFace& pression = static_cast<const NormalPressionFace&>(loading);
+		output.put<double>(pression.intensity);
+		writeCellContainer(output, pression);
+		break;
+	}
+	case Kind::DYNAMIC_EXCITATION: {
+		const DynamicExcitation& excitation = static_cast<const DynamicExcitation&>(loading);
+		output.putReference(excitation.getDynaPhaseReference());
+		output.putReference(excitation.getFunctionTableBReference());
+		output.putReference(excitation.getLoadSetReference());
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+shared_ptr<Loading> ModelSnapshot::readLoading(Input& input, Model& model) {
+	const Kind kind = input.get<Kind>();
+	const Identity identity = input.getIdentity();
+	shared_ptr<Loading> loading;
+	switch (kind) {
+	case Kind::GRAVITY: {
+		const double acceleration = input.get<double>();
+		const VectorialValue direction = input.getVectorial();
+		loading = makeModelObject<Gravity>(model, model, acceleration, direction,
+				identity.originalId);
+		break;
+	}
+	case Kind::ROTATION_CENTER: {
+		const double speed = input.get<double>();
+		const VectorialValue center = input.getVectorial();
+		const VectorialValue axis = input.getVectorial();
+		loading = makeModelObject<RotationCenter>(model, model, speed, center.x(), center.y(),
+				center.z(), axis.x(), axis.y(), axis.z(), identity.originalId);
+		break;
+	}
+	case Kind::ROTATION_NODE: {
+		const double speed = input.get<double>();
+		const int nodePosition = input.get<int32_t>();
+		const VectorialValue axis = input.getVectorial();
+		loading = makeModelObject<RotationNode>(model, model, speed, nodeId(model, nodePosition),
+				axis.x(), axis.y(), axis.z(), identity.originalId);
+		break;
+	}
+	case Kind::NODAL_FORCE: {
+		const int nodePosition = input.get<int32_t>();
+		const VectorialValue force = input.getVectorial();
+		const VectorialValue moment = input.getVectorial();
+		const int coordinateSystemId = input.get<int32_t>();
+		loading = makeModelObject<NodalForce>(model, model, nodeId(model, nodePosition), force,
+				moment, identity.originalId, coordinateSystemId);
+		break;
+	}
+	case Kind::NODAL_FORCE_TWO_NODES: {
+		const int nodePosition = input.get<int32_t>();
+		const int nodePosition1 = input.get<int32_t>();
+		const int nodePosition2 = input.get<int32_t>();
+		const double magnitude = input.get<double>();
+		loading = makeModelObject<NodalForceTwoNodes>(model, model, nodeId(model, nodePosition),
+				nodeId(model, nodePosition1), nodeId(model, nodePosition2), magnitude,
+				identity.originalId);
+		break;
+	}
+	case Kind::FORCE_SURFACE: {
+		const VectorialValue force = input.getVectorial();
+		const VectorialValue moment = input.getVectorial();
+		const auto forceSurface = makeModelObject<ForceSurface>(model, model, force, moment,
+				identity.originalId);
+		readCellContainer(input, *forceSurface);
+		loading = forceSurface;
+		break;
+	}
+	case Kind::PRESSION_FACE_TWO_NODES: {
+		const int nodePosition1 = input.get<int32_t>();
+		const int nodePosition2 = input.get<int32_t>();
+		const VectorialValue force = input.getVectorial();
+		const VectorialValue moment = input.getVectorial();
+		const auto pression = makeModelObject<PressionFaceTwoNodes>(model, model,
+				nodeId(model, nodePosition1), nodeId(model, nodePosition2), force, moment,
+				identity.originalId);
+		readCellContainer(input, *pression);
+		loading = pression;
+		break;
+	}
+	case Kind::FORCE_LINE: {
+		const VectorialValue force = input.getVectorial();
+		const VectorialValue moment = input.getVectorial();
+		const auto forceLine = makeModelObject<ForceLine>(model, model, force, moment,
+				identity.originalId);
+		readCellContainer(input, *forceLine);
+		loading = forceLine;
+		break;
+	}
+	case Kind::NORMAL_PRESSION_FACE: {
+		const auto pression = makeModelObject<NormalPressionFace>(model, model,
+				input.get<double>(), identity.originalId);
+		readCellContainer(input, *pression);
+		loading = pression;
+		break;
+	}
+	case Kind::DYNAMIC_EXCITATION: {
+		const Reference<Value> dynaPhase = input.getReference<Value>();
+		const Reference<Value> functionTableB = input.getReference<Value>();
+		const Reference<LoadSet> loadSet = input.getReference<LoadSet>();
+		loading = makeModelObject<DynamicExcitation>(model, model, dynaPhase, functionTableB,
+				loadSet, identity.originalId);
+		break;
+	}
+	default:
+		throw runtime_error("corrupted model snapshot");
+	}
+	restoreIdentity(*loading, identity.originalId, identity.id);
+	return loading;
+}
+
+void ModelSnapshot::writeConstraint(Output& output, const Constraint& constraint) {
+	Kind kind;
+	if (is<QuasiRigidConstraint>(constraint)) {
+		kind = Kind::QUASI_RIGID_CONSTRAINT;
+	} else if (is<RigidConstraint>(constraint)) {
+		kind = Kind::RIGID_CONSTRAINT;
+	} else if (is<RBE3>(constraint)) {
+		kind = Kind::RBE3_CONSTRAINT;
+	} else if (is<SinglePointConstraint>(constraint)) {
+		kind = Kind::SINGLE_POINT_CONSTRAINT;
+	} else if (is<LinearMultiplePointConstraint>(constraint)) {
+		kind = Kind::LINEAR_MULTIPLE_POINT_CONSTRAINT;
+	} else if (is<GapTwoNodes>(constraint)) {
+		kind = Kind::GAP_TWO_NODES;
+	} else if (is<GapNodeDirection>(constraint)) {
+		kind = Kind::GAP_NODE_DIRECTION;
+	} else {
+		throw unsupported("constraint", typeid(constraint));
+	}
+	output.put<Kind>(kind);
+	output.putIdentity(constraint);
+	switch (kind) {
+	case Kind::QUASI_RIGID_CONSTRAINT:
+	case Kind::RIGID_CONSTRAINT:
+	case Kind::RBE3_CONSTRAINT: {
+		const HomogeneousConstraint& homogeneous =
+				static_cast<const HomogeneousConstraint&>(constraint);
+		output.put<char>(homogeneous.dofs);
+		output.put<int32_t>(homogeneous.masterPosition);
+		output.putIntSet(homogeneous.slavePositions);
+		if (kind == Kind::RBE3_CONSTRAINT) {
+			const RBE3& rbe3 = static_cast<const RBE3&>(constraint);
+			output.put<uint64_t>(rbe3.slaveDofsByPosition.size());
+			for (const auto& positionAndDofs : rbe3.slaveDofsByPosition) {
+				output.put<int32_t>(positionAndDofs.first);
+				output.put<char>(positionAndDofs.second);
+			}
+			output.put<uint64_t>(rbe3.slaveCoefByPosition.size());
+			for (const auto& positionAndCoef : rbe3.slaveCoefByPosition) {
+				output.put<int32_t>(positionAndCoef.first);
+				output.put<double>(positionAndCoef.second);
+			}
+		}
+		break;
+	}
+	case Kind::SINGLE_POINT_CONSTRAINT: {
+		const SinglePointConstraint& spc = static_cast<const SinglePointConstraint&>(constraint);
+		output.put<uint8_t>(spc.group != nullptr);
+		if (spc.group != nullptr) {
+			output.putString(spc.group->getName());
+		}
+		output.putIntSet(spc._nodePositions);
+		for (const ValueOrReference& value : spc.spcs) {
+			output.putValueOrReference(value);
+		}
+		break;
+	}
+	case Kind::LINEAR_MULTIPLE_POINT_CONSTRAINT: {
+		const LinearMultiplePointConstraint& lmpc =
+				static_cast<const LinearMultiplePointConstraint&>(constraint);
+		output.put<double>(lmpc.coef_impo);
+		const set<int> nodePositions = lmpc.nodePositions();
+		output.put<uint64_t>(nodePositions.size());
+		for (int nodePosition : nodePositions) {
+			output.put<int32_t>(nodePosition);
+			LinearMultiplePointConstraint::DofCoefs coefs = lmpc.getDoFCoefsForNode(nodePosition);
+			for (int i = 0; i < 6; i++) {
+				output.put<double>(coefs[i]);
+			}
+		}
+		break;
+	}
+	case Kind::GAP_TWO_NODES: {
+		const GapTwoNodes& gap = static_cast<const GapTwoNodes&>(constraint);
+		output.put<double>(gap.initial_gap_opening);
+		output.put<uint64_t>(gap.directionNodePositionByconstrainedNodePosition.size());
+		for (const auto& positions : gap.directionNodePositionByconstrainedNodePosition) {
+			output.put<int32_t>(positions.first);
+			output.put<int32_t>(positions.second);
+		}
+		break;
+	}
+	case Kind::GAP_NODE_DIRECTION: {
+		const GapNodeDirection& gap = static_cast<const GapNodeDirection&>(constraint);
+		output.put<double>(gap.initial_gap_opening);
+		output.put<uint64_t>(gap.directionBynodePosition.size());
+		for (const auto& positionAndDirection : gap.directionBynodePosition) {
+			output.put<int32_t>(positionAndDirection.first);
+			output.putVectorial(positionAndDirection.second);
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+shared_ptr<Constraint> ModelSnapshot::readConstraint(Input& input, Model& model) {
+	const Kind kind = input.get<Kind>();
+	const Identity identity = input.getIdentity();
+	shared_ptr<Constraint> constraint;
+	switch (kind) {
+	case Kind::QUASI_RIGID_CONSTRAINT:
+	case Kind::RIGID_CONSTRAINT:
+	case Kind::RBE3_CONSTRAINT: {
+		const DOFS dofs(input.get<char>());
+		shared_ptr<HomogeneousConstraint> homogeneous;
+		if (kind == Kind::QUASI_RIGID_CONSTRAINT) {
+			homogeneous = makeModelObject<QuasiRigidConstraint>(model, model, dofs,
+					HomogeneousConstraint::UNAVAILABLE_MASTER, identity.originalId);
+		} else if (kind == Kind::RIGID_CONSTRAINT) {
+			homogeneous = makeModelObject<RigidConstraint>(model, model,
+					HomogeneousConstraint::UNAVAILABLE_MASTER, identity.originalId);
+		} else {
+			homogeneous = makeModelObject<RBE3>(model, model,
+					HomogeneousConstraint::UNAVAILABLE_MASTER, dofs, identity.originalId);
+		}
+		homogeneous->dofs = dofs;
+		homogeneous->masterPosition = input.get<int32_t>();
+		homogeneous->slavePositions = input.getIntSet();
+		if (kind == Kind::RBE3_CONSTRAINT) {
+			RBE3& rbe3 = static_cast<RBE3&>(*homogeneous);
+			for (uint64_t i = input.get<uint64_t>(); i > 0; i--) {
+				const int position = input.get<int32_t>();
+				rbe3.slaveDofsByPosition[position] = DOFS(input.get<char>());
+			}
+			for (uint64_t i = input.get<uint64_t>(); i > 0; i--) {
+				const int position = input.get<int32_t>();
+				rbe3.slaveCoefByPosition[position] = input.get<double>();
+			}
+		}
+		constraint = homogeneous;
+		break;
+	}
+	case Kind::SINGLE_POINT_CONSTRAINT: {
+		Group* group = nullptr;
+		if (input.get<uint8_t>() != 0) {
+			group = model.mesh->findGroup(input.getString());
+			if (group == nullptr) {
+				throw runtime_error("corrupted model snapshot");
+			}
+		}
+		const set<int> nodePositions = input.getIntSet();
+		array<ValueOrReference, 6> spcs;
+		for (ValueOrReference& value : spcs) {
+			value = input.getValueOrReference();
+		}
+		const auto spc = makeModelObject<SinglePointConstraint>(model, model, spcs, group,
+				identity.originalId);
+		spc->_nodePositions = nodePositions;
+		constraint = spc;
+		break;
+	}
+	case Kind::LINEAR_MULTIPLE_POINT_CONSTRAINT: {
+		const auto lmpc = makeModelObject<LinearMultiplePointConstraint>(model, model,
+				input.get<double>(), identity.originalId);
+		for (uint64_t i = input.get<uint64_t>(); i > 0; i--) {
+			const int position = input.get<int32_t>();
+			double coefs[6];
+			for (double& coef : coefs) {
+				coef = input.get<double>();
+			}
+			lmpc->addParticipation(nodeId(model, position), coefs[0], coefs[1], coefs[2],
+					coefs[3], coefs[4], coefs[5]);
+		}
+		constraint = lmpc;
+		break;
+	}
+	case Kind::GAP_TWO_NODES: {
+		const auto gap = makeModelObject<GapTwoNodes>(model, model, identity.originalId);
+		gap->initial_gap_opening = input.get<double>();
+		for (uint64_t i = input.get<uint64_t>(); i > 0; i--) {
+			const int position = input.get<int32_t>();
+			gap->directionNodePositionByconstrainedNodePosition[position] = input.get<int32_t>();
+		}
+		constraint = gap;
+		break;
+	}
+	case Kind::GAP_NODE_DIRECTION: {
+		const auto gap = makeModelObject<GapNodeDirection>(model, model, identity.originalId);
+		gap->initial_gap_opening = input.get<double>();
+		for (uint64_t i = input.get<uint64_t>(); i > 0; i--) {
+			const int position = input.get<int32_t>();
+			gap->directionBynodePosition[position] = input.getVectorial();
+		}
+		constraint = gap;
+		break;
+	}
+	default:
+		throw runtime_error("corrupted model snapshot");
+	}
+	restoreIdentity(*constraint, identity.originalId, identity.id);
+	return constraint;
+}
+
+void ModelSnapshot::writeCoordinateSystem(Output& output,
+		const CoordinateSystem& coordinateSystem) {
+	if (is<CartesianCoordinateSystem>(coordinateSystem)) {
+		output.put<Kind>(Kind::CARTESIAN_COORDINATE_SYSTEM);
+	} else if (is<CylindricalCoordinateSystem>(coordinateSystem)) {
+		output.put<Kind>(Kind::CYLINDRICAL_COORDINATE_SYSTEM);
+	} else if (is<SphericalCoordinateSystem>(coordinateSystem)) {
+		output.put<Kind>(Kind::SPHERICAL_COORDINATE_SYSTEM);
+	} else {
+		throw unsupported("coordinate system", typeid(coordinateSystem));
+	}
+	output.putIdentity(coordinateSystem);
+	output.putVectorial(coordinateSystem.origin);
+	output.putVectorial(coordinateSystem.ex);
+	output.putVectorial(coordinateSystem.ey);
+	output.putVectorial(coordinateSystem.ez);
+	// the local base of the cylindrical and spherical systems is recomputed at each point
+}
+
+shared_ptr<CoordinateSystem> ModelSnapshot::readCoordinateSystem(Input& input, Model& model) {
+	const Kind kind = input.get<Kind>();
+	const Identity identity = input.getIdentity();
+	const VectorialValue origin = input.getVectorial();
+	const VectorialValue ex = input.getVectorial();
+	const VectorialValue ey = input.getVectorial();
+	const VectorialValue ez = input.getVectorial();
+	shared_ptr<CoordinateSystem> coordinateSystem;
+	switch (kind) {
+	case Kind::CARTESIAN_COORDINATE_SYSTEM:
+		coordinateSystem = makeModelObject<CartesianCoordinateSystem>(model, model, origin, ex,
+				ey, identity.originalId);
+		break;
+	case Kind::CYLINDRICAL_COORDINATE_SYSTEM:
+		coordinateSystem = makeModelObject<CylindricalCoordinateSystem>(model, model, origin, ex,
+				ey, identity.originalId);
+		break;
+	case Kind::SPHERICAL_COORDINATE_SYSTEM:
+		coordinateSystem = makeModelObject<SphericalCoordinateSystem>(model, model, origin, ex,
+				ey, identity.originalId);
+		break;
+	default:
+		throw runtime_error("corrupted model snapshot");
+	}
+	// the base is normalized again by the constructor, which may round it differently
+	if (!sameVector(coordinateSystem->ex, ex) || !sameVector(coordinateSystem->ey, ey)
+			|| !sameVector(coordinateSystem->ez, ez)) {
+		throw runtime_error("base of coordinate system not restored");
+	}
+	restoreIdentity(*coordinateSystem, identity.originalId, identity.id);
+	return coordinateSystem;
+}
+
+void ModelSnapshot::writeElementSet(Output& output, const ObjectTable& table,
+		const ElementSet& elementSet) {
+	Kind kind;
+	if (is<CircularSectionBeam>(elementSet)) {
+		kind = Kind::CIRCULAR_SECTION_BEAM;
+	} else if (is<GenericSectionBeam>(elementSet)) {
+		kind = Kind::GENERIC_SECTION_BEAM;
+	} else if (is<RectangularSectionBeam>(elementSet)) {
+		kind = Kind::RECTANGULAR_SECTION_BEAM;
+	} else if (is<ISectionBeam>(elementSet)) {
+		kind = Kind::I_SECTION_BEAM;
+	} else if (is<Shell>(elementSet)) {
+		kind = Kind::SHELL;
+	} else if (is<Continuum>(elementSet)) {
+		kind = Kind::CONTINUUM;
+	} else if (is<DiscretePoint>(elementSet)) {
+		kind = Kind::DISCRETE_POINT;
+	} else if (is<DiscreteSegment>(elementSet)) {
+		kind = Kind::DISCRETE_SEGMENT;
+	} else if (is<NodalMass>(elementSet)) {
+		kind = Kind::NODAL_MASS;
+	} else if (is<StiffnessMatrix>(elementSet)) {
+		kind = Kind::STIFFNESS_MATRIX;
+	} else if (is<MassMatrix>(elementSet)) {
+		kind = Kind::MASS_MATRIX;
+	} else if (is<DampingMatrix>(elementSet)) {
+		kind = Kind::DAMPING_MATRIX;
+	} else {
+		throw unsupported("element set", typeid(elementSet));
+	}
+	output.put<Kind>(kind);
+	output.putIdentity(elementSet);
+	output.put<int8_t>(modelTypeIndex(elementSet.modelType));
+	output.put<uint8_t>(elementSet.cellGroup != nullptr);
+	if (elementSet.cellGroup != nullptr) {
+		output.putString(elementSet.cellGroup->getName());
+	}
+	output.put<uint32_t>(table.indexOf(elementSet.material));
+	if (elementSet.isBeam()) {
+		const Beam& beam = static_cast<const Beam&>(elementSet);
+		output.put<int32_t>(beam.beamModel);
+		output.put<double>(beam.getAdditionalMass());
+	}
+	switch (kind) {
+	case Kind::CIRCULAR_SECTION_BEAM:
+		output.put<double>(static_cast<const CircularSectionBeam&>(elementSet).radius);
+		break;
+	case Kind::GENERIC_SECTION_BEAM: {
+		const GenericSectionBeam& beam = static_cast<const GenericSectionBeam&>(elementSet);
+		output.put<double>(beam.area_cross_section);
+		output.put<double>(beam.moment_of_inertia_Y);
+		output.put<double>(beam.moment_of_inertia_Z);
+		output.put<double>(beam.torsional_constant);
+		output.put<double>(beam.shear_area_factor_Y);
+		output.put<double>(beam.shear_area_factor_Z);
+		break;
+	}
+	case Kind::RECTANGULAR_SECTION_BEAM: {
+		const RectangularSectionBeam& beam = static_cast<const RectangularSectionBeam&>(elementSet);
+		output.put<double>(beam.width);
+		output.put<double>(beam.height);
+		break;
+	}
+	case Kind::I_SECTION_BEAM: {
+		const ISectionBeam& beam = static_cast<const ISectionBeam&>(elementSet);
+		output.put<double>(beam.upper_flange_width);
+		output.put<double>(beam.lower_flange_width);
+		output.put<double>(beam.upper_flange_thickness);
+		output.put<double>(beam.lower_flange_thickness);
+		output.put<double>(beam.beam_height);
+		output.put<double>(beam.web_thickness);
+		break;
+	}
+	case Kind::SHELL: {
+		const Shell& shell = static_cast<const Shell&>(elementSet);
+		output.put<double>(shell.thickness);
+		output.put<double>(shell.getAdditionalMass());
+		break;
+	}
+	case Kind::DISCRETE_POINT: {
+		const DiscretePoint& discrete = static_cast<const DiscretePoint&>(elementSet);
+		output.put<uint8_t>(discrete.symmetric);
+		output.putDOFMatrix(discrete.stiffness);
+		output.putDOFMatrix(discrete.mass);
+		output.putDOFMatrix(discrete.damping);
+		break;
+	}
+	case Kind::DISCRETE_SEGMENT: {
+		const DiscreteSegment& discrete = static_cast<const DiscreteSegment&>(elementSet);
+		output.put<uint8_t>(discrete.symmetric);
+		for (int i = 0; i < 2; i++) {
+			for (int j = 0; j < 2; j++) {
+				output.putDOFMatrix(discrete.stiffness[i][j]);
+				output.putDOFMatrix(discrete.mass[i][j]);
+				output.putDOFMatrix(discrete.damping[i][j]);
+			}
+		}
+		break;
+	}
+	case Kind::NODAL_MASS: {
+		const NodalMass& nodalMass = static_cast<const NodalMass&>(elementSet);
+		for (double value : { nodalMass.m, nodalMass.ixx, nodalMass.iyy, nodalMass.izz,
+				nodalMass.ixy, nodalMass.iyz, nodalMass.ixz, nodalMass.ex, nodalMass.ey,
+				nodalMass.ez }) {
+			output.put<double>(value);
+		}
+		break;
+	}
+	case Kind::STIFFNESS_MATRIX:
+	case Kind::MASS_MATRIX:
+	case Kind::DAMPING_MATRIX: {
+		const MatrixElement& matrix = static_cast<const MatrixElement&>(elementSet);
+		output.put<uint8_t>(matrix.symmetric);
+		output.put<uint64_t>(matrix.submatrixByNodes.size());
+		for (const auto& nodesAndSubmatrix : matrix.submatrixByNodes) {
+			output.put<int32_t>(nodesAndSubmatrix.first.first);
+			output.put<int32_t>(nodesAndSubmatrix.first.second);
+			output.putDOFMatrix(*nodesAndSubmatrix.second);
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+shared_ptr<ElementSet> ModelSnapshot::readElementSet(Input& input, Model& model,
+		ObjectTable& table) {
+	const Kind kind = input.get<Kind>();
+	const Identity identity = input.getIdentity();
+	const ModelType* modelType = modelTypeAt(input.get<int8_t>());
+	CellGroup* cellGroup = nullptr;
+	if (input.get<uint8_t>() != 0) {
+		cellGroup = dynamic_cast<CellGroup*>(model.mesh->findGroup(input.getString()));
+		if (cellGroup == nullptr) {
+			throw runtime_error("corrupted model snapshot");
+		}
+	}
+	const uint32_t material = input.get<uint32_t>();
+	Beam::BeamModel beamModel = Beam::EULER;
+	double additionalMass = 0;
+	if (kind == Kind::CIRCULAR_SECTION_BEAM || kind == Kind::GENERIC_SECTION_BEAM
+			|| kind == Kind::RECTANGULAR_SECTION_BEAM || kind == Kind::I_SECTION_BEAM) {
+		beamModel = static_cast<Beam::BeamModel>(input.get<int32_t>());
+		additionalMass = input.get<double>();
+	}
+	shared_ptr<ElementSet> elementSet;
+	switch (kind) {
+	case Kind::CIRCULAR_SECTION_BEAM:
+		elementSet = makeModelObject<CircularSectionBeam>(model, model, input.get<double>(),
+				beamModel, additionalMass, identity.originalId);
+		break;
+	case Kind::GENERIC_SECTION_BEAM: {
+		double values[6];
+		for (double& value : values) {
+			value = input.get<double>();
+		}
+		elementSet = makeModelObject<GenericSectionBeam>(model, model, values[0], values[1],
+				values[2], values[3], values[4], values[5], beamModel, additionalMass,
+				identity.originalId);
+		break;
+	}
+	case Kind::RECTANGULAR_SECTION_BEAM: {
+		const double width = input.get<double>();
+		const double height = input.get<double>();
+		elementSet = makeModelObject<RectangularSectionBeam>(model, model, width, height,
+				beamModel, additionalMass, identity.originalId);
+		break;
+	}
+	case Kind::I_SECTION_BEAM: {
+		double values[6];
+		for (double& value : values) {
+			value = input.get<double>();
+		}
+		elementSet = makeModelObject<ISectionBeam>(model, model, values[0], values[1],
+				values[2], values[3], values[4], values[5], beamModel, additionalMass,
+				identity.originalId);
+		break;
+	}
+	case Kind::SHELL: {
+		const double thickness = input.get<double>();
+		const double shellAdditionalMass = input.get<double>();
+		elementSet = makeModelObject<Shell>(model, model, thickness, shellAdditionalMass,
+				identity.originalId);
+		break;
+	}
+	case Kind::CONTINUUM:
+		elementSet = makeModelObject<Continuum>(model, model, modelType, identity.originalId);
+		break;
+	case Kind::DISCRETE_POINT: {
+		const bool symmetric = input.get<uint8_t>() != 0;
+		const auto discrete = makeModelObject<DiscretePoint>(model, model, vector<double>(),
+				symmetric, identity.originalId);
+		discrete->stiffness = input.getDOFMatrix();
+		discrete->mass = input.getDOFMatrix();
+		discrete->damping = input.getDOFMatrix();
+		elementSet = discrete;
+		break;
+	}
+	case Kind::DISCRETE_SEGMENT: {
+		const bool symmetric = input.get<uint8_t>() != 0;
+		const auto discrete = makeModelObject<DiscreteSegment>(model, model, symmetric,
+				identity.originalId);
+		for (int i = 0; i < 2; i++) {
+			for (int j = 0; j < 2; j++) {
+				discrete->stiffness[i][j] = input.getDOFMatrix();
+				discrete->mass[i][j] = input.getDOFMatrix();
+				discrete->damping[i][j] = input.getDOFMatrix();
+			}
+		}
+		elementSet = discrete;
+		break;
+	}
+	case Kind::NODAL_MASS: {
+		double values[10];
+		for (double& value : values) {
+			value = input.get<double>();
+		}
+		elementSet = makeModelObject<NodalMass>(model, model, values[0], values[1], values[2],
+				values[3], values[4], values[5], values[6], values[7], values[8], values[9],
+				identity.originalId);
+		break;
+	}
+	case Kind::STIFFNESS_MATRIX:
+	case Kind::MASS_MATRIX:
+	case Kind::DAMPING_MATRIX: {
+		shared_ptr<MatrixElement> matrix;
+		if (kind == Kind::STIFFNESS_MATRIX) {
+			matrix = makeModelObject<StiffnessMatrix>(model, model, identity.originalId);
+		} else if (kind == Kind::MASS_MATRIX) {
+			matrix = makeModelObject<MassMatrix>(model, model, identity.originalId);
+		} else {
+			matrix = makeModelObject<DampingMatrix>(model, model, identity.originalId);
+		}
+		matrix->symmetric = input.get<uint8_t>() != 0;
+		for (uint64_t i = input.get<uint64_t>(); i > 0; i--) {
+			const int nodePosition1 = input.get<int32_t>();
+			const int nodePosition2 = input.get<int32_t>();
+			matrix->submatrixByNodes[make_pair(nodePosition1, nodePosition2)] = make_shared<
+					DOFMatrix>(input.getDOFMatrix());
+		}
+		elementSet = matrix;
+		break;
+	}
+	default:
+		throw runtime_error("corrupted model snapshot");
+	}
+	restoreIdentity(*elementSet, identity.originalId, identity.id);
+	elementSet->modelType = modelType;
+	elementSet->cellGroup = cellGroup;
+	if (material != NO_OBJECT) {
+		ElementSet* const target = elementSet.get();
+		const ObjectTable* const objects = &table;
+		table.fixups.push_back([target, objects, material]() {
+			target->material = objects->get<Material>(material, Family::MATERIAL);
+		});
+	}
+	return elementSet;
+}
+
+void ModelSnapshot::writeMaterial(Output& output, const Material& material) {
+	output.putIdentity(material);
+	output.put<uint64_t>(material.getNatures().size());
+	for (const auto& typeAndNature : material.getNatures()) {
+		const Nature& nature = *typeAndNature.second;
+		if (is<ElasticNature>(nature)) {
+			const ElasticNature& elastic = static_cast<const ElasticNature&>(nature);
+			output.put<Kind>(Kind::ELASTIC_NATURE);
+			for (double value : { elastic.e, elastic.nu, elastic.g, elastic.rho, elastic.alpha,
+					elastic.tref }) {
+				output.put<double>(value);
+			}
+		} else if (is<BilinearElasticNature>(nature)) {
+			const BilinearElasticNature& bilinear =
+					static_cast<const BilinearElasticNature&>(nature);
+			output.put<Kind>(Kind::BILINEAR_ELASTIC_NATURE);
+			output.put<double>(bilinear.elastic_limit);
+			output.put<double>(bilinear.secondary_slope);
+			output.put<uint8_t>(bilinear.yield_function_von_mises);
+			output.put<uint8_t>(bilinear.hardening_rule_isotropic);
+		} else if (is<NonLinearElasticNature>(nature)) {
+			output.put<Kind>(Kind::NONLINEAR_ELASTIC_NATURE);
+			output.putReference(static_cast<const NonLinearElasticNature&>(nature)
+					.getStressStrainFunctionReference());
+		} else {
+			throw unsupported("material nature", typeid(nature));
+		}
+	}
+}
+
+shared_ptr<Material> ModelSnapshot::readMaterial(Input& input, Model& model) {
+	const Identity identity = input.getIdentity();
+	const shared_ptr<Material> material = makeModelObject<Material>(model, &model,
+			identity.originalId);
+	restoreIdentity(*material, identity.originalId, identity.id);
+	for (uint64_t i = input.get<uint64_t>(); i > 0; i--) {
+		shared_ptr<Nature> nature;
+		switch (input.get<Kind>()) {
+		case Kind::ELASTIC_NATURE: {
+			double values[6];
+			for (double& value : values) {
+				value = input.get<double>();
+			}
+			nature = makeModelObject<ElasticNature>(model, model, values[0], values[1],
+					values[2], values[3], values[4], values[5]);
+			break;
+		}
+		case Kind::BILINEAR_ELASTIC_NATURE: {
+			const double elasticLimit = input.get<double>();
+			const double secondarySlope = input.get<double>();
+			const auto bilinear = makeModelObject<BilinearElasticNature>(model, model,
+					elasticLimit, secondarySlope);
+			bilinear->yield_function_von_mises = input.get<uint8_t>() != 0;
+			bilinear->hardening_rule_isotropic = input.get<uint8_t>() != 0;
+			nature = bilinear;
+			break;
+		}
+		case Kind::NONLINEAR_ELASTIC_NATURE: {
+			nature = makeModelObject<NonLinearElasticNature>(model, model,
+					input.getReference<Value>());
+			break;
+		}
+		default:
+			throw runtime_error("corrupted model snapshot");
+		}
+		material->addNature(*nature);
+	}
+	return material;
+}
+
+void ModelSnapshot::writeOrientation(Output& output, const Orientation& orientation) {
+	if (is<VectY>(orientation)) {
+		output.put<Kind>(Kind::VECT_Y);
+		output.putIdentity(orientation);
+		output.putVectorial(static_cast<const VectY&>(orientation).vectY);
+	} else if (is<TwoNodesOrientation>(orientation)) {
+		const auto& twoNodes = static_cast<const TwoNodesOrientation&>(orientation);
+		output.put<Kind>(Kind::TWO_NODES_ORIENTATION);
+		output.putIdentity(orientation);
+		output.put<int32_t>(twoNodes.node_id1);
+		output.put<int32_t>(twoNodes.node_id2);
+	} else {
+		throw unsupported("orientation", typeid(orientation));
+	}
+}
+
+shared_ptr<Orientation> ModelSnapshot::readOrientation(Input& input, Model& model) {
+	const Kind kind = input.get<Kind>();
+	const Identity identity = input.getIdentity();
+	shared_ptr<Orientation> orientation;
+	if (kind == Kind::VECT_Y) {
+		orientation = makeModelObject<VectY>(model, input.getVectorial());
+	} else if (kind == Kind::TWO_NODES_ORIENTATION) {
+		const int nodeId1 = input.get<int32_t>();
+		const int nodeId2 = input.get<int32_t>();
+		orientation = makeModelObject<TwoNodesOrientation>(model, model, nodeId1, nodeId2);
+	} else {
+		throw runtime_error("corrupted model snapshot");
+	}
+	restoreIdentity(*orientation, identity.originalId, identity.id);
+	return orientation;
+}
+
+} /* namespace vega */
@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) Alneos, s. a r. l. (contact@alneos.fr)
+ * Released under the GNU General Public License
+ *
+ * ModelSnapshot.h
+ *
+ *  Binary snapshot (.vega file) of a finished Model.
+ */
+
+#ifndef MODELSNAPSHOT_H_
+#define MODELSNAPSHOT_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include "ConfigurationParameters.h"
+
+namespace vega {
+
+namespace fs = boost::filesystem;
+
+template<class T> class Identifiable;
+class Model;
+class Mesh;
+class CellContainer;
+class Analysis;
+class Objective;
+class Value;
+class Loading;
+class Constraint;
+class CoordinateSystem;
+class ElementSet;
+class Material;
+class Orientation;
+
+/**
+ * Keeps a finished model in a .vega file, so that the next translation of the same input
+ * maps it instead of parsing and finishing the model again.
+ *
+ * The snapshot holds the whole model: the node and cell storages, the groups, the element
+ * sets, materials, values, coordinate systems, objectives, loadings, constraints and their
+ * sets, the analyses, and the counters of the automatic ids, so that the objects created
+ * afterwards by the writers are numbered as after a parsing. It is named after a hash of the
+ * input file, of the build of Vega and of the options changing the finished model (output
+ * solver, translation mode, result file), and records the size and hash of every file read to build the model:
+ * the input file, its INCLUDEs and the result file. If any of them changed, the model is
+ * parsed again and the snapshot written again.
+ */
+class ModelSnapshot final {
+private:
+	/**
+	 * A file read to build the model, with a size of -1 if it was missing. Its path is
+	 * relative to the directory of the input file when possible, so that a copied model can
+	 * use the same snapshot.
+	 */
+	class InputFile {
+	public:
+		std::string path;
+		int64_t size;
+		uint64_t hash;
+	};
+	class Output;
+	class Input;
+	class ObjectTable;
+	enum class Family : uint8_t;
+	const ConfigurationParameters& configuration;
+	const fs::path inputDirectory;
+	const std::string fingerprint;
+	fs::path snapshotPath;
+	bool valid;
+	boost::iostreams::mapped_file_source mappedSnapshot;
+	/**
+	 * The files read to build the model of a valid snapshot.
+	 */
+	std::vector<InputFile> inputFiles;
+	/**
+	 * Offset of the model in the mapped snapshot.
+	 */
+	size_t payloadOffset;
+	/**
+	 * Description of every file hashed so far by key, so that each file is hashed once.
+	 */
+	std::map<std::string, InputFile> describedFiles;
+
+	/**
+	 * The build of Vega and the options the finished model depends on.
+	 */
+	static std::string fingerprintOf(const ConfigurationParameters& configuration);
+	std::string key(const fs::path& file) const;
+	const InputFile& describe(const fs::path& file);
+	void open();
+
+	/**
+	 * Counters of the automatic ids: of each kind of identifiable object, of the nodes and of
+	 * the cells.
+	 */
+	static std::vector<int> autoIds();
+	static void restoreAutoIds(const std::vector<int>& autoIds);
+	template<class T> static int& autoId();
+	template<class T> static void restoreIdentity(Identifiable<T>& object, int originalId, int id);
+	template<class T, class C> static void collectObjects(ObjectTable& table, Family family,
+			const C& container);
+	template<class C> static void writeContainer(Output& output, const ObjectTable& table,
+			const C& container);
+	template<class T, class C> static void readContainer(Input& input, const ObjectTable& table,
+			Family family, C& container);
+
+	static void writeModel(Output& output, const Model& model);
+	static void writeMesh(Output& output, const Mesh& mesh);
+	static void writeCellContainer(Output& output, const CellContainer& cellContainer);
+	static void writeObject(Output& output, const ObjectTable& table, size_t index);
+	static void writeAnalysis(Output& output, const ObjectTable& table, const Analysis& analysis);
+	static void writeObjective(Output& output, const ObjectTable& table,
+			const Objective& objective);
+	static void writeValue(Output& output, const Value& value);
+	static void writeLoading(Output& output, const Loading& loading);
+	static void writeConstraint(Output& output, const Constraint& constraint);
+	static void writeCoordinateSystem(Output& output, const CoordinateSystem& coordinateSystem);
+	static void writeElementSet(Output& output, const ObjectTable& table,
+			const ElementSet& elementSet);
+	static void writeMaterial(Output& output, const Material& material);
+	static void writeOrientation(Output& output, const Orientation& orientation);
+	std::shared_ptr<Model> readModel(Input& input) const;
+	static void readMesh(Input& input, Mesh& mesh);
+	static void readCellContainer(Input& input, CellContainer& cellContainer);
+	static void readObject(Input& input, Model& model, ObjectTable& table, size_t index);
+	static std::shared_ptr<Analysis> readAnalysis(Input& input, Model& model, ObjectTable& table);
+	static std::shared_ptr<Objective> readObjective(Input& input, Model& model,
+			ObjectTable& table);
+	static std::shared_ptr<Value> readValue(Input& input, Model& model);
+	static std::shared_ptr<Loading> readLoading(Input& input, Model& model);
+	static std::shared_ptr<Constraint> readConstraint(Input& input, Model& model);
+	static std::shared_ptr<CoordinateSystem> readCoordinateSystem(Input& input, Model& model);
+	static std::shared_ptr<ElementSet> readElementSet(Input& input, Model& model,
+			ObjectTable& table);
+	static std::shared_ptr<Material> readMaterial(Input& input, Model& model);
+	static std::shared_ptr<Orientation> readOrientation(Input& input, Model& model);
+public:
+	static const char MAGIC[8];
+
+	/**
+	 * Opens the snapshot of the input file of configuration, in its model cache directory.
+	 */
+	explicit ModelSnapshot(const ConfigurationParameters& configuration);
+	ModelSnapshot(const ModelSnapshot&) = delete;
+	ModelSnapshot& operator=(const ModelSnapshot&) = delete;
+	/**
+	 * True if the snapshot was found and none of the files read to build its model changed.
+	 */
+	bool isValid() const;
+	const fs::path& getPath() const;
+	/**
+	 * Reads the model of a valid snapshot, finished.
+	 *
+	 * @return nullptr if the snapshot can't be read: the model must be parsed.
+	 */
+	std::shared_ptr<Model> load();
+	/**
+	 * Writes a finished model, built from the files of its inputFiles and from the result
+	 * file of the configuration. Models holding objects that can't be written are left
+	 * without snapshot.
+	 */
+	void write(const Model& model);
+	/**
+	 * FNV-1a hash of the content of a file.
+	 */
+	static uint64_t hashFile(const fs::path& file);
+};
+
+} /* namespace vega */
+
+#endif /* MODELSNAPSHOT_H_ */
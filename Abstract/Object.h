@@ -14,15 +14,19 @@
 
 #include "Reference.h"
 #include <climits>
+#include <memory>
 #include <string>
 #include <sstream>
 
 namespace vega {
 
+class ModelSnapshot;
+
 /**
  * Base template class for a vega identifiable class
  */
 template<class T> class Identifiable {
+	friend ModelSnapshot;
 	static int auto_id;
 	int original_id;
 	int id;
@@ -113,6 +117,23 @@ int operator <(const Identifiable<T>& left, const Identifiable<T>& right) {
 	return left.getReference() < right.getReference();
 }
 
+/**
+ * Orders pointers to identifiable objects by id, that is by creation order, instead of by
+ * address. Copies sharing an id are ordered by address.
+ */
+template<class T>
+struct IdentifiableLess {
+	bool operator()(const std::shared_ptr<T>& left, const std::shared_ptr<T>& right) const {
+		if (left == nullptr || right == nullptr) {
+			return left == nullptr && right != nullptr;
+		}
+		if (left->getId() != right->getId()) {
+			return left->getId() < right->getId();
+		}
+		return std::less<const T*>()(left.get(), right.get());
+	}
+};
+
 } /* namespace vega */
 
 namespace std {
@@ -94,7 +94,7 @@ set<int> FrequencyAssertion::nodePositions() const {
 }
 
 shared_ptr<Objective> FrequencyAssertion::clone() const {
-	return shared_ptr<Objective>(new FrequencyAssertion(*this));
+	return makeModelObject<FrequencyAssertion>(model, *this);
 }
 
 AnalysisParameter::AnalysisParameter(const Model& model, Type type, int original_id) :
@@ -102,7 +102,7 @@ AnalysisParameter::AnalysisParameter(const Model& model, Type type, int original
 }
 
 shared_ptr<Objective> AnalysisParameter::clone() const {
-	return shared_ptr<Objective>(new AnalysisParameter(*this));
+	return makeModelObject<AnalysisParameter>(model, *this);
 }
 
 FrequencyValues::FrequencyValues(const Model& model, const StepRange& step_range, int original_id) :
@@ -115,16 +115,25 @@ FrequencyValues::FrequencyValues(const Model& model, int step_range_id, int orig
 				step_range_id) {
 }
 
+FrequencyValues::FrequencyValues(const Model& model, const Reference<Value>& step_range,
+		int original_id) :
+		AnalysisParameter(model, FREQUENCY_TARGET, original_id), step_range(step_range) {
+}
+
 const shared_ptr<StepRange> FrequencyValues::getStepRange() const {
 	return dynamic_pointer_cast<StepRange>(model.find(step_range));
 }
 
+const Reference<Value>& FrequencyValues::getStepRangeReference() const {
+	return step_range;
+}
+
 const ValuePlaceHolder FrequencyValues::getStepRangePlaceHolder() const {
 	return ValuePlaceHolder(model, step_range.type, step_range.original_id, Value::FREQ);
 }
 
 shared_ptr<Objective> FrequencyValues::clone() const {
-	return shared_ptr<Objective>(new FrequencyValues(*this));
+	return makeModelObject<FrequencyValues>(model, *this);
 }
 
 FrequencyBand::FrequencyBand(const Model& model, double lower, double upper, int num_max,
@@ -134,7 +143,7 @@ FrequencyBand::FrequencyBand(const Model& model, double lower, double upper, int
 }
 
 shared_ptr<Objective> FrequencyBand::clone() const {
-	return shared_ptr<Objective>(new FrequencyBand(*this));
+	return makeModelObject<FrequencyBand>(model, *this);
 }
 
 ModalDamping::ModalDamping(const Model& model, const FunctionTable& function_table, int original_id) :
@@ -147,16 +156,25 @@ ModalDamping::ModalDamping(const Model& model, int function_table_original_id, i
 				function_table_original_id) {
 }
 
+ModalDamping::ModalDamping(const Model& model, const Reference<Value>& function_table,
+		int original_id) :
+		AnalysisParameter(model, MODAL_DAMPING, original_id), function_table(function_table) {
+}
+
 const shared_ptr<FunctionTable> ModalDamping::getFunctionTable() const {
 	return dynamic_pointer_cast<FunctionTable>(model.find(function_table));
 }
 
+const Reference<Value>& ModalDamping::getFunctionTableReference() const {
+	return function_table;
+}
+
 const ValuePlaceHolder ModalDamping::getFunctionTablePlaceHolder() const {
 	return ValuePlaceHolder(model, function_table.type, function_table.original_id, Value::FREQ);
 }
 
 shared_ptr<Objective> ModalDamping::clone() const {
-	return shared_ptr<Objective>(new ModalDamping(*this));
+	return makeModelObject<ModalDamping>(model, *this);
 }
 
 NonLinearStrategy::NonLinearStrategy(const Model& model, int number_of_increments, int original_id) :
@@ -165,7 +183,7 @@ NonLinearStrategy::NonLinearStrategy(const Model& model, int number_of_increment
 }
 
 shared_ptr<Objective> NonLinearStrategy::clone() const {
-	return shared_ptr<Objective>(new NonLinearStrategy(*this));
+	return makeModelObject<NonLinearStrategy>(model, *this);
 }
 
 } /* namespace vega */
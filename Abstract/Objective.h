@@ -20,6 +20,7 @@
 #include "Object.h"
 #include "Reference.h"
 #include "Dof.h"
+#include "ModelArena.h"
 
 namespace vega {
 
@@ -93,7 +94,7 @@ public:
 	NodalDisplacementAssertion(const Model&, double tolerance, int nodeId, DOF dof,
 			double value, double instant, int original_id = NO_ORIGINAL_ID);
 	std::shared_ptr<Objective> clone() const {
-		return std::shared_ptr<Objective>(new NodalDisplacementAssertion(*this));
+		return makeModelObject<NodalDisplacementAssertion>(model, *this);
 	}
 	~NodalDisplacementAssertion() {
 	}
@@ -107,7 +108,7 @@ public:
 	NodalComplexDisplacementAssertion(const Model&, double tolerance, int nodeId, DOF dof,
 			complex<double> value, double frequency, int original_id = NO_ORIGINAL_ID);
 	std::shared_ptr<Objective> clone() const {
-		return std::shared_ptr<Objective>(new NodalComplexDisplacementAssertion(*this));
+		return makeModelObject<NodalComplexDisplacementAssertion>(model, *this);
 	}
 	~NodalComplexDisplacementAssertion() {
 	}
@@ -144,7 +145,10 @@ protected:
 public:
 	FrequencyValues(const Model&, const StepRange&, int original_id = NO_ORIGINAL_ID);
 	FrequencyValues(const Model&, int step_range_id, int original_id = NO_ORIGINAL_ID);
+	FrequencyValues(const Model&, const Reference<Value>& step_range, int original_id =
+			NO_ORIGINAL_ID);
 	const std::shared_ptr<StepRange> getStepRange() const;
+	const Reference<Value>& getStepRangeReference() const;
 	const ValuePlaceHolder getStepRangePlaceHolder() const;
 	std::shared_ptr<Objective> clone() const;
 	~FrequencyValues() {
@@ -173,7 +177,10 @@ public:
 	ModalDamping(const Model& model, const FunctionTable& function_table, int original_id =
 			NO_ORIGINAL_ID);
 	ModalDamping(const Model& model, int function_table_id, int original_id = NO_ORIGINAL_ID);
+	ModalDamping(const Model& model, const Reference<Value>& function_table, int original_id =
+			NO_ORIGINAL_ID);
 	const std::shared_ptr<FunctionTable> getFunctionTable() const;
+	const Reference<Value>& getFunctionTableReference() const;
 	const ValuePlaceHolder getFunctionTablePlaceHolder() const;
 	std::shared_ptr<Objective> clone() const;
 	~ModalDamping() {
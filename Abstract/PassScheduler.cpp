@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) Alneos, s. a r. l. (contact@alneos.fr)
+ * Released under the GNU General Public License
+ *
+ * PassScheduler.cpp
+ *
+ *  Runs the passes of Model::finish, concurrently when they are independent.
+ */
+
+#include "PassScheduler.h"
+#include "Profiler.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <exception>
+#include <memory>
+
+namespace vega {
+
+using namespace std;
+
+PassScheduler::PassScheduler(unsigned int threads) :
+		threads(max(1u, threads)) {
+}
+
+bool PassScheduler::Pass::conflictsWith(const Pass& other) const {
+	return (writes & (other.reads | other.writes)) != 0 || (other.writes & reads) != 0;
+}
+
+void PassScheduler::add(const string& name, unsigned int reads, unsigned int writes,
+		const function<void()>& run) {
+	Pass pass;
+	pass.name = name;
+	pass.reads = reads;
+	pass.writes = writes;
+	pass.run = run;
+	passes.push_back(pass);
+}
+
+vector<vector<size_t>> PassScheduler::waves() const {
+	vector<vector<size_t>> result;
+	vector<size_t> waveOfPass(passes.size());
+	for (size_t i = 0; i < passes.size(); i++) {
+		size_t wave = 0;
+		for (size_t j = 0; j < i; j++) {
+			if (passes[i].conflictsWith(passes[j])) {
+				wave = max(wave, waveOfPass[j] + 1);
+			}
+		}
+		waveOfPass[i] = wave;
+		if (wave == result.size()) {
+			result.push_back(vector<size_t>());
+		}
+		result[wave].push_back(i);
+	}
+	return result;
+}
+
+void PassScheduler::run() {
+	if (threads == 1) {
+		for (const Pass& pass : passes) {
+			pass.run();
+		}
+		return;
+	}
+	// created with the first wave of several passes
+	unique_ptr<WorkerPool> pool;
+	for (const vector<size_t>& wave : waves()) {
+		if (wave.size() == 1) {
+			passes[wave[0]].run();
+			continue;
+		}
+		if (!pool) {
+			pool.reset(new WorkerPool(threads));
+		}
+		string waveName;
+		for (size_t passIndex : wave) {
+			waveName += (waveName.empty() ? "" : "+") + passes[passIndex].name;
+		}
+		Profiler::Scope scope(waveName.c_str());
+		vector<exception_ptr> errors(wave.size());
+		vector<vector<Profiler::Phase>> phasesOfPass(wave.size());
+		pool->run(wave.size(), [this, &wave, &errors, &phasesOfPass](size_t i) {
+			Profiler::ThreadRecorder recorder(phasesOfPass[i]);
+			try {
+				passes[wave[i]].run();
+			} catch (...) {
+				errors[i] = current_exception();
+			}
+		});
+		// in order of addition, whichever thread ran the passes
+		for (const vector<Profiler::Phase>& phases : phasesOfPass) {
+			Profiler::instance().merge(phases);
+		}
+		for (const exception_ptr& error : errors) {
+			if (error) {
+				rethrow_exception(error);
+			}
+		}
+	}
+}
+
+void PassScheduler::forEach(size_t count, unsigned int threads,
+		const function<void(size_t)>& task) {
+	const size_t threadCount = min(static_cast<size_t>(max(1u, threads)), count);
+	unique_ptr<WorkerPool> pool(
+			threadCount > 1 ? new WorkerPool(static_cast<unsigned int>(threadCount)) : nullptr);
+	forEach(pool.get(), count, task);
+}
+
+void PassScheduler::forEach(WorkerPool* pool, size_t count,
+		const function<void(size_t)>& task) {
+	const size_t rangeCount = pool ? min(static_cast<size_t>(pool->threads()), count) : 1;
+	if (rangeCount <= 1) {
+		for (size_t i = 0; i < count; i++) {
+			task(i);
+		}
+		return;
+	}
+	vector<exception_ptr> errors(rangeCount);
+	pool->run(rangeCount, [count, rangeCount, &task, &errors](size_t range) {
+		try {
+			for (size_t i = count * range / rangeCount; i < count * (range + 1) / rangeCount;
+					i++) {
+				task(i);
+			}
+		} catch (...) {
+			errors[range] = current_exception();
+		}
+	});
+	for (const exception_ptr& error : errors) {
+		if (error) {
+			rethrow_exception(error);
+		}
+	}
+}
+
+} /* namespace vega */
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) Alneos, s. a r. l. (contact@alneos.fr)
+ * Released under the GNU General Public License
+ *
+ * PassScheduler.h
+ *
+ *  Runs the passes of Model::finish, concurrently when they are independent.
+ */
+
+#ifndef PASSSCHEDULER_H_
+#define PASSSCHEDULER_H_
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace vega {
+
+class WorkerPool;
+
+/**
+ * Runs a sequence of passes, each one declaring the parts of the model it reads and writes.
+ * Two passes conflict if one of them writes a part the other one reads or writes: a pass
+ * is only started once the passes added before it that it conflicts with are done, so that
+ * the result is the one of a sequential run.
+ *
+ * With a single thread the passes run in the order they were added on the calling thread,
+ * which is the deterministic mode. Otherwise the passes are grouped by waves of
+ * independent passes, and the passes of a wave run concurrently on threads kept for the
+ * whole run. The profiler phases of these passes are reported under their wave.
+ */
+class PassScheduler final {
+public:
+	/**
+	 * Parts of the model read or written by a pass. Each part also numbers the objects it
+	 * holds (see Identifiable): a pass creating objects writes their part, so that they get
+	 * the ids of a sequential run.
+	 */
+	enum Part {
+		/**
+		 * Nodes and their DOFS, cells, groups and orientations.
+		 */
+		MESH = 1 << 0,
+		/**
+		 * Element sets and materials.
+		 */
+		ELEMENTS = 1 << 1,
+		/**
+		 * Material assignments of the cells.
+		 */
+		MATERIAL_ASSIGNMENTS = 1 << 2,
+		/**
+		 * Constraints, constraint sets and their members.
+		 */
+		CONSTRAINTS = 1 << 3,
+		/**
+		 * Loadings, load sets and their members.
+		 */
+		LOADINGS = 1 << 4,
+		/**
+		 * Analyses, the sets they use and their boundary DOFS.
+		 */
+		ANALYSES = 1 << 5,
+		OBJECTIVES = 1 << 6,
+		COORDINATE_SYSTEMS = 1 << 7,
+		ALL_PARTS = (1 << 8) - 1
+	};
+
+	/**
+	 * @param threads maximum number of passes run at the same time, 1 to run them in
+	 * sequence.
+	 */
+	explicit PassScheduler(unsigned int threads = 1);
+	PassScheduler(const PassScheduler&) = delete;
+	PassScheduler& operator=(const PassScheduler&) = delete;
+	/**
+	 * Adds a pass, reads and writes being combinations of Part.
+	 */
+	void add(const std::string& name, unsigned int reads, unsigned int writes,
+			const std::function<void()>& run);
+	/**
+	 * The passes grouped by waves, by their index in order of addition: a pass is in the
+	 * wave following the last one of the passes it depends on.
+	 */
+	std::vector<std::vector<size_t>> waves() const;
+	/**
+	 * Runs the passes. If passes throw, the exception of the first of them in order of
+	 * addition is thrown once the running passes are done.
+	 */
+	void run();
+	/**
+	 * Calls task for each index in [0, count) on up to threads threads, each thread taking
+	 * a contiguous range of indices. Tasks must only write data of their own index. If a
+	 * task throws, the exception of the first range is thrown once all the ranges are done.
+	 */
+	static void forEach(size_t count, unsigned int threads,
+			const std::function<void(size_t)>& task);
+	/**
+	 * Same as above on the threads of pool, for callers running many rounds, or on the
+	 * calling thread if pool is nullptr.
+	 */
+	static void forEach(WorkerPool* pool, size_t count, const std::function<void(size_t)>& task);
+private:
+	class Pass {
+	public:
+		std::string name;
+		unsigned int reads;
+		unsigned int writes;
+		std::function<void()> run;
+		bool conflictsWith(const Pass& other) const;
+	};
+	const unsigned int threads;
+	std::vector<Pass> passes;
+};
+
+} /* namespace vega */
+
+#endif /* PASSSCHEDULER_H_ */
@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) Alneos, s. a r. l. (contact@alneos.fr)
+ * Released under the GNU General Public License
+ *
+ * Profiler.cpp
+ *
+ *  Timing and memory usage of the phases of a translation.
+ */
+
+#include "Profiler.h"
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#ifdef __linux__
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace vega {
+
+using namespace std;
+
+atomic<bool> Profiler::allocationCounting(false);
+atomic<size_t> Profiler::allocationCount(0);
+atomic<size_t> Profiler::allocatedByteCount(0);
+
+namespace {
+
+/**
+ * The innermost ThreadRecorder of the calling thread, if any.
+ */
+thread_local Profiler::ThreadRecorder* threadRecorder = nullptr;
+
+void writeJsonString(ostream& out, const string& value) {
+	out << '"';
+	for (char c : value) {
+		if (c == '"' || c == '\\') {
+			out << '\\' << c;
+		} else if (static_cast<unsigned char>(c) < 0x20) {
+			out << "\\u" << hex << setw(4) << setfill('0') << static_cast<int>(c) << dec
+					<< setfill(' ');
+		} else {
+			out << c;
+		}
+	}
+	out << '"';
+}
+
+}
+
+Profiler::Profiler() :
+		enabled(false), currentPhase(-1) {
+}
+
+Profiler& Profiler::instance() {
+	static Profiler profiler;
+	return profiler;
+}
+
+void Profiler::enable() {
+	thread = this_thread::get_id();
+	// published with the thread profiled
+	enabled.store(true, memory_order_release);
+	allocationCounting.store(true, memory_order_relaxed);
+}
+
+void Profiler::disable() {
+	enabled.store(false, memory_order_release);
+	allocationCounting.store(false, memory_order_relaxed);
+}
+
+bool Profiler::isEnabled() const {
+	return enabled.load(memory_order_acquire);
+}
+
+void Profiler::reset() {
+	if (currentPhase >= 0) {
+		throw logic_error("Profiler reset while the phase " + phases[static_cast<size_t>(currentPhase)].path
+				+ " is measured.");
+	}
+	phases.clear();
+	allocationCount.store(0, memory_order_relaxed);
+	allocatedByteCount.store(0, memory_order_relaxed);
+}
+
+const vector<Profiler::Phase>& Profiler::getPhases() const {
+	return phases;
+}
+
+void Profiler::merge(const vector<Phase>& threadPhases) {
+	if (threadPhases.empty()) {
+		return;
+	}
+	if (this_thread::get_id() != thread) {
+		throw logic_error("Profiler phases merged by a thread other than the profiled one.");
+	}
+	const int offset = static_cast<int>(phases.size());
+	for (const Phase& threadPhase : threadPhases) {
+		Phase phase = threadPhase;
+		// the recorded parents are merged before their nested phases
+		phase.parent = threadPhase.parent >= 0 ? offset + threadPhase.parent : currentPhase;
+		if (phase.parent >= 0) {
+			const Phase& parent = phases[static_cast<size_t>(phase.parent)];
+			phase.path = parent.path + "/" + phase.name;
+			phase.depth = parent.depth + 1;
+		}
+		phases.push_back(phase);
+	}
+}
+
+size_t Profiler::residentSetSize() {
+#ifdef __linux__
+	ifstream statm("/proc/self/statm");
+	size_t totalPages = 0;
+	size_t residentPages = 0;
+	if (statm >> totalPages >> residentPages) {
+		return residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	}
+#endif
+	return 0;
+}
+
+size_t Profiler::peakResidentSetSize() {
+#ifdef __linux__
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0) {
+		// kilobytes on Linux
+		return static_cast<size_t>(usage.ru_maxrss) * 1024;
+	}
+#endif
+	return 0;
+}
+
+Profiler::ThreadRecorder::ThreadRecorder(vector<Phase>& phases) :
+		phases(phases), currentPhase(-1), previous(threadRecorder),
+		active(Profiler::instance().isEnabled()) {
+	if (active) {
+		threadRecorder = this;
+	}
+}
+
+Profiler::ThreadRecorder::~ThreadRecorder() {
+	if (active) {
+		threadRecorder = previous;
+	}
+}
+
+Profiler::Scope::Scope(const char* name) :
+		phases(nullptr), currentPhase(nullptr), phaseIndex(-1), allocationsAtStart(0),
+		allocatedBytesAtStart(0) {
+	Profiler& profiler = Profiler::instance();
+	if (!profiler.isEnabled()) {
+		return;
+	}
+	if (threadRecorder != nullptr) {
+		phases = &threadRecorder->phases;
+		currentPhase = &threadRecorder->currentPhase;
+	} else if (this_thread::get_id() == profiler.thread) {
+		phases = &profiler.phases;
+		currentPhase = &profiler.currentPhase;
+	} else {
+		return;
+	}
+	Phase phase;
+	phase.name = name;
+	phase.parent = *currentPhase;
+	if (phase.parent >= 0) {
+		const Phase& parent = (*phases)[static_cast<size_t>(phase.parent)];
+		phase.path = parent.path + "/" + phase.name;
+		phase.depth = parent.depth + 1;
+	} else {
+		phase.path = phase.name;
+		phase.depth = 0;
+	}
+	phase.seconds = 0;
+	phase.rssBefore = residentSetSize();
+	phase.rssAfter = 0;
+	phase.peakRss = 0;
+	phase.allocations = 0;
+	phase.allocatedBytes = 0;
+	phase.writtenBytes = 0;
+	phaseIndex = static_cast<int>(phases->size());
+	phases->push_back(phase);
+	*currentPhase = phaseIndex;
+	// the bookkeeping above is not part of the phase
+	allocationsAtStart = allocationCount.load(memory_order_relaxed);
+	allocatedBytesAtStart = allocatedByteCount.load(memory_order_relaxed);
+	start = chrono::steady_clock::now();
+}
+
+Profiler::Scope::~Scope() {
+	if (phaseIndex < 0) {
+		return;
+	}
+	const auto end = chrono::steady_clock::now();
+	const size_t allocations = allocationCount.load(memory_order_relaxed);
+	const size_t allocatedBytes = allocatedByteCount.load(memory_order_relaxed);
+	Phase& phase = (*phases)[static_cast<size_t>(phaseIndex)];
+	phase.seconds = chrono::duration<double>(end - start).count();
+	phase.allocations = allocations - allocationsAtStart;
+	phase.allocatedBytes = allocatedBytes - allocatedBytesAtStart;
+	phase.rssAfter = residentSetSize();
+	phase.peakRss = peakResidentSetSize();
+	*currentPhase = phase.parent;
+}
+
+void Profiler::Scope::addWrittenBytes(size_t bytes) {
+	if (phaseIndex < 0) {
+		return;
+	}
+	(*phases)[static_cast<size_t>(phaseIndex)].writtenBytes += bytes;
+}
+
+void Profiler::writeJson(ostream& out) const {
+	const auto precision = out.precision(6);
+	out << "{" << endl;
+	out << "  \"peakRss\": " << peakResidentSetSize() << "," << endl;
+	out << "  \"allocations\": " << allocationCount.load(memory_order_relaxed) << "," << endl;
+	out << "  \"allocatedBytes\": " << allocatedByteCount.load(memory_order_relaxed) << ","
+			<< endl;
+	out << "  \"phases\": [";
+	for (size_t i = 0; i < phases.size(); i++) {
+		const Phase& phase = phases[i];
+		out << (i == 0 ? "" : ",") << endl << "    {\"name\": ";
+		writeJsonString(out, phase.name);
+		out << ", \"path\": ";
+		writeJsonString(out, phase.path);
+		out << ", \"depth\": " << phase.depth << ", \"parent\": " << phase.parent
+				<< ", \"seconds\": " << fixed << phase.seconds << defaultfloat
+				<< ", \"rssBefore\": " << phase.rssBefore << ", \"rssAfter\": " << phase.rssAfter
+				<< ", \"peakRss\": " << phase.peakRss << ", \"allocations\": "
+				<< phase.allocations << ", \"allocatedBytes\": " << phase.allocatedBytes;
+		if (phase.writtenBytes > 0) {
+			out << ", \"writtenBytes\": " << phase.writtenBytes << ", \"megabytesPerSecond\": "
+					<< fixed
+					<< (phase.seconds > 0 ? static_cast<double>(phase.writtenBytes) / 1e6 / phase.seconds : 0.)
+					<< defaultfloat;
+		}
+		out << "}";
+	}
+	out << endl << "  ]" << endl << "}" << endl;
+	out.precision(precision);
+}
+
+} /* namespace vega */
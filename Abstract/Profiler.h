@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) Alneos, s. a r. l. (contact@alneos.fr)
+ * Released under the GNU General Public License
+ *
+ * Profiler.h
+ *
+ *  Timing and memory usage of the phases of a translation.
+ */
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vega {
+
+/**
+ * Records the duration, resident memory and allocations of the phases of a translation
+ * (parsing, each pass of Model::finish, each stage of the writers...) and writes them as a
+ * JSON report.
+ *
+ * The profiler is disabled by default: a Scope then only tests a flag. Phases are those of
+ * the thread that enabled the profiler, nested phases being reported with their parent. The
+ * scopes opened by other threads are ignored, unless a ThreadRecorder collects them to be
+ * merged afterwards.
+ */
+class Profiler final {
+public:
+	/**
+	 * A measured phase, in the order it was started.
+	 */
+	class Phase {
+	public:
+		std::string name;
+		/**
+		 * Names of the enclosing phases and of this one, separated by '/'.
+		 */
+		std::string path;
+		int depth;
+		/**
+		 * Index of the enclosing phase, -1 for a top level phase.
+		 */
+		int parent;
+		double seconds;
+		/**
+		 * Resident set size before and after the phase, and highest resident set size of
+		 * the process at its end, in bytes. 0 where it can't be measured.
+		 */
+		size_t rssBefore;
+		size_t rssAfter;
+		size_t peakRss;
+		/**
+		 * Number and size of the memory allocations made during the phase, nested phases
+		 * included. Only counted when the allocation functions report to the profiler.
+		 */
+		size_t allocations;
+		size_t allocatedBytes;
+		/**
+		 * Bytes written to the output files during the phase, as reported by its Scope.
+		 */
+		size_t writtenBytes;
+	};
+
+	/**
+	 * Measures a phase from its construction to its destruction.
+	 */
+	class Scope final {
+	private:
+		std::vector<Phase>* phases;
+		int* currentPhase;
+		int phaseIndex;
+		std::chrono::steady_clock::time_point start;
+		size_t allocationsAtStart;
+		size_t allocatedBytesAtStart;
+	public:
+		explicit Scope(const char* name);
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+		~Scope();
+		/**
+		 * Reports bytes written by the phase, so that its throughput is written too.
+		 */
+		void addWrittenBytes(size_t bytes);
+	};
+
+	/**
+	 * Collects the phases measured by the thread constructing it until its destruction, e.g.
+	 * a pass of Model::finish run by a worker thread, so that they can be merged with those
+	 * of the profiled thread once the thread is joined. Collects nothing if the profiler is
+	 * disabled.
+	 */
+	class ThreadRecorder final {
+	private:
+		std::vector<Phase>& phases;
+		int currentPhase;
+		ThreadRecorder* previous;
+		bool active;
+		friend class Scope;
+	public:
+		explicit ThreadRecorder(std::vector<Phase>& phases);
+		ThreadRecorder(const ThreadRecorder&) = delete;
+		ThreadRecorder& operator=(const ThreadRecorder&) = delete;
+		~ThreadRecorder();
+	};
+
+	static Profiler& instance();
+	void enable();
+	/**
+	 * Stops measuring the phases and counting the allocations. The phases already measured
+	 * are kept.
+	 */
+	void disable();
+	bool isEnabled() const;
+	/**
+	 * Forgets the phases measured and the allocations counted, e.g. between two tests. Not
+	 * allowed while a phase is measured.
+	 */
+	void reset();
+	/**
+	 * Called by the replaced allocation functions of an executable (see vegamain.cpp), so
+	 * that allocations are counted without this library replacing operator new.
+	 */
+	static inline void countAllocation(size_t size) {
+		if (allocationCounting.load(std::memory_order_relaxed)) {
+			allocationCount.fetch_add(1, std::memory_order_relaxed);
+			allocatedByteCount.fetch_add(size, std::memory_order_relaxed);
+		}
+	}
+	const std::vector<Phase>& getPhases() const;
+	/**
+	 * Adds the phases collected by a ThreadRecorder as nested phases of the current phase of
+	 * the profiled thread, which must be the calling thread. Their durations overlap those of
+	 * the phases run at the same time, and their allocations and resident set sizes are
+	 * those of the whole process.
+	 */
+	void merge(const std::vector<Phase>& threadPhases);
+	/**
+	 * Current resident set size of the process in bytes, 0 if unknown.
+	 */
+	static size_t residentSetSize();
+	/**
+	 * Highest resident set size of the process in bytes, 0 if unknown.
+	 */
+	static size_t peakResidentSetSize();
+	void writeJson(std::ostream& out) const;
+private:
+	static std::atomic<bool> allocationCounting;
+	static std::atomic<size_t> allocationCount;
+	static std::atomic<size_t> allocatedByteCount;
+	/**
+	 * Read by the scopes of every thread, while the profiled thread may enable or disable
+	 * the profiler.
+	 */
+	std::atomic<bool> enabled;
+	std::thread::id thread;
+	int currentPhase;
+	std::vector<Phase> phases;
+	Profiler();
+};
+
+} /* namespace vega */
+
+#endif /* PROFILER_H_ */
@@ -36,7 +36,7 @@ ValuePlaceHolder::ValuePlaceHolder(const Model& model, Type type, int original_i
 }
 
 shared_ptr<Value> ValuePlaceHolder::clone() const {
-	return shared_ptr<Value>(new ValuePlaceHolder(*this));
+	return makeModelObject<ValuePlaceHolder>(model, *this);
 }
 
 ValueRange::ValueRange(const Model& model, Type type, int original_id) :
@@ -44,7 +44,7 @@ ValueRange::ValueRange(const Model& model, Type type, int original_id) :
 }
 
 shared_ptr<Value> ValueRange::clone() const {
-	return shared_ptr<Value>(new ValueRange(*this));
+	return makeModelObject<ValueRange>(model, *this);
 }
 
 StepRange::StepRange(const Model& model, double start, double step, double end, int original_id) :
@@ -64,7 +64,7 @@ StepRange::StepRange(const Model& model, double start, double step, int count, i
 }
 
 shared_ptr<Value> StepRange::clone() const {
-	return shared_ptr<Value>(new StepRange(*this));
+	return makeModelObject<StepRange>(model, *this);
 }
 
 Function::Function(const Model& model, Type type, int original_id) :
@@ -72,7 +72,7 @@ Function::Function(const Model& model, Type type, int original_id) :
 }
 
 shared_ptr<Value> Function::clone() const {
-	return shared_ptr<Value>(new Function(*this));
+	return makeModelObject<Function>(model, *this);
 }
 
 FunctionTable::FunctionTable(const Model& model, Interpolation parameter, Interpolation value,
@@ -94,14 +94,14 @@ const vector<pair<double, double>>::const_iterator FunctionTable::getEndValuesXY
 }
 
 shared_ptr<Value> FunctionTable::clone() const {
-	return shared_ptr<Value>(new FunctionTable(*this));
+	return makeModelObject<FunctionTable>(model, *this);
 }
 
-ConstantValue::ConstantValue(const Model&, Type type, double value, int original_id) :
+ConstantValue::ConstantValue(const Model& model, Type type, double value, int original_id) :
 		Value(model, type, original_id), value(value) {
 }
 
-DynaPhase::DynaPhase(const Model&, double value, int original_id) :
+DynaPhase::DynaPhase(const Model& model, double value, int original_id) :
 		ConstantValue(model, DYNA_PHASE, value, original_id) {
 }
 
@@ -13,6 +13,7 @@
 #define VALUE_H_
 
 #include "Object.h"
+#include "ModelArena.h"
 
 #include <climits>
 #include <map>
@@ -161,11 +162,11 @@ protected:
 	double value;
 	ConstantValue(const Model&, Type, double value, int original_id = NO_ORIGINAL_ID);
 	public:
-	virtual double get() {
+	virtual double get() const {
 		return value;
 	}
 	std::shared_ptr<Value> clone() const {
-		return std::shared_ptr<Value>(new ConstantValue(*this));
+		return makeModelObject<ConstantValue>(model, *this);
 	}
 };
 
@@ -173,7 +174,7 @@ class DynaPhase: public ConstantValue {
 public:
 	DynaPhase(const Model&, double value, int original_id = NO_ORIGINAL_ID);
 	std::shared_ptr<Value> clone() const {
-		return std::shared_ptr<Value>(new DynaPhase(*this));
+		return makeModelObject<DynaPhase>(model, *this);
 	}
 };
 
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) Alneos, s. a r. l. (contact@alneos.fr)
+ * Released under the GNU General Public License
+ *
+ * WorkerPool.cpp
+ *
+ *  Threads kept to run several rounds of tasks.
+ */
+
+#include "WorkerPool.h"
+
+namespace vega {
+
+using namespace std;
+
+WorkerPool::WorkerPool(unsigned int threads) :
+		task(nullptr), taskCount(0), nextTask(0), runningTasks(0), round(0), stopping(false) {
+	for (unsigned int i = 1; i < threads; i++) {
+		workers.push_back(thread([this]() {loop();}));
+	}
+}
+
+WorkerPool::~WorkerPool() {
+	{
+		lock_guard<mutex> locked(lock);
+		stopping = true;
+	}
+	wakeUp.notify_all();
+	for (thread& worker : workers) {
+		worker.join();
+	}
+}
+
+unsigned int WorkerPool::threads() const {
+	return static_cast<unsigned int>(workers.size()) + 1;
+}
+
+void WorkerPool::work(unique_lock<mutex>& locked) {
+	while (nextTask < taskCount) {
+		const size_t i = nextTask++;
+		runningTasks++;
+		locked.unlock();
+		(*task)(i);
+		locked.lock();
+		runningTasks--;
+	}
+	if (runningTasks == 0) {
+		done.notify_all();
+	}
+}
+
+void WorkerPool::loop() {
+	unique_lock<mutex> locked(lock);
+	unsigned int seenRound = 0;
+	while (true) {
+		wakeUp.wait(locked, [this, seenRound]() {return stopping || round != seenRound;});
+		if (stopping) {
+			return;
+		}
+		seenRound = round;
+		work(locked);
+	}
+}
+
+void WorkerPool::run(size_t count, const function<void(size_t)>& tasks) {
+	unique_lock<mutex> locked(lock);
+	task = &tasks;
+	taskCount = count;
+	nextTask = 0;
+	round++;
+	wakeUp.notify_all();
+	work(locked);
+	done.wait(locked, [this]() {return nextTask >= taskCount && runningTasks == 0;});
+	task = nullptr;
+	taskCount = 0;
+	nextTask = 0;
+}
+
+} /* namespace vega */
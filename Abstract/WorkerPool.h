@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) Alneos, s. a r. l. (contact@alneos.fr)
+ * Released under the GNU General Public License
+ *
+ * WorkerPool.h
+ *
+ *  Threads kept to run several rounds of tasks.
+ */
+
+#ifndef WORKERPOOL_H_
+#define WORKERPOOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vega {
+
+/**
+ * Threads created once and given successive rounds of tasks, e.g. the waves of passes of
+ * Model::finish or the batches of cards of a parser. The tasks of a round are taken in order
+ * by the first free thread, the calling thread included, until they are all done.
+ */
+class WorkerPool final {
+private:
+	std::mutex lock;
+	std::condition_variable wakeUp;
+	std::condition_variable done;
+	const std::function<void(size_t)>* task;
+	size_t taskCount;
+	size_t nextTask;
+	size_t runningTasks;
+	unsigned int round;
+	bool stopping;
+	std::vector<std::thread> workers;
+	/**
+	 * Runs the tasks of the round not taken yet, lock being held between them.
+	 */
+	void work(std::unique_lock<std::mutex>& locked);
+	void loop();
+public:
+	/**
+	 * @param threads number of tasks run at the same time, the calling thread included.
+	 */
+	explicit WorkerPool(unsigned int threads);
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+	~WorkerPool();
+	/**
+	 * Number of tasks run at the same time, the calling thread included.
+	 */
+	unsigned int threads() const;
+	/**
+	 * Calls task for each index in [0, count) and returns once all the calls are done. The
+	 * task must not throw: it reports its errors itself, e.g. as an exception_ptr by index.
+	 */
+	void run(size_t count, const std::function<void(size_t)>& task);
+};
+
+} /* namespace vega */
+
+#endif /* WORKERPOOL_H_ */
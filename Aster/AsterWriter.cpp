@@ -11,13 +11,18 @@
 #include "AsterWriter.h"
 #include "build_properties.h"
 #include "../Abstract/Model.h"
+#include "../Abstract/Profiler.h"
+#include <cstdint>
 #include <cstdlib>
 #include <iostream>
 #include <iomanip>
 #include <memory>
 #include <string>
+#include <exception>
 #include <fstream>
 #include <limits>
+#include <sstream>
+#include <thread>
 
 #include <ciso646>
 
@@ -26,6 +31,8 @@ namespace fs = boost::filesystem;
 namespace vega {
 namespace aster {
 
+const size_t AsterWriterImpl::MAX_GROUP_NAME_LENGTH;
+
 AsterWriterImpl::AsterWriterImpl() {
 
 }
@@ -48,7 +55,11 @@ string AsterWriterImpl::writeModel(const shared_ptr<vega::Model> model_ptr,
 	string med_path = asterModel.getOutputFileName(".med");
 	string comm_path = asterModel.getOutputFileName(".comm");
 
-	model_ptr->mesh->writeMED(med_path.c_str());
+	createNameListGroups(*model_ptr, configuration.maxNameListSize);
+	const bool concurrentWrite = configuration.concurrentMedWrite;
+	if (!concurrentWrite) {
+		writeMED(asterModel, med_path);
+	}
 
 	ofstream comm_file_ofs;
 	//comm_file_ofs.setf(ios::scientific);
@@ -69,12 +80,170 @@ string AsterWriterImpl::writeModel(const shared_ptr<vega::Model> model_ptr,
 		string message = string("Can't open file ") + comm_path + " for writing.";
 		throw ios::failure(message);
 	}
-	this->writeComm(asterModel, comm_file_ofs);
+	if (concurrentWrite) {
+		writeMEDAndComm(asterModel, med_path, comm_file_ofs);
+	} else {
+		this->writeComm(asterModel, comm_file_ofs);
+	}
 	comm_file_ofs.close();
 	return exp_path;
 }
 
+void AsterWriterImpl::writeMEDAndComm(const AsterModel& asterModel, const string& med_path,
+		ostream& out) {
+	Profiler::Scope scope("writeMED+writeComm");
+	// finished here, writeMED must not modify the mesh read by writeComm
+	asterModel.model.mesh->finish();
+	exception_ptr medError;
+	ostringstream medMessages;
+	vector<Profiler::Phase> medPhases;
+	thread medWriter([this, &asterModel, &med_path, &medError, &medMessages, &medPhases]() {
+		Profiler::ThreadRecorder recorder(medPhases);
+		try {
+			writeMED(asterModel, med_path, medMessages);
+		} catch (...) {
+			medError = current_exception();
+		}
+	});
+	ostringstream comm;
+	comm.precision(out.precision());
+	try {
+		this->writeComm(asterModel, comm);
+	} catch (...) {
+		medWriter.join();
+		cout << medMessages.str();
+		Profiler::instance().merge(medPhases);
+		throw;
+	}
+	medWriter.join();
+	cout << medMessages.str();
+	Profiler::instance().merge(medPhases);
+	if (medError) {
+		rethrow_exception(medError);
+	}
+	const string text = comm.str();
+	out.write(text.data(), static_cast<streamsize>(text.size()));
+}
+
+void AsterWriterImpl::writeMED(const AsterModel& asterModel, const string& med_path,
+		ostream& messages) const {
+	vector<NodeGroup*> nodeGroups;
+	for (const auto& nodeGroup : nameListNodeGroups) {
+		nodeGroups.push_back(nodeGroup.get());
+	}
+	vector<CellGroup*> cellGroups;
+	for (const auto& cellGroup : nameListCellGroups) {
+		cellGroups.push_back(cellGroup.get());
+	}
+	asterModel.model.mesh->writeMED(med_path.c_str(), nodeGroups, cellGroups, messages,
+			asterModel.configuration.writerThreads);
+}
+
+string AsterWriterImpl::asterGroupName(const string& name) {
+	if (name.size() <= MAX_GROUP_NAME_LENGTH) {
+		return name;
+	}
+	// 32 bits FNV-1a, so that the names do not depend on the platform
+	uint32_t hash = 2166136261u;
+	for (const char c : name) {
+		hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+	}
+	ostringstream suffix;
+	suffix << "_" << uppercase << hex << setw(8) << setfill('0') << hash;
+	return name.substr(0, MAX_GROUP_NAME_LENGTH - suffix.str().size()) + suffix.str();
+}
+
+string AsterWriterImpl::newGroupName(const Mesh& mesh, const string& prefix, int id) const {
+	const auto isTaken = [this, &mesh](const string& name) {
+		if (mesh.findGroup(name) != nullptr) {
+			return true;
+		}
+		for (const auto& nodeGroup : nameListNodeGroups) {
+			if (nodeGroup->getName() == name) {
+				return true;
+			}
+		}
+		for (const auto& cellGroup : nameListCellGroups) {
+			if (cellGroup->getName() == name) {
+				return true;
+			}
+		}
+		return false;
+	};
+	string name = asterGroupName(prefix + to_string(id));
+	for (int suffix = 1; isTaken(name); suffix++) {
+		name = asterGroupName(prefix + to_string(id) + "_" + to_string(suffix));
+	}
+	return name;
+}
+
+void AsterWriterImpl::createNameListGroups(const Model& model, unsigned int maxNameListSize) {
+	Profiler::Scope scope("createNameListGroups");
+	nodeGroupNameBySpcId.clear();
+	cellGroupNameByContainer.clear();
+	cellGroupNameByMaterialId.clear();
+	nameListNodeGroups.clear();
+	nameListCellGroups.clear();
+	Mesh& mesh = *model.mesh;
+	for (auto constraint : model.constraints) {
+		if (constraint->type != Constraint::SPC) {
+			continue;
+		}
+		shared_ptr<const SinglePointConstraint> spc = static_pointer_cast<
+				const SinglePointConstraint>(constraint);
+		if (spc->group != nullptr || spc->hasReferences()) {
+			continue;
+		}
+		const set<int> nodePositions = spc->nodePositions();
+		if (nodePositions.size() <= maxNameListSize) {
+			continue;
+		}
+		const string name = newGroupName(mesh, "SPC", spc->getId());
+		unique_ptr<NodeGroup> nodeGroup = mesh.createDetachedNodeGroup(name);
+		for (int nodePosition : nodePositions) {
+			nodeGroup->addNodeByPosition(nodePosition);
+		}
+		nameListNodeGroups.push_back(move(nodeGroup));
+		nodeGroupNameBySpcId[spc->getId()] = name;
+	}
+	for (auto loading : model.loadings) {
+		const CellContainer* cellContainer = dynamic_cast<const ElementLoading*>(loading.get());
+		if (cellContainer == nullptr || !cellContainer->hasCells()) {
+			continue;
+		}
+		const vector<int> cellPositions = cellContainer->getCellPositions();
+		if (cellPositions.size() <= maxNameListSize) {
+			continue;
+		}
+		const string name = newGroupName(mesh, "LOAD", loading->getId());
+		unique_ptr<CellGroup> cellGroup = mesh.createDetachedCellGroup(name);
+		for (int cellPosition : cellPositions) {
+			cellGroup->addCellByPosition(cellPosition);
+		}
+		nameListCellGroups.push_back(move(cellGroup));
+		cellGroupNameByContainer[cellContainer] = name;
+	}
+	for (auto material : model.materials) {
+		const CellContainer assignment = material->getAssignment();
+		if (!assignment.hasCells()) {
+			continue;
+		}
+		const vector<int> cellPositions = assignment.getCellPositions();
+		if (cellPositions.size() <= maxNameListSize) {
+			continue;
+		}
+		const string name = newGroupName(mesh, "MAT", material->getId());
+		unique_ptr<CellGroup> cellGroup = mesh.createDetachedCellGroup(name);
+		for (int cellPosition : cellPositions) {
+			cellGroup->addCellByPosition(cellPosition);
+		}
+		nameListCellGroups.push_back(move(cellGroup));
+		cellGroupNameByMaterialId[material->getId()] = name;
+	}
+}
+
 void AsterWriterImpl::writeExport(AsterModel &model, ostream& out) {
+	Profiler::Scope scope("writeExport");
 	out << "P actions make_etude" << endl;
 	out << "P mem_aster 100.0" << endl;
 	out << "P mode interactif" << endl;
@@ -213,6 +382,7 @@ void AsterWriterImpl::writeImprResultats(const AsterModel& asterModel, ostream&
 }
 
 void AsterWriterImpl::writeAnalyses(const AsterModel& asterModel, ostream& out) {
+	Profiler::Scope scope("writeAnalyses");
 	double debut = 0;
 	for (auto it : asterModel.model.analyses) {
 		Analysis& analysis = *it;
@@ -259,6 +429,7 @@ void AsterWriterImpl::writeAnalyses(const AsterModel& asterModel, ostream& out)
 }
 
 void AsterWriterImpl::writeComm(const AsterModel& asterModel, ostream& out) {
+	Profiler::Scope scope("writeComm");
 	string asterVersion(asterModel.getAsterVersion());
 	out << "#Vega++ version " << VEGA_VERSION_MAJOR << "." << VEGA_VERSION_MINOR << endl;
 	out << "#Aster version " << asterModel.getAsterVersion() << endl;
@@ -293,6 +464,7 @@ void AsterWriterImpl::writeComm(const AsterModel& asterModel, ostream& out) {
 }
 
 void AsterWriterImpl::writeLireMaillage(const AsterModel& asterModel, ostream& out) {
+	Profiler::Scope scope("writeLireMaillage");
 	out << mail_name << "=LIRE_MAILLAGE(FORMAT='MED',";
 	if (asterModel.configuration.logLevel >= LogLevel::DEBUG) {
 		out << "INFO_MED=2,VERI_MAIL=_F(VERIF='OUI',),INFO=2";
@@ -303,6 +475,7 @@ void AsterWriterImpl::writeLireMaillage(const AsterModel& asterModel, ostream& o
 }
 
 void AsterWriterImpl::writeAffeModele(const AsterModel& asterModel, ostream& out) {
+	Profiler::Scope scope("writeAffeModele");
 	out << "MODMECA=AFFE_MODELE(MAILLAGE=" << mail_name << "," << endl;
 	out << "                    AFFE=(" << endl;
 	for (auto elementSet : asterModel.model.elementSets) {
@@ -383,6 +556,7 @@ string AsterWriterImpl::writeValue(Value& value, ostream& out) {
 }
 
 void AsterWriterImpl::writeMaterials(const AsterModel& asterModel, ostream& out) {
+	Profiler::Scope scope("writeMaterials");
 
 	typedef map<int, Material*>::iterator material_it;
 	for (auto material : asterModel.model.materials) {
@@ -420,7 +594,9 @@ void AsterWriterImpl::writeMaterials(const AsterModel& asterModel, ostream& out)
 			 << elementSet->cellGroup->getName() << "'," << endl;*/
 			out << "                          _F(MATER=M" << material->getId() << ",";
 			int celem = 0;
-			if (cells.hasCellGroups()) {
+			auto listGroupIt = cellGroupNameByMaterialId.find(material->getId());
+			const bool hasListGroup = listGroupIt != cellGroupNameByMaterialId.end();
+			if (cells.hasCellGroups() || hasListGroup) {
 				out << "GROUP_MA=(";
 				for (CellGroup * cellGroup : cells.getCellGroups()) {
 					celem++;
@@ -429,17 +605,20 @@ void AsterWriterImpl::writeMaterials(const AsterModel& asterModel, ostream& out)
 						out << endl << "                             ";
 					}
 				}
+				if (hasListGroup) {
+					out << "'" << listGroupIt->second << "',";
+				}
 				out << "),";
 			}
-			if (cells.hasCells()) {
+			if (cells.hasCells() && !hasListGroup) {
 				out << "MAILLE=(";
-				for (Cell cell : cells.getCells()) {
+				cells.forEachCell([&celem, &out](const CellView& cell) {
 					celem++;
 					out << "'M" << cell.id << "',";
 					if (celem % 6 == 0) {
 						out << endl << "                             ";
 					}
-				}
+				});
 				out << "),";
 			}
 			out << ")," << endl;
@@ -453,6 +632,7 @@ void AsterWriterImpl::writeMaterials(const AsterModel& asterModel, ostream& out)
 }
 
 void AsterWriterImpl::writeAffeCaraElem(const AsterModel& asterModel, ostream& out) {
+	Profiler::Scope scope("writeAffeCaraElem");
 	calc_sigm = false;
 	if (asterModel.model.elementSets.size() > 0) {
 		out << "CAEL=AFFE_CARA_ELEM(MODELE=MODMECA," << endl;
@@ -622,6 +802,7 @@ void AsterWriterImpl::writeAffeCaraElemPoutre(const ElementSet& elementSet, ostr
 }
 
 void AsterWriterImpl::writeAffeCharMeca(const AsterModel& asterModel, ostream& out) {
+	Profiler::Scope scope("writeAffeCharMeca");
 	for (auto it : asterModel.model.constraintSets) {
 		ConstraintSet& constraintSet = *it;
 		if (constraintSet.getConstraints().size() == 0) {
@@ -667,6 +848,7 @@ void AsterWriterImpl::writeAffeCharMeca(const AsterModel& asterModel, ostream& o
 }
 
 void AsterWriterImpl::writeDefiContact(const AsterModel& asterModel, ostream& out) {
+	Profiler::Scope scope("writeDefiContact");
 	for (auto it : asterModel.model.constraintSets) {
 		ConstraintSet& constraintSet = *it;
 		const set<shared_ptr<Constraint>> gaps = constraintSet.getConstraintsByType(
@@ -763,7 +945,10 @@ void AsterWriterImpl::writeSPC(const AsterModel& asterModel, const ConstraintSet
 						<< endl;
 			} else {
 				out << "                             _F(";
-				if (spc->group == nullptr) {
+				auto listGroupIt = nodeGroupNameBySpcId.find(spc->getId());
+				if (listGroupIt != nodeGroupNameBySpcId.end()) {
+					out << "GROUP_NO='" << listGroupIt->second << "',";
+				} else if (spc->group == nullptr) {
 					out << "NOEUD=(";
 					for (int nodePosition : spc->nodePositions()) {
 						out << "'"
@@ -1139,18 +1324,23 @@ void AsterWriterImpl::writeForceSurface(const LoadSet& loadSet, ostream&out) {
 }
 
 void AsterWriterImpl::writeCellContainer(const CellContainer& cellContainer, ostream& out) {
-	if (cellContainer.hasCellGroups()) {
+	auto listGroupIt = cellGroupNameByContainer.find(&cellContainer);
+	const bool hasListGroup = listGroupIt != cellGroupNameByContainer.end();
+	if (cellContainer.hasCellGroups() || hasListGroup) {
 		out << "GROUP_MA=(";
 		for (CellGroup* cellGroup : cellContainer.getCellGroups()) {
 			out << "'" << cellGroup->getName() << "',";
 		}
+		if (hasListGroup) {
+			out << "'" << listGroupIt->second << "',";
+		}
 		out << "),";
 	}
-	if (cellContainer.hasCells()) {
+	if (cellContainer.hasCells() && !hasListGroup) {
 		out << "MAILLE=(";
-		for (Cell& cell : cellContainer.getCells()) {
+		cellContainer.forEachCell([&out](const CellView& cell) {
 			out << "'" << cell.getMedName() << "',";
-		}
+		});
 		out << "),";
 	}
 }
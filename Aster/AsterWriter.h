@@ -28,6 +28,41 @@ namespace aster {
 class AsterWriterImpl {
 	string mail_name, sigm_noeu, sigm_elno, sief_elga;
 	bool calc_sigm = false;
+	/**
+	 * Groups created by createNameListGroups, by SPC id, by loading and by material id.
+	 */
+	map<int, string> nodeGroupNameBySpcId;
+	map<const CellContainer*, string> cellGroupNameByContainer;
+	map<int, string> cellGroupNameByMaterialId;
+	/**
+	 * The groups themselves, written in the MED file but not added to the mesh of the model.
+	 */
+	vector<unique_ptr<NodeGroup>> nameListNodeGroups;
+	vector<unique_ptr<CellGroup>> nameListCellGroups;
+
+	/**
+	 * Creates a detached group of the mesh for each set of nodes or cells larger than
+	 * maxNameListSize that would be listed by names in the command file. The groups are
+	 * written in the MED file, the command file only references them by name.
+	 */
+	void createNameListGroups(const Model& model, unsigned int maxNameListSize);
+	/**
+	 * Name of a new group, made unique by a suffix if needed among the groups of the mesh
+	 * and the name list groups.
+	 */
+	string newGroupName(const Mesh& mesh, const string& prefix, int id) const;
+	/**
+	 * Writes the mesh of the model and the name list groups, and the debug messages of the
+	 * mesh to messages.
+	 */
+	void writeMED(const AsterModel& asterModel, const string& med_path,
+			std::ostream& messages = std::cout) const;
+	/**
+	 * Writes the MED file on another thread while the command file is rendered in memory,
+	 * then writes the command file to out. The command file only reads the model. The
+	 * messages of the MED file are printed once both are written.
+	 */
+	void writeMEDAndComm(const AsterModel& asterModel, const string& med_path, std::ostream& out);
 
 	void writeExport(AsterModel& model, std::ostream&);
 	void writeComm(const AsterModel& model, std::ostream&);
@@ -63,6 +98,15 @@ class AsterWriterImpl {
 	void writeAnalyses(const AsterModel& asterModel, std::ostream& out);
 
 public:
+	/**
+	 * Longest group name accepted by Code_Aster.
+	 */
+	static const size_t MAX_GROUP_NAME_LENGTH = 24;
+	/**
+	 * The name itself if it is short enough for Code_Aster, else its beginning followed by
+	 * a hash of the whole name.
+	 */
+	static string asterGroupName(const string& name);
 	AsterWriterImpl();
 	virtual ~AsterWriterImpl();
 	string writeModel(const std::shared_ptr<Model> model_ptr, const ConfigurationParameters&);
@@ -15,12 +15,16 @@
 #include "../Systus/SystusWriter.h"
 #include "../Systus/SystusRunner.h"
 #include "../ResultReaders/ResultReadersFacade.h"
+#include "../Abstract/ModelSnapshot.h"
+#include "../Abstract/Profiler.h"
 #include <iostream>
 #include <fstream>
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/lexical_cast.hpp>
 #include <iterator>
+#include <thread>
+#include <algorithm>
 #include <ciso646>
 
 namespace fs = boost::filesystem;
@@ -103,17 +107,34 @@ VegaCommandLine::ExitCode VegaCommandLine::convertStudy(
         cout << "Selected writer: " << *writer << endl;
     }
 
-    Parser* parser = parserIterator->second;
-    shared_ptr<Model> model = parser->parse(configuration);
-
-    //adding assertions if result file is set in the model
-    shared_ptr<ResultReader> resultReader = result::ResultReadersFacade::getResultReader(
-            configuration);
-    if (resultReader) {
-        resultReader->add_assertions(configuration, model);
+    unique_ptr<ModelSnapshot> snapshot;
+    shared_ptr<Model> model;
+    if (!configuration.modelCacheDirectory.empty()) {
+        snapshot.reset(new ModelSnapshot(configuration));
+        if (snapshot->isValid()) {
+            Profiler::Scope scope("loadModelSnapshot");
+            model = snapshot->load();
+        }
     }
 
-    model->finish();
+    if (model == nullptr) {
+        Parser* parser = parserIterator->second;
+        model = parser->parse(configuration);
+
+        //adding assertions if result file is set in the model
+        shared_ptr<ResultReader> resultReader = result::ResultReadersFacade::getResultReader(
+                configuration);
+        if (resultReader) {
+            Profiler::Scope scope("addAssertions");
+            resultReader->add_assertions(configuration, model);
+        }
+
+        model->finish();
+        if (snapshot) {
+            Profiler::Scope scope("writeModelSnapshot");
+            snapshot->write(*model);
+        }
+    }
     bool validationResult = model->validate();
     if (!validationResult
             && configuration.translationMode == ConfigurationParameters::MODE_STRICT) {
@@ -121,6 +142,7 @@ VegaCommandLine::ExitCode VegaCommandLine::convertStudy(
         return MODEL_VALIDATION_ERROR;
     }
 
+    Profiler::Scope scope("write");
     string modelFile = writer->writeModel(model, configuration);
     modelFileOut.append(modelFile);
     return OK;
@@ -146,6 +168,15 @@ fs::path VegaCommandLine::normalize_path(string strpath) {
     return fs::path(strpath).make_preferred();
 }
 
+void VegaCommandLine::writeProfile(const fs::path& profilePath) {
+    ofstream profileFile(profilePath.string());
+    if (!profileFile) {
+        cerr << "Profile " << profilePath << " can't be written." << endl;
+    } else {
+        Profiler::instance().writeJson(profileFile);
+    }
+}
+
 ConfigurationParameters VegaCommandLine::readCommandLineParameters(const po::variables_map& vm) {
     LogLevel logLevel = LogLevel::INFO;
     if (vm.count("debug") > 0) {
@@ -237,9 +268,43 @@ ConfigurationParameters VegaCommandLine::readCommandLineParameters(const po::var
         solverServer = vm["solver-server"].as<string>();
         boost::algorithm::trim(solverServer);
     }
+    unsigned int parserThreads = 1;
+    if (vm.count("parser-threads")) {
+        parserThreads = vm["parser-threads"].as<unsigned int>();
+        if (parserThreads == 0) {
+            parserThreads = max(1u, thread::hardware_concurrency());
+        }
+    }
+    unsigned int finishThreads = 1;
+    if (vm.count("finish-threads")) {
+        finishThreads = vm["finish-threads"].as<unsigned int>();
+        if (finishThreads == 0) {
+            finishThreads = max(1u, thread::hardware_concurrency());
+        }
+    }
+    unsigned int writerThreads = 1;
+    if (vm.count("writer-threads")) {
+        writerThreads = vm["writer-threads"].as<unsigned int>();
+        if (writerThreads == 0) {
+            writerThreads = max(1u, thread::hardware_concurrency());
+        }
+    }
+    bool concurrentMedWrite = false;
+    if (vm.count("concurrent-med")) {
+        concurrentMedWrite = true;
+    }
+    unsigned int maxNameListSize = 1000;
+    if (vm.count("max-name-list")) {
+        maxNameListSize = vm["max-name-list"].as<unsigned int>();
+    }
+    fs::path modelCacheDirectory;
+    if (vm.count("model-cache")) {
+        modelCacheDirectory = normalize_path(vm["model-cache"].as<string>());
+    }
     ConfigurationParameters configuration = ConfigurationParameters(inputFile.string(), solver,
             solverVersion, modelName, outputDir, logLevel, translationMode, testFnamePath,
-            tolerance, runSolver, solverServer, solverCommand);
+            tolerance, runSolver, solverServer, solverCommand, parserThreads, modelCacheDirectory,
+            finishThreads, writerThreads, maxNameListSize, concurrentMedWrite);
     return configuration;
 }
 
@@ -314,6 +379,26 @@ VegaCommandLine::ExitCode VegaCommandLine::process(int ac, const char* av[]) {
         ("debug,d", "set debug options in solvers, verbose output") //
         ("solver-version", po::value<string>(), "output solver specific version") //
         ("tolerance,x", po::value<double>(), "use TOLERANCE during tests.") //
+        ("parser-threads,j", po::value<unsigned int>(),
+                "read the GRID and element cards of the input model on PARSER-THREADS threads, "
+                "0 to use all the cores.") //
+        ("finish-threads", po::value<unsigned int>(),
+                "run the independent passes completing the model on FINISH-THREADS threads, "
+                "0 to use all the cores. The passes run in sequence by default.") //
+        ("writer-threads", po::value<unsigned int>(),
+                "render the nodes and elements of the output files on WRITER-THREADS threads, "
+                "0 to use all the cores.") //
+        ("concurrent-med", "write the Code_Aster MED file on its own thread while the command "
+                "file is rendered.") //
+        ("max-name-list", po::value<unsigned int>(),
+                "write the sets of more than MAX-NAME-LIST nodes or cells as groups of the mesh "
+                "instead of listing their names in the Code_Aster command file (default 1000).") //
+        ("model-cache", po::value<string>(),
+                "keep the finished model in MODEL-CACHE directory, and reuse it instead of "
+                "parsing the input files while they are unchanged.") //
+        ("profile", po::value<string>(),
+                "write the duration, memory and allocations of each translation phase "
+                "in PROFILE file, as JSON.") //
         ("best-effort,b", "All the recognized keywords in the source file are "
                 "translated, unknown keywords are skipped.") //
         ("mesh-at-least,m", "If the source study is fully understood it is translated, "
@@ -402,10 +487,27 @@ VegaCommandLine::ExitCode VegaCommandLine::process(int ac, const char* av[]) {
             string inputSolverString = vm["input-format"].as<string>();
             inputFormat = Solver::fromString(inputSolverString);
         }
+        if (vm.count("profile")) {
+            Profiler::instance().enable();
+        }
+        const fs::path profilePath =
+                vm.count("profile") ? normalize_path(vm["profile"].as<string>()) : fs::path();
         string modelFile;
-        result = convertStudy(configuration, modelFile, inputFormat);
-        if (result == OK && configuration.runSolver) {
-            result = runSolver(configuration, modelFile);
+        try {
+            result = convertStudy(configuration, modelFile, inputFormat);
+            if (result == OK && configuration.runSolver) {
+                Profiler::Scope scope("runSolver");
+                result = runSolver(configuration, modelFile);
+            }
+        } catch (...) {
+            // the phases run until the failure, their scopes being closed by now
+            if (!profilePath.empty()) {
+                writeProfile(profilePath);
+            }
+            throw;
+        }
+        if (!profilePath.empty()) {
+            writeProfile(profilePath);
         }
     } catch (invalid_argument &e) {
         cerr << "\n Invalid argument:" << e.what() << "\n";
@@ -54,6 +54,10 @@ private:
     static void printHelp(const po::options_description& visible);
     std::string expand_user(std::string path);
     static fs::path normalize_path(std::string path);
+    /**
+     * Writes the phases measured by the Profiler, also when the conversion has failed.
+     */
+    static void writeProfile(const fs::path& profilePath);
     std::unordered_map<SolverName, Parser *, std::hash<int>> parserBySolverName;
     std::unordered_map<SolverName, Writer *, std::hash<int>> writersBySolverName;
     std::unordered_map<SolverName, Runner *, std::hash<int>> runnerBySolverType;
@@ -14,13 +14,57 @@
 
 #include "build_properties.h"
 #include "VegaCommandLine.h"
+#include "../Abstract/Profiler.h"
 #include <clocale>
 #include <cstdlib>
 #include <iostream>
+#include <new>
 
 using namespace vega;
 using namespace std;
 
+/*
+ * Allocation functions counting the allocations for the --profile report. They only
+ * forward to malloc when the profiler is disabled.
+ */
+void* operator new(size_t size) {
+    Profiler::countAllocation(size);
+    void* pointer = malloc(size == 0 ? 1 : size);
+    if (pointer == nullptr) {
+        throw bad_alloc();
+    }
+    return pointer;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept {
+    Profiler::countAllocation(size);
+    return malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](size_t size, const nothrow_t&) noexcept {
+    return operator new(size, nothrow);
+}
+
+void operator delete(void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete(void* pointer, const nothrow_t&) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void* pointer, const nothrow_t&) noexcept {
+    free(pointer);
+}
+
 int main(int ac, const char* av[]) {
     //workaround for https://svn.boost.org/trac/boost/ticket/5928
     setlocale(LC_ALL, "C");
@@ -10,11 +10,13 @@
  */
 
 #include "NastranParser.h"
+#include "../Abstract/Profiler.h"
 #include <boost/unordered_map.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <boost/tokenizer.hpp>
 #include <boost/lexical_cast.hpp>
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -48,6 +50,13 @@ const set<string> NastranParserImpl::IGNORED_KEYWORDS = {
 		"ENDDATA"
 };
 
+const set<string> NastranParserImpl::GEOMETRY_KEYWORDS = {
+		"GRID", "CHEXA", "CPENTA", "CPYRAMID", "CQUAD", "CTETRA", //
+		"CQUAD4", "CQUADR", "CQUAD8", "CTRIA3", "CTRIAR", "CTRIA6"
+};
+
+const size_t NastranParserImpl::GEOMETRY_BATCH_SIZE;
+
 const unordered_map<string, NastranParserImpl::parseElementFPtr> NastranParserImpl::PARSE_FUNCTION_BY_KEYWORD =
 		{
 				{ "CBAR", &NastranParserImpl::parseCBAR },
@@ -278,9 +287,18 @@ void NastranParserImpl::parseExecutiveSection(NastranTokenizer& tok, shared_ptr<
 
 void NastranParserImpl::parseBULKSection(NastranTokenizer &tok, shared_ptr<Model> model) {
 
+	const bool parallel = parserThreads > 1 && tok.isMapped();
+	bool serialCard = false;
 	while (tok.nextSymbolType == NastranTokenizer::SYMBOL_KEYWORD) {
+		const NastranTokenizer::Card card = parallel ? tok.currentCard() : NastranTokenizer::Card();
 		string keyword = tok.nextSymbolString();
 		trim(keyword);
+		if (parallel && !serialCard && GEOMETRY_KEYWORDS.find(keyword) != GEOMETRY_KEYWORDS.end()) {
+			tok.rewind(card);
+			serialCard = !parseGeometryCards(tok, model);
+			continue;
+		}
+		serialCard = false;
 		unordered_map<string, NastranParserImpl::parseElementFPtr>::const_iterator parseFunctionFptrKeywordPair;
 		//TODO: move these to the map
 		if (keyword == "CQUAD4" || keyword == "CQUADR") {
@@ -333,6 +351,68 @@ void NastranParserImpl::parseBULKSection(NastranTokenizer &tok, shared_ptr<Model
 
 }
 
+bool NastranParserImpl::parseGeometryCards(NastranTokenizer &tok, shared_ptr<Model> model) {
+	// first pass: find the boundaries of the cards, only the threads split them into fields
+	vector<NastranTokenizer::Card> cards;
+	tok.locateCards(GEOMETRY_KEYWORDS, GEOMETRY_BATCH_SIZE, cards);
+
+	// second pass: each thread reads a contiguous slice of cards
+	vector<GeometryCard> geometryCards(cards.size());
+	const size_t sliceCount = geometryWorkers ? geometryWorkers->threads() : 1;
+	const function<void(size_t)> readSlice =
+			[this, &cards, &geometryCards, &tok, sliceCount](size_t slice) {
+				const size_t end = cards.size() * (slice + 1) / sliceCount;
+				for (size_t i = cards.size() * slice / sliceCount; i < end; i++) {
+					readGeometryCard(cards[i], tok.fileName, geometryCards[i]);
+				}
+			};
+	if (geometryWorkers) {
+		geometryWorkers->run(sliceCount, readSlice);
+	} else {
+		readSlice(0);
+	}
+
+	size_t parsedCount = 0;
+	while (parsedCount < geometryCards.size() && geometryCards[parsedCount].parsed) {
+		parsedCount++;
+	}
+	const bool complete = parsedCount == geometryCards.size();
+	if (!complete) {
+		tok.rewind(cards[parsedCount]);
+	}
+	geometryCards.resize(parsedCount);
+	// the diagnostics of the threads are reported after them, in the order of the input file
+	for (const GeometryCard& geometryCard : geometryCards) {
+		if (!geometryCard.diagnostic.empty()) {
+			cerr << geometryCard.diagnostic << endl;
+		}
+	}
+	addGeometryCards(geometryCards, model);
+	return complete;
+}
+
+void NastranParserImpl::addGeometryCards(const vector<GeometryCard>& geometryCards,
+		shared_ptr<Model> model) {
+	// the model is filled sequentially, in the order of the input file
+	for (const GeometryCard& geometryCard : geometryCards) {
+		if (geometryCard.cellType == nullptr) {
+			model->mesh->addNode(geometryCard.id, geometryCard.x1, geometryCard.x2,
+					geometryCard.x3, geometryCard.cd, geometryCard.cp);
+			if (geometryCard.ps) {
+				addNodeSpc(geometryCard.id, geometryCard.ps, model);
+			}
+			if (this->logLevel >= LogLevel::TRACE) {
+				cout << fixed << "GRID " << geometryCard.id << ":" << geometryCard.x1 << ";"
+						<< geometryCard.x2 << ";" << geometryCard.x3 << endl;
+			}
+		} else {
+			model->mesh->addCell(geometryCard.id, *geometryCard.cellType,
+					geometryCard.connectivity);
+			addProperty(geometryCard.propertyId, geometryCard.id, model);
+		}
+	}
+}
+
 fs::path NastranParserImpl::findModelFile(const string& filename) {
 	if (!fs::exists(filename)) {
 		throw invalid_argument("Can't find file : " + fs::absolute(filename).string());
@@ -341,9 +421,35 @@ fs::path NastranParserImpl::findModelFile(const string& filename) {
 	return inputFilePath;
 }
 
+namespace {
+
+/**
+ * Empties the SPC and SPCD cards not yet added to the model at the end of a scope, even when
+ * it is left by an exception.
+ */
+template<class SpcdCards>
+class SpcCardsReset final {
+	SinglePointConstraintTable& spcTable;
+	SpcdCards& spcdCards;
+public:
+	SpcCardsReset(SinglePointConstraintTable& spcTable, SpcdCards& spcdCards) :
+			spcTable(spcTable), spcdCards(spcdCards) {
+	}
+	SpcCardsReset(const SpcCardsReset&) = delete;
+	SpcCardsReset& operator=(const SpcCardsReset&) = delete;
+	~SpcCardsReset() {
+		spcTable.clear();
+		spcdCards.clear();
+	}
+};
+
+}
+
 shared_ptr<Model> NastranParserImpl::parse(const ConfigurationParameters& configuration) {
+	Profiler::Scope scope("parse");
 	this->translationMode = configuration.translationMode;
 	this->logLevel = configuration.logLevel;
+	this->parserThreads = max(1u, configuration.parserThreads);
 
 	const string filename = configuration.inputFile;
 
@@ -352,14 +458,30 @@ shared_ptr<Model> NastranParserImpl::parse(const ConfigurationParameters& config
 	shared_ptr<Model> model = shared_ptr<Model>(new Model(modelName, "UNKNOWN", NASTRAN,
 			configuration.getModelConfiguration()));
 	map<string, string> executive_section_context;
-	ifstream istream(inputFilePath.c_str());
-	NastranTokenizer tok = NastranTokenizer(istream, logLevel, inputFilePath.string());
+	// the SPC cards of an interrupted parsing must not be added to the next model
+	const SpcCardsReset<vector<SpcdCard>> spcCardsReset(spcTable, spcdCards);
+	NastranTokenizer tok(inputFilePath, logLevel);
+	// kept for all the batches of geometry cards
+	geometryWorkers.reset(parserThreads > 1 ? new WorkerPool(parserThreads) : nullptr);
+	model->inputFiles.push_back(inputFilePath);
 
-	parseExecutiveSection(tok, model, executive_section_context);
+	{
+		Profiler::Scope executiveScope("parseExecutiveSection");
+		parseExecutiveSection(tok, model, executive_section_context);
+	}
 
 	tok.bulkSection();
-	parseBULKSection(tok, model);
-	istream.close();
+	{
+		Profiler::Scope bulkScope("parseBULKSection");
+		parseBULKSection(tok, model);
+	}
+	geometryWorkers.reset();
+	flushSpcTable(tok, model);
+	for (const SpcdCard& card : spcdCards) {
+		applySPCD(card, model);
+	}
+	// the results read before finishing the model (F06 assertions) need global coordinates
+	model->transformLocalNodePositions();
 
 	return model;
 }
@@ -632,7 +754,7 @@ void NastranParserImpl::parseCONM2(NastranTokenizer& tok, shared_ptr<Model> mode
 	int cellPosition = model->mesh->addCell(elemId, CellType::POINT1, { g });
 	string mn = string("MN") + lexical_cast<string>(elemId);
 	CellGroup* mnodale = model->mesh->createCellGroup(mn);
-	mnodale->addCell(model->mesh->findCell(cellPosition).id);
+	mnodale->addCellByPosition(cellPosition);
 	nodalMass.assignCellGroup(mnodale);
 	nodalMass.assignMaterial(model->getVirtualMaterial());
 
@@ -762,10 +884,10 @@ void NastranParserImpl::parseInclude(NastranTokenizer& tok, shared_ptr<Model> mo
 		fileName = fileName.substr(1, fileName.size() - 2);
 	fs::path currentFname(tok.fileName);
 	fs::path includePath = currentFname.parent_path() / fileName;
+	model->inputFiles.push_back(includePath);
 	if (fs::exists(includePath)) {
 		const string includePathStr = includePath.string();
-		ifstream istream(includePathStr);
-		NastranTokenizer tok2 = NastranTokenizer(istream, this->logLevel, includePathStr);
+		NastranTokenizer tok2(includePath, this->logLevel);
 		tok2.bulkSection();
 		try {
 			parseBULKSection(tok2, model);
@@ -776,7 +898,6 @@ void NastranParserImpl::parseInclude(NastranTokenizer& tok, shared_ptr<Model> mo
 						tok.fileName, tok.lineNumber);
 			}
 		}
-		istream.close();
 	} else {
 		cerr << "File " << includePath << " included by " << tok.fileName << " at line "
 				<< tok.lineNumber << " can not be found" << endl;
@@ -1459,13 +1580,8 @@ void NastranParserImpl::parseSPC(NastranTokenizer& tok, shared_ptr<Model> model)
 			//if (displacement != 0.0) {
 			//	handleParsingError(string("Displacement ") + boost::lexical_cast<string>(displacement) + "(!= 0) not supported", tok, model);
 			//}
-			SinglePointConstraint spc = SinglePointConstraint(*model, DOFS::nastranCodeToDOFS(gi),
-					displacement);
-			spc.addNodeId(nodeId);
-
-			model->add(spc);
-			model->addConstraintIntoConstraintSet(spc,
-					Reference<ConstraintSet>(ConstraintSet::SPC, spcSet_id));
+			spcTable.add(spcSet_id, model->mesh->findOrReserveNode(nodeId),
+					DOFS::nastranCodeToDOFS(gi), displacement);
 		}
 	} catch (ParsingException &e) {
 		handleParseException(e, model, "Problem parsing SPC");
@@ -1499,28 +1615,48 @@ void NastranParserImpl::parseSPC1(NastranTokenizer& tok, shared_ptr<Model> model
 	}
 
 	spc.group = spcNodeGroup;
-	model->add(spc);
+	spcTable.add(set_id, spc);
+}
 
-	model->addConstraintIntoConstraintSet(spc,
-			Reference<ConstraintSet>(ConstraintSet::SPC, set_id));
+void NastranParserImpl::flushSpcTable(NastranTokenizer& tok, shared_ptr<Model> model) {
+	if (spcTable.empty()) {
+		return;
+	}
+	Profiler::Scope scope("flushSpcTable");
+	for (const string& conflict : spcTable.conflicts(*model)) {
+		handleParsingError(conflict, tok, model);
+	}
+	spcTable.flush(*model);
 }
 
 void NastranParserImpl::parseSPCD(NastranTokenizer& tok, shared_ptr<Model> model) {
-	int set_id = tok.nextInt();
-	const int g1 = tok.nextInt();
-	const int c1 = tok.nextInt();
-	const double d1 = tok.nextDouble();
-	int g1pos = model->mesh->findNodePosition(g1);
-	int g2 = -1;
-	int c2;
-	double d2;
-	int g2pos = -1;
+	SpcdCard card;
+	card.setId = tok.nextInt();
+	card.g1 = tok.nextInt();
+	card.c1 = tok.nextInt();
+	card.d1 = tok.nextDouble();
+	card.g2 = -1;
+	card.c2 = 0;
+	card.d2 = 0;
 	if (tok.isNextInt()) {
-		g2 = tok.nextInt();
-		c2 = tok.nextInt();
-		d2 = tok.nextDouble();
-		g2pos = model->mesh->findNodePosition(g2);
+		card.g2 = tok.nextInt();
+		card.c2 = tok.nextInt();
+		card.d2 = tok.nextDouble();
 	}
+	spcdCards.push_back(card);
+	UNUSEDV(model);
+}
+
+void NastranParserImpl::applySPCD(const SpcdCard& card, shared_ptr<Model> model) {
+	const int set_id = card.setId;
+	const int g1 = card.g1;
+	const int c1 = card.c1;
+	const double d1 = card.d1;
+	const int g1pos = model->mesh->findNodePosition(g1);
+	const int g2 = card.g2;
+	const int c2 = card.c2;
+	const double d2 = card.d2;
+	const int g2pos = g2 != -1 ? model->mesh->findNodePosition(g2) : -1;
 	Reference<ConstraintSet> constraintSetReference(ConstraintSet::SPCD, set_id);
 	if (!model->find(constraintSetReference)) {
 		ConstraintSet constraintSet(*model, ConstraintSet::SPCD, set_id);
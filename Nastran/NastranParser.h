@@ -15,6 +15,7 @@
 #include <boost/filesystem.hpp>
 #include "../Abstract/Model.h"
 #include "../Abstract/SolverInterfaces.h"
+#include "../Abstract/WorkerPool.h"
 #include "NastranTokenizer.h"
 
 namespace vega {
@@ -38,6 +39,59 @@ private:
 		int seid;
 	};
 	GrdSet grdSet;
+	/**
+	 * A GRID or element card read by a parser thread, to be added to the model in the order
+	 * of the input file.
+	 */
+	class GeometryCard {
+	public:
+		/**
+		 * False if the card has to be parsed again by the serial parser (errors, warnings...)
+		 */
+		bool parsed = false;
+		int id = 0;
+		// GRID
+		double x1 = 0;
+		double x2 = 0;
+		double x3 = 0;
+		int cp = CoordinateSystem::GLOBAL_COORDINATE_SYSTEM_ID;
+		int cd = CoordinateSystem::GLOBAL_COORDINATE_SYSTEM_ID;
+		int ps = 0;
+		// elements, nullptr for a GRID
+		const CellType* cellType = nullptr;
+		int propertyId = 0;
+		vector<int> connectivity;
+		/**
+		 * Message to be printed once the card is added to the model.
+		 */
+		string diagnostic;
+	};
+	/**
+	 * The parserThreads threads reading the geometry cards during a parsing, nullptr if 1.
+	 */
+	std::unique_ptr<WorkerPool> geometryWorkers;
+	/**
+	 * SPC and SPC1 cards not yet added to the model, see flushSpcTable().
+	 */
+	SinglePointConstraintTable spcTable;
+	/**
+	 * An SPCD card, which overrides the SPC cards of its analyses, so is applied after them.
+	 */
+	struct SpcdCard {
+		int setId;
+		int g1;
+		int c1;
+		double d1;
+		int g2;
+		int c2;
+		double d2;
+	};
+	std::vector<SpcdCard> spcdCards;
+	/**
+	 * Number of cards read by the parser threads before adding them to the model.
+	 */
+	static const size_t GEOMETRY_BATCH_SIZE = 1 << 16;
+	static const std::set<string> GEOMETRY_KEYWORDS;
 
 	std::unordered_map<string, shared_ptr<Reference<ElementSet>>> directMatrixByName;
 	typedef void (NastranParserImpl::*parseElementFPtr)(NastranTokenizer& tok, std::shared_ptr<Model> model);
@@ -49,7 +103,25 @@ private:
 	void addCellIds(ElementLoading& loading, int eid1, int eid2);
 
 	fs::path findModelFile(const string& filename);
+	/**
+	 * Adds the SPC and SPC1 cards of the bulk section to the model, merged by constraint
+	 * set, once they are all read. The DOFS given different values in a constraint set are
+	 * parsing errors.
+	 */
+	void flushSpcTable(NastranTokenizer& tok, std::shared_ptr<Model> model);
+	void applySPCD(const SpcdCard& card, std::shared_ptr<Model> model);
 	void parseBULKSection(NastranTokenizer &tok, std::shared_ptr<Model> model1);
+	/**
+	 * Reads a batch of consecutive GRID and element cards on the geometryWorkers, then adds
+	 * them to the model in the input order. Stops before the first other keyword.
+	 *
+	 * @return false if it stopped before a card that must be parsed by parseBULKSection.
+	 */
+	bool parseGeometryCards(NastranTokenizer &tok, std::shared_ptr<Model> model);
+	void addGeometryCards(const vector<GeometryCard>& geometryCards,
+			std::shared_ptr<Model> model);
+	void readGeometryCard(const NastranTokenizer::Card& card, const string& fileName,
+			GeometryCard& geometryCard) const;//in NastranParser_geometry.cpp
 
 	void parseExecutiveSection(NastranTokenizer& tok, std::shared_ptr<Model> model, map<string, string>& context);
 	/**Renumbers the nodes
@@ -149,6 +221,7 @@ private:
 	void parseCBAR(NastranTokenizer& tok, std::shared_ptr<Model> model); //in NastranParser_geometry.cpp
 	void parseCBEAM(NastranTokenizer& tok, std::shared_ptr<Model> model);//in NastranParser_geometry.cpp
 	void parseElem(NastranTokenizer& tok, std::shared_ptr<Model> model, vector<CellType>);//in NastranParser_geometry.cpp
+	void readElem(NastranTokenizer& tok, vector<CellType> cellTypes, GeometryCard& card) const;//in NastranParser_geometry.cpp
 	void parseCELAS2(NastranTokenizer& tok, std::shared_ptr<Model> model);
 	void parseCELAS4(NastranTokenizer& tok, std::shared_ptr<Model> model);
 	void parseCGAP(NastranTokenizer& tok, std::shared_ptr<Model> model);//in NastranParser_geometry.cpp
@@ -205,12 +278,18 @@ private:
 	 * Parse cells in standard form: CTRIA3,CTRIAR,QUAD4
 	 */
 	void parseShellElem(NastranTokenizer& tok, std::shared_ptr<Model> model, CellType cellType); //in NastranParser_geometry.cpp
+	/**
+	 * Reads the fields of a shell element.
+	 * @return true if the card uses unsupported fields (theta, zoffs, tflag).
+	 */
+	bool readShellElem(NastranTokenizer& tok, CellType cellType, GeometryCard& card) const; //in NastranParser_geometry.cpp
 	void parseSPC(NastranTokenizer& tok, std::shared_ptr<Model> model);
 	void parseSPC1(NastranTokenizer& tok, std::shared_ptr<Model> model);
 	void parseSPCD(NastranTokenizer& tok, std::shared_ptr<Model> model);
 	string parseSubcase(NastranTokenizer& tok, std::shared_ptr<Model> model, map<string, string> context);
 
 	void addProperty(int property_id, int cell_id, std::shared_ptr<Model> model);//in NastranParser_geometry.cpp
+	void addNodeSpc(int id, int ps, std::shared_ptr<Model> model);//in NastranParser_geometry.cpp
 	CellGroup* getOrCreateGroup(int property_id, std::shared_ptr<Model> model);//in NastranParser_geometry.cpp
 
 	void handleParseException(vega::ParsingException &e, std::shared_ptr<Model> model, string message = "");
@@ -224,6 +303,11 @@ private:
 	 */
 	ConfigurationParameters::TranslationMode translationMode;
 	LogLevel logLevel = LogLevel::INFO;
+	/**
+	 * Threads reading the geometry cards. The cards are read sequentially if 1, or if the
+	 * input is not a memory mapped file.
+	 */
+	unsigned int parserThreads = 1;
 public:
 	NastranParserImpl();
 	virtual ~NastranParserImpl();
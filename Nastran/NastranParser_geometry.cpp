@@ -61,21 +61,15 @@ void NastranParserImpl::parseGRDSET(NastranTokenizer& tok, shared_ptr<Model> mod
 void NastranParserImpl::parseGRID(NastranTokenizer& tok, shared_ptr<Model> model) {
 	int id = tok.nextInt();
 	int cp = tok.nextInt(true, grdSet.cp);
-	if (cp != CoordinateSystem::GLOBAL_COORDINATE_SYSTEM_ID)
-		handleParsingError("GRID CP coordinate system not supported", tok, model);
-
+	// coordinates in cp are made global by Model::finish
 	double x1 = tok.nextDouble();
 	double x2 = tok.nextDouble();
 	double x3 = tok.nextDouble();
 	int cd = tok.nextInt(true, grdSet.cd);
-	model->mesh->addNode(id, x1, x2, x3, cd);
+	model->mesh->addNode(id, x1, x2, x3, cd, cp);
 	int ps = tok.nextInt(true, grdSet.ps);
 	if (ps) {
-		string spcName = string("SPC") + lexical_cast<string>(id);
-		SinglePointConstraint spc = SinglePointConstraint(*model, DOFS::nastranCodeToDOFS(ps));
-		spc.addNodeId(id);
-		model->add(spc);
-		model->addConstraintIntoConstraintSet(spc, model->commonConstraintSet);
+		addNodeSpc(id, ps, model);
 	}
 
 	if (this->logLevel >= LogLevel::TRACE) {
@@ -83,6 +77,57 @@ void NastranParserImpl::parseGRID(NastranTokenizer& tok, shared_ptr<Model> model
 	}
 }
 
+void NastranParserImpl::addNodeSpc(int id, int ps, shared_ptr<Model> model) {
+	SinglePointConstraint spc = SinglePointConstraint(*model, DOFS::nastranCodeToDOFS(ps));
+	spc.addNodeId(id);
+	model->add(spc);
+	model->addConstraintIntoConstraintSet(spc, model->commonConstraintSet);
+}
+
+void NastranParserImpl::readGeometryCard(const NastranTokenizer::Card& card,
+		const string& fileName, GeometryCard& geometryCard) const {
+	try {
+		NastranTokenizer tok(card, fileName);
+		string keyword = tok.nextSymbolString();
+		boost::trim(keyword);
+		bool unsupportedFields = false;
+		if (keyword == "GRID") {
+			geometryCard.id = tok.nextInt();
+			geometryCard.cp = tok.nextInt(true, grdSet.cp);
+			geometryCard.x1 = tok.nextDouble();
+			geometryCard.x2 = tok.nextDouble();
+			geometryCard.x3 = tok.nextDouble();
+			geometryCard.cd = tok.nextInt(true, grdSet.cd);
+			geometryCard.ps = tok.nextInt(true, grdSet.ps);
+		} else if (keyword == "CQUAD4" || keyword == "CQUADR") {
+			unsupportedFields = readShellElem(tok, CellType::QUAD4, geometryCard);
+		} else if (keyword == "CQUAD8") {
+			unsupportedFields = readShellElem(tok, CellType::QUAD8, geometryCard);
+		} else if (keyword == "CTRIA3" || keyword == "CTRIAR") {
+			unsupportedFields = readShellElem(tok, CellType::TRI3, geometryCard);
+		} else if (keyword == "CTRIA6") {
+			unsupportedFields = readShellElem(tok, CellType::TRI6, geometryCard);
+		} else if (keyword == "CHEXA") {
+			readElem(tok, { CellType::HEXA8, CellType::HEXA20 }, geometryCard);
+		} else if (keyword == "CPENTA") {
+			readElem(tok, { CellType::PENTA6, CellType::PENTA15 }, geometryCard);
+		} else if (keyword == "CPYRAMID") {
+			readElem(tok, { CellType::PYRA5, CellType::PYRA13 }, geometryCard);
+		} else if (keyword == "CQUAD") {
+			readElem(tok, { CellType::QUAD4, CellType::QUAD8, CellType::QUAD9 }, geometryCard);
+		} else if (keyword == "CTETRA") {
+			readElem(tok, { CellType::TETRA4, CellType::TETRA10 }, geometryCard);
+		} else {
+			return;
+		}
+		// anything to report is left to the serial parser
+		geometryCard.parsed = !unsupportedFields
+				&& !(tok.nextSymbolType == NastranTokenizer::SYMBOL_FIELD && !tok.isNextEmpty());
+	} catch (...) {
+		geometryCard.parsed = false;
+	}
+}
+
 void NastranParserImpl::addProperty(int property_id, int cell_id, shared_ptr<Model> model) {
 	CellGroup* cellGroup = getOrCreateGroup(property_id, model);
 	cellGroup->addCell(cell_id);
@@ -165,6 +210,14 @@ void NastranParserImpl::parseCBEAM(NastranTokenizer& tok, shared_ptr<Model> mode
 
 void NastranParserImpl::parseElem(NastranTokenizer& tok, shared_ptr<Model> model,
 								  vector<CellType> cellTypes) {
+	GeometryCard card;
+	readElem(tok, cellTypes, card);
+	model->mesh->addCell(card.id, *card.cellType, card.connectivity);
+	addProperty(card.propertyId, card.id, model);
+}
+
+void NastranParserImpl::readElem(NastranTokenizer& tok, vector<CellType> cellTypes,
+		GeometryCard& card) const {
 	int cell_id = tok.nextInt();
 	int property_id = tok.nextInt(true, cell_id);
 	auto it = cellTypes.begin();
@@ -189,8 +242,10 @@ void NastranParserImpl::parseElem(NastranTokenizer& tok, shared_ptr<Model> model
 		for (unsigned int i = 0; i < cellType.numNodes; i++)
 			medConnect[nastran2medNodeConnect[i]] = nastranConnect[i];
 	}
-	model->mesh->addCell(cell_id, cellType, medConnect);
-	addProperty(property_id, cell_id, model);
+	card.id = cell_id;
+	card.propertyId = property_id;
+	card.cellType = CellType::findByCode(cellType.code);
+	card.connectivity.swap(medConnect);
 }
 
 void NastranParserImpl::parseCGAP(NastranTokenizer& tok, shared_ptr<Model> model) {
@@ -268,6 +323,27 @@ void NastranParserImpl::parseCTETRA(NastranTokenizer& tok, shared_ptr<Model> mod
 
 void NastranParserImpl::parseShellElem(NastranTokenizer& tok, shared_ptr<Model> model,
 		CellType cellType) {
+	GeometryCard card;
+	const bool unsupportedFields = readShellElem(tok, cellType, card);
+	if (!card.diagnostic.empty()) {
+		cerr << card.diagnostic << endl;
+	}
+	if (unsupportedFields) {
+		const string msg = "Keywords not supported in: " + tok.currentRawDataLine();
+		if (translationMode == ConfigurationParameters::MODE_STRICT) {
+			throw ParsingException(msg, tok.fileName, tok.lineNumber);
+		} else if (translationMode == ConfigurationParameters::MESH_AT_LEAST) {
+			model->onlyMesh = true;
+		}
+		cerr << msg << " file: " << tok.fileName << " line: " << tok.lineNumber << endl;
+	}
+	model->mesh->addCell(card.id, *card.cellType, card.connectivity);
+	addProperty(card.propertyId, card.id, model);
+
+}
+
+bool NastranParserImpl::readShellElem(NastranTokenizer& tok, CellType cellType,
+		GeometryCard& card) const {
 	int cell_id = tok.nextInt();
 	int property_id = tok.nextInt(true, cell_id);
 
@@ -329,23 +405,15 @@ void NastranParserImpl::parseShellElem(NastranTokenizer& tok, shared_ptr<Model>
 
 	default:
 		//nothing
-		cerr << "not impl" << endl;
+		card.diagnostic = "not impl";
 	}
-	if (!is_equal(thetaOrMCID, NastranTokenizer::UNAVAILABLE_DOUBLE)
+	card.id = cell_id;
+	card.propertyId = property_id;
+	card.cellType = CellType::findByCode(cellType.code);
+	card.connectivity.swap(coords);
+	return !is_equal(thetaOrMCID, NastranTokenizer::UNAVAILABLE_DOUBLE)
 			|| !is_equal(zoffs, NastranTokenizer::UNAVAILABLE_DOUBLE)
-			|| tflag != NastranTokenizer::UNAVAILABLE_INT) {
-		const string msg = "Keywords not supported in: " + tok.currentRawDataLine();
-		if (translationMode == ConfigurationParameters::MODE_STRICT) {
-			throw ParsingException(msg, tok.fileName, tok.lineNumber);
-		} else if (translationMode == ConfigurationParameters::MESH_AT_LEAST) {
-			model->onlyMesh = true;
-		}
-		cerr << msg << " file: " << tok.fileName << " line: " << tok.lineNumber << endl;
-	}
-
-	model->mesh->addCell(cell_id, cellType, coords);
-	addProperty(property_id, cell_id, model);
-
+			|| tflag != NastranTokenizer::UNAVAILABLE_INT;
 }
 
 } /* namespace nastran */
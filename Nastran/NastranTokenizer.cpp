@@ -9,7 +9,6 @@
  */
 
 #include <boost/algorithm/string.hpp>
-#include <boost/tokenizer.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/lexical_cast.hpp>
 #include <iostream>
@@ -17,29 +16,221 @@
 #include <vector>
 #include <fstream>
 #include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <cstdint>
+#include <limits>
 #include "NastranTokenizer.h"
 #include "../Abstract/SolverInterfaces.h"
 #include <ciso646>
 
 using namespace std;
-using boost::tokenizer;
-using boost::offset_separator;
 using boost::lexical_cast;
 using boost::trim_copy;
 
 const int NastranTokenizer::UNAVAILABLE_INT = vega::Globals::UNAVAILABLE_INT;
 const double NastranTokenizer::UNAVAILABLE_DOUBLE = vega::Globals::UNAVAILABLE_DOUBLE;
 
+namespace {
+
+typedef NastranTokenizer::Field Field;
+
+/**
+ * Same as boost::trim_copy, without copying.
+ */
+Field trimmed(const Field& field) {
+	const char* begin = field.begin();
+	const char* end = field.end();
+	while (begin != end && isspace(static_cast<unsigned char>(*begin))) {
+		begin++;
+	}
+	while (end != begin && isspace(static_cast<unsigned char>(*(end - 1)))) {
+		end--;
+	}
+	return Field(begin, end);
+}
+
+Field trimmedRight(const Field& field) {
+	const char* end = field.end();
+	while (end != field.begin() && isspace(static_cast<unsigned char>(*(end - 1)))) {
+		end--;
+	}
+	return Field(field.begin(), end);
+}
+
+string toString(const Field& field) {
+	return string(field.begin(), field.end());
+}
+
+/**
+ * Rewrites a Nastran real in the notation understood by lexical_cast: blanks are removed,
+ * D exponents become E exponents and the E of implicit exponents ("1.5-3", "7.+4") is added.
+ */
+void normalizeReal(string& value) {
+	boost::replace_all(value, "d", "e");
+	boost::replace_all(value, "D", "E");
+	boost::algorithm::erase_all(value, " ");
+	size_t position = value.find_first_of("+-", 1);
+	if (position != string::npos and position != value.find_first_of("eE", 1) + 1) {
+		value.insert(position, "E");
+	}
+}
+
+/**
+ * Powers of ten that are exactly representable as doubles.
+ */
+const double EXACT_POWERS_OF_TEN[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+		1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+const int MAX_EXACT_POWER_OF_TEN = 22;
+const uint64_t MAX_EXACT_MANTISSA = uint64_t(1) << 53;
+const uint64_t MAX_MANTISSA_BEFORE_DIGIT = (numeric_limits<uint64_t>::max() - 9) / 10;
+
+const char* skipBlanks(const char* c, const char* end) {
+	while (c != end && *c == ' ') {
+		c++;
+	}
+	return c;
+}
+
+bool isDigit(char c) {
+	return c >= '0' && c <= '9';
+}
+
+/**
+ * Reads the digits of a mantissa, ignoring blanks.
+ * @return false if there are too many digits to be held in the mantissa.
+ */
+bool readMantissaDigits(const char*& c, const char* end, uint64_t& mantissa, int& digitCount) {
+	for (; c != end && (isDigit(*c) || *c == ' '); c++) {
+		if (*c == ' ') {
+			continue;
+		}
+		if (mantissa > MAX_MANTISSA_BEFORE_DIGIT) {
+			return false;
+		}
+		mantissa = mantissa * 10 + static_cast<uint64_t>(*c - '0');
+		digitCount++;
+	}
+	return true;
+}
+
+/**
+ * Decodes the usual Nastran reals without any allocation: [sign] digits [. digits] followed by
+ * an optional exponent (E, D or a sign alone), blanks being ignored. The result is computed
+ * exactly when the mantissa and the power of ten are exactly representable (Clinger's fast
+ * path), so that it is the correctly rounded value also returned by lexical_cast.
+ * @return false if the field must be converted by the general algorithm.
+ */
+bool decodeDoubleFastPath(const Field& field, double& result) {
+	const char* c = skipBlanks(field.begin(), field.end());
+	const char* end = field.end();
+	bool negative = false;
+	if (c != end && (*c == '+' || *c == '-')) {
+		negative = *c == '-';
+		c++;
+	}
+	uint64_t mantissa = 0;
+	int digitCount = 0;
+	if (!readMantissaDigits(c, end, mantissa, digitCount)) {
+		return false;
+	}
+	int exponent = 0;
+	if (c != end && *c == '.') {
+		c++;
+		const int integerDigitCount = digitCount;
+		if (!readMantissaDigits(c, end, mantissa, digitCount)) {
+			return false;
+		}
+		exponent -= digitCount - integerDigitCount;
+	}
+	if (digitCount == 0) {
+		return false;
+	}
+	if (c != end) {
+		if (*c == 'E' || *c == 'e' || *c == 'D' || *c == 'd') {
+			c = skipBlanks(c + 1, end);
+		} else if (*c != '+' && *c != '-') {
+			return false;
+		}
+		bool negativeExponent = false;
+		if (c != end && (*c == '+' || *c == '-')) {
+			negativeExponent = *c == '-';
+			c = skipBlanks(c + 1, end);
+		}
+		int explicitExponent = 0;
+		int exponentDigitCount = 0;
+		for (; c != end && (isDigit(*c) || *c == ' '); c++) {
+			if (*c == ' ') {
+				continue;
+			}
+			if (++exponentDigitCount > 4) {
+				return false;
+			}
+			explicitExponent = explicitExponent * 10 + (*c - '0');
+		}
+		if (c != end || exponentDigitCount == 0) {
+			return false;
+		}
+		exponent += negativeExponent ? -explicitExponent : explicitExponent;
+	}
+	if (mantissa == 0) {
+		result = negative ? -0.0 : 0.0;
+		return true;
+	}
+	if (mantissa > MAX_EXACT_MANTISSA || exponent > MAX_EXACT_POWER_OF_TEN
+			|| exponent < -MAX_EXACT_POWER_OF_TEN) {
+		return false;
+	}
+	result = static_cast<double>(mantissa);
+	if (exponent >= 0) {
+		result *= EXACT_POWERS_OF_TEN[exponent];
+	} else {
+		result /= EXACT_POWERS_OF_TEN[-exponent];
+	}
+	if (negative) {
+		result = -result;
+	}
+	return true;
+}
+
+}
+
 NastranTokenizer::NastranTokenizer(istream& input, vega::LogLevel logLevel, const string fileName) :
-		instrream(input), currentField(0), logLevel(logLevel), fileName(fileName), lineNumber(0), currentSection(
+		instrream(&input), cursor(nullptr), inputEnd(nullptr), cardBegin(nullptr), cardLineNumber(0), currentField(
+				0), logLevel(logLevel), fileName(fileName), lineNumber(0), currentSection(
 				SECTION_EXECUTIVE) {
 	this->nextSymbolType = NastranTokenizer::SYMBOL_KEYWORD;
 }
 
+NastranTokenizer::NastranTokenizer(const boost::filesystem::path& inputFile,
+		vega::LogLevel logLevel) :
+		instrream(nullptr), cursor(nullptr), inputEnd(nullptr), cardBegin(nullptr), cardLineNumber(
+				0), currentField(0), logLevel(logLevel), fileName(inputFile.string()), lineNumber(0), currentSection(
+				SECTION_EXECUTIVE) {
+	// empty files can't be mapped
+	if (boost::filesystem::file_size(inputFile) > 0) {
+		mappedFile.open(inputFile);
+		cursor = mappedFile.data();
+		inputEnd = cursor + mappedFile.size();
+	}
+	// so that the first card can be located before its line is read
+	cardBegin = cursor;
+	cardLineNumber = 1;
+	this->nextSymbolType = NastranTokenizer::SYMBOL_KEYWORD;
+}
+
+NastranTokenizer::NastranTokenizer(const Card& card, const string& fileName,
+		vega::LogLevel logLevel) :
+		instrream(nullptr), cursor(card.begin), inputEnd(card.end), cardBegin(card.begin), cardLineNumber(
+				card.lineNumber), currentField(0), logLevel(logLevel), fileName(fileName), lineNumber(
+				card.lineNumber - 1), currentSection(SECTION_BULK) {
+	nextLine();
+}
+
 NastranTokenizer::~NastranTokenizer() {
 }
 
-string NastranTokenizer::nextSymbolString() {
+NastranTokenizer::Field NastranTokenizer::nextSymbolField() {
 	if (this->nextSymbolType == SYMBOL_EOF) {
 		ostringstream oss;
 		oss << "Attempt to read past the end of file. Line: " << this->lineNumber << endl;
@@ -55,23 +246,30 @@ string NastranTokenizer::nextSymbolString() {
 		}
 	}
 
-	string result = currentLineVector[currentField];
-	if (this->nextSymbolType == SYMBOL_KEYWORD) {
-		boost::to_upper(result);
-	}
+	const Field result = currentLineVector[currentField];
 	this->currentField++;
 	if (this->currentField >= this->currentLineVector.size()) {
 		nextLine();
 	} else {
 		this->nextSymbolType = SYMBOL_FIELD;
 	}
-	return boost::trim_right_copy(result);
+	return result;
+}
+
+string NastranTokenizer::nextSymbolString() {
+	const bool isKeyword = this->nextSymbolType == SYMBOL_KEYWORD;
+	string result = toString(trimmedRight(nextSymbolField()));
+	if (isKeyword) {
+		boost::to_upper(result);
+	}
+	return result;
 }
 
-NastranTokenizer::LineType NastranTokenizer::getLineType(const string& line) {
-	const string beginning = line.substr(0, 8);
-	if (beginning.find(",") == string::npos) {
-		if (beginning.find("*") == string::npos) {
+NastranTokenizer::LineType NastranTokenizer::getLineType(const Field& line) {
+	const Field beginning(line.begin(),
+			line.begin() + min(line.end() - line.begin(), static_cast<ptrdiff_t>(8)));
+	if (find(beginning.begin(), beginning.end(), ',') == beginning.end()) {
+		if (find(beginning.begin(), beginning.end(), '*') == beginning.end()) {
 			return SHORT_FORMAT;
 		} else {
 			return LONG_FORMAT;
@@ -82,19 +280,53 @@ NastranTokenizer::LineType NastranTokenizer::getLineType(const string& line) {
 
 }
 
-bool NastranTokenizer::readLineSkipComment(string& line) {
+NastranTokenizer::Field NastranTokenizer::ownedCopy(const string& line) {
+	lineBuffers.push_back(line);
+	const string& buffer = lineBuffers.back();
+	return Field(buffer.data(), buffer.data() + buffer.size());
+}
+
+bool NastranTokenizer::readLine(Field& line) {
+	if (instrream == nullptr) {
+		if (cursor == inputEnd) {
+			line = Field();
+			return false;
+		}
+		const char* newline = static_cast<const char*>(memchr(cursor, '\n',
+				static_cast<size_t>(inputEnd - cursor)));
+		if (newline == nullptr) {
+			line = Field(cursor, inputEnd);
+			cursor = inputEnd;
+		} else {
+			line = Field(cursor, newline);
+			cursor = newline + 1;
+		}
+		return true;
+	}
+	string buffer;
+	if (!getline(*instrream, buffer)) {
+		line = Field();
+		return false;
+	}
+	line = ownedCopy(buffer);
+	return true;
+}
+
+char NastranTokenizer::peekChar() {
+	if (instrream == nullptr) {
+		return cursor == inputEnd ? static_cast<char>(char_traits<char>::eof()) : *cursor;
+	}
+	return static_cast<char>(this->instrream->peek());
+}
+
+bool NastranTokenizer::readLineSkipComment(Field& line) {
 	bool eof = true;
-	while (getline(this->instrream, line)) {
+	while (readLine(line)) {
 		lineNumber += 1;
-		if (!line.empty() and !boost::all(line,isblank) and line[0] != '$') {
-			boost::iterator_range<string::iterator> middle_dollar = boost::find_first(line, "$");
-			if (middle_dollar) {
-				boost::erase_tail(line,
-						static_cast<int>(line.size())
-								- static_cast<int>(distance(line.begin(), middle_dollar.begin())));
-			}
+		if (!line.empty() and !boost::all(line, ::isblank) and line.front() != '$') {
+			line = Field(line.begin(), find(line.begin(), line.end(), '$'));
 			//if the line is not blank exit the loop
-			if (!boost::all(line, isblank)){
+			if (!boost::all(line, ::isblank)){
 				eof = false;
 				break;
 			}
@@ -103,33 +335,35 @@ bool NastranTokenizer::readLineSkipComment(string& line) {
 	return eof;
 }
 
-void NastranTokenizer::splitFreeFormat(string line, bool firstLine) {
+void NastranTokenizer::splitFreeFormat(Field line, bool firstLine, vector<Field>& fields) {
 	if (firstLine) {
-		split(currentLineVector, line, boost::is_any_of(","));
+		split(fields, line, boost::is_any_of(","));
 	} else {
 		//skip first field;
-		string lineNoContinuation = line.substr(line.find(',') + 1);
-		vector<string> otherLine;
+		const char* comma = find(line.begin(), line.end(), ',');
+		Field lineNoContinuation =
+				comma == line.end() ? line : Field(comma + 1, line.end());
+		vector<Field> otherLine;
 		split(otherLine, lineNoContinuation, boost::is_any_of(","));
-		currentLineVector.insert(currentLineVector.end(), otherLine.begin(), otherLine.end());
+		fields.insert(fields.end(), otherLine.begin(), otherLine.end());
 	}
 	bool explicitContinuation = false;
-	for (size_t fieldIndex = 1; fieldIndex < currentLineVector.size(); fieldIndex += 8) {
-		string field = trim_copy(currentLineVector[fieldIndex]);
-		if (field[0] == '+') {
+	for (size_t fieldIndex = 1; fieldIndex < fields.size(); fieldIndex += 8) {
+		Field field = trimmed(fields[fieldIndex]);
+		if (!field.empty() && field.front() == '+') {
 			explicitContinuation = true;
-			currentLineVector.erase(currentLineVector.begin() + fieldIndex);
+			fields.erase(fields.begin() + fieldIndex);
 		}
 	}
-	char c = static_cast<char>(this->instrream.peek());
-	string line2;
+	char c = peekChar();
+	Field line2;
     if (explicitContinuation || c == ',' || c == '+' || c == '*') {
 		readLineSkipComment(line2);
-		splitFreeFormat(line2, false);
+		splitFreeFormat(line2, false, fields);
 	}
 }
 
-void NastranTokenizer::parseBulkSectionLine(string line) {
+void NastranTokenizer::parseBulkSectionLine(Field line) {
 	LineType lineType = getLineType(line);
 	switch (lineType) {
 	case LONG_FORMAT:
@@ -139,7 +373,7 @@ void NastranTokenizer::parseBulkSectionLine(string line) {
 		splitFixedFormat(line, false, true);
 		break;
 	case FREE_FORMAT:
-		splitFreeFormat(line, true);
+		splitFreeFormat(line, true, currentLineVector);
 		break;
 	default:
 		throw vega::ParsingException("line format not recognized: Line N ", this->fileName,
@@ -185,25 +419,24 @@ bool NastranTokenizer::isNextInt() {
 	if (nextSymbolType != NastranTokenizer::SYMBOL_FIELD) {
 		return false;
 	}
-	string curField = trim_copy(currentLineVector[currentField]);
-	return !curField.empty() && (strspn(curField.c_str(), "-0123456789") == curField.size());
+	Field curField = trimmed(currentLineVector[currentField]);
+	return !curField.empty() && boost::all(curField, boost::is_any_of("-0123456789"));
 }
 
 bool NastranTokenizer::isNextDouble() {
 	if (nextSymbolType != NastranTokenizer::SYMBOL_FIELD) {
 		return false;
 	}
-	string curField = trim_copy(currentLineVector[currentField]);
-	boost::algorithm::erase_all(curField, " ");
-	return !curField.empty() && (strspn(curField.c_str(), "-+0123456789.eEdD") == curField.size());
+	//blanks inside the field are ignored
+	Field curField = trimmed(currentLineVector[currentField]);
+	return !curField.empty() && boost::all(curField, boost::is_any_of(" -+0123456789.eEdD"));
 }
 
 bool NastranTokenizer::isNextEmpty() {
 	if (nextSymbolType != NastranTokenizer::SYMBOL_FIELD) {
 		return false;
 	}
-	string curField = trim_copy(currentLineVector[currentField]);
-	return curField.empty();
+	return trimmed(currentLineVector[currentField]).empty();
 }
 
 bool NastranTokenizer::isEmptyUntilNextKeyword() {
@@ -214,8 +447,7 @@ bool NastranTokenizer::isEmptyUntilNextKeyword() {
 	}
 	bool result = true;
 	for (size_t i = currentField; i < this->currentLineVector.size() && result; i++) {
-		string curField = trim_copy(currentLineVector[i]);
-		result &= curField.empty();
+		result &= trimmed(currentLineVector[i]).empty();
 	}
 	return result;
 }
@@ -226,12 +458,16 @@ void NastranTokenizer::nextLine() {
 //enough in 99% of lines
 	currentLineVector.reserve(128);
 	currentField = 0;
+	previousLineBuffers.swap(lineBuffers);
+	lineBuffers.clear();
 
 	bool iseof = readLineSkipComment(this->currentLine);
 	if (!iseof) {
+		cardBegin = this->currentLine.begin();
+		cardLineNumber = lineNumber;
 		switch (currentSection) {
 		case SECTION_EXECUTIVE:
-			boost::algorithm::trim(this->currentLine);
+			this->currentLine = trimmed(this->currentLine);
 			split(currentLineVector, this->currentLine, boost::is_any_of("\t\\= "), boost::algorithm::token_compress_on);
 			break;
 		case SECTION_BULK:
@@ -240,50 +476,54 @@ void NastranTokenizer::nextLine() {
 		}
 		this->nextSymbolType = SYMBOL_KEYWORD;
 	} else {
+		cardBegin = cursor;
+		cardLineNumber = lineNumber + 1;
 		this->nextSymbolType = SYMBOL_EOF;
 	}
 }
 
-void NastranTokenizer::splitFixedFormat(string& line, const bool longFormat, const bool firstLine) {
-	boost::offset_separator f;
-
-	int fieldMax;
-	if (longFormat) {
-		int offsets[] = { 8, 16, 16, 16, 16, 8 };
-		fieldMax = 5;
-		f = offset_separator(offsets, offsets + 6);
-	} else {
-		int offsets[] = { 8, 8, 8, 8, 8, 8, 8, 8, 8, 8 };
-		fieldMax = 9;
-		f = offset_separator(offsets, offsets + 10);
+void NastranTokenizer::splitFixedFormat(Field line, const bool longFormat, const bool firstLine) {
+	static const int longOffsets[] = { 8, 16, 16, 16, 16, 8 };
+	static const int shortOffsets[] = { 8, 8, 8, 8, 8, 8, 8, 8, 8, 8 };
+	const int* offsets = longFormat ? longOffsets : shortOffsets;
+	const int fieldMax = longFormat ? 5 : 9;
 
+	if (find(line.begin(), line.end(), '\t') != line.end()) {
+		string expanded = toString(line);
+		replaceTabs(expanded);
+		line = ownedCopy(expanded);
 	}
-	replaceTabs(line);
-	tokenizer<offset_separator> tok(line, f);
-	tokenizer<offset_separator>::iterator beg = tok.begin();
+	const char* position = line.begin();
 	int count = 0;
 	if (!firstLine) {
 		//todo:check that explicit continuation tokens are the same
-		++beg;
+		position += min(line.end() - position, static_cast<ptrdiff_t>(offsets[count]));
 		count++;
 	}
 	bool explicitContinuation = false;
-	for (; beg != tok.end(); ++beg) {
-		string trimCopy = trim_copy(*beg);
+	while (position != line.end()) {
+		const char* fieldEnd = position + min(line.end() - position, static_cast<ptrdiff_t>(offsets[count]));
+		Field field = trimmed(Field(position, fieldEnd));
+		position = fieldEnd;
 		//erase all the long format specifiers
-		if (count == 0) {
-			boost::erase_all(trimCopy, "*");
+		if (count == 0 && find(field.begin(), field.end(), '*') != field.end()) {
+			string keyword = toString(field);
+			boost::erase_all(keyword, "*");
+			field = ownedCopy(keyword);
 		}
-		currentLineVector.push_back(trimCopy);
+		currentLineVector.push_back(field);
 		if (++count == fieldMax) {
-			explicitContinuation = (++beg != tok.end()) && !(trim_copy(*beg).empty());
+			if (position != line.end()) {
+				fieldEnd = position + min(line.end() - position, static_cast<ptrdiff_t>(offsets[count]));
+				explicitContinuation = !trimmed(Field(position, fieldEnd)).empty();
+			}
 			if (explicitContinuation && this->logLevel >= vega::LogLevel::TRACE) {
 				cout << "explicitContinuation" << endl;
 			}
 			break;
 		}
 	}
-	string line2;
+	Field line2;
 	if (explicitContinuation) {
 		//todo:check that continuation tokens are the same
 		bool iseof = readLineSkipComment(line2);
@@ -294,12 +534,12 @@ void NastranTokenizer::splitFixedFormat(string& line, const bool longFormat, con
 		}
 	} else {
 		//test for automatic continuation
-		char c = static_cast<char>(this->instrream.peek());
+		char c = peekChar();
 		if (c == ' ' || c == '+' || c == '*') {
 			readLineSkipComment(line2);
 			//fill the current line with empty fields
 			for (; count < fieldMax; count++) {
-				currentLineVector.push_back("");
+				currentLineVector.push_back(Field());
 			}
 			bool longFormat = (c == '*');
 			splitFixedFormat(line2, longFormat, false);
@@ -308,6 +548,91 @@ void NastranTokenizer::splitFixedFormat(string& line, const bool longFormat, con
 
 }
 
+void NastranTokenizer::skipFixedFormatContinuations(Field line) {
+	string expanded;
+	while (true) {
+		if (find(line.begin(), line.end(), '\t') != line.end()) {
+			expanded = toString(line);
+			replaceTabs(expanded);
+			line = Field(expanded.data(), expanded.data() + expanded.size());
+		}
+		// the tenth field is at column 73 in both the short and the long format
+		const ptrdiff_t length = line.end() - line.begin();
+		const bool explicitContinuation = length > 72
+				&& !trimmed(Field(line.begin() + 72, line.begin() + min(length, ptrdiff_t(80)))).empty();
+		if (explicitContinuation) {
+			// a missing continuation is reported when the card is split into fields
+			if (readLineSkipComment(line)) {
+				return;
+			}
+		} else {
+			const char c = peekChar();
+			if (c != ' ' && c != '+' && c != '*') {
+				return;
+			}
+			readLineSkipComment(line);
+		}
+	}
+}
+
+void NastranTokenizer::locateCards(const set<string>& keywords, size_t maxCount,
+		vector<Card>& cards) {
+	if (!isMapped() || currentSection != SECTION_BULK) {
+		throw logic_error("Only the bulk section of memory mapped files can be located.");
+	}
+	if (nextSymbolType != SYMBOL_KEYWORD || maxCount == 0) {
+		return;
+	}
+	string keyword = toString(trimmedRight(currentLineVector[0]));
+	boost::to_upper(keyword);
+	if (keywords.find(keyword) == keywords.end()) {
+		return;
+	}
+	cards.push_back(currentCard());
+	vector<Field> freeFormatFields;
+	while (true) {
+		Card next;
+		next.begin = cursor;
+		next.end = inputEnd;
+		next.lineNumber = lineNumber + 1;
+		if (cards.size() >= maxCount) {
+			rewind(next);
+			return;
+		}
+		Field line;
+		if (readLineSkipComment(line)) {
+			rewind(next);
+			return;
+		}
+		Card card;
+		card.begin = line.begin();
+		card.lineNumber = lineNumber;
+		const LineType lineType = getLineType(line);
+		if (lineType == FREE_FORMAT) {
+			keyword = toString(trimmedRight(Field(line.begin(), find(line.begin(), line.end(), ','))));
+		} else {
+			// same as the first field of splitFixedFormat, the keyword is at most 8 columns
+			const char* keywordEnd = line.begin() + min(line.end() - line.begin(), ptrdiff_t(8));
+			keyword = toString(trimmed(Field(line.begin(), find(line.begin(), keywordEnd, '\t'))));
+			boost::erase_all(keyword, "*");
+		}
+		boost::to_upper(keyword);
+		if (keywords.find(keyword) == keywords.end()) {
+			rewind(card);
+			return;
+		}
+		if (lineType == FREE_FORMAT) {
+			// free format continuations are marked in the fields
+			freeFormatFields.clear();
+			splitFreeFormat(line, true, freeFormatFields);
+		} else {
+			skipFixedFormatContinuations(line);
+		}
+		card.end = cursor;
+		cards.push_back(card);
+	}
+}
+
 string NastranTokenizer::nextString(bool returnDefaultIfNotFoundOrBlank, string defaultValue) {
 	string result;
 	if (returnDefaultIfNotFoundOrBlank && (this->nextSymbolType != SYMBOL_FIELD)) {
@@ -346,13 +671,21 @@ int NastranTokenizer::nextInt(bool returnDefaultIfNotFoundOrBlank, int defaultVa
 	if (returnDefaultIfNotFoundOrBlank && this->nextSymbolType != SYMBOL_FIELD) {
 		return defaultValue;
 	}
-	string value = trim_copy(nextSymbolString());
-	if (returnDefaultIfNotFoundOrBlank && value.empty()) {
+	const bool isKeyword = this->nextSymbolType == SYMBOL_KEYWORD;
+	const Field field = trimmed(nextSymbolField());
+	if (returnDefaultIfNotFoundOrBlank && field.empty()) {
 		return defaultValue;
 	}
+	if (decodeInt(field, result)) {
+		return result;
+	}
 	try {
-		result = lexical_cast<int>(value);
+		result = lexical_cast<int>(field.begin(), static_cast<size_t>(field.size()));
 	} catch (boost::bad_lexical_cast &) {
+		string value = toString(field);
+		if (isKeyword) {
+			boost::to_upper(value);
+		}
 		string currentFieldstr =
 				currentField == 0 ? string("LAST") : (lexical_cast<string>(currentField - 1));
 		string message = "Value: [" + value + "] can't be converted to int. Field Num:"
@@ -366,19 +699,20 @@ double NastranTokenizer::nextDouble(bool returnDefaultIfNotFoundOrBlank, double
 	double result;
 	if (returnDefaultIfNotFoundOrBlank && this->nextSymbolType != SYMBOL_FIELD) {
 		return defaultValue;
-
 	}
-	string value = trim_copy(nextSymbolString());
-	if (returnDefaultIfNotFoundOrBlank && value.empty()) {
+	const bool isKeyword = this->nextSymbolType == SYMBOL_KEYWORD;
+	const Field field = trimmed(nextSymbolField());
+	if (returnDefaultIfNotFoundOrBlank && field.empty()) {
 		return defaultValue;
 	}
-	boost::replace_all(value, "d", "e");
-	boost::replace_all(value, "D", "E");
-	boost::algorithm::erase_all(value, " ");
-	size_t position = value.find_first_of("+-", 1);
-	if (position != string::npos and position != value.find_first_of("eE", 1) + 1) {
-		value.insert(position, "E");
+	if (!isKeyword && decodeDouble(field, result)) {
+		return result;
 	}
+	string value = toString(field);
+	if (isKeyword) {
+		boost::to_upper(value);
+	}
+	normalizeReal(value);
 	try {
 		result = lexical_cast<double>(value);
 	} catch (boost::bad_lexical_cast &e) {
@@ -391,10 +725,82 @@ double NastranTokenizer::nextDouble(bool returnDefaultIfNotFoundOrBlank, double
 	return result;
 }
 
+bool NastranTokenizer::decodeInt(const Field& field, int& result) {
+	const char* c = field.begin();
+	const char* end = field.end();
+	bool negative = false;
+	if (c != end && (*c == '+' || *c == '-')) {
+		negative = *c == '-';
+		c++;
+	}
+	if (c == end) {
+		return false;
+	}
+	// the magnitude of INT_MIN is larger than INT_MAX
+	const int64_t limit =
+			negative ? -int64_t(numeric_limits<int>::min()) : numeric_limits<int>::max();
+	int64_t value = 0;
+	for (; c != end; c++) {
+		if (!isDigit(*c)) {
+			return false;
+		}
+		value = value * 10 + (*c - '0');
+		if (value > limit) {
+			return false;
+		}
+	}
+	result = static_cast<int>(negative ? -value : value);
+	return true;
+}
+
+bool NastranTokenizer::decodeDouble(const Field& field, double& result) {
+	if (decodeDoubleFastPath(field, result)) {
+		return true;
+	}
+	return decodeDoubleByString(field, result);
+}
+
+bool NastranTokenizer::decodeDoubleByString(const Field& field, double& result) {
+	string value = toString(trimmed(field));
+	normalizeReal(value);
+	try {
+		result = lexical_cast<double>(value);
+	} catch (boost::bad_lexical_cast &) {
+		return false;
+	}
+	return true;
+}
+
+bool NastranTokenizer::isMapped() const {
+	return instrream == nullptr;
+}
+
+NastranTokenizer::Card NastranTokenizer::currentCard() const {
+	Card card;
+	card.begin = cardBegin;
+	card.end = cursor;
+	card.lineNumber = cardLineNumber;
+	return card;
+}
+
+void NastranTokenizer::rewind(const Card& card) {
+	if (!isMapped()) {
+		throw logic_error("Only memory mapped files can be rewound.");
+	}
+	cursor = card.begin;
+	lineNumber = card.lineNumber - 1;
+	nextLine();
+}
+
 vector<string> NastranTokenizer::currentDataLine() const {
-	return currentLineVector;
+	vector<string> result;
+	result.reserve(currentLineVector.size());
+	for (const Field& field : currentLineVector) {
+		result.push_back(toString(field));
+	}
+	return result;
 }
 
 const string NastranTokenizer::currentRawDataLine() const {
-	return this->currentLine;
+	return toString(this->currentLine);
 }
@@ -15,8 +15,13 @@
 #include <string>
 #include <fstream>
 #include <vector>
+#include <deque>
+#include <set>
 #include <iostream>
 #include <limits>
+#include <boost/filesystem/path.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/range/iterator_range.hpp>
 #include "../Abstract/ConfigurationParameters.h"
 
 using namespace std;
@@ -24,6 +29,25 @@ using namespace std;
 //TODO implements iterator
 class NastranTokenizer {
 
+public:
+	/**
+	 * A line or a field of the input. It points either into the memory mapped file or
+	 * into a line buffer owned by the tokenizer, so that fields are never copied.
+	 */
+	typedef boost::iterator_range<const char*> Field;
+	/**
+	 * Location of a card (keyword and continuation lines) in a memory mapped file.
+	 */
+	class Card {
+	public:
+		const char* begin;
+		const char* end;
+		/**
+		 * Line number of the keyword
+		 */
+		int lineNumber;
+	};
+
 private:
 	enum LineType {
 		FREE_FORMAT,
@@ -32,19 +56,51 @@ private:
 	};
 	static const int TAB_SIZE = 4;
 
-	istream& instrream;
+	/**
+	 * Input stream, or nullptr when reading a memory mapped file.
+	 */
+	istream* instrream;
+	boost::iostreams::mapped_file_source mappedFile;
+	/**
+	 * Next character to be read in the memory mapped file, and end of the mapping.
+	 */
+	const char* cursor;
+	const char* inputEnd;
+	/**
+	 * Lines that can't point into the mapping: lines read from a stream and lines rewritten
+	 * by the tokenizer (tabs expanded...). The buffers of the previous keyword are kept until
+	 * the next one, so that the last symbol returned before a new line is still valid.
+	 */
+	deque<string> lineBuffers;
+	deque<string> previousLineBuffers;
+	/**
+	 * Beginning of the current card in the memory mapped file, and its line number.
+	 */
+	const char* cardBegin;
+	int cardLineNumber;
 	unsigned int currentField;
-	vector<string> currentLineVector;
-	string currentLine;
+	vector<Field> currentLineVector;
+	Field currentLine;
 
-	void splitFixedFormat(string& line, bool longFormat, bool firstLine);
+	void splitFixedFormat(Field line, bool longFormat, bool firstLine);
+	/**
+	 * Reads the continuation lines of a fixed format line, without splitting them into fields.
+	 */
+	void skipFixedFormatContinuations(Field line);
 
 	void replaceTabs(string &line);
-	LineType getLineType(const string& line);
-	bool readLineSkipComment(string& line);
-	void splitFreeFormat(string line, bool firstLine);
-	void parseBulkSectionLine(string line);
+	LineType getLineType(const Field& line);
+	bool readLine(Field& line);
+	char peekChar();
+	Field ownedCopy(const string& line);
+	bool readLineSkipComment(Field& line);
+	void splitFreeFormat(Field line, bool firstLine, vector<Field>& fields);
+	void parseBulkSectionLine(Field line);
 	void parseParameters();
+	/**
+	 * Return the next symbol, untouched, and advances to next symbol.
+	 */
+	Field nextSymbolField();
 
 public:
 	enum SymbolType {
@@ -73,6 +129,20 @@ public:
 
 	NastranTokenizer(istream& stream, vega::LogLevel logLevel = vega::LogLevel::INFO,
 			const string fileName = "UNKNOWN");
+	/**
+	 * Reads a file through a read-only memory mapping: lines and fields point into the
+	 * mapping and are only copied when converted to strings or numbers.
+	 */
+	NastranTokenizer(const boost::filesystem::path& inputFile, vega::LogLevel logLevel =
+			vega::LogLevel::INFO);
+	/**
+	 * Reads a single card of a memory mapped file, in the bulk section. The file must stay
+	 * mapped by its own tokenizer.
+	 */
+	NastranTokenizer(const Card& card, const string& fileName, vega::LogLevel logLevel =
+			vega::LogLevel::INFO);
+	NastranTokenizer(const NastranTokenizer&) = delete;
+	NastranTokenizer& operator=(const NastranTokenizer&) = delete;
 	virtual ~NastranTokenizer();
 
 	/*
@@ -121,6 +191,25 @@ public:
 	 */
 	double nextDouble(bool returnDefaultIfNotFoundOrBlank = false, double defaultValue =
 			UNAVAILABLE_DOUBLE);
+	/**
+	 * Converts a trimmed field to an integer, without allocating memory.
+	 * @return false if the field is not an integer.
+	 */
+	static bool decodeInt(const Field& field, int& result);
+	/**
+	 * Converts a field to a double, accepting all the Nastran notations: blanks anywhere,
+	 * D exponents and implicit exponents ("1.5-3", "7.+4"). The usual 8 and 16 characters
+	 * fields are decoded without allocating memory.
+	 * @return false if the field is not a real.
+	 */
+	static bool decodeDouble(const Field& field, double& result);
+	/**
+	 * Converts a field to a double by rewriting it in the notation understood by
+	 * lexical_cast, as the tokenizer did before decodeDouble. Slower, it is used by
+	 * decodeDouble for the fields outside of its fast path, and as the reference of its tests.
+	 * @return false if the field is not a real.
+	 */
+	static bool decodeDoubleByString(const Field& field, double& result);
 
 	/**
 	 * Skip at most n fields. It stops if end of line is reached.
@@ -144,6 +233,27 @@ public:
 	 */
 	void nextLine();
 
+	/**
+	 * True if the input is a memory mapped file: cards can be located and read again.
+	 */
+	bool isMapped() const;
+	/**
+	 * Location of the current card. Only meaningful before its keyword is read. At the end
+	 * of the file it is an empty card located after the last line.
+	 */
+	Card currentCard() const;
+	/**
+	 * Restarts reading at the keyword of a card previously returned by currentCard().
+	 */
+	void rewind(const Card& card);
+	/**
+	 * Locates the current card and the following ones, at most maxCount cards, as long as
+	 * their keyword is in keywords. The cards after the current one are not split into
+	 * fields: only their keyword and their continuation lines are looked for. The tokenizer
+	 * is left on the first card not located.
+	 */
+	void locateCards(const set<string>& keywords, size_t maxCount, vector<Card>& cards);
+
 };
 
 #endif /* NASTRANTOKENIZER_H_ */
@@ -10,9 +10,11 @@
 
 #include "build_properties.h"
 #include "../Abstract/Model.h"
+#include "../Abstract/Profiler.h"
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
-#include <iomanip>
 #include <memory>
 #include <string>
 #include <fstream>
@@ -21,7 +23,6 @@
 #include <ciso646>
 #include "NastranWriter.h"
 #include <boost/algorithm/string/predicate.hpp>
-#include <boost/format.hpp>
 
 namespace fs = boost::filesystem;
 using namespace std;
@@ -30,18 +31,8 @@ namespace vega {
 namespace nastran {
 
 ostream &operator<<(ostream &out, const Line& line) {
-	out << left << setw(8);
-	out << line.keyword;
-	int fieldCount = 0;
-	for(auto& field : line.fields) {
-		fieldCount++;
-		if (fieldCount % line.fieldNum == 0) {
-			out << endl;
-			out << setw(line.fieldLength) << "";
-		}
-		out << field;
-	}
-	out << endl;
+	out.write(line.text.data(), static_cast<streamsize>(line.text.size()));
+	out.put('\n');
 	return out;
 }
 
@@ -53,39 +44,59 @@ Line::Line(string _keyword) : keyword(_keyword) {
 		fieldLength = 8;
 		fieldNum = 8;
 	}
+	text.reserve(80);
+	text = keyword;
+	if (keyword.size() < 8) {
+		text.append(8 - keyword.size(), ' ');
+	}
+}
+
+void Line::addField(const char* value, size_t length, bool signPadding) {
+	fieldCount++;
+	if (fieldCount % fieldNum == 0) {
+		text += '\n';
+		text.append(fieldLength, ' ');
+	}
+	if (length >= fieldLength) {
+		text.append(value, length);
+	} else if (signPadding && value[0] == '-') {
+		text += '-';
+		text.append(fieldLength - length, ' ');
+		text.append(value + 1, length - 1);
+	} else {
+		text.append(fieldLength - length, ' ');
+		text.append(value, length);
+	}
 }
 
 Line& Line::add() {
-	this->add(string());
+	this->addField("", 0);
 	return *this;
 }
 
 Line& Line::add(double value) {
-	std::ostringstream strs;
-	strs << boost::format("%8.7g") % value;
-	string gnum = strs.str();
-	strs.str("");
-	strs.clear();
-	if (gnum.length() <= fieldLength) {
-		strs << internal << setw(this->fieldLength) << gnum;
-	} else {
-		strs << internal << setw(this->fieldLength) << boost::format("%4.2e") % value;
+	char buffer[48];
+	int length = snprintf(buffer, sizeof(buffer), "%8.7g", value);
+	if (length > static_cast<int>(fieldLength)) {
+		// as written until now: the field width went to the padding of the value, which
+		// then followed fieldLength spaces
+		memset(buffer, ' ', fieldLength);
+		length = static_cast<int>(fieldLength)
+				+ snprintf(buffer + fieldLength, sizeof(buffer) - fieldLength, "%4.2e", value);
 	}
-	this->fields.push_back(strs.str());
+	this->addField(buffer, static_cast<size_t>(length));
 	return *this;
 }
 
 Line& Line::add(string value) {
-	std::ostringstream strs;
-	strs << internal << setw(this->fieldLength) << value;
-	this->fields.push_back(strs.str());
+	this->addField(value.data(), value.size());
 	return *this;
 }
 
 Line& Line::add(int value) {
-	std::ostringstream strs;
-	strs << internal << setw(this->fieldLength) << value;
-	this->fields.push_back(strs.str());
+	char buffer[16];
+	const int length = snprintf(buffer, sizeof(buffer), "%d", value);
+	this->addField(buffer, static_cast<size_t>(length), true);
 	return *this;
 }
 
@@ -96,7 +107,7 @@ Line& Line::add(const vector<double> values) {
 	return *this;
 }
 
-Line& Line::add(const vector<int> values) {
+Line& Line::add(const vector<int>& values) {
 	for(int value : values) {
 		this->add(value);
 	}
@@ -175,18 +186,22 @@ void NastranWriterImpl::writeSOL(const shared_ptr<vega::Model>& model, ofstream&
 
 void NastranWriterImpl::writeCells(const shared_ptr<vega::Model>& model, ofstream& out)
 		{
+	Profiler::Scope scope("writeCells");
 	for (auto elementSet : model->elementSets) {
 		if (elementSet->isDiscrete() || elementSet->isMatrixElement()) {
 			continue;
 		}
 		CellGroup* cellGroup = elementSet->cellGroup;
-		for (const Cell& cell : cellGroup->getCells()) {
+		const vector<int>& nodeIdByPosition = model->mesh->nodes.getIds();
+		// reused from a cell to the next one
+		vector<int> nodeIds;
+		cellGroup->forEachCell([&](const CellView& cell) {
 			string keyword;
 			if (elementSet->isBeam()) {
 				keyword = "CBEAM";
 			} else
 			if (elementSet->isShell()) {
-				switch (cell.type.code) {
+				switch (cell.typeCode) {
 				case CellType::TRI3_CODE:
 					keyword = "CTRIA3";
 					break;
@@ -204,7 +219,7 @@ void NastranWriterImpl::writeCells(const shared_ptr<vega::Model>& model, ofstrea
 				}
 			} else
 			if (elementSet->type == ElementSet::CONTINUUM) {
-				switch (cell.type.code) {
+				switch (cell.typeCode) {
 				case CellType::HEXA8_CODE:
 					case CellType::HEXA20_CODE:
 					keyword = "CHEXA";
@@ -218,13 +233,18 @@ void NastranWriterImpl::writeCells(const shared_ptr<vega::Model>& model, ofstrea
 				}
 			}
 
-			out << Line(keyword).add(cell.id).add(elementSet->bestId()).add(cell.nodeIds);
-		}
+			nodeIds.clear();
+			for (int nodePosition : cell.nodePositions) {
+				nodeIds.push_back(nodeIdByPosition[nodePosition]);
+			}
+			out << Line(keyword).add(cell.id).add(elementSet->bestId()).add(nodeIds);
+		});
 	}
 }
 
 void NastranWriterImpl::writeNodes(const shared_ptr<vega::Model>& model, ofstream& out)
 		{
+	Profiler::Scope scope("writeNodes");
 	for (Node node : model->mesh->nodes) {
 		out << Line("GRID").add(node.id).add().add(node.x).add(node.y).add(node.z);
 	}
@@ -232,6 +252,7 @@ void NastranWriterImpl::writeNodes(const shared_ptr<vega::Model>& model, ofstrea
 
 void NastranWriterImpl::writeMaterials(const shared_ptr<vega::Model>& model, ofstream& out)
 		{
+	Profiler::Scope scope("writeMaterials");
 	for (auto material : model->materials) {
 		Line mat1("MAT1");
 		mat1.add(material->bestId());
@@ -249,6 +270,7 @@ void NastranWriterImpl::writeMaterials(const shared_ptr<vega::Model>& model, ofs
 
 void NastranWriterImpl::writeConstraints(const shared_ptr<vega::Model>& model, ofstream& out)
 		{
+	Profiler::Scope scope("writeConstraints");
 	for (auto constraintSet : model->constraintSets) {
 		const set<shared_ptr<Constraint> > spcs = constraintSet->getConstraintsByType(
 				Constraint::SPC);
@@ -287,6 +309,7 @@ void NastranWriterImpl::writeConstraints(const shared_ptr<vega::Model>& model, o
 
 void NastranWriterImpl::writeLoadings(const shared_ptr<vega::Model>& model, ofstream& out)
 		{
+	Profiler::Scope scope("writeLoadings");
 	for (auto loadingSet : model->loadSets) {
 		const set<shared_ptr<Loading> > gravities = loadingSet->getLoadingsByType(Loading::GRAVITY);
 		if (gravities.size() > 0) {
@@ -350,6 +373,7 @@ void NastranWriterImpl::writeRuler(ofstream& out)
 
 void NastranWriterImpl::writeElements(const shared_ptr<vega::Model>& model, ofstream& out)
 		{
+	Profiler::Scope scope("writeElements");
 	for (shared_ptr<Beam> beam : model->getBeams()) {
 		Line pbeam("PBEAM");
 		pbeam.add(beam->bestId());
@@ -384,7 +408,10 @@ string NastranWriterImpl::writeModel(const shared_ptr<vega::Model> model,
 	}
 
 	string datPath = getDatFilename(model, outputPath);
+	// declared first, it has to outlive the stream
+	vector<char> outBuffer(OUTPUT_BUFFER_SIZE);
 	ofstream out;
+	out.rdbuf()->pubsetbuf(outBuffer.data(), static_cast<streamsize>(outBuffer.size()));
 	out.precision(DBL_DIG);
 	out.open(datPath.c_str(), ios::out | ios::trunc);
 	if (!out.is_open()) {
@@ -24,20 +24,31 @@
 namespace vega {
 namespace nastran {
 
+/**
+ * A card in small field format, or in large field format if the keyword ends with '*'.
+ * The fields are rendered into the text of the card as they are added, continuation lines
+ * included, so that writing it is a single copy.
+ */
 class Line {
 private:
 	friend std::ostream &operator<<(std::ostream &out, const Line& line);
 	unsigned int fieldLength = 0;
 	unsigned int fieldNum = 0;
+	unsigned int fieldCount = 0;
 	const string keyword = "";
-	std::vector<string> fields;
+	string text;
+	/**
+	 * Appends a field, padded on the left to fieldLength characters. With signPadding, the
+	 * padding goes after a leading '-', as the std::internal adjustment of numbers.
+	 */
+	void addField(const char* value, size_t length, bool signPadding = false);
 public:
 	Line(string _keyword);
 	Line& add();
 	Line& add(double value);
 	Line& add(string value);
 	Line& add(int value);
-	Line& add(const std::vector<int> values);
+	Line& add(const std::vector<int>& values);
 	Line& add(const std::vector<double> values);
 	Line& add(const DOFS dofs);
 	Line& add(const VectorialValue vector);
@@ -52,6 +63,10 @@ public:
 	string writeModel(const std::shared_ptr<Model> model_ptr, const ConfigurationParameters&);
 
 private:
+	/**
+	 * Size of the buffer of the output file, the cards being written one by one.
+	 */
+	static const size_t OUTPUT_BUFFER_SIZE = 1 << 20;
 	string getDatFilename(const shared_ptr<vega::Model>& model, const string& outputPath) const;
 	void writeSOL(const shared_ptr<vega::Model>& model, ofstream& out) const;
 	void writeCells(const shared_ptr<vega::Model>& model, ofstream& out);
@@ -78,24 +78,21 @@ int F06Parser::readDisplacementSection(const Model& model,
 					//		<< endl;
 					continue;
 				}
-				VectorialValue translation(stod(tokens[2]), stod(tokens[3]), stod(tokens[4]));
-				VectorialValue rotation(stod(tokens[5]), stod(tokens[6]), stod(tokens[7]));
+				// the translation then the rotation
+				double values[6];
+				for (int i = 0; i < 6; i++) {
+					values[i] = stod(tokens[2 + i]);
+				}
 
 				int nodePosition = model.mesh->findNodePosition(nodeId);
 				Node node = model.mesh->findNode(nodePosition);
 				if (node.displacementCS != CoordinateSystem::GLOBAL_COORDINATE_SYSTEM_ID) {
-					Node node = model.mesh->findNode(nodePosition);
 					shared_ptr<CoordinateSystem> coordSystem = model.find(
 							Reference<CoordinateSystem>(CoordinateSystem::UNKNOWN,
 									node.displacementCS));
-					coordSystem->updateLocalBase(VectorialValue(node.x, node.y, node.z));
-					translation = coordSystem->vectorToGlobal(translation);
-					rotation = coordSystem->vectorToGlobal(rotation);
+					const double points[6] = { node.x, node.y, node.z, node.x, node.y, node.z };
+					coordSystem->vectorsToGlobal(points, values, values, 2);
 				}
-				double values[6] = {
-						translation.x(), translation.y(), translation.z(),
-						rotation.x(), rotation.y(), rotation.z(),
-				};
 				for (int i = 0; i < 6; i++) {
 					double value = values[i];
 					if (abs(value) < 1e-12)
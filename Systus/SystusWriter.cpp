@@ -9,6 +9,8 @@
  *      Author: devel
  */
 
+#include <cfloat>
+#include <cstdio>
 #include <cstdlib>
 #include <iostream>
 #include <iomanip>
@@ -19,11 +21,31 @@
 #include <boost/filesystem.hpp>
 #include "SystusWriter.h"
 #include "build_properties.h"
+#include "../Abstract/PassScheduler.h"
+#include "../Abstract/Profiler.h"
 #include "cmath" /* M_PI */
 
 namespace fs = boost::filesystem;
 
 namespace vega {
+
+namespace {
+
+void appendInt(string& buffer, long value) {
+	char field[24];
+	buffer.append(field, static_cast<size_t>(snprintf(field, sizeof(field), "%ld", value)));
+}
+
+/**
+ * Same text as a stream with precision DBL_DIG.
+ */
+void appendDouble(string& buffer, double value) {
+	char field[32];
+	buffer.append(field, static_cast<size_t>(snprintf(field, sizeof(field), "%.*g", DBL_DIG, value)));
+}
+
+}
+
 SystusWriter::SystusWriter() {
 }
 
@@ -61,14 +83,21 @@ string SystusWriter::writeModel(const shared_ptr<Model> model,
 
 	string asc_path = systusModel.getOutputFileName("_DATA1.ASC");
 
+	// declared first, it has to outlive the stream
+	vector<char> ascBuffer(OUTPUT_BUFFER_SIZE);
 	ofstream asc_file_ofs;
+	asc_file_ofs.rdbuf()->pubsetbuf(ascBuffer.data(), static_cast<streamsize>(ascBuffer.size()));
 	asc_file_ofs.precision(DBL_DIG);
 	asc_file_ofs.open(asc_path.c_str(), ios::trunc | ios::out);
 	if (!asc_file_ofs.is_open()) {
 		string message = string("Can't open file ") + asc_path + " for writing.";
 		throw ios::failure(message);
 	}
+	// kept for all the sections written by chunks
+	const unsigned int writerThreads = systusModel.configuration.writerThreads;
+	chunkWorkers.reset(writerThreads > 1 ? new WorkerPool(writerThreads) : nullptr);
 	this->writeAsc(systusModel, asc_file_ofs);
+	chunkWorkers.reset();
 	asc_file_ofs.close();
 
 	ofstream dat_file_ofs;
@@ -130,6 +159,7 @@ void SystusWriter::getSystusInformations(const SystusModel& systusModel) {
 }
 
 void SystusWriter::generateRBEs(const SystusModel& systusModel) {
+	Profiler::Scope scope("generateRBEs");
 
 	shared_ptr<Mesh> mesh = systusModel.model->mesh;
 	vector<shared_ptr<ConstraintSet>> commonConstraintSets = systusModel.model->getCommonConstraintSets();
@@ -161,7 +191,7 @@ void SystusWriter::generateRBEs(const SystusModel& systusModel) {
 				else if (systusOption == 4)
 					cellPosition = mesh->addCell(Cell::AUTO_ID, CellType::SEG4, nodes, true);
 				RBE2rbarPositions.push_back(cellPosition);
-				group->addCell(mesh->findCell(cellPosition).id);
+				group->addCellByPosition(cellPosition);
 			}
 		}
 		constraints = constraintSet->getConstraintsByType(Constraint::RBE3);
@@ -176,7 +206,7 @@ void SystusWriter::generateRBEs(const SystusModel& systusModel) {
 				vector<int> nodes = {master.id, slave.id};
 				int cellPosition = mesh->addCell(Cell::AUTO_ID, CellType::SEG2, nodes, true);
 				RBE3rbarPositions.push_back(cellPosition);
-				group->addCell(mesh->findCell(cellPosition).id);
+				group->addCellByPosition(cellPosition);
 			}
 		}
 	}
@@ -184,6 +214,7 @@ void SystusWriter::generateRBEs(const SystusModel& systusModel) {
 }
 
 void SystusWriter::fillLists(const SystusModel& systusModel) {
+	Profiler::Scope scope("fillLists");
 
 	map<int, map<int, int>> loadingByLoadSetByNodePosition;
 	vector<shared_ptr<LoadSet>> commonLoadSets = systusModel.model->getCommonLoadSets();
@@ -212,7 +243,7 @@ void SystusWriter::fillLists(const SystusModel& systusModel) {
 	}
 
 	for (auto it : loadingByLoadSetByNodePosition) {
-		List list(it.second);
+		List list(static_cast<int>(lists.size()) + 1, it.second);
 		lists.push_back(list);
 		loadingListIdByNodePosition[it.first] = list.getId();
 	}
@@ -262,7 +293,7 @@ void SystusWriter::fillLists(const SystusModel& systusModel) {
 	}
 
 	for (auto it : constraintByConstraintSetByNodePosition) {
-		List list(it.second);
+		List list(static_cast<int>(lists.size()) + 1, it.second);
 		lists.push_back(list);
 		constraintListIdByNodePosition[it.first] = list.getId();
 	}
@@ -270,6 +301,7 @@ void SystusWriter::fillLists(const SystusModel& systusModel) {
 
 
 void SystusWriter::writeAsc(const SystusModel &systusModel, ostream& out) {
+	Profiler::Scope scope("writeAsc");
 
 	getSystusInformations(systusModel);
 
@@ -357,42 +389,95 @@ void SystusWriter::writeInformations(const SystusModel& systusModel, ostream& ou
 	out << "END_INFORMATIONS" << endl;
 }
 
+size_t SystusWriter::writeChunks(ostream& out, size_t count,
+		const function<void(size_t chunk, size_t begin, size_t end, string& buffer)>& render) {
+	const size_t chunkCount = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	// a few chunks per thread at a time, so that the rendered text stays small
+	const size_t chunksByWave = 4 * (chunkWorkers ? chunkWorkers->threads() : 1);
+	size_t writtenBytes = 0;
+	for (size_t waveBegin = 0; waveBegin < chunkCount; waveBegin += chunksByWave) {
+		const size_t waveSize = min(chunksByWave, chunkCount - waveBegin);
+		vector<string> buffers(waveSize);
+		PassScheduler::forEach(chunkWorkers.get(), waveSize, [&](size_t i) {
+			const size_t chunk = waveBegin + i;
+			render(chunk, chunk * CHUNK_SIZE, min(count, (chunk + 1) * CHUNK_SIZE), buffers[i]);
+		});
+		for (const string& buffer : buffers) {
+			out.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+			writtenBytes += buffer.size();
+		}
+	}
+	return writtenBytes;
+}
+
 void SystusWriter::writeNodes(const SystusModel& systusModel, ostream& out) {
+	Profiler::Scope scope("writeNodes");
 	const shared_ptr<Mesh> mesh = systusModel.model->mesh;
 
 	out << "BEGIN_NODES ";
 	out << mesh->countNodes();
 	out << " 3" << endl; // number of coordinates
 
-	for (auto node : mesh->nodes) {
-		int nid = node.position + 1;
-		int iconst = 0;
-		auto it = constraintByNodePosition.find(node.position);
-		if (it != constraintByNodePosition.end())
-			iconst = int(it->second);
-		int imeca = 0;
-		int iangl = 0;
-		if (node.displacementCS != CoordinateSystem::GLOBAL_COORDINATE_SYSTEM_ID)
-			iangl = Constraint::lastAutoId() + Loading::lastAutoId()
-				+systusModel.model->find(Reference<CoordinateSystem>(CoordinateSystem::UNKNOWN, node.displacementCS))->getId();
-		int isol = 0;
-		auto it2 = loadingListIdByNodePosition.find(node.position);
-		if (it2 != loadingListIdByNodePosition.end())
-			isol = it2->second;
-		int idisp = 0;
-		it2 = constraintListIdByNodePosition.find(node.position);
-		if (it2 != constraintListIdByNodePosition.end())
-			idisp = it2->second;
-		out << nid << " " << iconst << " " << imeca << " " << iangl << " " << isol << " " << idisp
-				<< " ";
-		out << node.x << " " << node.y << " " << node.z << endl;
-	}
+	const Model* model = systusModel.model;
+	const size_t writtenBytes = writeChunks(out, static_cast<size_t>(mesh->countNodes()),
+			[this, model, &mesh](size_t, size_t begin, size_t end, string& buffer) {
+				buffer.reserve((end - begin) * 80);
+				// the nodes of a chunk usually share a few coordinate systems
+				unordered_map<int, int> ianglByDisplacementCS;
+				for (size_t position = begin; position < end; position++) {
+					const Node node = mesh->findNode(static_cast<int>(position));
+					int iconst = 0;
+					auto it = constraintByNodePosition.find(node.position);
+					if (it != constraintByNodePosition.end())
+						iconst = int(it->second);
+					int iangl = 0;
+					if (node.displacementCS != CoordinateSystem::GLOBAL_COORDINATE_SYSTEM_ID) {
+						auto ianglIt = ianglByDisplacementCS.find(node.displacementCS);
+						if (ianglIt == ianglByDisplacementCS.end()) {
+							const int coordinateSystemId = model->find(Reference<CoordinateSystem>(
+									CoordinateSystem::UNKNOWN, node.displacementCS))->getId();
+							ianglIt = ianglByDisplacementCS.insert(make_pair(node.displacementCS,
+									Constraint::lastAutoId() + Loading::lastAutoId()
+											+ coordinateSystemId)).first;
+						}
+						iangl = ianglIt->second;
+					}
+					int isol = 0;
+					auto it2 = loadingListIdByNodePosition.find(node.position);
+					if (it2 != loadingListIdByNodePosition.end())
+						isol = it2->second;
+					int idisp = 0;
+					it2 = constraintListIdByNodePosition.find(node.position);
+					if (it2 != constraintListIdByNodePosition.end())
+						idisp = it2->second;
+					// nid iconst imeca iangl isol idisp x y z
+					appendInt(buffer, node.position + 1);
+					buffer += ' ';
+					appendInt(buffer, iconst);
+					buffer += " 0 ";
+					appendInt(buffer, iangl);
+					buffer += ' ';
+					appendInt(buffer, isol);
+					buffer += ' ';
+					appendInt(buffer, idisp);
+					buffer += ' ';
+					appendDouble(buffer, node.x);
+					buffer += ' ';
+					appendDouble(buffer, node.y);
+					buffer += ' ';
+					appendDouble(buffer, node.z);
+					buffer += '\n';
+				}
+			});
+	scope.addWrittenBytes(writtenBytes);
 
 	out << "END_NODES" << endl;
 }
 
 void SystusWriter::writeElements(const SystusModel& systusModel, ostream& out) {
+	Profiler::Scope scope("writeElements");
 	shared_ptr<Mesh> mesh = systusModel.model->mesh;
+	size_t writtenBytes = 0;
 	out << "BEGIN_ELEMENTS " << mesh->countCells() << endl;
 	for (auto elementSet : systusModel.model->elementSets) {
 		//if (elementSet->getElementType() == ElementSet::ELEMENT_UNDEFINED || elementSet->cellGroup == nullptr)
@@ -426,78 +511,129 @@ void SystusWriter::writeElements(const SystusModel& systusModel, ostream& out) {
 			cout << "Warning : " << *elementSet << " not supported" << endl;
 		}
 		}
-		for (const Cell& cell : cellGroup->getCells()) {
-			auto systus2med_it = systus2medNodeConnectByCellType.find(cell.type.code);
-			if (systus2med_it == systus2medNodeConnectByCellType.end()) {
-				cout << "Warning : " << cell << " not supported in Systus" << endl;
-				continue;
-			}
-			out << cell.id << " " << dim << 0 << setfill('0') << setw(2)
-					<< cell.nodeIds.size();
-			//out << " " << material->getId() << " " << 0 << " " << 0 << " ";
-			out << " " << elementSet->getId() << " 0 0";
-			vector<int> systus2medNodeConnect = systus2med_it->second;
-			vector<int> medConnect = cell.nodeIds;
-			vector<int> systusConnect;
-			for (unsigned int i = 0; i < cell.type.numNodes; i++)
-				systusConnect.push_back(medConnect[systus2medNodeConnect[i]]);
-			for (int node : systusConnect) {
-				out << " " << mesh->findNodePosition(node) + 1;
+		const vector<int> cellPositions = cellGroup->cellPositions();
+		const int elementSetId = elementSet->getId();
+		const size_t chunkCount = (cellPositions.size() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+		// filled by the chunks, the warnings are printed in order once the cells are written
+		vector<vector<int>> unsupportedCellPositionsByChunk(chunkCount);
+		writtenBytes += writeChunks(out, cellPositions.size(),
+				[&](size_t chunk, size_t begin, size_t end, string& buffer) {
+					buffer.reserve((end - begin) * 64);
+					for (size_t i = begin; i < end; i++) {
+						const CellView cell = mesh->findCellView(cellPositions[i]);
+						auto systus2med_it = systus2medNodeConnectByCellType.find(cell.typeCode);
+						if (systus2med_it == systus2medNodeConnectByCellType.end()) {
+							unsupportedCellPositionsByChunk[chunk].push_back(cell.position);
+							continue;
+						}
+						const size_t numNodes = cell.nodePositions.size();
+						appendInt(buffer, cell.id);
+						buffer += ' ';
+						appendInt(buffer, dim);
+						buffer += '0';
+						if (numNodes < 10)
+							buffer += '0';
+						appendInt(buffer, static_cast<long>(numNodes));
+						//out << " " << material->getId() << " " << 0 << " " << 0 << " ";
+						buffer += ' ';
+						appendInt(buffer, elementSetId);
+						buffer += " 0 0";
+						const vector<int>& systus2medNodeConnect = systus2med_it->second;
+						for (unsigned int j = 0; j < cell.type().numNodes; j++) {
+							buffer += ' ';
+							appendInt(buffer, cell.nodePositions[systus2medNodeConnect[j]] + 1);
+						}
+						buffer += '\n';
+					}
+				});
+		for (const vector<int>& unsupportedCellPositions : unsupportedCellPositionsByChunk) {
+			for (int position : unsupportedCellPositions) {
+				cout << "Warning : " << mesh->findCell(position) << " not supported in Systus" << endl;
 			}
-			out << endl;
 		}
 	}
 	// adding rbars elements corresponding to rbe2 and rbe3
+	string rbarBuffer;
 	if (RBE2rbarPositions.size()){
 		RBE2rbarsElementId = ElementSet::lastAutoId() + 1;
 		for (int position : RBE2rbarPositions){
-			Cell cell = mesh->findCell(position);
-			out << cell.id << " 190" << cell.nodeIds.size() << " " << RBE2rbarsElementId << " 0 0";
-			for (int nodeId : cell.nodeIds)
-				out << " " << mesh->findNodePosition(nodeId) + 1;
-			out << endl;
+			const CellView cell = mesh->findCellView(position);
+			appendInt(rbarBuffer, cell.id);
+			rbarBuffer += " 190";
+			appendInt(rbarBuffer, static_cast<long>(cell.nodePositions.size()));
+			rbarBuffer += ' ';
+			appendInt(rbarBuffer, RBE2rbarsElementId);
+			rbarBuffer += " 0 0";
+			for (int nodePosition : cell.nodePositions) {
+				rbarBuffer += ' ';
+				appendInt(rbarBuffer, nodePosition + 1);
+			}
+			rbarBuffer += '\n';
 		}
 	}
 	if (RBE3rbarPositions.size()){
 		RBE3rbarsElementId = ElementSet::lastAutoId() + 2;
 		for (int position : RBE3rbarPositions){
-			Cell cell = mesh->findCell(position);
-			out << cell.id << " 100" << cell.nodeIds.size() << " " << RBE3rbarsElementId << " 0 0";
-			for (int nodeId : cell.nodeIds)
-				out << " " << mesh->findNodePosition(nodeId) + 1;
-			out << endl;
+			const CellView cell = mesh->findCellView(position);
+			appendInt(rbarBuffer, cell.id);
+			rbarBuffer += " 100";
+			appendInt(rbarBuffer, static_cast<long>(cell.nodePositions.size()));
+			rbarBuffer += ' ';
+			appendInt(rbarBuffer, RBE3rbarsElementId);
+			rbarBuffer += " 0 0";
+			for (int nodePosition : cell.nodePositions) {
+				rbarBuffer += ' ';
+				appendInt(rbarBuffer, nodePosition + 1);
+			}
+			rbarBuffer += '\n';
 		}
 	}
+	out.write(rbarBuffer.data(), static_cast<streamsize>(rbarBuffer.size()));
+	writtenBytes += rbarBuffer.size();
+	scope.addWrittenBytes(writtenBytes);
 
 	out << "END_ELEMENTS" << endl;
 }
 
 void SystusWriter::writeGroups(const SystusModel& systusModel, ostream& out) {
+	Profiler::Scope scope("writeGroups");
 	vector<NodeGroup*> nodeGroups = systusModel.model->mesh->getNodeGroups();
 	vector<CellGroup*> cellGroups = systusModel.model->mesh->getCellGroups();
 
 	out << "BEGIN_GROUPS ";
 	out << cellGroups.size() + nodeGroups.size() << endl;
+	string buffer;
 	for (auto cellGroup : cellGroups) {
 		//1 E2D 2 0 "SYST DIMENSION 2" "" "Comments of the group" 101 102 103 201 202 203 301 302 303
-		out << cellGroup->getId() << " " << cellGroup->getName()
-				<< " 2 0 \"No method\" \"\" \"No Comments\"";
-		for (auto cell : cellGroup->getCells())
-			out << " " << cell.id;
-		out << endl;
+		appendInt(buffer, cellGroup->getId());
+		buffer += ' ';
+		buffer += cellGroup->getName();
+		buffer += " 2 0 \"No method\" \"\" \"No Comments\"";
+		cellGroup->forEachCell([&buffer](const CellView& cell) {
+			buffer += ' ';
+			appendInt(buffer, cell.id);
+		});
+		buffer += '\n';
 	}
 
 	for (auto nodeGroup : nodeGroups) {
-		out << nodeGroup->getId() << " " << nodeGroup->getName()
-				<< " 1 0 \"No method\" \"\" \"No Comments\"";
-		for (int id : nodeGroup->nodePositions())
-			out << " " << id;
-		out << endl;
+		appendInt(buffer, nodeGroup->getId());
+		buffer += ' ';
+		buffer += nodeGroup->getName();
+		buffer += " 1 0 \"No method\" \"\" \"No Comments\"";
+		for (int id : nodeGroup->nodePositionSet()) {
+			buffer += ' ';
+			appendInt(buffer, id);
+		}
+		buffer += '\n';
 	}
+	out.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+	scope.addWrittenBytes(buffer.size());
 	out << "END_GROUPS" << endl;
 }
 
 void SystusWriter::writeMaterials(const SystusModel& systusModel, ostream& out) {
+	Profiler::Scope scope("writeMaterials");
 	out << "BEGIN_MATERIALS " << systusModel.model->elementSets.size() << " "
 			<< 3 * systusModel.model->elementSets.size() << endl;
 	for (auto elementSet : systusModel.model->elementSets) {
@@ -555,6 +691,7 @@ void SystusWriter::writeMaterials(const SystusModel& systusModel, ostream& out)
 }
 
 void SystusWriter::writeLoads(const SystusModel& systusModel, ostream& out) {
+	Profiler::Scope scope("writeLoads");
 	out << "BEGIN_LOADS ";
 	vector<shared_ptr<LoadSet>> commonLoadSets = systusModel.model->getCommonLoadSets();
 	vector<shared_ptr<ConstraintSet>> commonConstraintSets =
@@ -593,6 +730,7 @@ void SystusWriter::writeLoads(const SystusModel& systusModel, ostream& out) {
 }
 
 void SystusWriter::writeLists(const SystusModel& systusModel, ostream& out) {
+	Profiler::Scope scope("writeLists");
 	UNUSEDV(systusModel);
 	out << "BEGIN_LISTS ";
 	out << lists.size() << " 2" << endl;
@@ -691,10 +829,11 @@ void SystusWriter::writeMasses(const SystusModel &systusModel, ostream& out) {
 				out << "VALUES 6 " << nodalMass->getMass() << " " << nodalMass->getMass() << " "
 						<< nodalMass->getMass() << " " << nodalMass->ixx << " " << nodalMass->iyy
 						<< " " << nodalMass->izz;
-				for (auto cell : mass->cellGroup->getCells()) {
+				const vector<int>& nodeIdByPosition = systusModel.model->mesh->nodes.getIds();
+				mass->cellGroup->forEachCell([&](const CellView& cell) {
 					// NODEi
-					out << " " << cell.nodeIds[0];
-				}
+					out << " " << nodeIdByPosition[cell.nodePositions[0]];
+				});
 				out << endl;
 			}
 		}
@@ -704,6 +843,7 @@ void SystusWriter::writeMasses(const SystusModel &systusModel, ostream& out) {
 
 void SystusWriter::writeDat(const SystusModel& systusModel, const Analysis& analysis,
 		ostream& out) {
+	Profiler::Scope scope("writeDat");
 	set<shared_ptr<ConstraintSet>> uncommonConstaintSets =
 			systusModel.model->getUncommonConstraintSets();
 	set<shared_ptr<LoadSet>> uncommonLoadSets = systusModel.model->getUncommonLoadSets();
@@ -16,11 +16,13 @@
 #include <memory>
 #include <string>
 #include <fstream>
+#include <functional>
 #include <boost/filesystem.hpp>
 #include <boost/assign.hpp>
 #include "../Abstract/Model.h"
 #include "../Abstract/SolverInterfaces.h"
 #include "../Abstract/ConfigurationParameters.h"
+#include "../Abstract/WorkerPool.h"
 #include "SystusModel.h"
 
 namespace vega {
@@ -29,11 +31,19 @@ class SystusWriter: public Writer {
 	int systusOption = 0;
 	int maxNumNodes = 0;
 	int nbNodes = 0;
-	class List: public Identifiable<List> {
+	/**
+	 * Numbered from 1 by each writer, so that the files written do not depend on the models
+	 * written before by the process.
+	 */
+	class List {
+		int id;
 		map<int, int> iVectByiLoad;
 	public:
-		List(const map<int, int>& iVectByiLoad) :
-				Identifiable(), iVectByiLoad(iVectByiLoad) {
+		List(int id, const map<int, int>& iVectByiLoad) :
+				id(id), iVectByiLoad(iVectByiLoad) {
+		}
+		int getId() const {
+			return id;
 		}
 		void write(std::ostream& out) {
 			out << getId();
@@ -52,6 +62,21 @@ class SystusWriter: public Writer {
 	map<int, char> constraintByNodePosition;
 	// vs 2013 compiler bug	in initializer list {{3,6}, {4,3}} not supported
 	map<int, int> numberOfDofBySystusOption = boost::assign::map_list_of(3, 6)(4, 3);
+	/**
+	 * Size of the buffer of the ASC file, the large sections being written by chunks.
+	 */
+	static const size_t OUTPUT_BUFFER_SIZE = 1 << 20;
+	/**
+	 * The writerThreads threads rendering the chunks during a writeModel, nullptr if 1.
+	 */
+	std::unique_ptr<WorkerPool> chunkWorkers;
+	/**
+	 * Renders count items by chunks of CHUNK_SIZE on the chunkWorkers, and writes the chunks
+	 * in order. render is called with the index of the chunk, its range of items and the
+	 * buffer to append the lines to. Returns the number of bytes written.
+	 */
+	size_t writeChunks(std::ostream& out, size_t count,
+			const std::function<void(size_t chunk, size_t begin, size_t end, std::string& buffer)>& render);
 	/**
 	 * Renumbers the nodes
 	 * see Systus ref manual chapter 15 or chapter 13 2.7
@@ -233,6 +258,10 @@ class SystusWriter: public Writer {
 	void writeMasses(const SystusModel&, std::ostream& out);
 
 public:
+	/**
+	 * Number of nodes or cells rendered together in a buffer by writeNodes and writeElements.
+	 */
+	static const size_t CHUNK_SIZE = 4096;
 	SystusWriter();
 	virtual ~SystusWriter();
 
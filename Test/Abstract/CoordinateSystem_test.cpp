@@ -139,3 +139,57 @@ BOOST_AUTO_TEST_CASE( test_CoordinateSystem ) {
 	}
 
 }
+
+BOOST_AUTO_TEST_CASE( test_batched_transforms ) {
+	Model model("test");
+	const VectorialValue X = VectorialValue::X;
+	const VectorialValue Y = VectorialValue::Y;
+	const VectorialValue Z = VectorialValue::Z;
+	CylindricalCoordinateSystem cylindrical(model, X, X + Y, Y);
+	SphericalCoordinateSystem spherical(model, Z, X, Y);
+	const double points[9] = { 2., 1., 0., -1., 3., 5., 1., -2., 1. };
+	const double localVectors[9] = { 1., 2., 3., 0., 1., 0., -1., 0.5, 2. };
+	for (CoordinateSystem* coordinateSystem : { static_cast<CoordinateSystem*>(&cylindrical),
+			static_cast<CoordinateSystem*>(&spherical) }) {
+		// same as the stateful transform at each point
+		double globalVectors[9];
+		coordinateSystem->vectorsToGlobal(points, localVectors, globalVectors, 3);
+		for (int i = 0; i < 9; i += 3) {
+			const VectorialValue point(points[i], points[i + 1], points[i + 2]);
+			const VectorialValue local(localVectors[i], localVectors[i + 1], localVectors[i + 2]);
+			coordinateSystem->updateLocalBase(point);
+			BOOST_CHECK(!!(coordinateSystem->vectorToGlobal(local)
+					== VectorialValue(globalVectors[i], globalVectors[i + 1], globalVectors[i + 2])));
+			BOOST_CHECK(!!(coordinateSystem->vectorToGlobalAt(point, local)
+					== coordinateSystem->vectorToGlobal(local)));
+		}
+	}
+	// (r, theta, z) and (r, theta, phi), angles in degrees
+	double coordinates[6] = { 2., 90., 1., 3., 90., 90. };
+	cylindrical.pointsToGlobal(coordinates, coordinates, 1);
+	BOOST_CHECK(!!(VectorialValue(coordinates[0], coordinates[1], coordinates[2])
+			== X + 2 * (Y - X) / sqrt(2) + Z));
+	spherical.pointsToGlobal(coordinates + 3, coordinates + 3, 1);
+	BOOST_CHECK(!!(VectorialValue(coordinates[3], coordinates[4], coordinates[5]) == Z + 3 * Y));
+	// the radial vector of a point on the X axis of the spherical system
+	BOOST_CHECK(!!(spherical.vectorToGlobalAt(Z + X, X) == X));
+}
+
+BOOST_AUTO_TEST_CASE( test_local_node_positions ) {
+	Model model("test");
+	CartesianCoordinateSystem cartesian(model, VectorialValue(1., 0., 0.), VectorialValue::Y,
+			-1 * VectorialValue::X, 3);
+	model.add(cartesian);
+	const int nodePosition1 = model.mesh->addNode(1, 1., 2., 3.,
+			CoordinateSystem::GLOBAL_COORDINATE_SYSTEM_ID, 3);
+	const int nodePosition2 = model.mesh->addNode(2, 1., 2., 3.);
+	BOOST_CHECK_EQUAL(model.mesh->getNodePositionsByPositionCS().size(), 1);
+	model.finish();
+	const Node node1 = model.mesh->findNode(nodePosition1);
+	BOOST_CHECK_CLOSE(node1.x, -1., 1e-9);
+	BOOST_CHECK_CLOSE(node1.y, 1., 1e-9);
+	BOOST_CHECK_CLOSE(node1.z, 3., 1e-9);
+	const Node node2 = model.mesh->findNode(nodePosition2);
+	BOOST_CHECK_EQUAL(node2.x, 1.);
+	BOOST_CHECK(model.mesh->getNodePositionsByPositionCS().empty());
+}
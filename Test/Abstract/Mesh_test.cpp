@@ -7,6 +7,8 @@
 #include <boost/test/unit_test.hpp>
 #include "../../Abstract/MeshComponents.h"
 #include "../../Abstract/Mesh.h"
+#include <algorithm>
+#include <sstream>
 
 using namespace std;
 using namespace vega;
@@ -36,6 +38,40 @@ BOOST_AUTO_TEST_CASE( test_NodeGroup2Families ) {
 	BOOST_CHECK(famGN1_GN2_found);
 }
 
+BOOST_AUTO_TEST_CASE( test_cell_families ) {
+	Mesh mesh(LogLevel::INFO, "test");
+	for (int i = 1; i <= 5; i++) {
+		mesh.addNode(i, i, 0, 0);
+	}
+	mesh.addCell(1, CellType::TRI3, { 1, 2, 3 });
+	mesh.addCell(2, CellType::SEG2, { 1, 3 });
+	mesh.addCell(3, CellType::TRI3, { 3, 4, 5 });
+	mesh.addCell(4, CellType::TRI3, { 1, 4, 5 });
+	CellGroup* gma1 = mesh.createCellGroup("GMA1");
+	gma1->addCell(1);
+	gma1->addCell(2);
+	gma1->addCell(3);
+	CellGroup* gma2 = mesh.createCellGroup("GMA2");
+	gma2->addCell(3);
+	unordered_map<CellType::Code, int, hash<int>> cellCountByType;
+	cellCountByType[CellType::SEG2_CODE] = 1;
+	cellCountByType[CellType::TRI3_CODE] = 3;
+	CellGroup2Families cg2fam(&mesh, cellCountByType, { gma1, gma2 });
+	const vector<int>& tri3 = *cg2fam.getFamilyOnCells()[CellType::TRI3_CODE];
+	const vector<int>& seg2 = *cg2fam.getFamilyOnCells()[CellType::SEG2_CODE];
+	int expectedTri3[] = { -1, -2, 0 };
+	BOOST_CHECK_EQUAL_COLLECTIONS(tri3.begin(), tri3.end(), expectedTri3, expectedTri3 + 3);
+	BOOST_CHECK_EQUAL(-1, seg2[0]);
+	const vector<Family>& families = cg2fam.getFamilies();
+	BOOST_REQUIRE_EQUAL((size_t )2, families.size());
+	// sorted by id
+	BOOST_CHECK_EQUAL(-2, families[0].num);
+	BOOST_CHECK_EQUAL("GMA1_GMA2", families[0].name);
+	BOOST_CHECK_EQUAL((size_t )2, families[0].groups.size());
+	BOOST_CHECK_EQUAL(-1, families[1].num);
+	BOOST_CHECK_EQUAL("GMA1", families[1].name);
+}
+
 BOOST_AUTO_TEST_CASE( test_faceIds ) {
 	vector<int> nodeIds = { 101, 102, 103, 104, 105, 106, 107, 108 };
 	Mesh mesh(LogLevel::INFO, "test");
@@ -51,6 +87,111 @@ BOOST_AUTO_TEST_CASE( test_faceIds ) {
 			expectedFace2NodeIds.begin(), expectedFace2NodeIds.end());
 }
 
+BOOST_AUTO_TEST_CASE( test_cell_connectivity ) {
+	Mesh mesh(LogLevel::INFO, "test");
+	vector<int> hexaNodeIds = { 101, 102, 103, 104, 105, 106, 107, 108 };
+	vector<int> segNodeIds = { 108, 109 };
+	vector<int> triaNodeIds = { 101, 109, 110 };
+	int hexaPosition = mesh.addCell(1, CellType::HEXA8, hexaNodeIds);
+	int segPosition = mesh.addCell(2, CellType::SEG2, segNodeIds);
+	int triaPosition = mesh.addCell(3, CellType::TRI3, triaNodeIds);
+	BOOST_CHECK_EQUAL(mesh.cells.nodePositions(hexaPosition).size(), 8);
+	BOOST_CHECK_EQUAL(mesh.cells.nodePositions(segPosition).size(), 2);
+	NodePositionRange triaPositions = mesh.cells.nodePositions(triaPosition);
+	BOOST_CHECK_EQUAL(triaPositions.size(), 3);
+	BOOST_CHECK_EQUAL(triaPositions[0], mesh.findNodePosition(101));
+	BOOST_CHECK_EQUAL(triaPositions[1], mesh.findNodePosition(109));
+	BOOST_CHECK_EQUAL(triaPositions[2], mesh.findNodePosition(110));
+	Cell seg = mesh.findCell(segPosition);
+	BOOST_CHECK_EQUAL_COLLECTIONS(seg.nodeIds.begin(), seg.nodeIds.end(), segNodeIds.begin(),
+			segNodeIds.end());
+	Cell tria = mesh.findCell(triaPosition);
+	BOOST_CHECK_EQUAL_COLLECTIONS(tria.nodePositions.begin(), tria.nodePositions.end(),
+			triaPositions.begin(), triaPositions.end());
+	const CellView triaView = mesh.findCellView(triaPosition);
+	BOOST_CHECK_EQUAL(triaView.id, 3);
+	BOOST_CHECK_EQUAL(triaView.position, triaPosition);
+	BOOST_CHECK(triaView.type() == CellType::TRI3);
+	BOOST_CHECK_EQUAL(triaView.getMedName(), tria.getMedName());
+	BOOST_CHECK_EQUAL_COLLECTIONS(triaView.nodePositions.begin(), triaView.nodePositions.end(),
+			triaPositions.begin(), triaPositions.end());
+	ostringstream printed;
+	printed << triaView;
+	BOOST_CHECK_EQUAL(printed.str(),
+			"CellView[id:3,type:" + to_string(CellType::TRI3.code) + ",nodePositions:["
+					+ to_string(triaPositions[0]) + "," + to_string(triaPositions[1]) + ","
+					+ to_string(triaPositions[2]) + "]]");
+}
+
+BOOST_AUTO_TEST_CASE( test_cells_of_node ) {
+	Mesh mesh(LogLevel::INFO, "test");
+	int hexaPosition = mesh.addCell(1, CellType::HEXA8, { 101, 102, 103, 104, 105, 106, 107, 108 });
+	int segPosition = mesh.addCell(2, CellType::SEG2, { 108, 109 });
+	int triaPosition = mesh.addCell(3, CellType::TRI3, { 101, 109, 110 });
+	CellPositionRange cells101 = mesh.cellPositionsOfNode(mesh.findNodePosition(101));
+	vector<int> expected101 = { hexaPosition, triaPosition };
+	BOOST_CHECK_EQUAL_COLLECTIONS(cells101.begin(), cells101.end(), expected101.begin(),
+			expected101.end());
+	BOOST_CHECK_EQUAL(mesh.cellPositionsOfNode(mesh.findNodePosition(102)).size(), 1);
+	int unconnectedPosition = mesh.addNode(111, 0., 0., 0.);
+	BOOST_CHECK(mesh.cellPositionsOfNode(unconnectedPosition).empty());
+	// the index follows the insertion of cells
+	int pointPosition = mesh.addCell(4, CellType::POINT1, { 109 });
+	CellPositionRange cells109 = mesh.cellPositionsOfNode(mesh.findNodePosition(109));
+	vector<int> expected109 = { segPosition, triaPosition, pointPosition };
+	BOOST_CHECK_EQUAL_COLLECTIONS(cells109.begin(), cells109.end(), expected109.begin(),
+			expected109.end());
+	BOOST_CHECK(mesh.cellPositionsOfNode(unconnectedPosition).empty());
+}
+
+BOOST_AUTO_TEST_CASE( test_PositionById ) {
+	PositionById compact;
+	for (int id = 1; id <= 5000; id++) {
+		compact.set(id, id - 1);
+	}
+	//decreasing ids below the first one
+	for (int id = 0; id > -100; id--) {
+		compact.set(id, 6000 - id);
+	}
+	BOOST_CHECK(compact.isDense());
+	BOOST_CHECK_EQUAL(compact.size(), (size_t ) 5100);
+	BOOST_CHECK_EQUAL(compact.find(1), 0);
+	BOOST_CHECK_EQUAL(compact.find(5000), 4999);
+	BOOST_CHECK_EQUAL(compact.find(-99), 6099);
+	BOOST_CHECK_EQUAL(compact.find(5001), PositionById::NOT_FOUND);
+	//automatic ids are far away from the others
+	compact.set(9999999, 42);
+	compact.set(9999998, 43);
+	BOOST_CHECK(!compact.isDense());
+	BOOST_CHECK_EQUAL(compact.find(9999999), 42);
+	BOOST_CHECK_EQUAL(compact.find(9999998), 43);
+	BOOST_CHECK_EQUAL(compact.find(9999997), PositionById::NOT_FOUND);
+	compact.set(9999999, 44);
+	BOOST_CHECK_EQUAL(compact.find(9999999), 44);
+	BOOST_CHECK_EQUAL(compact.size(), (size_t ) 5102);
+	compact.rebalance();
+	BOOST_CHECK_EQUAL(compact.find(9999999), 44);
+	BOOST_CHECK_EQUAL(compact.find(2500), 2499);
+	BOOST_CHECK_EQUAL(compact.size(), (size_t ) 5102);
+
+	//the first ids are outliers, the compact range is detected later
+	PositionById sparse;
+	sparse.set(INT_MAX, 0);
+	sparse.set(INT_MIN + 1, 1);
+	for (int id = 0; id < 20000; id++) {
+		sparse.set(id * 7, id + 2);
+	}
+	for (int id = 0; id < 20000; id++) {
+		BOOST_REQUIRE_EQUAL(sparse.find(id * 7), id + 2);
+		BOOST_REQUIRE_EQUAL(sparse.find(id * 7 + 1), PositionById::NOT_FOUND);
+	}
+	BOOST_CHECK_EQUAL(sparse.find(INT_MAX), 0);
+	BOOST_CHECK_EQUAL(sparse.find(INT_MIN + 1), 1);
+	BOOST_CHECK_EQUAL(sparse.size(), (size_t ) 20002);
+	BOOST_CHECK_THROW(sparse.set(INT_MIN, 2), invalid_argument);
+	BOOST_CHECK_EQUAL(sparse.size(), (size_t ) 20002);
+}
+
 BOOST_AUTO_TEST_CASE( test_NodeGroup ) {
 	Mesh mesh(LogLevel::INFO, "test");
 	vector<int> nodeIds = { 101, 102, 103, 104 };
@@ -75,6 +216,204 @@ BOOST_AUTO_TEST_CASE( test_NodeGroup ) {
 	BOOST_ASSERT_MSG(groupById != nullptr, "Group found by id");
 }
 
+BOOST_AUTO_TEST_CASE( test_PositionSet ) {
+	PositionSet building;
+	set<int> expected;
+	// a sparse chunk, a dense one that becomes a bitmap, and values out of order
+	for (int i = 0; i < 10000; i++) {
+		const int value = (i % 3 == 0) ? 200000 + i * 7 : 70000 + (i * 13) % 20000;
+		building.insert(value);
+		expected.insert(value);
+	}
+	vector<int> bulk = { 5, 3, 200007, 3, 1 };
+	building.insert(bulk.begin(), bulk.end());
+	expected.insert(bulk.begin(), bulk.end());
+	BOOST_CHECK_EQUAL(building.size(), expected.size());
+	BOOST_CHECK(building.toSet() == expected);
+
+	PositionSet compacted = building;
+	compacted.compact();
+	BOOST_CHECK(compacted.isCompact());
+	BOOST_CHECK(compacted == building);
+	BOOST_CHECK_EQUAL_COLLECTIONS(compacted.begin(), compacted.end(), expected.begin(),
+			expected.end());
+	BOOST_CHECK(compacted.contains(70013));
+	BOOST_CHECK(!compacted.contains(70000));
+	BOOST_CHECK(!compacted.contains(-1));
+	BOOST_CHECK_THROW(compacted.insert(-1), invalid_argument);
+
+	// modifications after the compaction
+	compacted.insert(2);
+	BOOST_CHECK(compacted.contains(2));
+	const size_t compactedSize = compacted.size();
+	compacted.insert(2);
+	BOOST_CHECK_EQUAL(compacted.size(), compactedSize);
+	BOOST_CHECK(compacted.erase(5));
+	BOOST_CHECK(!compacted.erase(5));
+	for (int value = 70000; value < 90000; value++) {
+		compacted.erase(value);
+	}
+	expected.insert(2);
+	expected.erase(5);
+	expected.erase(expected.lower_bound(70000), expected.lower_bound(90000));
+	BOOST_CHECK(compacted.toSet() == expected);
+
+	PositionSet other;
+	for (int value = 0; value < 300000; value += 2) {
+		other.insert(value);
+	}
+	set<int> expectedUnion(expected);
+	vector<int> expectedIntersection;
+	for (int value : other) {
+		expectedUnion.insert(value);
+		if (expected.find(value) != expected.end()) {
+			expectedIntersection.push_back(value);
+		}
+	}
+	const PositionSet unionBuilding = PositionSet::unionOf(
+			PositionSet(expected.begin(), expected.end()), other);
+	BOOST_CHECK(unionBuilding.toSet() == expectedUnion);
+	const PositionSet intersection = PositionSet::intersectionOf(
+			PositionSet(expected.begin(), expected.end()), other);
+	BOOST_CHECK(intersection.toVector() == expectedIntersection);
+	other.compact();
+	PositionSet unionCompact = compacted;
+	unionCompact |= other;
+	BOOST_CHECK(unionCompact.isCompact());
+	BOOST_CHECK(unionCompact.toSet() == expectedUnion);
+	PositionSet intersectionCompact = compacted;
+	intersectionCompact &= other;
+	BOOST_CHECK(intersectionCompact.toVector() == expectedIntersection);
+}
+
+BOOST_AUTO_TEST_CASE( test_PositionSet_descending ) {
+	// members added in decreasing order, with duplicates, are merged by the first read
+	PositionSet descending;
+	for (int value = 200000; value >= 0; value -= 2) {
+		descending.insert(value);
+		descending.insert(value);
+	}
+	BOOST_CHECK_EQUAL(descending.size(), (size_t ) 100001);
+	BOOST_CHECK(descending.contains(0));
+	BOOST_CHECK(descending.contains(200000));
+	BOOST_CHECK(!descending.contains(199999));
+	BOOST_CHECK(is_sorted(descending.begin(), descending.end()));
+	BOOST_CHECK(adjacent_find(descending.begin(), descending.end()) == descending.end());
+	descending.insert(7);
+	descending.insert(3);
+	BOOST_CHECK(descending.erase(7));
+	BOOST_CHECK(!descending.erase(7));
+	BOOST_CHECK(descending.contains(3));
+	BOOST_CHECK_EQUAL(descending.size(), (size_t ) 100002);
+	PositionSet copy = descending;
+	copy.insert(1);
+	copy.compact();
+	BOOST_CHECK_EQUAL(copy.size(), (size_t ) 100003);
+	BOOST_CHECK_EQUAL(*copy.begin(), 0);
+	BOOST_CHECK_EQUAL(descending.size(), (size_t ) 100002);
+}
+
+BOOST_AUTO_TEST_CASE( test_group_compaction ) {
+	Mesh mesh(LogLevel::INFO, "test");
+	for (int i = 1; i <= 4; i++) {
+		mesh.addNode(i, i, 0, 0);
+	}
+	mesh.addCell(1, CellType::SEG2, { 1, 2 });
+	mesh.addCell(2, CellType::SEG2, { 2, 3 });
+	mesh.addCell(3, CellType::SEG2, { 3, 4 });
+	NodeGroup* nodeGroup = mesh.createNodeGroup("GN");
+	nodeGroup->addNode(3);
+	nodeGroup->addNode(1);
+	CellGroup* cellGroup = mesh.createCellGroup("GM");
+	cellGroup->addCell(3);
+	cellGroup->addCell(1);
+	mesh.finish();
+	BOOST_CHECK(nodeGroup->nodePositionSet().isCompact());
+	BOOST_CHECK(cellGroup->cellPositionSet().isCompact());
+	BOOST_CHECK(nodeGroup->nodePositions()
+			== set<int>({ mesh.findNodePosition(1), mesh.findNodePosition(3) }));
+	nodeGroup->removeNodeByPosition(mesh.findNodePosition(1));
+	BOOST_CHECK_THROW(nodeGroup->removeNodeByPosition(mesh.findNodePosition(1)), logic_error);
+	BOOST_CHECK_EQUAL(nodeGroup->nodePositionSet().size(), 1);
+	BOOST_CHECK_EQUAL(cellGroup->nodePositions().size(), 4);
+}
+
+BOOST_AUTO_TEST_CASE( test_node_closure ) {
+	shared_ptr<Mesh> mesh(new Mesh(LogLevel::INFO, "test"));
+	for (int i = 1; i <= 5; i++) {
+		mesh->addNode(i, i, 0, 0);
+	}
+	mesh->addCell(10, CellType::SEG2, { 4, 5 });
+	mesh->addCell(11, CellType::SEG2, { 1, 2 });
+	mesh->addCell(12, CellType::SEG2, { 2, 3 });
+	CellGroup* group = mesh->createCellGroup("GM");
+	group->addCell(11);
+	BOOST_CHECK_THROW(group->addCell(13), invalid_argument);
+	vector<int> expected = { mesh->findNodePosition(1), mesh->findNodePosition(2) };
+	BOOST_CHECK(group->nodePositionClosure() == expected);
+	BOOST_CHECK(group->getCellIds() == vector<int>({ 11 }));
+
+	CellContainer container(mesh);
+	container.add(*group);
+	BOOST_CHECK(container.nodePositions() == expected);
+	// the closure is computed again when the container or one of its groups changes
+	group->addCell(12);
+	expected.push_back(mesh->findNodePosition(3));
+	BOOST_CHECK(group->nodePositionClosure() == expected);
+	BOOST_CHECK(container.nodePositions() == expected);
+	container.addCell(10);
+	expected = { 0, 1, 2, 3, 4 };
+	BOOST_CHECK(container.nodePositions() == expected);
+	container.clear();
+	BOOST_CHECK(container.nodePositions().empty());
+
+	// a cell can be added before the mesh has it, as by a load read before the elements
+	container.addCell(13);
+	mesh->addCell(13, CellType::SEG2, { 3, 4 });
+	container.addCell(11);
+	BOOST_CHECK(container.getCellIds() == vector<int>({ 11, 13 }));
+	expected = { mesh->findNodePosition(1), mesh->findNodePosition(2),
+			mesh->findNodePosition(3), mesh->findNodePosition(4) };
+	BOOST_CHECK(container.nodePositions() == expected);
+}
+
+BOOST_AUTO_TEST_CASE( test_cell_visitor ) {
+	shared_ptr<Mesh> mesh(new Mesh(LogLevel::INFO, "test"));
+	for (int i = 1; i <= 4; i++) {
+		mesh->addNode(i, i, 0, 0);
+	}
+	mesh->addCell(10, CellType::SEG2, { 3, 4 });
+	mesh->addCell(11, CellType::SEG2, { 1, 2 });
+	mesh->addCell(12, CellType::TRI3, { 1, 2, 3 });
+	CellGroup* group = mesh->createCellGroup("GM");
+	group->addCell(12);
+	group->addCell(11);
+	vector<int> visitedIds;
+	group->forEachCell([&visitedIds](const CellView& cell) {
+		visitedIds.push_back(cell.id);
+	});
+	BOOST_CHECK(visitedIds == group->getCellIds());
+
+	CellContainer container(mesh);
+	container.addCell(10);
+	container.add(*group);
+	visitedIds.clear();
+	vector<int> visitedNodePositions;
+	container.forEachCell([&](const CellView& cell) {
+		visitedIds.push_back(cell.id);
+		visitedNodePositions.insert(visitedNodePositions.end(), cell.nodePositions.begin(),
+				cell.nodePositions.end());
+	}, true);
+	BOOST_CHECK(visitedIds == container.getCellIds(true));
+	vector<int> expectedNodePositions;
+	for (const Cell& cell : container.getCells(true)) {
+		for (int nodeId : cell.nodeIds) {
+			expectedNodePositions.push_back(mesh->findNodePosition(nodeId));
+		}
+	}
+	BOOST_CHECK(visitedNodePositions == expectedNodePositions);
+}
+
 BOOST_AUTO_TEST_CASE( test_node_iterator ) {
 	Mesh mesh(LogLevel::INFO, "test");
 	double coords[12] = { 1.0, 250., 0., 433., 250., 0., 0., -500., 0., 0., 0., 1000. };
@@ -119,6 +458,28 @@ BOOST_AUTO_TEST_CASE( test_node_iterator ) {
 	}
 	BOOST_CHECK_EQUAL(mesh.countNodes(), i);
 }
+
+BOOST_AUTO_TEST_CASE( test_node_coordinates ) {
+	Mesh mesh(LogLevel::INFO, "test");
+	mesh.addNode(10, 1., 2., 3.);
+	mesh.addNode(20, 4., 5., 6., 7);
+	// redefining a node overwrites its coordinates in place
+	mesh.addNode(10, -1., -2., -3.);
+	const vector<double> expected = { -1., -2., -3., 4., 5., 6. };
+	const vector<double>& coordinates = mesh.nodes.getCoordinates();
+	BOOST_CHECK_EQUAL_COLLECTIONS(coordinates.begin(), coordinates.end(), expected.begin(),
+			expected.end());
+	const vector<int> expectedIds = { 10, 20 };
+	const vector<int>& ids = mesh.nodes.getIds();
+	BOOST_CHECK_EQUAL_COLLECTIONS(ids.begin(), ids.end(), expectedIds.begin(), expectedIds.end());
+
+	mesh.allowDOFS(1, DOFS::TRANSLATIONS);
+	const Node node = mesh.findNode(1);
+	BOOST_CHECK_EQUAL(20, node.id);
+	BOOST_CHECK_CLOSE(5., node.y, DOUBLE_COMPARE_TOLERANCE);
+	BOOST_CHECK_EQUAL(7, node.displacementCS);
+	BOOST_CHECK(node.dofs == DOFS::TRANSLATIONS);
+}
 /* API change, review the test
  BOOST_AUTO_TEST_CASE( test_CellGroup2Families ) {
  vector<CellGroup *> cellGroups;
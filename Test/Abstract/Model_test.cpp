@@ -18,8 +18,12 @@
 #include "build_properties.h"
 #include "../../Abstract/ConfigurationParameters.h"
 #include "../../Abstract/Model.h"
+#include "../../Abstract/PassScheduler.h"
+#include "../../Abstract/WorkerPool.h"
+#include "../../Abstract/Profiler.h"
 #include <cstddef>
 #include <new>
+#include <sstream>
 #include <string>
 #include <vector>
 #ifdef __GNUC__
@@ -100,14 +104,15 @@ BOOST_AUTO_TEST_CASE( test_cells_iterator ) {
 //C++ style
 	for (i = 0; cellIterator != model.mesh->cells.cells_end(CellType::TRI3); cellIterator++) {
 		i++;
-		Cell cell(*(cellIterator));
+		const CellView cell = *cellIterator;
 		cout << cell << endl;
 	}
 	BOOST_CHECK_EQUAL(1, i);
 	BOOST_CHECKPOINT("Iteration new begin2");
 	CellIterator cellIterator2 = model.mesh->cells.cells_begin(CellType::SEG2);
 	for (i = 0; cellIterator2.hasNext(); i++) {
-		Cell cell = cellIterator2.next();
+		const CellView cell = cellIterator2.next();
+		BOOST_CHECK_EQUAL(2, cell.nodePositions.size());
 		cout << cell << endl;
 	}
 	BOOST_CHECK_EQUAL(3, i);
@@ -245,7 +250,8 @@ BOOST_AUTO_TEST_CASE( test_create_skin2d ) {
 	BOOST_CHECK_EQUAL(model->materials.size(), 1);
 	BOOST_CHECK(model->validate());
 	BOOST_REQUIRE_EQUAL(1, model->mesh->countCells(CellType::QUAD4));
-	Cell cell = model->mesh->cells.cells_begin(CellType::QUAD4).next();
+	const CellView cellView = model->mesh->cells.cells_begin(CellType::QUAD4).next();
+	Cell cell = model->mesh->findCell(cellView.position);
 	BOOST_CHECK_EQUAL_COLLECTIONS(cell.nodeIds.begin(), cell.nodeIds.end(),
 			expectedFace1NodeIds.begin(), expectedFace1NodeIds.end());
 }
@@ -367,6 +373,80 @@ BOOST_AUTO_TEST_CASE( combined_loadset1 ) {
 	BOOST_CHECK_EQUAL(model.getLoadingsByLoadSet(combination).size(), (size_t ) 3);
 }
 
+BOOST_AUTO_TEST_CASE( set_membership ) {
+	Model model("inputfile", "10.3", SolverName::NASTRAN);
+	model.mesh->addNode(1, 0.0, 0.0, 0.0);
+	NodalForce force1(model, 1, 0.0, 1.0);
+	NodalForce force2(model, 2, 0.0, 1.0);
+	// sets and loadings may be referenced before being added to the model
+	const Reference<LoadSet> loadSet1(LoadSet::LOAD, 1);
+	model.addLoadingIntoLoadSet(force1, loadSet1);
+	model.addLoadingIntoLoadSet(force1, model.commonLoadSet);
+	model.addLoadingIntoLoadSet(force2, loadSet1);
+	model.add(force1);
+	model.add(force2);
+	BOOST_CHECK_EQUAL(model.getLoadSetsByLoading(force1).size(), 2);
+	BOOST_CHECK_EQUAL(model.getLoadSetsByLoading(force2).size(), 1);
+	// the common set is kept under its id and its original id
+	BOOST_CHECK_EQUAL(boost::distance(model.getLoadSetKeysByLoading(force1)), 3);
+	model.remove(force1.getReference());
+	BOOST_CHECK(model.getLoadSetsByLoading(force1).empty());
+	BOOST_CHECK(model.getLoadSetKeysByLoading(force1).empty());
+	BOOST_CHECK_EQUAL(model.getLoadingsByLoadSet(loadSet1).size(), 1);
+	BOOST_CHECK_EQUAL(model.getLoadingsByLoadSet(model.commonLoadSet).size(), 0);
+
+	SinglePointConstraint spc(model, DOFS::ALL_DOFS, 0.0);
+	spc.addNodeId(1);
+	model.add(spc);
+	const Reference<ConstraintSet> spcSetReference(ConstraintSet::SPC, 10);
+	model.addConstraintIntoConstraintSet(spc, spcSetReference);
+	model.addConstraintIntoConstraintSet(spc, model.commonConstraintSet);
+	// the SPC set is not in the model yet
+	BOOST_CHECK_EQUAL(model.getConstraintSetsByConstraint(spc).size(), 1);
+	BOOST_CHECK_EQUAL(boost::distance(model.getConstraintSetKeysByConstraint(spc)), 3);
+	ConstraintSet spcSet(model, ConstraintSet::SPC, 10);
+	model.add(spcSet);
+	BOOST_CHECK_EQUAL(model.getConstraintSetsByConstraint(spc).size(), 2);
+	model.remove(spc.getReference());
+	BOOST_CHECK(model.getConstraintSetsByConstraint(spc).empty());
+	BOOST_CHECK(model.getConstraintsByConstraintSet(spcSetReference).empty());
+}
+
+BOOST_AUTO_TEST_CASE( set_classification ) {
+	Model model("inputfile", "10.3", SolverName::NASTRAN);
+	LoadSet loadSet1(model, LoadSet::LOAD, 1);
+	LoadSet loadSet2(model, LoadSet::LOAD, 2);
+	LoadSet dloadSet(model, LoadSet::DLOAD, 3);
+	model.add(loadSet1);
+	model.add(loadSet2);
+	model.add(dloadSet);
+	LinearMecaStat analysis1(model, 1);
+	analysis1.add(loadSet1);
+	analysis1.add(loadSet2);
+	analysis1.add(dloadSet);
+	LinearMecaStat analysis2(model, 2);
+	analysis2.add(loadSet1);
+	analysis2.add(dloadSet);
+	model.add(analysis1);
+	model.add(analysis2);
+	BOOST_CHECK_EQUAL(model.getActiveLoadSets().size(), 3);
+	BOOST_CHECK(model.getActiveLoadSets()[0]->getReference() == loadSet1.getReference());
+	// DLOAD is never common
+	BOOST_REQUIRE_EQUAL(model.getCommonLoadSets().size(), 1);
+	BOOST_CHECK(model.getCommonLoadSets()[0]->getReference() == loadSet1.getReference());
+	BOOST_REQUIRE_EQUAL(model.getUncommonLoadSets().size(), 1);
+	BOOST_CHECK((*model.getUncommonLoadSets().begin())->getReference() == loadSet2.getReference());
+
+	// the classification follows the changes of the analyses
+	model.find(analysis2.getReference())->add(loadSet2);
+	BOOST_CHECK_EQUAL(model.getCommonLoadSets().size(), 2);
+	BOOST_CHECK(model.getUncommonLoadSets().empty());
+	model.remove(loadSet1.getReference());
+	BOOST_CHECK_EQUAL(model.getActiveLoadSets().size(), 2);
+	BOOST_CHECK_EQUAL(model.getCommonLoadSets().size(), 1);
+	BOOST_CHECK(model.getActiveConstraintSets().empty());
+}
+
 BOOST_AUTO_TEST_CASE( reference_compare ) {
 	Reference<LoadSet> rauto1(LoadSet::LOAD, Reference<LoadSet>::NO_ID, 1);
 	BOOST_CHECK(rauto1 == rauto1);
@@ -503,5 +583,375 @@ BOOST_AUTO_TEST_CASE(test_spc_dof_remove) {
 		}
 	}
 }
+BOOST_AUTO_TEST_CASE(test_spc_table) {
+	Model model("inputfile", "10.3", SolverName::NASTRAN);
+	const int position1 = model.mesh->findOrReserveNode(1);
+	const int position2 = model.mesh->findOrReserveNode(2);
+	const int position3 = model.mesh->findOrReserveNode(3);
+	SinglePointConstraintTable table;
+	table.add(1, position2, DOFS::TRANSLATIONS, 0.0);
+	table.add(1, position1, DOF::DX, 0.0);
+	table.add(1, position1, DOFS::TRANSLATIONS - DOF::DX, 0.0);
+	table.add(1, position3, DOF::DZ, 2.0);
+	table.add(1, position3, DOF::DZ, 3.0);
+	table.add(2, position1, DOFS::ALL_DOFS, 0.0);
+	// as an SPC1 card
+	SinglePointConstraint groupConstraint(model, DOF::RX, 1.0);
+	NodeGroup* nodeGroup = model.mesh->createNodeGroup("SPC1_GROUP");
+	nodeGroup->addNode(1);
+	groupConstraint.group = nodeGroup;
+	table.add(2, groupConstraint);
+	BOOST_CHECK_EQUAL(table.size(), 7);
+	const vector<string> conflicts = table.conflicts(model);
+	BOOST_REQUIRE_EQUAL(conflicts.size(), 2);
+	BOOST_CHECK(conflicts[0].find("SPC set 1") != string::npos);
+	BOOST_CHECK(conflicts[1].find("SPC set 2") != string::npos);
+	// the translations of nodes 1 and 2, the two values of node 3, and set 2 with the group
+	BOOST_CHECK_EQUAL(table.flush(model), 5);
+	BOOST_CHECK(table.empty());
+	const Reference<ConstraintSet> set1(ConstraintSet::SPC, 1);
+	int twoNodesCount = 0;
+	for (const auto& constraint : model.getConstraintsByConstraintSet(set1)) {
+		const set<int> nodePositions = constraint->nodePositions();
+		if (nodePositions.size() == 2) {
+			twoNodesCount++;
+			BOOST_CHECK(nodePositions.find(position1) != nodePositions.end());
+			BOOST_CHECK_EQUAL(constraint->getDOFSForNode(position2), DOFS::TRANSLATIONS);
+		} else {
+			BOOST_CHECK_EQUAL(*nodePositions.begin(), position3);
+			BOOST_CHECK_EQUAL(constraint->getDOFSForNode(position3), DOF::DZ);
+		}
+	}
+	BOOST_CHECK_EQUAL(twoNodesCount, 1);
+	BOOST_CHECK_EQUAL(model.getConstraintsByConstraintSet(set1).size(), 3);
+	const Reference<ConstraintSet> set2(ConstraintSet::SPC, 2);
+	BOOST_CHECK_EQUAL(model.getConstraintsByConstraintSet(set2).size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_replace_direct_matrices) {
+	Model model("inputfile", "10.3", SolverName::NASTRAN);
+	model.mesh->addNode(1, 0.0, 0.0, 0.0);
+	model.mesh->addNode(2, 1.0, 0.0, 0.0);
+	model.mesh->addNode(3, 2.0, 0.0, 0.0);
+	model.mesh->addCell(1, CellType::SEG2, {1, 2});
+	vega::CellGroup* beamGroup = model.mesh->createCellGroup("GM1");
+	beamGroup->addCell(1);
+	RectangularSectionBeam beam(model, 100.0, 110.0, Beam::EULER, 1);
+	beam.assignCellGroup(beamGroup);
+	beam.assignMaterial(1);
+	model.add(beam);
+	model.getOrCreateMaterial(1)->addNature(ElasticNature(model, 1, 0));
+	// a spring between a node of the beam and a free node
+	StiffnessMatrix matrix(model);
+	matrix.addStiffness(2, DOF::DZ, 3, DOF::DZ, 1e6);
+	model.add(matrix);
+	model.finish();
+
+	BOOST_CHECK_EQUAL(model.filterElements(ElementSet::STIFFNESS_MATRIX).size(), 0);
+	BOOST_CHECK_EQUAL(model.filterElements(ElementSet::DISCRETE_1D).size(), 1);
+	// the translations of the free node are blocked, the node of the beam already having
+	// all its dofs
+	const int freeNodePosition = model.mesh->findNodePosition(3);
+	int spcCount = 0;
+	for (const auto& constraint : model.constraints) {
+		if (constraint->type != Constraint::SPC) {
+			continue;
+		}
+		spcCount++;
+		BOOST_CHECK(constraint->nodePositions() == set<int>{freeNodePosition});
+		BOOST_CHECK_EQUAL(constraint->getDOFSForNode(freeNodePosition), DOFS::TRANSLATIONS);
+	}
+	BOOST_CHECK_EQUAL(spcCount, 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_replace_chained_direct_matrices) {
+	Model model("inputfile", "10.3", SolverName::NASTRAN);
+	model.mesh->addNode(1, 0.0, 0.0, 0.0);
+	model.mesh->addNode(2, 1.0, 0.0, 0.0);
+	model.mesh->addNode(3, 2.0, 0.0, 0.0);
+	model.mesh->addNode(4, 3.0, 0.0, 0.0);
+	model.mesh->addCell(1, CellType::SEG2, {1, 2});
+	vega::CellGroup* beamGroup = model.mesh->createCellGroup("GM1");
+	beamGroup->addCell(1);
+	RectangularSectionBeam beam(model, 100.0, 110.0, Beam::EULER, 1);
+	beam.assignCellGroup(beamGroup);
+	beam.assignMaterial(1);
+	model.add(beam);
+	model.getOrCreateMaterial(1)->addNature(ElasticNature(model, 1, 0));
+	// springs in a chain: the discrete replacing the first one gives its translations to
+	// the node shared with the second one
+	StiffnessMatrix matrix1(model);
+	matrix1.addStiffness(2, DOF::DZ, 3, DOF::DZ, 1e6);
+	model.add(matrix1);
+	StiffnessMatrix matrix2(model);
+	matrix2.addStiffness(3, DOF::DZ, 4, DOF::DZ, 1e6);
+	model.add(matrix2);
+	model.finish();
+
+	BOOST_CHECK_EQUAL(model.filterElements(ElementSet::STIFFNESS_MATRIX).size(), 0);
+	BOOST_CHECK_EQUAL(model.filterElements(ElementSet::DISCRETE_1D).size(), 2);
+	const int lastNodePosition = model.mesh->findNodePosition(4);
+	int spcCount = 0;
+	for (const auto& constraint : model.constraints) {
+		if (constraint->type != Constraint::SPC) {
+			continue;
+		}
+		spcCount++;
+		BOOST_CHECK(constraint->nodePositions() == set<int>{lastNodePosition});
+		BOOST_CHECK_EQUAL(constraint->getDOFSForNode(lastNodePosition), DOFS::TRANSLATIONS);
+	}
+	BOOST_CHECK_EQUAL(spcCount, 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_boundary_dofs) {
+	shared_ptr<Model> model = createModelWith1HEXA8();
+	LinearMecaStat analysis1(*model, 1);
+	LinearMecaStat analysis2(*model, 2);
+	SinglePointConstraint spc(*model, DOFS::ALL_DOFS, 0.0);
+	spc.addNodeId(50);
+	model->add(spc);
+	model->addConstraintIntoConstraintSet(spc, model->commonConstraintSet);
+	model->add(analysis1);
+	model->add(analysis2);
+	model->finish();
+
+	const int nodePosition = model->mesh->findNodePosition(50);
+	for (const auto& analysis : model->analyses) {
+		BOOST_CHECK_EQUAL(analysis->findBoundaryDOFS(nodePosition), DOFS::ALL_DOFS);
+		BOOST_CHECK_EQUAL(analysis->findBoundaryDOFS(model->mesh->findNodePosition(51)),
+				DOFS::NO_DOFS);
+		BOOST_CHECK_EQUAL(analysis->findBoundaryDOFS(1000), DOFS::NO_DOFS);
+		BOOST_CHECK_EQUAL(analysis->boundaryNodePositions().size(), 1);
+	}
+	// the rotations blocked on a solid node are carried by a virtual discrete
+	BOOST_CHECK_EQUAL(model->mesh->findNode(nodePosition).dofs, DOFS::ALL_DOFS);
+	BOOST_CHECK_EQUAL(model->mesh->findNode(model->mesh->findNodePosition(51)).dofs,
+			DOFS::TRANSLATIONS);
+	BOOST_CHECK(model->mesh->findGroup("VDiscrTR") != nullptr);
+	BOOST_CHECK(model->mesh->findGroup("VDiscrT") == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(test_pass_scheduler) {
+	typedef PassScheduler S;
+	vector<string> sequence;
+	PassScheduler sequential;
+	sequential.add("mesh", S::MESH, S::MESH, [&sequence]() {sequence.push_back("mesh");});
+	sequential.add("loads", S::LOADINGS, S::LOADINGS, [&sequence]() {sequence.push_back("loads");});
+	sequential.add("both", S::MESH | S::LOADINGS, S::ANALYSES,
+			[&sequence]() {sequence.push_back("both");});
+	sequential.add("analyses", S::ANALYSES, S::ANALYSES,
+			[&sequence]() {sequence.push_back("analyses");});
+	sequential.add("objectives", S::OBJECTIVES, S::OBJECTIVES,
+			[&sequence]() {sequence.push_back("objectives");});
+	const vector<vector<size_t>> waves = sequential.waves();
+	BOOST_REQUIRE_EQUAL(waves.size(), 3);
+	vector<size_t> expectedFirstWave = { 0, 1, 4 };
+	BOOST_CHECK_EQUAL_COLLECTIONS(waves[0].begin(), waves[0].end(), expectedFirstWave.begin(),
+			expectedFirstWave.end());
+	BOOST_CHECK_EQUAL(waves[1].size(), 1);
+	BOOST_CHECK_EQUAL(waves[2].size(), 1);
+	sequential.run();
+	vector<string> expectedSequence = { "mesh", "loads", "both", "analyses", "objectives" };
+	BOOST_CHECK_EQUAL_COLLECTIONS(sequence.begin(), sequence.end(), expectedSequence.begin(),
+			expectedSequence.end());
+
+	vector<int> runs(3, 0);
+	PassScheduler concurrent(2);
+	concurrent.add("first", S::MESH, 0, [&runs]() {runs[0]++;});
+	concurrent.add("failing", S::MESH, 0, [&runs]() {
+		runs[1]++;
+		throw logic_error("failing pass");
+	});
+	concurrent.add("third", S::MESH, 0, [&runs]() {runs[2]++;});
+	BOOST_CHECK_EQUAL(concurrent.waves().size(), 1);
+	BOOST_CHECK_THROW(concurrent.run(), logic_error);
+	BOOST_CHECK_EQUAL(runs[0] + runs[1] + runs[2], 3);
+
+	vector<int> squares(100, 0);
+	PassScheduler::forEach(squares.size(), 3, [&squares](size_t i) {
+		squares[i] = static_cast<int>(i * i);
+	});
+	BOOST_CHECK_EQUAL(squares[99], 99 * 99);
+	// the threads of a pool are kept for the next rounds
+	WorkerPool pool(3);
+	for (int round = 1; round <= 2; round++) {
+		PassScheduler::forEach(&pool, squares.size(), [&squares, round](size_t i) {
+			squares[i] = round * static_cast<int>(i);
+		});
+		BOOST_CHECK_EQUAL(squares[99], round * 99);
+	}
+	BOOST_CHECK_THROW(PassScheduler::forEach(&pool, squares.size(), [](size_t i) {
+		if (i == 50) {
+			throw logic_error("task");
+		}
+	}), logic_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_finish_threads) {
+	vector<shared_ptr<Model>> models;
+	for (unsigned int threads : { 1u, 4u }) {
+		shared_ptr<Model> model = createModelWith1HEXA8();
+		model->configuration.finishThreads = threads;
+		LinearMecaStat analysis1(*model, 1);
+		LinearMecaStat analysis2(*model, 2);
+		SinglePointConstraint spc(*model, DOFS::TRANSLATIONS, 0.0);
+		spc.addNodeId(50);
+		model->add(spc);
+		model->addConstraintIntoConstraintSet(spc, model->commonConstraintSet);
+		NodalForce force(*model, 56, 1.0);
+		model->add(force);
+		model->addLoadingIntoLoadSet(force, model->commonLoadSet);
+		model->add(analysis1);
+		model->add(analysis2);
+		model->finish();
+		models.push_back(model);
+	}
+	Model& sequential = *models[0];
+	Model& concurrent = *models[1];
+	BOOST_CHECK(concurrent.validate());
+	BOOST_CHECK_EQUAL(sequential.constraints.size(), concurrent.constraints.size());
+	BOOST_CHECK_EQUAL(sequential.constraintSets.size(), concurrent.constraintSets.size());
+	BOOST_CHECK_EQUAL(sequential.loadings.size(), concurrent.loadings.size());
+	BOOST_CHECK_EQUAL(sequential.elementSets.size(), concurrent.elementSets.size());
+	BOOST_CHECK_EQUAL(sequential.mesh->countCells(), concurrent.mesh->countCells());
+	BOOST_CHECK_EQUAL(sequential.getCommonLoadSets().size(), concurrent.getCommonLoadSets().size());
+	BOOST_CHECK(concurrent.getOrCreateMaterial(1)->getAssignment().hasCellGroups());
+	for (const auto& analysis : concurrent.analyses) {
+		const int nodePosition = concurrent.mesh->findNodePosition(50);
+		BOOST_CHECK_EQUAL(analysis->findBoundaryDOFS(nodePosition), DOFS::TRANSLATIONS);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_model_arena) {
+	shared_ptr<Loading> loading;
+	{
+		Model model("inputfile", "10.3", SolverName::NASTRAN);
+		const size_t allocationCount = model.getArena()->getAllocationCount();
+		NodalForce force(model, 1, 1.0);
+		model.add(force);
+		model.addLoadingIntoLoadSet(force, model.commonLoadSet);
+		model.addLoadingIntoLoadSet(force, model.commonLoadSet);
+		// the loading and the common load set
+		BOOST_CHECK_EQUAL(model.getArena()->getAllocationCount(), allocationCount + 2);
+		BOOST_CHECK_EQUAL(model.getLoadingsByLoadSet(model.commonLoadSet).size(), 1);
+		loading = model.find(force.getReference());
+		model.remove(force.getReference());
+		BOOST_CHECK(model.getLoadingsByLoadSet(model.commonLoadSet).empty());
+	}
+	// the arena is kept alive by the objects allocated in it
+	BOOST_CHECK_EQUAL(loading->type, Loading::NODAL_FORCE);
+	// the orientations of the cells are held by the mesh, outside of the arena
+	Model model("inputfile", "10.3", SolverName::NASTRAN);
+	const TwoNodesOrientation orientation(model, 1, 3);
+	const size_t allocationCount = model.getArena()->getAllocationCount();
+	for (int cellId = 1; cellId <= 10; cellId++) {
+		model.mesh->addCell(cellId, CellType::SEG2, { 1, 2 }, false, &orientation);
+	}
+	BOOST_CHECK_EQUAL(model.getArena()->getAllocationCount(), allocationCount);
+}
+
+/**
+ * Leaves the profiler disabled and empty, as the other tests expect it, even if a test fails.
+ */
+class ProfilerReset {
+public:
+	~ProfilerReset() {
+		Profiler::instance().disable();
+		Profiler::instance().reset();
+	}
+};
+
+BOOST_FIXTURE_TEST_CASE(test_profiler_phases, ProfilerReset) {
+	Profiler& profiler = Profiler::instance();
+	BOOST_CHECK(!profiler.isEnabled());
+	{
+		Profiler::Scope ignored("ignored");
+	}
+	BOOST_CHECK(profiler.getPhases().empty());
+
+	profiler.enable();
+	Model model("inputfile", "10.3", SolverName::NASTRAN);
+	model.mesh->addNode(1, 0.0, 0.0, 0.0);
+	model.mesh->addNode(2, 1.0, 0.0, 0.0);
+	model.mesh->addCell(1, CellType::SEG2, {1, 2});
+	model.finish();
+
+	const vector<Profiler::Phase>& phases = profiler.getPhases();
+	BOOST_REQUIRE(!phases.empty());
+	BOOST_CHECK_EQUAL(phases[0].path, "finish");
+	BOOST_CHECK_EQUAL(phases[0].parent, -1);
+	bool replaceDirectMatricesFound = false;
+	for (size_t i = 1; i < phases.size(); i++) {
+		BOOST_CHECK_EQUAL(phases[i].parent, 0);
+		BOOST_CHECK_EQUAL(phases[i].depth, 1);
+		BOOST_CHECK(phases[i].seconds >= 0);
+		if (phases[i].path == "finish/replaceDirectMatrices") {
+			replaceDirectMatricesFound = true;
+		}
+	}
+	BOOST_CHECK(replaceDirectMatricesFound);
+	{
+		Profiler::Scope writeScope("write");
+		writeScope.addWrittenBytes(1000);
+		writeScope.addWrittenBytes(24);
+	}
+	BOOST_CHECK_EQUAL(profiler.getPhases().back().writtenBytes, 1024);
+
+	ostringstream json;
+	profiler.writeJson(json);
+	BOOST_CHECK(json.str().find("\"path\": \"finish/Mesh::finish\"") != string::npos);
+	BOOST_CHECK(json.str().find("\"writtenBytes\": 1024, \"megabytesPerSecond\": ") != string::npos);
+
+	const size_t phaseCount = profiler.getPhases().size();
+	profiler.disable();
+	BOOST_CHECK(!profiler.isEnabled());
+	{
+		Profiler::Scope ignored("ignored");
+	}
+	BOOST_CHECK_EQUAL(profiler.getPhases().size(), phaseCount);
+	{
+		profiler.enable();
+		Profiler::Scope open("open");
+		BOOST_CHECK_THROW(profiler.reset(), logic_error);
+	}
+	profiler.reset();
+	BOOST_CHECK(profiler.getPhases().empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(test_profiler_concurrent_passes, ProfilerReset) {
+	typedef PassScheduler S;
+	Profiler& profiler = Profiler::instance();
+	profiler.enable();
+	PassScheduler scheduler(2);
+	scheduler.add("mesh", S::MESH, S::MESH, []() {
+		Profiler::Scope scope("mesh");
+		Profiler::Scope nested("nested");
+	});
+	scheduler.add("loads", S::LOADINGS, S::LOADINGS, []() {Profiler::Scope scope("loads");});
+	scheduler.add("analyses", S::MESH | S::LOADINGS, S::ANALYSES,
+			[]() {Profiler::Scope scope("analyses");});
+	scheduler.add("objectives", S::MESH, S::OBJECTIVES,
+			[]() {Profiler::Scope scope("objectives");});
+	{
+		Profiler::Scope finishScope("finish");
+		scheduler.run();
+	}
+	vector<string> paths;
+	for (const Profiler::Phase& phase : profiler.getPhases()) {
+		paths.push_back(phase.path + ":" + to_string(phase.depth));
+	}
+	// the passes run by worker threads are reported under their wave, in order of addition
+	const vector<string> expectedPaths = { "finish:0", "finish/mesh+loads:1",
+			"finish/mesh+loads/mesh:2", "finish/mesh+loads/mesh/nested:3",
+			"finish/mesh+loads/loads:2", "finish/analyses+objectives:1",
+			"finish/analyses+objectives/analyses:2", "finish/analyses+objectives/objectives:2" };
+	BOOST_CHECK_EQUAL_COLLECTIONS(paths.begin(), paths.end(), expectedPaths.begin(),
+			expectedPaths.end());
+	for (const Profiler::Phase& phase : profiler.getPhases()) {
+		BOOST_CHECK(phase.parent < 0 || phase.path.find(
+				profiler.getPhases()[static_cast<size_t>(phase.parent)].path + "/") == 0);
+	}
+}
+
 //____________________________________________________________________________//
 
@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) Alneos, s. a r. l. (contact@alneos.fr)
+ * Released under the GNU General Public License
+ *
+ * AsterWriter_test.cpp
+ *
+ * Command and MED files written by the Aster writer.
+ */
+
+#define BOOST_TEST_MODULE aster_writer_tests
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+
+#include "../../Abstract/Profiler.h"
+#include "../../Aster/AsterWriter.h"
+#include "../../Nastran/NastranFacade.h"
+
+using namespace std;
+using namespace vega;
+using vega::aster::AsterWriterImpl;
+namespace fs = boost::filesystem;
+
+namespace {
+
+/**
+ * Three shells pressed by a PLOAD4, with an SPC on four of their nodes.
+ */
+void writeShellsDeck(const fs::path& deckPath) {
+	ofstream deck(deckPath.string());
+	deck << "SOL 101\nCEND\nSPC = 1\nLOAD = 2\nBEGIN BULK\n";
+	deck << "GRID    1               0.      0.      0.\n";
+	deck << "GRID    2               1.      0.      0.\n";
+	deck << "GRID    3               2.      0.      0.\n";
+	deck << "GRID    4               3.      0.      0.\n";
+	deck << "GRID    5               0.      1.      0.\n";
+	deck << "GRID    6               1.      1.      0.\n";
+	deck << "GRID    7               2.      1.      0.\n";
+	deck << "GRID    8               3.      1.      0.\n";
+	deck << "CQUAD4  1       1       1       2       6       5\n";
+	deck << "CQUAD4  2       1       2       3       7       6\n";
+	deck << "CQUAD4  3       1       3       4       8       7\n";
+	deck << "PSHELL  1       1       0.1\n";
+	deck << "MAT1    1       2.1+11          0.3\n";
+	deck << "SPC     1       1       123456  0.\n";
+	deck << "SPC     1       2       123456  0.\n";
+	deck << "SPC     1       3       123456  0.\n";
+	deck << "SPC     1       4       123456  0.\n";
+	deck << "PLOAD4  2       1       10.                             THRU    3\n";
+	deck << "ENDDATA\n";
+}
+
+string readFile(const fs::path& path) {
+	ifstream in(path.string());
+	ostringstream content;
+	content << in.rdbuf();
+	return content.str();
+}
+
+size_t countGroups(Mesh& mesh) {
+	return mesh.getNodeGroups().size() + mesh.getCellGroups().size();
+}
+
+/**
+ * A new temporary directory, removed with its content at the end of the scope, even when a
+ * check fails.
+ */
+class TemporaryDirectory final {
+public:
+	const fs::path path;
+	TemporaryDirectory() :
+			path(fs::temp_directory_path() / fs::unique_path("vega_%%%%%%%%")) {
+		fs::create_directories(path);
+	}
+	TemporaryDirectory(const TemporaryDirectory&) = delete;
+	TemporaryDirectory& operator=(const TemporaryDirectory&) = delete;
+	~TemporaryDirectory() {
+		boost::system::error_code ignored;
+		fs::remove_all(path, ignored);
+	}
+};
+
+/**
+ * The writer parameters set by the tests, the others keeping their default values.
+ */
+struct WriterOptions {
+	unsigned int writerThreads = 1;
+	unsigned int maxNameListSize = 1000;
+	bool concurrentMedWrite = false;
+};
+
+ConfigurationParameters writerConfiguration(const fs::path& deckPath,
+		const fs::path& outputDirectory, const WriterOptions& options = WriterOptions()) {
+	return ConfigurationParameters(deckPath.string(), CODE_ASTER, "", "",
+			outputDirectory.string(), LogLevel::INFO, ConfigurationParameters::BEST_EFFORT, "",
+			0.02, false, "", "", 1, "", 1, options.writerThreads, options.maxNameListSize,
+			options.concurrentMedWrite);
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(name_list_groups) {
+	const TemporaryDirectory temporaryDirectory;
+	const fs::path& directory = temporaryDirectory.path;
+	const fs::path deckPath = directory / "shells.dat";
+	writeShellsDeck(deckPath);
+	nastran::NastranParser parser;
+	const shared_ptr<Model> model = parser.parse(
+			ConfigurationParameters(deckPath.string(), CODE_ASTER, "", ""));
+	model->finish();
+
+	// the material is also assigned to the cells directly
+	BOOST_REQUIRE_EQUAL(model->materials.size(), 1);
+	const shared_ptr<Material> material = *model->materials.begin();
+	CellContainer cells(model->mesh);
+	for (int cellId = 1; cellId <= 3; cellId++) {
+		cells.addCell(cellId);
+	}
+	material->assignMaterial(cells);
+	shared_ptr<Constraint> spc;
+	for (const auto& constraint : model->constraints) {
+		if (constraint->type == Constraint::SPC) {
+			spc = constraint;
+		}
+	}
+	BOOST_REQUIRE(spc != nullptr);
+	shared_ptr<Loading> pressure;
+	for (const auto& loading : model->loadings) {
+		if (dynamic_pointer_cast<ElementLoading>(loading) != nullptr) {
+			pressure = loading;
+		}
+	}
+	BOOST_REQUIRE(pressure != nullptr);
+	// the name of the group of the SPC is already taken
+	const string spcName = "SPC" + to_string(spc->getId());
+	model->mesh->createNodeGroup(spcName)->addNode(8);
+	const size_t groupCount = countGroups(*model->mesh);
+
+	AsterWriterImpl listWriter;
+	listWriter.writeModel(model, writerConfiguration(deckPath, directory));
+	const string listComm = readFile(directory / "shells.comm");
+	BOOST_CHECK(listComm.find("NOEUD=(") != string::npos);
+	BOOST_CHECK(listComm.find("MAILLE=(") != string::npos);
+
+	WriterOptions groupOptions;
+	groupOptions.maxNameListSize = 1;
+	AsterWriterImpl groupWriter;
+	groupWriter.writeModel(model, writerConfiguration(deckPath, directory, groupOptions));
+	const string groupComm = readFile(directory / "shells.comm");
+	BOOST_CHECK(groupComm.find("NOEUD=(") == string::npos);
+	BOOST_CHECK(groupComm.find("MAILLE=(") == string::npos);
+	BOOST_CHECK(groupComm.find("GROUP_NO='" + spcName + "_1'") != string::npos);
+	BOOST_CHECK(groupComm.find("'LOAD" + to_string(pressure->getId()) + "'") != string::npos);
+	BOOST_CHECK(groupComm.find("'MAT" + to_string(material->getId()) + "'") != string::npos);
+	// the groups are only written in the MED file
+	BOOST_CHECK_EQUAL(countGroups(*model->mesh), groupCount);
+	BOOST_CHECK(fs::exists(directory / "shells.med"));
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_med_write) {
+	const TemporaryDirectory temporaryDirectory;
+	const fs::path& directory = temporaryDirectory.path;
+	const fs::path serialDirectory = directory / "serial";
+	const fs::path concurrentDirectory = directory / "concurrent";
+	fs::create_directories(serialDirectory);
+	fs::create_directories(concurrentDirectory);
+	const fs::path deckPath = directory / "shells.dat";
+	writeShellsDeck(deckPath);
+	nastran::NastranParser parser;
+	const shared_ptr<Model> model = parser.parse(
+			ConfigurationParameters(deckPath.string(), CODE_ASTER, "", ""));
+	model->finish();
+
+	// name list groups are written too, the largest sets being written as groups
+	for (bool concurrentMedWrite : { false, true }) {
+		const fs::path outputDirectory = concurrentMedWrite ? concurrentDirectory : serialDirectory;
+		WriterOptions options;
+		options.maxNameListSize = 1;
+		options.concurrentMedWrite = concurrentMedWrite;
+		AsterWriterImpl writer;
+		writer.writeModel(model, writerConfiguration(deckPath, outputDirectory, options));
+	}
+	const string serialComm = readFile(serialDirectory / "shells.comm");
+	BOOST_CHECK(!serialComm.empty());
+	BOOST_CHECK(serialComm == readFile(concurrentDirectory / "shells.comm"));
+	// MED files hold their modification times, only their sizes can be compared
+	BOOST_REQUIRE(fs::exists(concurrentDirectory / "shells.med"));
+	BOOST_CHECK_EQUAL(fs::file_size(serialDirectory / "shells.med"),
+			fs::file_size(concurrentDirectory / "shells.med"));
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_med_write_phases) {
+	const TemporaryDirectory temporaryDirectory;
+	const fs::path& directory = temporaryDirectory.path;
+	const fs::path deckPath = directory / "shells.dat";
+	writeShellsDeck(deckPath);
+	nastran::NastranParser parser;
+	const shared_ptr<Model> model = parser.parse(
+			ConfigurationParameters(deckPath.string(), CODE_ASTER, "", ""));
+	model->finish();
+
+	Profiler& profiler = Profiler::instance();
+	profiler.enable();
+	WriterOptions options;
+	options.concurrentMedWrite = true;
+	AsterWriterImpl writer;
+	writer.writeModel(model, writerConfiguration(deckPath, directory, options));
+	profiler.disable();
+	set<string> paths;
+	for (const Profiler::Phase& phase : profiler.getPhases()) {
+		paths.insert(phase.path);
+	}
+	profiler.reset();
+	// the stages of the MED thread are reported once it is joined
+	for (const char* stage : { "writeMEDNodes", "buildMEDConnectivity", "writeMEDCells",
+			"writeMEDFamilies" }) {
+		BOOST_CHECK_MESSAGE(paths.count(string("writeMED+writeComm/writeMED/") + stage) == 1,
+				stage);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(aster_group_names) {
+	BOOST_CHECK_EQUAL(AsterWriterImpl::asterGroupName("SPC12_3"), "SPC12_3");
+	const string name(AsterWriterImpl::MAX_GROUP_NAME_LENGTH, 'A');
+	BOOST_CHECK_EQUAL(AsterWriterImpl::asterGroupName(name), name);
+	const string longName = name + "1";
+	const string shortName = AsterWriterImpl::asterGroupName(longName);
+	BOOST_CHECK_EQUAL(shortName.size(), AsterWriterImpl::MAX_GROUP_NAME_LENGTH);
+	BOOST_CHECK_EQUAL(shortName.substr(0, 10), longName.substr(0, 10));
+	BOOST_CHECK_NE(shortName, AsterWriterImpl::asterGroupName(name + "2"));
+	BOOST_CHECK_EQUAL(shortName, AsterWriterImpl::asterGroupName(longName));
+}
@@ -10,9 +10,11 @@
 
 #define BOOST_TEST_MODULE nastran_parser_tests
 #include "../../Nastran/NastranFacade.h"
+#include "../../Abstract/ModelSnapshot.h"
 #include "build_properties.h"
 #include <boost/test/unit_test.hpp>
 #include <boost/filesystem.hpp>
+#include <fstream>
 #include <iostream>
 #ifdef __GNUC__
 #include <valgrind/memcheck.h>
@@ -21,6 +23,34 @@
 using namespace std;
 using namespace vega;
 
+namespace {
+
+void checkSameMesh(const shared_ptr<Model> expectedModel, const shared_ptr<Model> model) {
+	const shared_ptr<Mesh> expectedMesh = expectedModel->mesh;
+	const shared_ptr<Mesh> mesh = model->mesh;
+	BOOST_CHECK_EQUAL(expectedMesh->countNodes(), mesh->countNodes());
+	BOOST_CHECK_EQUAL(expectedMesh->countCells(), mesh->countCells());
+	const vector<double>& expectedCoordinates = expectedMesh->nodes.getCoordinates();
+	const vector<double>& coordinates = mesh->nodes.getCoordinates();
+	BOOST_CHECK_EQUAL_COLLECTIONS(expectedCoordinates.begin(), expectedCoordinates.end(),
+			coordinates.begin(), coordinates.end());
+	const vector<int>& expectedIds = expectedMesh->nodes.getIds();
+	const vector<int>& ids = mesh->nodes.getIds();
+	BOOST_CHECK_EQUAL_COLLECTIONS(expectedIds.begin(), expectedIds.end(), ids.begin(), ids.end());
+	for (int position = 0; position < min(expectedMesh->countCells(), mesh->countCells());
+			position++) {
+		const CellView expectedCell = expectedMesh->findCellView(position);
+		const CellView cell = mesh->findCellView(position);
+		BOOST_CHECK_EQUAL(expectedCell.id, cell.id);
+		BOOST_CHECK_EQUAL_COLLECTIONS(expectedCell.nodePositions.begin(),
+				expectedCell.nodePositions.end(), cell.nodePositions.begin(),
+				cell.nodePositions.end());
+	}
+	BOOST_CHECK_EQUAL(expectedModel->constraints.size(), model->constraints.size());
+}
+
+}
+
 //____________________________________________________________________________//
 
 BOOST_AUTO_TEST_CASE( nastran_med_write ) {
@@ -94,3 +124,169 @@ BOOST_AUTO_TEST_CASE(test_comments_in_the_end) {
 	//expected 1 material elastic
 }
 //____________________________________________________________________________//
+
+BOOST_AUTO_TEST_CASE( test_parser_threads ) {
+	for (const string deck : { "test1.nas", "include.dat", "bush.dat" }) {
+		string testLocation = fs::path(
+		PROJECT_BASE_DIR "/testdata/unitTest/nastranparser/" + deck).make_preferred().string();
+		nastran::NastranParser parser;
+		const shared_ptr<Model> serialModel = parser.parse(
+				ConfigurationParameters(testLocation, CODE_ASTER, "", "", ".", LogLevel::INFO,
+						ConfigurationParameters::BEST_EFFORT));
+		const shared_ptr<Model> parallelModel = parser.parse(
+				ConfigurationParameters(testLocation, CODE_ASTER, "", "", ".", LogLevel::INFO,
+						ConfigurationParameters::BEST_EFFORT, "", 0.02, false, "", "", 4));
+		checkSameMesh(serialModel, parallelModel);
+	}
+}
+
+BOOST_AUTO_TEST_CASE( test_model_snapshot ) {
+	const fs::path directory = fs::temp_directory_path() / fs::unique_path("vega_%%%%%%%%");
+	const fs::path cacheDirectory = directory / "cache";
+	fs::create_directories(directory);
+	{
+		ofstream deck((directory / "cached.dat").string());
+		deck << "SOL 101\nCEND\nSPC = 1\nLOAD = 2\nBEGIN BULK\n";
+		deck << "GRID    1               0.      0.      0.\n";
+		deck << "GRID    2               1.      0.      0.              123456\n";
+		deck << "GRID    3               1.      1.-1    0.\n";
+		deck << "GRID,4,,0.,1.,0.\n";
+		deck << "SPC1    1       123456  1       4\n";
+		deck << "FORCE   2       3               1000.   0.      0.      1.\n";
+		deck << "MAT1    1       2.1+11          0.3\n";
+		deck << "CQUAD4  1       1       1       2       3       4\n";
+		deck << "INCLUDE 'cached_included.dat'\n";
+		deck << "PSHELL  1       1       0.1     1\n";
+		deck << "CTRIA3  3       1       4       5       6       30.\n";
+		deck << "ENDDATA\n";
+		ofstream included((directory / "cached_included.dat").string());
+		included << "GRID    5               2.      0.      0.\n";
+		included << "CTRIA3  2       1       2       5       6\n";
+		included << "GRID    6               2.      1.      0.\n";
+	}
+	const string testLocation = (directory / "cached.dat").string();
+	const ConfigurationParameters configuration(testLocation, CODE_ASTER, "", "", ".",
+			LogLevel::INFO, ConfigurationParameters::BEST_EFFORT, "", 0.02, false, "", "", 1,
+			cacheDirectory);
+	nastran::NastranParser parser;
+	const shared_ptr<Model> model = parser.parse(configuration);
+	model->finish();
+	BOOST_CHECK_EQUAL(model->inputFiles.size(), 2u);
+	{
+		ModelSnapshot snapshot(configuration);
+		BOOST_CHECK(!snapshot.isValid());
+		BOOST_CHECK(snapshot.load() == nullptr);
+		snapshot.write(*model);
+		BOOST_CHECK(fs::exists(snapshot.getPath()));
+	}
+	ModelSnapshot snapshot(configuration);
+	BOOST_REQUIRE(snapshot.isValid());
+	const shared_ptr<Model> loadedModel = snapshot.load();
+	BOOST_REQUIRE(loadedModel != nullptr);
+	BOOST_CHECK(loadedModel->finished);
+	checkSameMesh(model, loadedModel);
+	BOOST_CHECK_EQUAL(model->mesh->getNodeGroups().size(),
+			loadedModel->mesh->getNodeGroups().size());
+	for (CellGroup* cellGroup : model->mesh->getCellGroups()) {
+		const Group* loadedGroup = loadedModel->mesh->findGroup(cellGroup->getName());
+		BOOST_REQUIRE(loadedGroup != nullptr);
+		BOOST_CHECK(cellGroup->nodePositions() == loadedGroup->nodePositions());
+	}
+	BOOST_CHECK_EQUAL(model->elementSets.size(), loadedModel->elementSets.size());
+	BOOST_CHECK_EQUAL(model->materials.size(), loadedModel->materials.size());
+	BOOST_CHECK_EQUAL(model->loadings.size(), loadedModel->loadings.size());
+	BOOST_CHECK_EQUAL(model->loadSets.size(), loadedModel->loadSets.size());
+	BOOST_CHECK_EQUAL(model->constraints.size(), loadedModel->constraints.size());
+	BOOST_CHECK_EQUAL(model->constraintSets.size(), loadedModel->constraintSets.size());
+	BOOST_CHECK_EQUAL(model->analyses.size(), loadedModel->analyses.size());
+	for (const auto& elementSet : model->elementSets) {
+		const auto loadedElementSet = loadedModel->elementSets.find(
+				Reference<ElementSet>(*elementSet));
+		BOOST_REQUIRE(loadedElementSet != nullptr);
+		BOOST_CHECK_EQUAL(elementSet->getId(), loadedElementSet->getId());
+		BOOST_CHECK_EQUAL(elementSet->getOriginalId(), loadedElementSet->getOriginalId());
+		BOOST_CHECK_EQUAL(elementSet->cellGroup->getName(), loadedElementSet->cellGroup->getName());
+		BOOST_CHECK(elementSet->nodePositions() == loadedElementSet->nodePositions());
+	}
+	auto loadedConstraint = loadedModel->constraints.begin();
+	for (const auto& constraint : model->constraints) {
+		BOOST_CHECK_EQUAL(constraint->getId(), (*loadedConstraint)->getId());
+		BOOST_CHECK(constraint->nodePositions() == (*loadedConstraint)->nodePositions());
+		++loadedConstraint;
+	}
+
+	// any change in an include invalidates the snapshot
+	{
+		ofstream included((directory / "cached_included.dat").string(), ios::app);
+		included << "$ modified" << endl;
+	}
+	BOOST_CHECK(!ModelSnapshot(configuration).isValid());
+	fs::remove_all(directory);
+}
+
+BOOST_AUTO_TEST_CASE( test_spc_table ) {
+	const fs::path directory = fs::temp_directory_path() / fs::unique_path("vega_%%%%%%%%");
+	fs::create_directories(directory);
+	{
+		ofstream deck((directory / "spc.dat").string());
+		deck << "SOL 101\nCEND\nBEGIN BULK\n";
+		deck << "GRID    1               0.      0.      0.\n";
+		deck << "GRID    2               1.      0.      0.\n";
+		deck << "GRID    3               2.      0.      0.\n";
+		deck << "SPC     1       1       123     0.\n";
+		deck << "SPC     1       2       123     0.\n";
+		deck << "SPC1    1       456     3\n";
+		deck << "SPC     1       3       1       0.\n";
+		deck << "ENDDATA\n";
+		ofstream invalid((directory / "invalid.dat").string());
+		invalid << "SOL 101\nCEND\nBEGIN BULK\n";
+		invalid << "GRID    1               0.      0.      0.\n";
+		invalid << "SPC     1       1       123     0.\n";
+		invalid << "SPC     1       X       123     0.\n";
+		invalid << "ENDDATA\n";
+	}
+	nastran::NastranParser parser;
+	const shared_ptr<Model> model = parser.parse(
+			ConfigurationParameters((directory / "spc.dat").string(), CODE_ASTER, "", ""));
+	// the SPC cards of a constraint set are merged, after the SPC1 cards
+	vector<shared_ptr<SinglePointConstraint>> spcs;
+	for (const auto& constraint : model->constraints) {
+		if (constraint->type == Constraint::SPC) {
+			spcs.push_back(static_pointer_cast<SinglePointConstraint>(constraint));
+		}
+	}
+	BOOST_REQUIRE_EQUAL(spcs.size(), 3u);
+	BOOST_CHECK(spcs[0]->group != nullptr);
+	BOOST_CHECK_EQUAL(spcs[1]->nodePositions().size(), 2u);
+	BOOST_CHECK(spcs[1]->group == nullptr);
+	BOOST_CHECK(spcs[2]->getDOFSForNode(model->mesh->findNodePosition(3)) == DOFS(DOF::DX));
+
+	// the SPC cards read before an error are not added to the next model
+	BOOST_CHECK_THROW(parser.parse(ConfigurationParameters((directory / "invalid.dat").string(),
+			CODE_ASTER, "", "", ".", LogLevel::INFO, ConfigurationParameters::MODE_STRICT)),
+			ParsingException);
+	{
+		ofstream deck((directory / "nospc.dat").string());
+		deck << "SOL 101\nCEND\nBEGIN BULK\n";
+		deck << "GRID    1               0.      0.      0.\n";
+		deck << "ENDDATA\n";
+	}
+	const shared_ptr<Model> nextModel = parser.parse(
+			ConfigurationParameters((directory / "nospc.dat").string(), CODE_ASTER, "", ""));
+	BOOST_CHECK_EQUAL(nextModel->constraints.size(), 0);
+
+	// the values given to a DOF by the cards of a constraint set must agree
+	{
+		ofstream deck((directory / "conflict.dat").string());
+		deck << "SOL 101\nCEND\nBEGIN BULK\n";
+		deck << "GRID    1               0.      0.      0.\n";
+		deck << "SPC     1       1       1       0.\n";
+		deck << "GRID    2               1.      0.      0.\n";
+		deck << "SPC     1       1       1       1.\n";
+		deck << "ENDDATA\n";
+	}
+	BOOST_CHECK_THROW(parser.parse(ConfigurationParameters((directory / "conflict.dat").string(),
+			CODE_ASTER, "", "", ".", LogLevel::INFO, ConfigurationParameters::MODE_STRICT)),
+			ParsingException);
+	fs::remove_all(directory);
+}
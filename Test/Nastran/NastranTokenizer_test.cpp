@@ -12,8 +12,13 @@
 #define BOOST_TEST_MODULE nastran_tokenizer_tests
 #include <boost/test/unit_test.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <cmath>
 #include <cstddef>
+#include <cstring>
 #include <fstream>
+#include <random>
 #include <vector>
 
 namespace fs = boost::filesystem;
@@ -290,3 +295,248 @@ BOOST_AUTO_TEST_CASE(nastran_bar1r_grid) {
 	source.close();
 }
 
+
+vector<string> allSymbols(NastranTokenizer& tok) {
+	vector<string> symbols;
+	while (tok.nextSymbolType != NastranTokenizer::SYMBOL_EOF) {
+		const string prefix = tok.nextSymbolType == NastranTokenizer::SYMBOL_KEYWORD ? "K:" : "F:";
+		symbols.push_back(prefix + tok.nextSymbolString());
+	}
+	return symbols;
+}
+
+BOOST_AUTO_TEST_CASE(memory_mapped_file) {
+	const string content = "SOL 101\nCEND\nBEGIN BULK\n"
+			"$comment\n"
+			"GRID*   1               0.              1.5\n"
+			"*       -2.D+3\n"
+			"GRID,2,,1.,2.,3.,,+\n"
+			"+,123\n"
+			"CBAR    1       1\t2       3       1.      0.      1.\n"
+			"GRID    3               1.      2.      3.      $ trailing comment\n"
+			"ENDDATA";
+	const fs::path filePath = fs::temp_directory_path() / fs::unique_path("tok_%%%%%%%%.dat");
+	{
+		ofstream out(filePath.c_str());
+		out << content;
+	}
+	istringstream istr(content);
+	NastranTokenizer streamTok(istr);
+	NastranTokenizer mappedTok(filePath);
+	BOOST_CHECK_EQUAL(filePath.string(), mappedTok.fileName);
+	BOOST_CHECK_EQUAL("SOL", mappedTok.nextSymbolString());
+	streamTok.nextSymbolString();
+	while (mappedTok.nextSymbolString() != "BEGIN") {
+		mappedTok.nextLine();
+	}
+	while (streamTok.nextSymbolString() != "BEGIN") {
+		streamTok.nextLine();
+	}
+	streamTok.bulkSection();
+	mappedTok.bulkSection();
+	streamTok.nextLine();
+	mappedTok.nextLine();
+	BOOST_CHECK_EQUAL("GRID", mappedTok.nextSymbolString());
+	BOOST_CHECK_EQUAL(1, mappedTok.nextInt());
+	streamTok.skip(2);
+	vector<string> expected = allSymbols(streamTok);
+	vector<string> symbols = allSymbols(mappedTok);
+	BOOST_CHECK_EQUAL_COLLECTIONS(symbols.begin(), symbols.end(), expected.begin(), expected.end());
+	BOOST_CHECK_EQUAL(streamTok.lineNumber, mappedTok.lineNumber);
+	fs::remove(filePath);
+}
+
+BOOST_AUTO_TEST_CASE(locate_cards) {
+	const string content = "BEGIN BULK\n"
+			"GRID*   1               0.              1.5\n"
+			"*       -2.D+3\n"
+			"$comment\n"
+			"GRID,2,,1.,2.,3.,,+\n"
+			"+,123\n"
+			"CQUAD4\t1\t1\t1\t2\t3\t4\n"
+			"CHEXA   1       1       1       2       3       4       5       6       +C1\n"
+			"\n"
+			"+C1     7       8\n"
+			"CTRIA3  2       1       1       2       3\n"
+			"        0.1\n"
+			"cbar    1       1       2       3       1.      0.      1.\n"
+			"GRID    3               1.      2.      3.\n"
+			"ENDDATA";
+	const fs::path filePath = fs::temp_directory_path() / fs::unique_path("tok_%%%%%%%%.dat");
+	{
+		ofstream out(filePath.c_str());
+		out << content;
+	}
+	// the boundaries found by splitting every card into fields
+	NastranTokenizer tok(filePath);
+	tok.bulkSection();
+	tok.nextLine();
+	tok.nextLine();
+	vector<NastranTokenizer::Card> expected;
+	while (tok.nextSymbolType == NastranTokenizer::SYMBOL_KEYWORD) {
+		expected.push_back(tok.currentCard());
+		tok.nextLine();
+	}
+	BOOST_REQUIRE_EQUAL(expected.size(), 8u);
+
+	const set<string> keywords = { "GRID", "CQUAD4", "CHEXA", "CTRIA3" };
+	NastranTokenizer locatingTok(filePath);
+	locatingTok.bulkSection();
+	locatingTok.nextLine();
+	locatingTok.nextLine();
+	vector<NastranTokenizer::Card> cards;
+	locatingTok.locateCards(keywords, 100, cards);
+	BOOST_REQUIRE_EQUAL(cards.size(), 5u);
+	for (size_t i = 0; i < cards.size(); i++) {
+		BOOST_CHECK_EQUAL(string(cards[i].begin, cards[i].end),
+				string(expected[i].begin, expected[i].end));
+		BOOST_CHECK_EQUAL(cards[i].lineNumber, expected[i].lineNumber);
+	}
+	// the tokenizer is left on the first card not located
+	BOOST_CHECK_EQUAL(locatingTok.currentCard().lineNumber, expected[5].lineNumber);
+	BOOST_CHECK_EQUAL("CBAR", locatingTok.nextSymbolString());
+	locatingTok.nextLine();
+	cards.clear();
+	locatingTok.locateCards(keywords, 100, cards);
+	BOOST_CHECK_EQUAL(cards.size(), 1u);
+	BOOST_CHECK_EQUAL("ENDDATA", locatingTok.nextSymbolString());
+
+	// at most maxCount cards
+	NastranTokenizer limitedTok(filePath);
+	limitedTok.bulkSection();
+	limitedTok.nextLine();
+	limitedTok.nextLine();
+	cards.clear();
+	limitedTok.locateCards(keywords, 2, cards);
+	BOOST_CHECK_EQUAL(cards.size(), 2u);
+	BOOST_CHECK_EQUAL(limitedTok.currentCard().lineNumber, expected[2].lineNumber);
+	BOOST_CHECK_EQUAL("CQUAD4", limitedTok.nextSymbolString());
+	fs::remove(filePath);
+}
+
+BOOST_AUTO_TEST_CASE(memory_mapped_empty_file) {
+	const fs::path filePath = fs::temp_directory_path() / fs::unique_path("tok_%%%%%%%%.dat");
+	{
+		ofstream out(filePath.c_str());
+	}
+	NastranTokenizer tok(filePath);
+	tok.bulkSection();
+	tok.nextLine();
+	BOOST_CHECK_EQUAL(NastranTokenizer::SYMBOL_EOF, tok.nextSymbolType);
+	fs::remove(filePath);
+}
+
+namespace {
+
+/**
+ * Conversion of reals as it was done by NastranTokenizer::nextDouble before decodeDouble,
+ * kept as is so that the decoding of the tokenizer is compared to the original one.
+ */
+bool referenceDecodeDouble(const string& field, double& result) {
+	string value = boost::trim_copy(field);
+	boost::replace_all(value, "d", "e");
+	boost::replace_all(value, "D", "E");
+	boost::algorithm::erase_all(value, " ");
+	size_t position = value.find_first_of("+-", 1);
+	if (position != string::npos and position != value.find_first_of("eE", 1) + 1) {
+		value.insert(position, "E");
+	}
+	try {
+		result = boost::lexical_cast<double>(value);
+	} catch (boost::bad_lexical_cast &) {
+		return false;
+	}
+	return true;
+}
+
+bool referenceDecodeInt(const string& field, int& result) {
+	try {
+		result = boost::lexical_cast<int>(field);
+	} catch (boost::bad_lexical_cast &) {
+		return false;
+	}
+	return true;
+}
+
+void checkSameDecoding(const string& field) {
+	const NastranTokenizer::Field range(field.data(), field.data() + field.size());
+	double expected = 0, decoded = 0;
+	const bool expectedOk = referenceDecodeDouble(field, expected);
+	BOOST_REQUIRE_MESSAGE(NastranTokenizer::decodeDouble(range, decoded) == expectedOk,
+			"[" << field << "] " << expectedOk);
+	if (expectedOk) {
+		// bitwise equality, except for NaN
+		BOOST_REQUIRE_MESSAGE(
+				(std::isnan(expected) && std::isnan(decoded))
+						|| memcmp(&expected, &decoded, sizeof(double)) == 0,
+				"[" << field << "] " << expected << " " << decoded);
+	}
+	int expectedInt = 0, decodedInt = 0;
+	const bool expectedIntOk = referenceDecodeInt(field, expectedInt);
+	BOOST_REQUIRE_MESSAGE(NastranTokenizer::decodeInt(range, decodedInt) == expectedIntOk,
+			"[" << field << "] " << expectedIntOk);
+	if (expectedIntOk) {
+		BOOST_REQUIRE_EQUAL(expectedInt, decodedInt);
+	}
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(decode_numbers) {
+	const char* fields[] = { "7.0", ".7E1", "0.7+1", ".70+1", "7.E+0", "70.-1", "1.5-3", "7.+4",
+			"-1.5D-3", "5.000388 D+5", " 1. 5 ", "-0.", "+0", "0.", "1.23456789012+4",
+			"-2.34567890123-12", "1.7976931348623157+308", "4.9-324", "1.e400", "123456789012345678901",
+			"0.1234567890123456789", "2147483647", "-2147483648", "2147483648", "-2147483649", "+12",
+			"", " ", "+", "-", ".", "E5", "1.5E", "1.5E+", "1..5", "1.5-3-2", "1.5E3+2", "--1", "1,5",
+			"inf", "-INF", "nan", "NaN", "0x10", "1 2", "007" };
+	for (const char* field : fields) {
+		checkSameDecoding(field);
+	}
+	double value = 0;
+	const string implicitExponent = "7.+4";
+	BOOST_CHECK(NastranTokenizer::decodeDouble(
+			NastranTokenizer::Field(implicitExponent.data(),
+					implicitExponent.data() + implicitExponent.size()), value));
+	BOOST_CHECK_EQUAL(70000.0, value);
+}
+
+BOOST_AUTO_TEST_CASE(decode_numbers_fuzz) {
+	mt19937 generator(20131);
+	// random characters
+	const string alphabet = " +-.0123456789eEdD";
+	uniform_int_distribution<size_t> charDistribution(0, alphabet.size() - 1);
+	uniform_int_distribution<int> lengthDistribution(1, 16);
+	for (int i = 0; i < 200000; i++) {
+		string field(static_cast<size_t>(lengthDistribution(generator)), ' ');
+		for (char& c : field) {
+			c = alphabet[charDistribution(generator)];
+		}
+		checkSameDecoding(field);
+	}
+	// well formed reals in 8 and 16 characters fields
+	const char* exponentMarks[] = { "", "E", "e", "D", "d", "E ", " " };
+	const char* signs[] = { "", "+", "-" };
+	uniform_int_distribution<int> digitDistribution(0, 9);
+	uniform_int_distribution<int> countDistribution(0, 15);
+	uniform_int_distribution<int> exponentDistribution(0, 330);
+	for (int i = 0; i < 200000; i++) {
+		string field = signs[generator() % 3];
+		const int integerDigits = countDistribution(generator);
+		for (int j = 0; j < integerDigits; j++) {
+			field += static_cast<char>('0' + digitDistribution(generator));
+		}
+		if (generator() % 4 != 0) {
+			field += '.';
+			const int fractionDigits = countDistribution(generator);
+			for (int j = 0; j < fractionDigits; j++) {
+				field += static_cast<char>('0' + digitDistribution(generator));
+			}
+		}
+		if (generator() % 2 == 0) {
+			field += exponentMarks[generator() % 7];
+			field += signs[generator() % 3];
+			field += to_string(exponentDistribution(generator) % (generator() % 2 == 0 ? 30 : 331));
+		}
+		checkSameDecoding(field.substr(0, generator() % 2 == 0 ? 8 : 16));
+	}
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) Alneos, s. a r. l. (contact@alneos.fr)
+ * Released under the GNU General Public License
+ *
+ * NastranWriter_test.cpp
+ *
+ * Formatting of the cards written by the Nastran writer.
+ */
+
+#define BOOST_TEST_MODULE nastran_writer_tests
+#include <boost/test/unit_test.hpp>
+#include <boost/format.hpp>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+#include "../../Nastran/NastranWriter.h"
+
+using namespace std;
+using namespace vega;
+using namespace vega::nastran;
+
+namespace {
+
+/**
+ * The fields as they were formatted with streams and boost::format before the cards were
+ * rendered directly, for the comparison.
+ */
+string streamedField(double value, unsigned int fieldLength) {
+	ostringstream strs;
+	strs << boost::format("%8.7g") % value;
+	string gnum = strs.str();
+	strs.str("");
+	strs.clear();
+	if (gnum.length() <= fieldLength) {
+		strs << internal << setw(fieldLength) << gnum;
+	} else {
+		strs << internal << setw(fieldLength) << boost::format("%4.2e") % value;
+	}
+	return strs.str();
+}
+
+string streamedField(int value, unsigned int fieldLength) {
+	ostringstream strs;
+	strs << internal << setw(fieldLength) << value;
+	return strs.str();
+}
+
+string streamedLine(const string& keyword, const vector<string>& fields,
+		unsigned int fieldLength, unsigned int fieldNum) {
+	ostringstream out;
+	out << left << setw(8) << keyword;
+	unsigned int fieldCount = 0;
+	for (const string& field : fields) {
+		fieldCount++;
+		if (fieldCount % fieldNum == 0) {
+			out << endl << setw(fieldLength) << "";
+		}
+		out << field;
+	}
+	out << endl;
+	return out.str();
+}
+
+string written(const Line& line) {
+	ostringstream out;
+	out << line;
+	return out.str();
+}
+
+}
+
+BOOST_AUTO_TEST_CASE( test_line_fields ) {
+	const vector<double> doubles = { 0., -0., 1., -1.5, 0.3, 7850., 2.1e11, -2.1e11, 1e-10,
+			123456789., 12345678., 1234567.8, -1234567., 3.14159265358979, 1e300, -1e-300,
+			numeric_limits<double>::max(), numeric_limits<double>::denorm_min() };
+	const vector<int> ints = { 0, 7, -7, 12345678, -1234567, -12345678, 123456789 };
+	for (const string& keyword : { string("GRID"), string("GRID*"), string("LONGKEYWORD") }) {
+		const bool largeField = keyword == "GRID*";
+		const unsigned int fieldLength = largeField ? 16 : 8;
+		const unsigned int fieldNum = largeField ? 4 : 8;
+		Line line(keyword);
+		vector<string> fields;
+		for (double value : doubles) {
+			line.add(value);
+			fields.push_back(streamedField(value, fieldLength));
+		}
+		for (int value : ints) {
+			line.add(value);
+			fields.push_back(streamedField(value, fieldLength));
+		}
+		line.add();
+		fields.push_back(string(fieldLength, ' '));
+		line.add(string("THRU"));
+		fields.push_back(string(fieldLength - 4, ' ') + "THRU");
+		BOOST_CHECK_EQUAL(written(line), streamedLine(keyword, fields, fieldLength, fieldNum));
+	}
+	BOOST_CHECK_EQUAL(written(Line("GRID").add(12).add().add(1.5).add(-2).add(0.)),
+			"GRID          12             1.5-      2       0\n");
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) Alneos, s. a r. l. (contact@alneos.fr)
+ * Released under the GNU General Public License
+ *
+ * Mesh_benchmark.cpp
+ *
+ * Throughput of the mesh storage on large meshes. Timings are printed on the standard
+ * output, the checks only guard the correctness of the results.
+ */
+
+#define BOOST_TEST_MODULE mesh_benchmark
+#include <boost/test/unit_test.hpp>
+#include "../../Abstract/Mesh.h"
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <random>
+
+using namespace std;
+using namespace vega;
+
+namespace {
+
+const int NUM_IDS = 10000000;
+
+double elapsedSeconds(const chrono::steady_clock::time_point& start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+void printThroughput(const string& label, size_t lookups, double seconds) {
+	cout << label << ": " << lookups << " lookups in " << seconds << " s, "
+			<< static_cast<double>(lookups) / seconds / 1e6 << " Mlookups/s" << endl;
+}
+
+/**
+ * Fills the index and a std::map with the same ids, then looks up all of them in a
+ * shuffled order.
+ */
+void benchmarkIds(const string& label, const vector<int>& ids) {
+	PositionById index;
+	map<int, int> reference;
+	auto start = chrono::steady_clock::now();
+	for (size_t i = 0; i < ids.size(); i++) {
+		index.set(ids[i], static_cast<int>(i));
+	}
+	index.rebalance();
+	cout << label << ": " << ids.size() << " insertions in " << elapsedSeconds(start) << " s, "
+			<< (index.isDense() ? "dense" : "hashed") << endl;
+	for (size_t i = 0; i < ids.size(); i++) {
+		reference[ids[i]] = static_cast<int>(i);
+	}
+	vector<int> queries(ids);
+	shuffle(queries.begin(), queries.end(), mt19937(42));
+
+	long long checksum = 0;
+	start = chrono::steady_clock::now();
+	for (int id : queries) {
+		checksum += index.find(id);
+	}
+	printThroughput(label + " PositionById", queries.size(), elapsedSeconds(start));
+
+	long long referenceChecksum = 0;
+	start = chrono::steady_clock::now();
+	for (int id : queries) {
+		referenceChecksum += reference.find(id)->second;
+	}
+	printThroughput(label + " std::map", queries.size(), elapsedSeconds(start));
+	BOOST_CHECK_EQUAL(checksum, referenceChecksum);
+}
+
+}
+
+BOOST_AUTO_TEST_CASE( position_by_id_compact ) {
+	vector<int> ids;
+	ids.reserve(NUM_IDS);
+	for (int i = 1; i <= NUM_IDS; i++) {
+		ids.push_back(i);
+	}
+	benchmarkIds("compact ids", ids);
+}
+
+BOOST_AUTO_TEST_CASE( position_by_id_sparse ) {
+	vector<int> ids;
+	ids.reserve(NUM_IDS);
+	mt19937 generator(7);
+	uniform_int_distribution<int> gap(1, 200);
+	int id = 0;
+	for (int i = 0; i < NUM_IDS; i++) {
+		id += gap(generator);
+		ids.push_back(id);
+	}
+	benchmarkIds("sparse ids", ids);
+}
+
+BOOST_AUTO_TEST_CASE( write_med ) {
+	// a block of 100^3 HEXA8 cells, with overlapping groups of cells and nodes
+	const int size = 100;
+	const int nodesBySide = size + 1;
+	Mesh mesh(LogLevel::DEBUG, "block");
+	for (int k = 0; k < nodesBySide; k++) {
+		for (int j = 0; j < nodesBySide; j++) {
+			for (int i = 0; i < nodesBySide; i++) {
+				mesh.addNode((k * nodesBySide + j) * nodesBySide + i + 1, i, j, k);
+			}
+		}
+	}
+	CellGroup* lower = mesh.createCellGroup("LOWER");
+	CellGroup* left = mesh.createCellGroup("LEFT");
+	NodeGroup* bottom = mesh.createNodeGroup("BOTTOM");
+	int cellId = 1;
+	for (int k = 0; k < size; k++) {
+		for (int j = 0; j < size; j++) {
+			for (int i = 0; i < size; i++) {
+				const int n = (k * nodesBySide + j) * nodesBySide + i + 1;
+				const int up = nodesBySide * nodesBySide;
+				mesh.addCell(cellId, CellType::HEXA8,
+						{ n, n + 1, n + 1 + nodesBySide, n + nodesBySide, n + up, n + 1 + up, n + 1
+								+ nodesBySide + up, n + nodesBySide + up });
+				if (k < size / 2) {
+					lower->addCell(cellId);
+				}
+				if (i < size / 2) {
+					left->addCell(cellId);
+				}
+				cellId++;
+			}
+		}
+	}
+	for (int position = 0; position < nodesBySide * nodesBySide; position++) {
+		bottom->addNodeByPosition(position);
+	}
+	const fs::path medFile = fs::temp_directory_path() / fs::unique_path("mesh_%%%%%%%%.med");
+	const auto start = chrono::steady_clock::now();
+	mesh.writeMED(medFile.string().c_str());
+	cout << "writeMED: " << mesh.countCells() << " cells in " << elapsedSeconds(start) << " s"
+			<< endl;
+	BOOST_CHECK(fs::exists(medFile));
+	fs::remove(medFile);
+}
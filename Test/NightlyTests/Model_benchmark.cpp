@@ -0,0 +1,384 @@
+/*
+ * Copyright (C) Alneos, s. a r. l. (contact@alneos.fr)
+ * Released under the GNU General Public License
+ *
+ * Model_benchmark.cpp
+ *
+ * Duration of the parsing and of the passes of Model::finish on large synthetic decks, and
+ * allocations of the model objects. Timings and counts are printed on the standard output,
+ * the checks only guard the correctness of the results.
+ */
+
+#define BOOST_TEST_MODULE model_benchmark
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#include "../../Abstract/Profiler.h"
+#include "../../Nastran/NastranFacade.h"
+#include "../../Systus/SystusWriter.h"
+#include "../../Aster/AsterFacade.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+using namespace vega;
+namespace fs = boost::filesystem;
+
+namespace {
+
+/**
+ * Number of GRIDs along each side of the shell plate.
+ */
+const int PLATE_SIZE = 700;
+/**
+ * Every DMIG_STEP-th GRID of the plate is tied to the next one by direct stiffness terms.
+ */
+const int DMIG_STEP = 100;
+/**
+ * Number of GRIDs of the line loaded by FORCE and fixed by SPC1 cards.
+ */
+const int LOADED_GRIDS = 100000;
+
+double elapsedSeconds(const chrono::steady_clock::time_point& start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+string readFile(const fs::path& path) {
+	ifstream in(path.string());
+	ostringstream content;
+	content << in.rdbuf();
+	return content.str();
+}
+
+/**
+ * A plate of CQUAD4 with direct stiffness terms (DMIG selected by K2GG) on a few thousand
+ * pairs of its GRIDs.
+ */
+void writeDmigDeck(const fs::path& deckPath) {
+	ofstream deck(deckPath.string());
+	deck << "SOL 101\nK2GG = KAAX\nCEND\nBEGIN BULK\n";
+	deck << "MAT1    1       2.1+11          0.3\n";
+	deck << "PSHELL  1       1       0.1     1\n";
+	char line[81];
+	for (int j = 0; j < PLATE_SIZE; j++) {
+		for (int i = 0; i < PLATE_SIZE; i++) {
+			snprintf(line, sizeof(line), "GRID    %-8d        %7d.%7d.0.\n",
+					j * PLATE_SIZE + i + 1, i, j);
+			deck << line;
+		}
+	}
+	for (int j = 0; j < PLATE_SIZE - 1; j++) {
+		for (int i = 0; i < PLATE_SIZE - 1; i++) {
+			const int node = j * PLATE_SIZE + i + 1;
+			snprintf(line, sizeof(line), "CQUAD4  %-8d1       %-8d%-8d%-8d%-8d\n",
+					j * (PLATE_SIZE - 1) + i + 1, node, node + 1, node + PLATE_SIZE + 1,
+					node + PLATE_SIZE);
+			deck << line;
+		}
+	}
+	deck << "DMIG    KAAX    0       6       1\n";
+	// springs between consecutive GRIDs, given by the lower triangle of the matrix
+	for (int node = 1; node < PLATE_SIZE * PLATE_SIZE; node += DMIG_STEP) {
+		snprintf(line, sizeof(line), "DMIG    KAAX    %-8d3               %-8d3       1.+6\n",
+				node, node);
+		deck << line;
+		snprintf(line, sizeof(line), "+       %-8d3       -1.+6\n", node + 1);
+		deck << line;
+		snprintf(line, sizeof(line), "DMIG    KAAX    %-8d3               %-8d3       1.+6\n",
+				node + 1, node + 1);
+		deck << line;
+	}
+	deck << "ENDDATA\n";
+}
+
+/**
+ * A line of CBAR in which every GRID has its own FORCE and SPC1 card.
+ */
+void writeLoadedLineDeck(const fs::path& deckPath) {
+	ofstream deck(deckPath.string());
+	deck << "SOL 101\nCEND\nSUBCASE 1\n  LOAD = 1\n  SPC = 2\nBEGIN BULK\n";
+	deck << "MAT1    1       2.1+11          0.3\n";
+	deck << "PBAR    1       1       1.      1.      1.      1.\n";
+	char line[81];
+	for (int node = 1; node <= LOADED_GRIDS; node++) {
+		snprintf(line, sizeof(line), "GRID    %-8d        %7d.0.      0.\n", node, node);
+		deck << line;
+		snprintf(line, sizeof(line), "FORCE   1       %-8d0       1.      0.      0.      1.\n",
+				node);
+		deck << line;
+		snprintf(line, sizeof(line), "SPC1    2       345     %-8d\n", node);
+		deck << line;
+	}
+	for (int node = 1; node < LOADED_GRIDS; node++) {
+		snprintf(line, sizeof(line), "CBAR    %-8d1       %-8d%-8d0.      1.      0.\n", node,
+				node, node + 1);
+		deck << line;
+	}
+	deck << "ENDDATA\n";
+}
+
+/**
+ * A helix of CBAR whose GRIDs are given in a cylindrical coordinate system, also used for
+ * their displacements.
+ */
+void writeCylindricalGridDeck(const fs::path& deckPath) {
+	ofstream deck(deckPath.string());
+	deck << "SOL 101\nCEND\nBEGIN BULK\n";
+	deck << "MAT1    1       2.1+11          0.3\n";
+	deck << "PBAR    1       1       1.      1.      1.      1.\n";
+	deck << "CORD2C  5               0.      0.      0.      0.      0.      1.\n";
+	deck << "+       1.      0.      0.\n";
+	char line[81];
+	for (int node = 1; node <= LOADED_GRIDS; node++) {
+		snprintf(line, sizeof(line), "GRID    %-8d5       10.     %7d.%7d.5\n", node,
+				node % 360, node / 360);
+		deck << line;
+	}
+	for (int node = 1; node < LOADED_GRIDS; node++) {
+		snprintf(line, sizeof(line), "CBAR    %-8d1       %-8d%-8d0.      0.      1.\n", node,
+				node, node + 1);
+		deck << line;
+	}
+	deck << "ENDDATA\n";
+}
+
+/**
+ * A line of CBAR in which every GRID is fixed by two SPC cards, one of them giving each
+ * constrained DOF twice.
+ */
+void writeSpcLineDeck(const fs::path& deckPath) {
+	ofstream deck(deckPath.string());
+	deck << "SOL 101\nCEND\nSUBCASE 1\n  SPC = 2\nBEGIN BULK\n";
+	deck << "MAT1    1       2.1+11          0.3\n";
+	deck << "PBAR    1       1       1.      1.      1.      1.\n";
+	char line[81];
+	for (int node = 1; node <= LOADED_GRIDS; node++) {
+		snprintf(line, sizeof(line), "GRID    %-8d        %7d.0.      0.\n", node, node);
+		deck << line;
+		snprintf(line, sizeof(line), "SPC     2       %-8d3       0.      %-8d45      0.\n",
+				node, node);
+		deck << line;
+		snprintf(line, sizeof(line), "SPC     2       %-8d345     0.\n", node);
+		deck << line;
+	}
+	for (int node = 1; node < LOADED_GRIDS; node++) {
+		snprintf(line, sizeof(line), "CBAR    %-8d1       %-8d%-8d0.      1.      0.\n", node,
+				node, node + 1);
+		deck << line;
+	}
+	deck << "ENDDATA\n";
+}
+
+}
+
+BOOST_AUTO_TEST_CASE( replace_direct_matrices ) {
+	const fs::path directory = fs::temp_directory_path() / fs::unique_path("vega_%%%%%%%%");
+	fs::create_directories(directory);
+	const fs::path deckPath = directory / "dmig.dat";
+	writeDmigDeck(deckPath);
+
+	nastran::NastranParser parser;
+	const shared_ptr<Model> model = parser.parse(
+			ConfigurationParameters(deckPath.string(), CODE_ASTER, "", "", ".", LogLevel::INFO,
+					ConfigurationParameters::BEST_EFFORT));
+	Profiler::instance().enable();
+	const auto start = chrono::steady_clock::now();
+	model->finish();
+	cout << "finish: " << elapsedSeconds(start) << " s" << endl;
+	for (const Profiler::Phase& phase : Profiler::instance().getPhases()) {
+		if (phase.depth == 1 and phase.seconds > 0.01) {
+			cout << "  " << phase.name << ": " << phase.seconds << " s" << endl;
+		}
+	}
+
+	int discreteCount = 0;
+	for (const auto& elementSet : model->elementSets) {
+		BOOST_CHECK(!elementSet->isMatrixElement());
+		if (elementSet->isDiscrete()) {
+			discreteCount++;
+		}
+	}
+	BOOST_CHECK_EQUAL(discreteCount, (PLATE_SIZE * PLATE_SIZE - 2) / DMIG_STEP + 1);
+	fs::remove_all(directory);
+}
+
+BOOST_AUTO_TEST_CASE( loading_and_constraint_cards ) {
+	const fs::path directory = fs::temp_directory_path() / fs::unique_path("vega_%%%%%%%%");
+	fs::create_directories(directory);
+	const fs::path deckPath = directory / "loaded.dat";
+	writeLoadedLineDeck(deckPath);
+
+	nastran::NastranParser parser;
+	auto start = chrono::steady_clock::now();
+	const shared_ptr<Model> model = parser.parse(
+			ConfigurationParameters(deckPath.string(), CODE_ASTER, "", "", ".", LogLevel::INFO,
+					ConfigurationParameters::BEST_EFFORT));
+	cout << "parse: " << elapsedSeconds(start) << " s" << endl;
+	BOOST_CHECK_EQUAL(model->loadings.size(), LOADED_GRIDS);
+	BOOST_CHECK_EQUAL(model->constraints.size(), LOADED_GRIDS);
+	start = chrono::steady_clock::now();
+	model->finish();
+	cout << "finish: " << elapsedSeconds(start) << " s" << endl;
+	const ModelArena& arena = *model->getArena();
+	cout << "arena: " << arena.getAllocationCount() << " allocations, "
+			<< arena.getAllocatedBytes() / 1024 << " KB in " << arena.getBlockCount()
+			<< " blocks" << endl;
+	BOOST_CHECK_GE(arena.getAllocationCount(), static_cast<size_t>(2 * LOADED_GRIDS));
+	fs::remove_all(directory);
+}
+
+BOOST_AUTO_TEST_CASE( spc_cards ) {
+	const fs::path directory = fs::temp_directory_path() / fs::unique_path("vega_%%%%%%%%");
+	fs::create_directories(directory);
+	const fs::path deckPath = directory / "spc.dat";
+	writeSpcLineDeck(deckPath);
+
+	nastran::NastranParser parser;
+	auto start = chrono::steady_clock::now();
+	const shared_ptr<Model> model = parser.parse(
+			ConfigurationParameters(deckPath.string(), CODE_ASTER, "", "", ".", LogLevel::INFO,
+					ConfigurationParameters::BEST_EFFORT));
+	cout << "parse: " << elapsedSeconds(start) << " s" << endl;
+	// the rows of all the nodes are merged into a single constraint
+	BOOST_CHECK_EQUAL(model->constraints.size(), 1);
+	start = chrono::steady_clock::now();
+	model->finish();
+	cout << "finish: " << elapsedSeconds(start) << " s" << endl;
+	fs::remove_all(directory);
+}
+
+BOOST_AUTO_TEST_CASE( local_grid_positions ) {
+	const fs::path directory = fs::temp_directory_path() / fs::unique_path("vega_%%%%%%%%");
+	fs::create_directories(directory);
+	const fs::path deckPath = directory / "cylindrical.dat";
+	writeCylindricalGridDeck(deckPath);
+
+	nastran::NastranParser parser;
+	auto start = chrono::steady_clock::now();
+	const shared_ptr<Model> model = parser.parse(
+			ConfigurationParameters(deckPath.string(), CODE_ASTER, "", "", ".", LogLevel::INFO,
+					ConfigurationParameters::BEST_EFFORT));
+	cout << "parse: " << elapsedSeconds(start) << " s" << endl;
+	BOOST_CHECK_EQUAL(model->mesh->getNodePositionsByPositionCS().size(), 1);
+	start = chrono::steady_clock::now();
+	model->finish();
+	cout << "finish: " << elapsedSeconds(start) << " s" << endl;
+	// GRID 90 is at theta = 90 degrees
+	const Node node = model->mesh->findNode(model->mesh->findNodePosition(90));
+	BOOST_CHECK_SMALL(node.x, 1e-9);
+	BOOST_CHECK_CLOSE(node.y, 10., 1e-9);
+	fs::remove_all(directory);
+}
+
+BOOST_AUTO_TEST_CASE( nastran_writer ) {
+	const fs::path directory = fs::temp_directory_path() / fs::unique_path("vega_%%%%%%%%");
+	fs::create_directories(directory);
+	const fs::path deckPath = directory / "loaded.dat";
+	writeLoadedLineDeck(deckPath);
+	const ConfigurationParameters configuration(deckPath.string(), NASTRAN, "", "",
+			directory.string(), LogLevel::INFO, ConfigurationParameters::BEST_EFFORT);
+	nastran::NastranParser parser;
+	const shared_ptr<Model> model = parser.parse(configuration);
+	model->finish();
+
+	nastran::NastranWriter writer;
+	auto start = chrono::steady_clock::now();
+	const string writtenPath = writer.writeModel(model, configuration);
+	cout << "writeModel: " << elapsedSeconds(start) << " s, " << fs::file_size(writtenPath) / 1024
+			<< " KB" << endl;
+	fs::remove_all(directory);
+}
+
+BOOST_AUTO_TEST_CASE( systus_writer ) {
+	const fs::path directory = fs::temp_directory_path() / fs::unique_path("vega_%%%%%%%%");
+	fs::create_directories(directory);
+	const fs::path deckPath = directory / "loaded.dat";
+	writeLoadedLineDeck(deckPath);
+	// parsed once: the automatic ids of a second parsing would differ
+	nastran::NastranParser parser;
+	const shared_ptr<Model> model = parser.parse(
+			ConfigurationParameters(deckPath.string(), SYSTUS, "", ""));
+	model->finish();
+	vector<fs::path> ascPaths;
+	for (unsigned int writerThreads : { 1u, max(1u, thread::hardware_concurrency()) }) {
+		const fs::path outputDirectory = directory / to_string(ascPaths.size());
+		fs::create_directories(outputDirectory);
+		const ConfigurationParameters configuration(deckPath.string(), SYSTUS, "", "",
+				outputDirectory.string(), LogLevel::INFO, ConfigurationParameters::BEST_EFFORT, "",
+				0.02, false, "", "", 1, "", 1, writerThreads);
+		SystusWriter writer;
+		auto start = chrono::steady_clock::now();
+		writer.writeModel(model, configuration);
+		const double seconds = elapsedSeconds(start);
+		ascPaths.push_back(outputDirectory / "loaded_DATA1.ASC");
+		const uintmax_t ascSize = fs::file_size(ascPaths.back());
+		cout << "writeModel on " << writerThreads << " threads: " << seconds << " s, "
+				<< ascSize / 1024 << " KB, " << static_cast<double>(ascSize) / seconds / 1e6
+				<< " MB/s" << endl;
+	}
+	BOOST_CHECK(readFile(ascPaths[0]) == readFile(ascPaths[1]));
+	fs::remove_all(directory);
+}
+
+BOOST_AUTO_TEST_CASE( aster_name_lists ) {
+	const fs::path directory = fs::temp_directory_path() / fs::unique_path("vega_%%%%%%%%");
+	fs::create_directories(directory);
+	const fs::path deckPath = directory / "spc.dat";
+	writeSpcLineDeck(deckPath);
+	// listing all the names, then writing the SPC of all the GRIDs as a group
+	for (unsigned int maxNameListSize : { static_cast<unsigned int>(LOADED_GRIDS), 1000u }) {
+		const ConfigurationParameters configuration(deckPath.string(), CODE_ASTER, "", "",
+				directory.string(), LogLevel::INFO, ConfigurationParameters::BEST_EFFORT, "", 0.02,
+				false, "", "", 1, "", 1, 1, maxNameListSize);
+		nastran::NastranParser parser;
+		const shared_ptr<Model> model = parser.parse(configuration);
+		model->finish();
+
+		aster::AsterWriter writer;
+		auto start = chrono::steady_clock::now();
+		writer.writeModel(model, configuration);
+		const double seconds = elapsedSeconds(start);
+		const fs::path commPath = directory / "spc.comm";
+		cout << "writeModel with " << maxNameListSize << " names at most: " << seconds << " s, "
+				<< fs::file_size(commPath) / 1024 << " KB .comm, "
+				<< fs::file_size(directory / "spc.med") / 1024 << " KB .med" << endl;
+		if (maxNameListSize < LOADED_GRIDS) {
+			ifstream comm(commPath.string());
+			const string text((istreambuf_iterator<char>(comm)), istreambuf_iterator<char>());
+			BOOST_CHECK(text.find("GROUP_NO='SPC") != string::npos);
+			BOOST_CHECK(text.find("NOEUD=(") == string::npos);
+		}
+	}
+	fs::remove_all(directory);
+}
+
+BOOST_AUTO_TEST_CASE( aster_concurrent_write ) {
+	const fs::path directory = fs::temp_directory_path() / fs::unique_path("vega_%%%%%%%%");
+	fs::create_directories(directory);
+	const fs::path deckPath = directory / "loaded.dat";
+	writeLoadedLineDeck(deckPath);
+	nastran::NastranParser parser;
+	const shared_ptr<Model> model = parser.parse(
+			ConfigurationParameters(deckPath.string(), CODE_ASTER, "", "", directory.string(),
+					LogLevel::INFO, ConfigurationParameters::BEST_EFFORT));
+	model->finish();
+
+	// the same model written in sequence, then with the MED file written concurrently
+	vector<string> commTexts;
+	for (bool concurrentMedWrite : { false, true }) {
+		const ConfigurationParameters configuration(deckPath.string(), CODE_ASTER, "", "",
+				directory.string(), LogLevel::INFO, ConfigurationParameters::BEST_EFFORT, "", 0.02,
+				false, "", "", 1, "", 1, 1, 1000, concurrentMedWrite);
+		aster::AsterWriter writer;
+		auto start = chrono::steady_clock::now();
+		writer.writeModel(model, configuration);
+		cout << "writeModel" << (concurrentMedWrite ? " with concurrent MED" : "") << ": "
+				<< elapsedSeconds(start) << " s" << endl;
+		ifstream comm((directory / "loaded.comm").string());
+		commTexts.push_back(string(istreambuf_iterator<char>(comm), istreambuf_iterator<char>()));
+	}
+	BOOST_CHECK(commTexts[0] == commTexts[1]);
+	fs::remove_all(directory);
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) Alneos, s. a r. l. (contact@alneos.fr)
+ * Released under the GNU General Public License
+ *
+ * NastranTokenizer_benchmark.cpp
+ *
+ * Throughput of the conversion of Nastran fields to numbers. Timings are printed on the
+ * standard output, the checks only guard the correctness of the results.
+ */
+
+#define BOOST_TEST_MODULE nastran_tokenizer_benchmark
+#include <boost/test/unit_test.hpp>
+#include <boost/lexical_cast.hpp>
+#include "../../Nastran/NastranTokenizer.h"
+#include <chrono>
+#include <ciso646>
+
+using namespace std;
+
+namespace {
+
+const int NUM_PASSES = 200000;
+
+/**
+ * Fields as found on GRID, CORD2R and PSHELL cards, in short and long format.
+ */
+const char* const REAL_FIELDS[] = { "0.", "1.", "-2.5", "1.5-3", "7.+4", "12.34567", "-1.234-2",
+		".25", "2.1+11", "0.3", "7.85-9", "-0.866025", "1.234567890123+04", "-9.87654321098-03",
+		"  5.000388D+05  ", "100.    " };
+const char* const INT_FIELDS[] = { "1", "12", "123456", "0", "99999999", "3", "-1", "2001" };
+
+double elapsedSeconds(const chrono::steady_clock::time_point& start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+void printThroughput(const string& label, size_t fields, double seconds) {
+	cout << label << ": " << fields << " fields in " << seconds << " s, "
+			<< static_cast<double>(fields) / seconds / 1e6 << " Mfields/s" << endl;
+}
+
+vector<NastranTokenizer::Field> toFields(const vector<string>& values) {
+	vector<NastranTokenizer::Field> fields;
+	for (const string& value : values) {
+		fields.push_back(NastranTokenizer::Field(value.data(), value.data() + value.size()));
+	}
+	return fields;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE( decode_reals ) {
+	const vector<string> values(begin(REAL_FIELDS), end(REAL_FIELDS));
+	const vector<NastranTokenizer::Field> fields = toFields(values);
+	const size_t count = fields.size() * NUM_PASSES;
+
+	double sum = 0;
+	auto start = chrono::steady_clock::now();
+	for (int pass = 0; pass < NUM_PASSES; pass++) {
+		for (const NastranTokenizer::Field& field : fields) {
+			double value;
+			NastranTokenizer::decodeDouble(field, value);
+			sum += value;
+		}
+	}
+	printThroughput("decodeDouble", count, elapsedSeconds(start));
+
+	double referenceSum = 0;
+	start = chrono::steady_clock::now();
+	for (int pass = 0; pass < NUM_PASSES; pass++) {
+		for (const NastranTokenizer::Field& field : fields) {
+			double value;
+			NastranTokenizer::decodeDoubleByString(field, value);
+			referenceSum += value;
+		}
+	}
+	printThroughput("string and lexical_cast", count, elapsedSeconds(start));
+	BOOST_CHECK_EQUAL(sum, referenceSum);
+}
+
+BOOST_AUTO_TEST_CASE( decode_ints ) {
+	const vector<string> values(begin(INT_FIELDS), end(INT_FIELDS));
+	const vector<NastranTokenizer::Field> fields = toFields(values);
+	const size_t count = fields.size() * NUM_PASSES;
+
+	long long sum = 0;
+	auto start = chrono::steady_clock::now();
+	for (int pass = 0; pass < NUM_PASSES; pass++) {
+		for (const NastranTokenizer::Field& field : fields) {
+			int value;
+			NastranTokenizer::decodeInt(field, value);
+			sum += value;
+		}
+	}
+	printThroughput("decodeInt", count, elapsedSeconds(start));
+
+	long long referenceSum = 0;
+	start = chrono::steady_clock::now();
+	for (int pass = 0; pass < NUM_PASSES; pass++) {
+		for (const NastranTokenizer::Field& field : fields) {
+			referenceSum += boost::lexical_cast<int>(field.begin(),
+					static_cast<size_t>(field.size()));
+		}
+	}
+	printThroughput("lexical_cast", count, elapsedSeconds(start));
+	BOOST_CHECK_EQUAL(sum, referenceSum);
+}
@@ -12,16 +12,43 @@
 #include "build_properties.h"
 #include "../../Abstract/Model.h"
 #include "../../ResultReaders/F06Parser.h"
+#include "../../Nastran/NastranFacade.h"
 #include <boost/test/unit_test.hpp>
 //#include <valgrind/memcheck.h>
 #include <boost/pointer_cast.hpp>
 #include <boost/assign.hpp>
+#include <boost/filesystem.hpp>
+#include <fstream>
 #include <string>
 
 using namespace std;
 using namespace vega;
 using boost::assign::list_of;
 using vega::result::F06Parser;
+namespace fs = boost::filesystem;
+
+namespace {
+
+/**
+ * A new temporary directory, removed with its content at the end of the scope, even when a
+ * check fails.
+ */
+class TemporaryDirectory final {
+public:
+	const fs::path path;
+	TemporaryDirectory() :
+			path(fs::temp_directory_path() / fs::unique_path("vega_%%%%%%%%")) {
+		fs::create_directories(path);
+	}
+	TemporaryDirectory(const TemporaryDirectory&) = delete;
+	TemporaryDirectory& operator=(const TemporaryDirectory&) = delete;
+	~TemporaryDirectory() {
+		boost::system::error_code ignored;
+		fs::remove_all(path, ignored);
+	}
+};
+
+}
 
 BOOST_AUTO_TEST_CASE(nastran_f06_parsing) {
 
@@ -162,3 +189,51 @@ BOOST_AUTO_TEST_CASE(test_4a) {
 
 }
 
+
+BOOST_AUTO_TEST_CASE(cylindrical_grid_displacements) {
+	const TemporaryDirectory temporaryDirectory;
+	const fs::path& directory = temporaryDirectory.path;
+	const fs::path deckPath = directory / "cylindrical.dat";
+	const fs::path f06Path = directory / "cylindrical.f06";
+	{
+		// GRID 2 is given at radius 10, theta 90 in the cylindrical system 5, also used for its displacements
+		ofstream deck(deckPath.string());
+		deck << "SOL 101\nCEND\nBEGIN BULK\n";
+		deck << "MAT1    1       2.1+11          0.3\n";
+		deck << "PBAR    1       1       1.      1.      1.      1.\n";
+		deck << "CORD2C  5               0.      0.      0.      0.      0.      1.\n";
+		deck << "+       1.      0.      0.\n";
+		deck << "GRID    1               0.      0.      0.\n";
+		deck << "GRID    2       5       10.     90.     0.      5\n";
+		deck << "CBAR    1       1       1       2       0.      0.      1.\n";
+		deck << "ENDDATA\n";
+		ofstream f06(f06Path.string());
+		f06 << "                                             D I S P L A C E M E N T   V E C T O R\n";
+		f06 << "      POINT ID.   TYPE          T1             T2             T3             R1             R2             R3\n";
+		f06 << "             2      G      1.000000E+00   0.0            0.0            0.0            0.0            0.0\n";
+	}
+	nastran::NastranParser parser;
+	const shared_ptr<Model> model = parser.parse(
+			ConfigurationParameters(deckPath.string(), CODE_ASTER, "", ""));
+	ConfigurationParameters confParams("inputFile", vega::CODE_ASTER, "..", "vega", ".",
+			LogLevel::INFO, ConfigurationParameters::BEST_EFFORT, f06Path.string(), 0.0003);
+	// the assertions are read before the model is finished, as in the conversion
+	F06Parser f06parser;
+	f06parser.add_assertions(confParams, model);
+
+	const Node& node = model->mesh->findNode(model->mesh->findNodePosition(2));
+	BOOST_CHECK_SMALL(node.x, 1e-9);
+	BOOST_CHECK_CLOSE(node.y, 10.0, 1e-9);
+	// a radial displacement at theta 90 is along the global Y axis
+	map<DOF, double> expected = { { DOF::DX, 0.0 }, { DOF::DY, 1.0 }, { DOF::DZ, 0.0 } };
+	int checked = 0;
+	for (const auto& assertion : (*model->analyses.begin())->getAssertions()) {
+		const auto& displacement = dynamic_pointer_cast<NodalDisplacementAssertion>(assertion);
+		if (displacement == nullptr or expected.find(displacement->dof) == expected.end()) {
+			continue;
+		}
+		BOOST_CHECK_SMALL(displacement->value - expected[displacement->dof], 1e-9);
+		checked++;
+	}
+	BOOST_CHECK_EQUAL(checked, 3);
+}
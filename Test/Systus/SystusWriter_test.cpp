@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) Alneos, s. a r. l. (contact@alneos.fr)
+ * Released under the GNU General Public License
+ *
+ * SystusWriter_test.cpp
+ *
+ * ASC and DAT files written by the Systus writer.
+ */
+
+#define BOOST_TEST_MODULE systus_writer_tests
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "../../Systus/SystusWriter.h"
+#include "../../Nastran/NastranFacade.h"
+
+using namespace std;
+using namespace vega;
+namespace fs = boost::filesystem;
+
+namespace {
+
+/**
+ * Number of GRIDs of the line. With 3 threads rendering waves of 12 chunks, the cells fill a
+ * wave and the nodes start another one with a single node chunk. 2 threads render a last
+ * wave of 5 node chunks.
+ */
+const int LINE_GRIDS = static_cast<int>(12 * SystusWriter::CHUNK_SIZE + 1);
+
+/**
+ * A line of GRIDs linked by CBARs, each GRID having its own FORCE and SPC1 card.
+ */
+void writeLineDeck(const fs::path& deckPath) {
+	ofstream deck(deckPath.string());
+	deck << "SOL 101\nCEND\nSUBCASE 1\n  LOAD = 1\n  SPC = 2\nBEGIN BULK\n";
+	deck << "MAT1    1       2.1+11          0.3\n";
+	deck << "PBAR    1       1       1.      1.      1.      1.\n";
+	char line[81];
+	for (int node = 1; node <= LINE_GRIDS; node++) {
+		snprintf(line, sizeof(line), "GRID    %-8d        %7d.0.      0.\n", node, node);
+		deck << line;
+		snprintf(line, sizeof(line), "FORCE   1       %-8d0       1.      0.      0.      1.\n",
+				node);
+		deck << line;
+		snprintf(line, sizeof(line), "SPC1    2       345     %-8d\n", node);
+		deck << line;
+	}
+	for (int node = 1; node < LINE_GRIDS; node++) {
+		snprintf(line, sizeof(line), "CBAR    %-8d1       %-8d%-8d0.      1.      0.\n", node,
+				node, node + 1);
+		deck << line;
+	}
+	deck << "ENDDATA\n";
+}
+
+string readFile(const fs::path& path) {
+	ifstream in(path.string());
+	ostringstream content;
+	content << in.rdbuf();
+	return content.str();
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(writer_threads) {
+	const fs::path directory = fs::temp_directory_path() / fs::unique_path("vega_%%%%%%%%");
+	fs::create_directories(directory);
+	const fs::path deckPath = directory / "line.dat";
+	writeLineDeck(deckPath);
+	nastran::NastranParser parser;
+	const shared_ptr<Model> model = parser.parse(
+			ConfigurationParameters(deckPath.string(), SYSTUS, "", ""));
+	model->finish();
+	BOOST_REQUIRE_EQUAL(model->mesh->countNodes(), LINE_GRIDS);
+
+	vector<string> ascTexts;
+	for (unsigned int writerThreads : { 1u, 2u, 3u }) {
+		const fs::path outputDirectory = directory / to_string(writerThreads);
+		fs::create_directories(outputDirectory);
+		SystusWriter writer;
+		writer.writeModel(model,
+				ConfigurationParameters(deckPath.string(), SYSTUS, "", "",
+						outputDirectory.string(), LogLevel::INFO,
+						ConfigurationParameters::BEST_EFFORT, "", 0.02, false, "", "", 1, "", 1,
+						writerThreads));
+		ascTexts.push_back(readFile(outputDirectory / "line_DATA1.ASC"));
+	}
+	BOOST_CHECK(ascTexts[0].find("BEGIN_NODES " + to_string(LINE_GRIDS) + " 3") != string::npos);
+	// the load and constraint lists of the nodes are numbered by each writer
+	BOOST_CHECK(ascTexts[0].find("\n1 28 0 0 1 ") != string::npos);
+	BOOST_CHECK(ascTexts[0] == ascTexts[1]);
+	BOOST_CHECK(ascTexts[0] == ascTexts[2]);
+	fs::remove_all(directory);
+}